@@ -0,0 +1,157 @@
+#include "bench.h"
+#include <string.h>
+#include <time.h>
+
+/* Linux:
+     cc -O3 -pthread -o bench/bench bench/bench*.c \
+        src/simd.c src/math4x4.c src/threads.c src/bvh.c src/bvh8.c src/collide.c src/voxels.c \
+        src/slice.c src/distance.c src/sdf.c src/inside.c src/ao.c src/scene.c \
+        ext/counters.c ext/intersect_triangle.cpp ext/intersect_triangle_simd.c \
+        ext/intersections/opttritri.c ext/intersections/tritri_isectline.c ext/intersections/tritri_robust.c \
+        ext/intersections/tritri_simd.c \
+        ext/intersections/tribox3.c ext/intersections/fromtorot.c \
+        ext/intersections/fromtorot_simd.c bench/bench_chain.cpp -lm
+     bench/bench bvh [triangles...]
+     bench/bench lbvh [triangles...]
+     bench/bench build [triangles [threads...]]
+     bench/bench refit [triangles [threshold]]
+     bench/bench bvh8 [triangles...]
+     bench/bench triangle
+     bench/bench collide [triangles...]
+     bench/bench self [triangles...]
+     bench/bench voxels [triangles [resolution...]]
+     bench/bench slice [triangles [layers...]]
+     bench/bench distance [triangles [points]]
+     bench/bench sdf [triangles [resolution...]]
+     bench/bench inside [triangles [points]]
+     bench/bench ao [triangles [rays...]]
+     bench/bench rotations [count...]
+     bench/bench matrix [count...]
+     bench/bench transform [count...]
+     bench/bench instances [count...]
+     bench/bench chain [count...]
+     bench/bench scene [nodes [changed...]]
+     bench/bench ext [results.json|- [baseline.json [threshold%]]]
+*/
+
+BEGIN_C
+
+double bench_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint64_t bench_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+float bench_uniform(uint64_t* state) {
+    return (float)(bench_random(state) >> 40) * (1.0f / (1 << 24));
+}
+
+void bench_direction(uint64_t* state, float d[3]) {
+    const float z = bench_uniform(state) * 2 - 1;
+    const float a = bench_uniform(state) * 6.28318530718f;
+    const float r = sqrtf(maximum(0.0f, 1 - z * z));
+    d[0] = r * cosf(a);
+    d[1] = r * sinf(a);
+    d[2] = z;
+}
+
+int bench_sphere(bench_mesh_t* m, int triangles, uint64_t seed) {
+    const int rows = maximum(2, (int)sqrtf(triangles / 4.0f));
+    const int cols = rows * 2;
+    const int vertex_count = (rows - 1) * cols + 2; // two poles
+    const int triangle_count = 2 * cols * (rows - 1);
+    m->vertices = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)vertex_count);
+    m->indices = (int32_t*)malloc(sizeof(int32_t) * 3 * (size_t)triangle_count);
+    if (m->vertices == null || m->indices == null) { bench_mesh_free(m); return 0; }
+    uint64_t s = seed;
+    const float fa = 3 + bench_uniform(&s) * 5, fb = 3 + bench_uniform(&s) * 5;
+    int k = 0;
+    for (int r = 1; r < rows; r++) {
+        const float theta = 3.14159265359f * r / rows;
+        for (int c = 0; c < cols; c++) {
+            const float phi = 6.28318530718f * c / cols;
+            const float bump = 1 + 0.05f * sinf(fa * theta) * cosf(fb * phi);
+            m->vertices[k][0] = bump * sinf(theta) * cosf(phi);
+            m->vertices[k][1] = bump * sinf(theta) * sinf(phi);
+            m->vertices[k][2] = bump * cosf(theta);
+            k++;
+        }
+    }
+    const int north = k, south = k + 1;
+    m->vertices[north][0] = 0; m->vertices[north][1] = 0; m->vertices[north][2] = 1;
+    m->vertices[south][0] = 0; m->vertices[south][1] = 0; m->vertices[south][2] = -1;
+    int32_t* ix = m->indices;
+    for (int c = 0; c < cols; c++) {
+        const int c1 = (c + 1) % cols;
+        *ix++ = north; *ix++ = c; *ix++ = c1;
+        *ix++ = south; *ix++ = (rows - 2) * cols + c1; *ix++ = (rows - 2) * cols + c;
+        for (int r = 0; r < rows - 2; r++) {
+            const int a = r * cols + c, b = r * cols + c1, d = a + cols, e = b + cols;
+            *ix++ = a; *ix++ = d; *ix++ = b;
+            *ix++ = b; *ix++ = d; *ix++ = e;
+        }
+    }
+    m->mesh.vertices = m->vertices;
+    m->mesh.indices = m->indices;
+    m->mesh.vertex_count = vertex_count;
+    m->mesh.triangle_count = triangle_count;
+    return 1;
+}
+
+void bench_mesh_free(bench_mesh_t* m) {
+    free(m->vertices);
+    free(m->indices);
+    memset(m, 0, sizeof(*m));
+}
+
+static const struct {
+    const char* name;
+    void (*run)(int argc, const char* argv[]);
+} benchmarks[] = {
+    { "bvh",   bench_bvh },
+    { "lbvh",  bench_lbvh },
+    { "build", bench_build },
+    { "refit", bench_refit },
+    { "bvh8",  bench_bvh8 },
+    { "triangle", bench_triangle },
+    { "collide", bench_collide },
+    { "self", bench_self },
+    { "voxels", bench_voxels },
+    { "slice", bench_slice },
+    { "distance", bench_distance },
+    { "sdf", bench_sdf },
+    { "inside", bench_inside },
+    { "ao", bench_ao },
+    { "rotations", bench_rotations },
+    { "matrix", bench_matrix },
+    { "transform", bench_transform },
+    { "instances", bench_instances },
+    { "chain", bench_chain },
+    { "scene", bench_scene },
+    { "ext", bench_ext },
+};
+
+int main(int argc, const char* argv[]) {
+    const int n = (int)(sizeof(benchmarks) / sizeof(benchmarks[0]));
+    for (int i = 0; i < n; i++) {
+        if (argc > 1 && strcmp(argv[1], benchmarks[i].name) == 0) {
+            benchmarks[i].run(argc - 2, argv + 2);
+            return 0;
+        }
+    }
+    fprintf(stderr, "usage: %s <benchmark> [arguments]\nbenchmarks:", argv[0]);
+    for (int i = 0; i < n; i++) { fprintf(stderr, " %s", benchmarks[i].name); }
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+END_C
@@ -0,0 +1,47 @@
+#pragma once
+#include "../src/std.h"
+#include "../src/mesh.h"
+
+/* benchmarks, see bench.c for how to build and run */
+
+BEGIN_C
+
+double bench_seconds(void); /* monotonic */
+
+uint64_t bench_random(uint64_t* state); /* xorshift64*, state must not be 0 */
+float bench_uniform(uint64_t* state);   /* [0..1) */
+void bench_direction(uint64_t* state, float d[3]); /* uniform on unit sphere */
+
+typedef struct bench_mesh_s {
+    mesh_t mesh;
+    vec3f_t* vertices;
+    int32_t* indices;
+} bench_mesh_t;
+
+/* closed bumpy sphere of radius ~1 with about `triangles` triangles */
+int  bench_sphere(bench_mesh_t* m, int triangles, uint64_t seed);
+void bench_mesh_free(bench_mesh_t* m);
+
+void bench_bvh(int argc, const char* argv[]);
+void bench_lbvh(int argc, const char* argv[]);
+void bench_build(int argc, const char* argv[]);
+void bench_refit(int argc, const char* argv[]);
+void bench_bvh8(int argc, const char* argv[]);
+void bench_triangle(int argc, const char* argv[]);
+void bench_collide(int argc, const char* argv[]);
+void bench_self(int argc, const char* argv[]);
+void bench_voxels(int argc, const char* argv[]);
+void bench_slice(int argc, const char* argv[]);
+void bench_distance(int argc, const char* argv[]);
+void bench_sdf(int argc, const char* argv[]);
+void bench_inside(int argc, const char* argv[]);
+void bench_ao(int argc, const char* argv[]);
+void bench_rotations(int argc, const char* argv[]);
+void bench_matrix(int argc, const char* argv[]);
+void bench_transform(int argc, const char* argv[]);
+void bench_instances(int argc, const char* argv[]);
+void bench_chain(int argc, const char* argv[]);
+void bench_scene(int argc, const char* argv[]);
+void bench_ext(int argc, const char* argv[]);
+
+END_C
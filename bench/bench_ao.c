@@ -0,0 +1,147 @@
+#include "bench.h"
+#include "../src/ao.h"
+#include "../src/threads.h"
+#include "../ext/intersect_triangle.h"
+
+BEGIN_C
+
+enum { REFERENCE = 256, BRUTE = 8 }; /* vertices checked against bvh_any_hit() and brute force */
+
+static const float DISTANCE = 0.5f;
+
+/* bumpy sphere with a smaller one sunk into its side: occlusion in the crease */
+static int scene(bench_mesh_t* m, int triangles) {
+    bench_mesh_t a = {0}, b = {0};
+    int ok = bench_sphere(&a, triangles * 3 / 4, 1) && bench_sphere(&b, triangles / 4, 2);
+    if (ok) {
+        const int vc = a.mesh.vertex_count + b.mesh.vertex_count;
+        const int tc = a.mesh.triangle_count + b.mesh.triangle_count;
+        m->vertices = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)vc);
+        m->indices = (int32_t*)malloc(sizeof(int32_t) * 3 * (size_t)tc);
+        ok = m->vertices != null && m->indices != null;
+        if (ok) {
+            memcpy(m->vertices, a.vertices, sizeof(vec3f_t) * (size_t)a.mesh.vertex_count);
+            memcpy(m->indices, a.indices, sizeof(int32_t) * 3 * (size_t)a.mesh.triangle_count);
+            for (int i = 0; i < b.mesh.vertex_count; i++) {
+                float* v = m->vertices[a.mesh.vertex_count + i];
+                for (int k = 0; k < 3; k++) { v[k] = b.vertices[i][k] * 0.6f + (k == 0) * 1.3f; }
+            }
+            for (int i = 0; i < b.mesh.triangle_count * 3; i++) {
+                m->indices[a.mesh.triangle_count * 3 + i] = b.indices[i] + a.mesh.vertex_count;
+            }
+            m->mesh = (mesh_t){ m->vertices, m->indices, vc, tc };
+        } else {
+            bench_mesh_free(m);
+        }
+    }
+    bench_mesh_free(&a);
+    bench_mesh_free(&b);
+    return ok;
+}
+
+static void unit_normals(const mesh_t* m, vec3f_t* n) {
+    memset(n, 0, sizeof(vec3f_t) * (size_t)m->vertex_count);
+    for (int i = 0; i < m->triangle_count; i++) {
+        const float* v[3];
+        mesh_triangle(m, i, v);
+        const float e1[3] = { v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2] };
+        const float e2[3] = { v[2][0] - v[0][0], v[2][1] - v[0][1], v[2][2] - v[0][2] };
+        const float c[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                             e1[0] * e2[1] - e1[1] * e2[0] };
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 3; k++) { n[m->indices[i * 3 + j]][k] += c[k]; }
+        }
+    }
+    for (int i = 0; i < m->vertex_count; i++) {
+        const float l = sqrtf(n[i][0] * n[i][0] + n[i][1] * n[i][1] + n[i][2] * n[i][2]);
+        for (int k = 0; k < 3; k++) { n[i][k] = l > 0 ? n[i][k] / l : 0; }
+    }
+}
+
+/* occluded rays of vertex i: bvh_any_hit() or every triangle */
+static int reference(const bvh_t* bvh, int brute, const vec3f_t* normals, int i, int rays) {
+    const mesh_t* m = &bvh->mesh;
+    float o[3];
+    ao_origin(bvh, m->vertices[i], normals[i], o);
+    int hits = 0;
+    for (int j = 0; j < rays; j++) {
+        float d[3];
+        ao_direction(normals[i], 1, i, j, rays, d);
+        if (!brute) {
+            hits += bvh_any_hit(bvh, o, d, 0, DISTANCE);
+        } else {
+            int hit = 0;
+            for (int k = 0; k < m->triangle_count && !hit; k++) {
+                const float* v[3];
+                mesh_triangle(m, k, v);
+                hit = intersect_triangle_occluded_f(o, d, v[0], v[1], v[2], 1e-30f, DISTANCE);
+            }
+            hits += hit;
+        }
+    }
+    return hits;
+}
+
+static void run(const bvh_t* bvh, const vec3f_t* normals, int rays) {
+    const mesh_t* m = &bvh->mesh;
+    float* ao = (float*)malloc(sizeof(float) * (size_t)m->vertex_count);
+    float* single = (float*)malloc(sizeof(float) * (size_t)m->vertex_count);
+    if (ao == null || single == null) {
+        printf("out of memory\n");
+    } else {
+        threads_init(1);
+        ao_bake(bvh, normals, rays, DISTANCE, 1, single);
+        threads_init(0);
+        const double time = bench_seconds();
+        const int ok = ao_bake(bvh, normals, rays, DISTANCE, 1, ao);
+        const double seconds = bench_seconds() - time;
+        double sum = 0;
+        int occluded = 0;
+        for (int i = 0; i < m->vertex_count; i++) { sum += ao[i]; occluded += ao[i] < 1; }
+        const int step = maximum(1, m->vertex_count / REFERENCE);
+        int differ = 0, count = 0; // rays deciding differently from bvh_any_hit()
+        double scalar = bench_seconds();
+        for (int i = 0; i < m->vertex_count; i += step, count++) {
+            differ += abs(reference(bvh, 0, normals, i, rays) - (int)lroundf((1 - ao[i]) * rays));
+        }
+        scalar = (bench_seconds() - scalar) / count * m->vertex_count;
+        double brute = bench_seconds();
+        for (int i = 0; i < BRUTE; i++) { reference(bvh, 1, normals, i * step, rays); }
+        brute = (bench_seconds() - brute) / BRUTE * m->vertex_count;
+        printf("%4d rays %7.3f s %6.2f Mrays/s, mean ao %.4f, %d occluded vertices, "
+               "%d rays differ from bvh_any_hit, %s with 1 thread\n",
+               rays, seconds, (double)rays * m->vertex_count / seconds / 1e6, sum / m->vertex_count,
+               occluded, differ, ok && memcmp(ao, single, sizeof(float) * (size_t)m->vertex_count) == 0 ?
+               "identical" : "DIFFERENT");
+        printf("          estimated bvh_any_hit per ray %.1f s, brute force %.0f s\n", scalar, brute);
+    }
+    free(single);
+    free(ao);
+}
+
+/* bench ao [triangles [rays...]] */
+void bench_ao(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    bench_mesh_t m = {0};
+    bvh_t* bvh = null;
+    vec3f_t* normals = null;
+    if (!scene(&m, triangles) || (bvh = bvh_create(&m.mesh)) == null ||
+        (normals = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)m.mesh.vertex_count)) == null) {
+        printf("out of memory\n");
+    } else {
+        printf("%d vertices, %d triangles, %d threads, distance %.2f\n",
+               m.mesh.vertex_count, m.mesh.triangle_count, threads_count(), DISTANCE);
+        unit_normals(&m.mesh, normals);
+        if (argc > 1) {
+            for (int i = 1; i < argc; i++) { run(bvh, normals, atoi(argv[i])); }
+        } else {
+            run(bvh, normals, 16);
+            run(bvh, normals, 64);
+        }
+    }
+    free(normals);
+    bvh_destroy(bvh);
+    bench_mesh_free(&m);
+}
+
+END_C
@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "../src/bvh.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+static int same(const bvh_t* a, const bvh_t* b) {
+    return a->node_count == b->node_count &&
+           memcmp(a->nodes, b->nodes, sizeof(bvh_node_t) * (size_t)a->node_count) == 0 &&
+           memcmp(a->triangles, b->triangles, sizeof(int32_t) * (size_t)a->triangle_count) == 0;
+}
+
+static void scaling(const char* name, bvh_t* (*create)(const mesh_t* mesh),
+                    const mesh_t* mesh, const int threads[], int n) {
+    threads_init(1);
+    bvh_t* reference = create(mesh);
+    if (reference == null) { printf("out of memory\n"); return; }
+    double single = 0;
+    for (int i = 0; i < n; i++) {
+        threads_init(threads[i]);
+        double best = INFINITY;
+        int identical = 1;
+        for (int repeat = 0; repeat < 3; repeat++) {
+            const double time = bench_seconds();
+            bvh_t* bvh = create(mesh);
+            best = minimum(best, bench_seconds() - time);
+            if (bvh == null) { printf("out of memory\n"); break; }
+            identical = identical && same(bvh, reference);
+            bvh_destroy(bvh);
+        }
+        if (threads[i] == 1 || single == 0) { single = best; }
+        printf("%-6s %9d triangles %3d threads build %8.4f s speedup %5.2f %s\n", name, mesh->triangle_count,
+               threads[i], best, single / best, identical ? "identical" : "DIFFERENT");
+    }
+    bvh_destroy(reference);
+}
+
+/* bench build [triangles [threads...]] build time vs number of threads,
+   every build is compared with the single threaded one */
+void bench_build(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    const int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int threads[16];
+    int n = 0;
+    for (int i = 1; i < argc && n < 16; i++) { threads[n++] = atoi(argv[i]); }
+    if (n == 0) {
+        for (int t = 1; t < cores && n < 15; t *= 2) { threads[n++] = t; }
+        threads[n++] = cores;
+    }
+    bench_mesh_t m = {0};
+    if (!bench_sphere(&m, triangles, 1)) { printf("out of memory\n"); return; }
+    scaling("sah", bvh_create, &m.mesh, threads, n);
+    scaling("linear", bvh_create_linear, &m.mesh, threads, n);
+    threads_init(0);
+    bench_mesh_free(&m);
+}
+
+END_C
@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "../src/bvh.h"
+#include "../ext/intersect_triangle.h"
+
+BEGIN_C
+
+enum { RAYS = 1 << 20, BRUTE_RAYS = 256 };
+
+typedef struct rays_s {
+    vec3f_t* orig;
+    vec3f_t* dir; /* from outside towards a point inside radius 1.5, ~1/2 miss */
+} rays_t;
+
+static void make_rays(rays_t* r, int n, uint64_t seed) {
+    r->orig = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)n);
+    r->dir = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)n);
+    uint64_t s = seed;
+    for (int i = 0; i < n; i++) {
+        float o[3], t[3];
+        bench_direction(&s, o);
+        bench_direction(&s, t);
+        const float radius = bench_uniform(&s) * 1.5f;
+        for (int k = 0; k < 3; k++) {
+            r->orig[i][k] = o[k] * 3;
+            r->dir[i][k] = t[k] * radius - r->orig[i][k];
+        }
+    }
+}
+
+static int brute_closest(const mesh_t* m, const float orig[3], const float dir[3], double* tbest) {
+    int best = -1;
+    *tbest = INFINITY;
+    double o[3] = { orig[0], orig[1], orig[2] }, d[3] = { dir[0], dir[1], dir[2] };
+    for (int i = 0; i < m->triangle_count; i++) {
+        const float* v[3];
+        mesh_triangle(m, i, v);
+        double v0[3] = { v[0][0], v[0][1], v[0][2] }, v1[3] = { v[1][0], v[1][1], v[1][2] }, v2[3] = { v[2][0], v[2][1], v[2][2] };
+        double t, u, w;
+        if (intersect_triangle(o, d, v0, v1, v2, &t, &u, &w) && t >= 0 && t < *tbest) { *tbest = t; best = i; }
+    }
+    return best;
+}
+
+static void run(int triangles, bvh_t* (*create)(const mesh_t* mesh)) {
+    bench_mesh_t m = {0};
+    if (!bench_sphere(&m, triangles, 1)) { printf("out of memory\n"); return; }
+    double time = bench_seconds();
+    bvh_t* bvh = create(&m.mesh);
+    const double build = bench_seconds() - time;
+    if (bvh == null) { printf("out of memory\n"); bench_mesh_free(&m); return; }
+    rays_t r;
+    make_rays(&r, RAYS, 2);
+    int hits = 0;
+    bvh_hit_t h;
+    time = bench_seconds();
+    for (int i = 0; i < RAYS; i++) { hits += bvh_closest_hit(bvh, r.orig[i], r.dir[i], 0, INFINITY, &h); }
+    const double closest = RAYS / (bench_seconds() - time);
+    int occluded = 0;
+    time = bench_seconds();
+    for (int i = 0; i < RAYS; i++) { occluded += bvh_any_hit(bvh, r.orig[i], r.dir[i], 0, 1); }
+    const double any = RAYS / (bench_seconds() - time);
+    bvh_hit_t all[16];
+    int total = 0;
+    time = bench_seconds();
+    for (int i = 0; i < RAYS; i++) { total += bvh_all_hits(bvh, r.orig[i], r.dir[i], 0, INFINITY, all, 16); }
+    const double every = RAYS / (bench_seconds() - time);
+    printf("%9d triangles build %8.3f s %5.1f MB nodes %9d | closest %6.2f any %6.2f all %6.2f Mrays/s | hit %.2f occluded %.2f\n",
+           m.mesh.triangle_count, build, (bvh->node_count * sizeof(bvh_node_t) + bvh->triangle_count * sizeof(int32_t)) / 1e6,
+           bvh->node_count, closest / 1e6, any / 1e6, every / 1e6, (double)hits / RAYS, (double)occluded / RAYS);
+    int farther = 0; // the one kept of all hits along the whole line is the nearest
+    for (int i = 0; i < RAYS; i += 16) {
+        bvh_closest_hit(bvh, r.orig[i], r.dir[i], -INFINITY, INFINITY, &h);
+        farther += bvh_all_hits(bvh, r.orig[i], r.dir[i], -INFINITY, INFINITY, all, 1) > 0 && all[0].t != h.t;
+    }
+    printf("%9s all hits of capacity 1 not the closest %d of %d\n", "", farther, RAYS / 16);
+    if (m.mesh.triangle_count <= 100000) { // cross check against the O(n) loop it replaces
+        int mismatches = 0;
+        time = bench_seconds();
+        for (int i = 0; i < BRUTE_RAYS; i++) {
+            double t;
+            const int b = brute_closest(&m.mesh, r.orig[i], r.dir[i], &t);
+            bvh_closest_hit(bvh, r.orig[i], r.dir[i], 0, INFINITY, &h);
+            if (b != h.triangle && (b < 0 || h.triangle < 0 || fabs(t - h.t) > 1e-6 * maximum(1, t))) { mismatches++; }
+        }
+        const double brute = BRUTE_RAYS / (bench_seconds() - time);
+        printf("%9s brute force %.4f Mrays/s, mismatches %d of %d\n", "", brute / 1e6, mismatches, BRUTE_RAYS);
+    }
+    free(r.orig);
+    free(r.dir);
+    bvh_destroy(bvh);
+    bench_mesh_free(&m);
+}
+
+static const char* sizes[] = { "10000", "1000000", "10000000" };
+
+void bench_bvh(int argc, const char* argv[]) {
+    if (argc == 0) { argc = 3; argv = sizes; }
+    for (int i = 0; i < argc; i++) { run(atoi(argv[i]), bvh_create); }
+}
+
+void bench_lbvh(int argc, const char* argv[]) {
+    if (argc == 0) { argc = 3; argv = sizes; }
+    for (int i = 0; i < argc; i++) { run(atoi(argv[i]), bvh_create_linear); }
+}
+
+END_C
@@ -0,0 +1,79 @@
+#include "bench.h"
+#include "../src/bvh8.h"
+#include "../src/simd.h"
+
+BEGIN_C
+
+enum { RAYS = 1 << 20 };
+
+static void run(int triangles) {
+    bench_mesh_t m = {0};
+    if (!bench_sphere(&m, triangles, 1)) { printf("out of memory\n"); return; }
+    bvh_t* bvh = bvh_create(&m.mesh);
+    double time = bench_seconds();
+    bvh8_t* bvh8 = bvh != null ? bvh8_create(bvh) : null;
+    const double convert = bench_seconds() - time;
+    vec3f_t* orig = (vec3f_t*)malloc(sizeof(vec3f_t) * RAYS);
+    vec3f_t* dir = (vec3f_t*)malloc(sizeof(vec3f_t) * RAYS);
+    if (bvh8 == null || orig == null || dir == null) {
+        printf("out of memory\n");
+    } else {
+        uint64_t s = 2;
+        for (int i = 0; i < RAYS; i++) {
+            float o[3], t[3];
+            bench_direction(&s, o);
+            bench_direction(&s, t);
+            const float radius = bench_uniform(&s) * 1.5f;
+            for (int k = 0; k < 3; k++) { orig[i][k] = o[k] * 3; dir[i][k] = t[k] * radius - orig[i][k]; }
+        }
+        const double bytes = (double)bvh->node_count * sizeof(bvh_node_t) + bvh->triangle_count * sizeof(int32_t);
+        const double bytes8 = (double)bvh8->node_count * sizeof(bvh8_node_t) + bvh8->triangle_count * sizeof(int32_t);
+        const int n = m.mesh.triangle_count;
+        printf("%9d triangles bvh %5.1f bytes/triangle, bvh8 %5.1f bytes/triangle (%.2fx) nodes %d, convert %.3f s\n",
+               n, bytes / n, bytes8 / n, bytes / bytes8, bvh8->node_count, convert);
+        bvh_hit_t h;
+        int hits = 0;
+        time = bench_seconds();
+        for (int i = 0; i < RAYS; i++) { hits += bvh_closest_hit(bvh, orig[i], dir[i], 0, INFINITY, &h); }
+        double closest = RAYS / (bench_seconds() - time);
+        time = bench_seconds();
+        for (int i = 0; i < RAYS; i++) { hits += bvh_any_hit(bvh, orig[i], dir[i], 0, 1); }
+        double any = RAYS / (bench_seconds() - time);
+        printf("%9s %-7s closest %6.2f any %6.2f Mrays/s\n", "", "bvh", closest / 1e6, any / 1e6);
+        const int levels[] = { SIMD_SCALAR, simd_detect() };
+        for (int l = 0; l < 2; l++) {
+            simd_force(levels[l]);
+            time = bench_seconds();
+            for (int i = 0; i < RAYS; i++) { hits += bvh8_closest_hit(bvh8, orig[i], dir[i], 0, INFINITY, &h); }
+            closest = RAYS / (bench_seconds() - time);
+            time = bench_seconds();
+            for (int i = 0; i < RAYS; i++) { hits += bvh8_any_hit(bvh8, orig[i], dir[i], 0, 1); }
+            any = RAYS / (bench_seconds() - time);
+            int mismatches = 0;
+            for (int i = 0; i < RAYS; i += 16) {
+                bvh_hit_t a, b;
+                bvh_closest_hit(bvh, orig[i], dir[i], 0, INFINITY, &a);
+                bvh8_closest_hit(bvh8, orig[i], dir[i], 0, INFINITY, &b);
+                mismatches += a.triangle != b.triangle && a.t != b.t;
+                mismatches += bvh_any_hit(bvh, orig[i], dir[i], 0, 1) != bvh8_any_hit(bvh8, orig[i], dir[i], 0, 1);
+            }
+            printf("%9s bvh8 %-6s closest %6.2f any %6.2f Mrays/s, mismatches %d of %d\n", "", simd_name(simd_level()),
+                   closest / 1e6, any / 1e6, mismatches, RAYS / 16 * 2);
+        }
+        simd_force(-1);
+        if (hits < 0) { printf("\n"); } // keeps the loops
+    }
+    free(orig);
+    free(dir);
+    bvh8_destroy(bvh8);
+    bvh_destroy(bvh);
+    bench_mesh_free(&m);
+}
+
+void bench_bvh8(int argc, const char* argv[]) {
+    static const char* sizes[] = { "10000", "1000000", "10000000" };
+    if (argc == 0) { argc = 3; argv = sizes; }
+    for (int i = 0; i < argc; i++) { run(atoi(argv[i])); }
+}
+
+END_C
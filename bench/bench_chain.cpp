@@ -0,0 +1,92 @@
+#include "bench.h"
+#include "../src/math4x4.hpp"
+
+using namespace linear;
+
+BEGIN_C
+
+enum { REPEAT = 4 };
+
+/* rotation about z by a, scale s, translation t */
+static mat4x4f model(float a, float s, float tx, float ty, float tz) {
+    const float c = cosf(a) * s, n = sinf(a) * s;
+    return mat4x4f{{ c, n, 0, 0,  -n, c, 0, 0,  0, 0, s, 0,  tx, ty, tz, 1 }};
+}
+
+/* worst |a - b| / maximum(1, |b|) over n arrays of `floats` */
+static double check(const float* a, const float* b, int n, int floats) {
+    double worst = 0;
+    for (int i = 0; i < n * floats; i++) {
+        worst = maximum(worst, fabs((double)a[i] - b[i]) / maximum(1.0, fabs(b[i])));
+    }
+    return worst;
+}
+
+/* bench chain [count...]: math4x4.hpp products projection * view * model[i]
+   against two multiply_4x4f_scalar() calls, and projection * view * model[i] * p[i]
+   evaluated against apply() of it, reassociated to three matrix vector products */
+void bench_chain(int argc, const char* argv[]) {
+    const float f = 1.5f, near = 0.1f, far = 100.0f;
+    constexpr mat4x4f identity = { IDENTITY_MATRIX_4x4F };
+    const mat4x4f projection = {{ f, 0, 0, 0,  0, f, 0, 0,  0, 0, (far + near) / (near - far), -1,
+                                  0, 0, 2 * far * near / (near - far), 0 }};
+    const mat4x4f view = identity * model(0.2f, 1, 0, -1, -5);
+    const int runs = argc > 0 ? argc : 1;
+    for (int c = 0; c < runs; c++) {
+        const int n = argc > 0 ? atoi(argv[c]) : 1000000;
+        const size_t count = (size_t)maximum(1, n);
+        mat4x4f* m = (mat4x4f*)aligned_alloc(alignof(mat4x4f), sizeof(mat4x4f) * count);
+        mat4x4f* r = (mat4x4f*)aligned_alloc(alignof(mat4x4f), sizeof(mat4x4f) * count);
+        mat4x4f* expected = (mat4x4f*)aligned_alloc(alignof(mat4x4f), sizeof(mat4x4f) * count);
+        vec4f* p = (vec4f*)aligned_alloc(alignof(vec4f), sizeof(vec4f) * count);
+        vec4f* v = (vec4f*)aligned_alloc(alignof(vec4f), sizeof(vec4f) * count);
+        vec4f* w = (vec4f*)aligned_alloc(alignof(vec4f), sizeof(vec4f) * count);
+        if (m == null || r == null || expected == null || p == null || v == null || w == null) {
+            printf("out of memory\n");
+        } else {
+            uint64_t s = 0xC4A1;
+            for (int i = 0; i < n; i++) {
+                m[i] = model(bench_uniform(&s) * 6.28318530718f, 0.5f + bench_uniform(&s),
+                             bench_uniform(&s) * 4 - 2, bench_uniform(&s) * 4 - 2, bench_uniform(&s) * 4 - 2);
+                p[i] = vec4f{{ bench_uniform(&s) * 2 - 1, bench_uniform(&s) * 2 - 1, bench_uniform(&s) * 2 - 1, 1 }};
+            }
+            printf("%d instances, M/s\n", n);
+            double time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) {
+                for (int i = 0; i < n; i++) {
+                    mat4x4f_t t;
+                    multiply_4x4f_scalar(t, projection, view);
+                    multiply_4x4f_scalar(expected[i], t, m[i]);
+                }
+            }
+            const double scalar = (bench_seconds() - time) / REPEAT;
+            time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) {
+                for (int i = 0; i < n; i++) { r[i] = projection * view * m[i]; }
+            }
+            const double chain = (bench_seconds() - time) / REPEAT;
+            printf("matrix   multiply_4x4f_scalar %8.1f hpp %8.1f, %s\n", n / scalar / 1e6, n / chain / 1e6,
+                   memcmp(r, expected, sizeof(mat4x4f) * (size_t)n) == 0 ? "bit identical" : "DIFFERENT");
+            time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) {
+                for (int i = 0; i < n; i++) { v[i] = projection * view * m[i] * p[i]; }
+            }
+            const double evaluated = (bench_seconds() - time) / REPEAT;
+            time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) {
+                for (int i = 0; i < n; i++) { w[i] = apply(projection * view * m[i], p[i]); }
+            }
+            const double reassociated = (bench_seconds() - time) / REPEAT;
+            printf("vector   evaluated %8.1f reassociated %8.1f, max error %.1e\n", n / evaluated / 1e6,
+                   n / reassociated / 1e6, check(w[0], v[0], n, 4));
+        }
+        free(m);
+        free(r);
+        free(expected);
+        free(p);
+        free(v);
+        free(w);
+    }
+}
+
+END_C
@@ -0,0 +1,166 @@
+#include "bench.h"
+#include "../src/collide.h"
+#include "../ext/intersections/intersections.h"
+#include <string.h>
+
+BEGIN_C
+
+enum { REPEAT = 10, CHECK_MAX = 20000 }; /* brute force check for small meshes only */
+
+static int shares_vertex(const float* a[3], const float* b[3]) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (a[i][0] == b[j][0] && a[i][1] == b[j][1] && a[i][2] == b[j][2]) { return true; }
+        }
+    }
+    return false;
+}
+
+/* pairs collide_meshes() or collide_self() should find, with COLLIDE_EPSILON if epsilon */
+static int brute_force(const mesh_t* a, const mesh_t* b, int self, int epsilon) {
+    int count = 0;
+    for (int i = 0; i < a->triangle_count; i++) {
+        const float* va[3];
+        mesh_triangle(a, i, va);
+        float amin[3], amax[3], v[3][3];
+        for (int k = 0; k < 3; k++) {
+            amin[k] = minimum(va[0][k], minimum(va[1][k], va[2][k]));
+            amax[k] = maximum(va[0][k], maximum(va[1][k], va[2][k]));
+            for (int n = 0; n < 3; n++) { v[n][k] = va[n][k]; }
+        }
+        for (int j = self ? i + 1 : 0; j < b->triangle_count; j++) {
+            const float* vb[3];
+            mesh_triangle(b, j, vb);
+            if (self && shares_vertex(va, vb)) { continue; }
+            float u[3][3];
+            int overlap = 1;
+            for (int k = 0; k < 3; k++) {
+                overlap &= maximum(vb[0][k], maximum(vb[1][k], vb[2][k])) >= amin[k];
+                overlap &= minimum(vb[0][k], minimum(vb[1][k], vb[2][k])) <= amax[k];
+                for (int n = 0; n < 3; n++) { u[n][k] = vb[n][k]; }
+            }
+            if (overlap) {
+                count += epsilon ? no_div_tri_tri_intersect(v[0], v[1], v[2], u[0], u[1], u[2]) :
+                                   robust_tri_tri_intersect(v[0], v[1], v[2], u[0], u[1], u[2]);
+            }
+        }
+    }
+    return count;
+}
+
+static double best_of(const bvh_t* a, const bvh_t* b, int flags, int* count) {
+    double best = INFINITY;
+    for (int r = 0; r < REPEAT; r++) {
+        const double time = bench_seconds();
+        collide_t* c = collide_meshes(a, b, flags);
+        best = minimum(best, bench_seconds() - time);
+        *count = c != null ? c->count : -1;
+        collide_destroy(c);
+    }
+    return best;
+}
+
+/* two bumpy spheres of radius ~1 with centers 1 apart: a circle of contacts */
+static void run(int triangles) {
+    bench_mesh_t m0 = {0}, m1 = {0};
+    if (!bench_sphere(&m0, triangles, 1) || !bench_sphere(&m1, triangles, 2)) {
+        printf("out of memory\n");
+    } else {
+        for (int i = 0; i < m1.mesh.vertex_count; i++) { m1.vertices[i][0] += 1; m1.vertices[i][1] += 0.1f; }
+        bvh_t* a = bvh_create(&m0.mesh);
+        bvh_t* b = bvh_create(&m1.mesh);
+        if (a == null || b == null) {
+            printf("out of memory\n");
+        } else {
+            int pairs = 0, segments = 0, epsilon_pairs = 0;
+            const double test = best_of(a, b, 0, &pairs);
+            const double line = best_of(a, b, COLLIDE_SEGMENTS, &segments);
+            const double epsilon = best_of(a, b, COLLIDE_EPSILON, &epsilon_pairs);
+            printf("%9d x %d triangles %6d pairs %7.3f ms, with segments %6d pairs %7.3f ms, epsilon %6d pairs %7.3f ms",
+                   m0.mesh.triangle_count, m1.mesh.triangle_count, pairs, test * 1e3, segments, line * 1e3,
+                   epsilon_pairs, epsilon * 1e3);
+            if (triangles <= CHECK_MAX) {
+                printf(", brute force %d and %d pairs", brute_force(&m0.mesh, &m1.mesh, false, false),
+                       brute_force(&m0.mesh, &m1.mesh, false, true));
+            }
+            printf("\n");
+        }
+        bvh_destroy(a);
+        bvh_destroy(b);
+    }
+    bench_mesh_free(&m0);
+    bench_mesh_free(&m1);
+}
+
+/* a triangle much smaller than EPSILON crossing the plane of a large one:
+   only the large one looks coplanar to the epsilon test, which left the
+   interval of the second triangle of tri_tri_intersect_line() uninitialised */
+static void check_isectline(void) {
+    float v[3][3] = { { 0, 0, -1e-4f }, { 1e-4f, 0, 1e-4f }, { 0, 1e-4f, 1e-4f } };
+    float u[3][3] = { { -1, -1, 0 }, { 1, -1, 0 }, { 0, 1, 0 } };
+    float a[3], b[3];
+    int coplanar = 0;
+    const int hit = tri_tri_intersect_line(v[0], v[1], v[2], u[0], u[1], u[2], &coplanar, a, b);
+    printf("tri_tri_intersect_line small triangle through a large one: hit %d coplanar %d (expected 1 1)\n",
+           hit, coplanar);
+}
+
+/* one mesh of two interpenetrating spheres of triangles / 2 each */
+static void run_self(int triangles) {
+    bench_mesh_t m0 = {0}, m1 = {0};
+    vec3f_t* vertices = null;
+    int32_t* indices = null;
+    if (bench_sphere(&m0, triangles / 2, 1) && bench_sphere(&m1, triangles / 2, 2)) {
+        vertices = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)(m0.mesh.vertex_count + m1.mesh.vertex_count));
+        indices = (int32_t*)malloc(sizeof(int32_t) * 3 * (size_t)(m0.mesh.triangle_count + m1.mesh.triangle_count));
+    }
+    if (vertices == null || indices == null) {
+        printf("out of memory\n");
+    } else {
+        const int nv = m0.mesh.vertex_count, nt = m0.mesh.triangle_count;
+        memcpy(vertices, m0.vertices, sizeof(vec3f_t) * (size_t)nv);
+        memcpy(indices, m0.indices, sizeof(int32_t) * 3 * (size_t)nt);
+        for (int i = 0; i < m1.mesh.vertex_count; i++) {
+            vertices[nv + i][0] = m1.vertices[i][0] + 1;
+            vertices[nv + i][1] = m1.vertices[i][1] + 0.1f;
+            vertices[nv + i][2] = m1.vertices[i][2];
+        }
+        for (int i = 0; i < m1.mesh.triangle_count * 3; i++) { indices[nt * 3 + i] = m1.indices[i] + nv; }
+        const mesh_t mesh = { vertices, indices, nv + m1.mesh.vertex_count, nt + m1.mesh.triangle_count };
+        double time = bench_seconds();
+        bvh_t* bvh = bvh_create(&mesh);
+        const double build = bench_seconds() - time;
+        time = bench_seconds();
+        collide_t* c = bvh != null ? collide_self(bvh, COLLIDE_SEGMENTS) : null;
+        const double query = bench_seconds() - time;
+        if (c == null) {
+            printf("out of memory\n");
+        } else {
+            printf("%9d triangles build %7.3f s, self intersection %6d pairs %7.3f s",
+                   mesh.triangle_count, build, c->count, query);
+            if (mesh.triangle_count <= CHECK_MAX) { printf(", brute force %d pairs", brute_force(&mesh, &mesh, true, false)); }
+            printf("\n");
+        }
+        collide_destroy(c);
+        bvh_destroy(bvh);
+    }
+    free(vertices);
+    free(indices);
+    bench_mesh_free(&m0);
+    bench_mesh_free(&m1);
+}
+
+void bench_self(int argc, const char* argv[]) {
+    static const char* sizes[] = { "10000", "100000", "2000000" };
+    if (argc == 0) { argc = 3; argv = sizes; }
+    for (int i = 0; i < argc; i++) { run_self(atoi(argv[i])); }
+}
+
+void bench_collide(int argc, const char* argv[]) {
+    check_isectline();
+    static const char* sizes[] = { "10000", "100000", "1000000" };
+    if (argc == 0) { argc = 3; argv = sizes; }
+    for (int i = 0; i < argc; i++) { run(atoi(argv[i])); }
+}
+
+END_C
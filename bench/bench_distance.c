@@ -0,0 +1,183 @@
+#include "bench.h"
+#include "../src/distance.h"
+#include "../src/simd.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+enum { KERNEL_COUNT = 1000, BATCH = 13, CHECK_POINTS = 2000, CHECK_MAX = 20000 };
+
+static void random_triangle(uint64_t* s, float t[3][3], float scale) {
+    for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) { t[j][k] = (bench_uniform(s) * 2 - 1) * scale; }
+    }
+    const float r = bench_uniform(s);
+    if (r < 0.05f) { memcpy(t[1], t[0], sizeof(t[0])); } // degenerate: segment
+    else if (r < 0.1f) { memcpy(t[1], t[0], sizeof(t[0])); memcpy(t[2], t[0], sizeof(t[0])); } // point
+}
+
+/* batches against the scalar kernels, triangle distance against sampled point distances */
+static void check_kernels(void) {
+    uint64_t s = 0x5EED;
+    float v[9][BATCH], d2[BATCH], c[3][BATCH], b[3][BATCH];
+    const float* const vc[9] = { v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8] };
+    float* const cc[3] = { c[0], c[1], c[2] };
+    float* const bc[3] = { b[0], b[1], b[2] };
+    const int levels[] = { SIMD_SCALAR, simd_detect() };
+    for (int l = 0; l < 2; l++) {
+        simd_force(levels[l]);
+        float error = 0;
+        int sampled = 0;
+        for (int r = 0; r < KERNEL_COUNT; r++) {
+            float p[3], t[3][3], u[BATCH][3][3];
+            for (int k = 0; k < 3; k++) { p[k] = bench_uniform(&s) * 2 - 1; }
+            random_triangle(&s, t, 1);
+            for (int i = 0; i < BATCH; i++) {
+                random_triangle(&s, u[i], 1);
+                for (int j = 0; j < 9; j++) { v[j][i] = u[i][j / 3][j % 3]; }
+            }
+            point_triangles_distance2(p, vc, BATCH, d2, cc);
+            for (int i = 0; i < BATCH; i++) {
+                float q[3];
+                const float e = point_triangle_distance2(p, u[i][0], u[i][1], u[i][2], q);
+                error = maximum(error, fabsf(e - d2[i]));
+            }
+            triangle_triangles_distance2((const float (*)[3])t, vc, BATCH, d2, cc, bc);
+            for (int i = 0; i < BATCH; i++) {
+                float a[3], q[3];
+                const float e = triangle_triangle_distance2((const float (*)[3])t, (const float (*)[3])u[i], a, q);
+                error = maximum(error, fabsf(e - d2[i]));
+                // no point of t may be nearer to u[i] than the reported distance
+                for (int k = 0; k < 8 && r % 8 == 0; k++) {
+                    float x = bench_uniform(&s), y = bench_uniform(&s);
+                    if (x + y > 1) { x = 1 - x; y = 1 - y; }
+                    for (int j = 0; j < 3; j++) { p[j] = t[0][j] + (t[1][j] - t[0][j]) * x + (t[2][j] - t[0][j]) * y; }
+                    const float f = point_triangle_distance2(p, u[i][0], u[i][1], u[i][2], null);
+                    sampled += sqrtf(f) < sqrtf(e) - 1e-5f;
+                }
+            }
+        }
+        printf("kernels %-6s max |batch - scalar| %.3g, sampled points nearer than triangle distance %d\n",
+               simd_name(simd_level()), error, sampled);
+    }
+    simd_force(-1);
+}
+
+static float brute_point(const mesh_t* m, const float p[3]) {
+    float best = INFINITY;
+    for (int i = 0; i < m->triangle_count; i++) {
+        const float* v[3];
+        mesh_triangle(m, i, v);
+        best = minimum(best, point_triangle_distance2(p, v[0], v[1], v[2], null));
+    }
+    return sqrtf(best);
+}
+
+static float brute_mesh(const mesh_t* a, const mesh_t* b) {
+    float best = INFINITY;
+    for (int i = 0; i < a->triangle_count; i++) {
+        float t[3][3];
+        const float* v[3];
+        mesh_triangle(a, i, v);
+        for (int k = 0; k < 3; k++) { memcpy(t[k], v[k], sizeof(t[k])); }
+        for (int j = 0; j < b->triangle_count; j++) {
+            float u[3][3];
+            mesh_triangle(b, j, v);
+            for (int k = 0; k < 3; k++) { memcpy(u[k], v[k], sizeof(u[k])); }
+            best = minimum(best, triangle_triangle_distance2((const float (*)[3])t, (const float (*)[3])u, null, null));
+        }
+    }
+    return sqrtf(best);
+}
+
+static void run_points(const bench_mesh_t* m, const bvh_t* bvh, int count) {
+    vec3f_t* points = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)count);
+    bvh_closest_t* c = (bvh_closest_t*)malloc(sizeof(bvh_closest_t) * (size_t)count);
+    if (points == null || c == null) {
+        printf("out of memory\n");
+    } else {
+        uint64_t s = 0xD15;
+        for (int i = 0; i < count; i++) {
+            const float r = 0.9f + bench_uniform(&s) * 0.2f; // near the surface
+            bench_direction(&s, points[i]);
+            for (int k = 0; k < 3; k++) { points[i][k] *= r; }
+        }
+        const double time = bench_seconds();
+        bvh_closest_points(bvh, points, count, INFINITY, c);
+        const double seconds = bench_seconds() - time;
+        int mismatches = 0, checked = 0;
+        if (m->mesh.triangle_count <= CHECK_MAX) {
+            for (int i = 0; i < count; i += maximum(1, count / CHECK_POINTS)) {
+                const float e = brute_point(&m->mesh, points[i]);
+                mismatches += fabsf(e - c[i].distance) > 1e-5f * maximum(1, e);
+                checked++;
+            }
+        }
+        // bounded queries find only the points nearer than max_distance
+        int near = 0, bounded = 0;
+        for (int i = 0; i < minimum(count, CHECK_POINTS); i++) {
+            bvh_closest_t q;
+            near += c[i].distance < 0.05f;
+            bounded += bvh_closest_point(bvh, points[i], 0.05f, &q) && q.distance == c[i].distance;
+        }
+        printf("%9d points %7.3f s %6.2f Mpoints/s, mismatches %d of %d, bounded %d of %d\n",
+               count, seconds, count / seconds / 1e6, mismatches, checked, bounded, near);
+    }
+    free(points);
+    free(c);
+}
+
+static void run_meshes(int triangles, float offset) {
+    bench_mesh_t m0 = {0}, m1 = {0};
+    if (!bench_sphere(&m0, triangles, 1) || !bench_sphere(&m1, triangles, 2)) {
+        printf("out of memory\n");
+    } else {
+        for (int i = 0; i < m1.mesh.vertex_count; i++) { m1.vertices[i][0] += offset; m1.vertices[i][1] += 0.1f; }
+        bvh_t* a = bvh_create(&m0.mesh);
+        bvh_t* b = bvh_create(&m1.mesh);
+        if (a == null || b == null) {
+            printf("out of memory\n");
+        } else {
+            bvh_distance_t d;
+            const double time = bench_seconds();
+            const int found = bvh_mesh_distance(a, b, INFINITY, &d);
+            const double seconds = bench_seconds() - time;
+            printf("%9d x %d triangles offset %.1f distance %.6f (%d %d) %7.3f ms",
+                   m0.mesh.triangle_count, m1.mesh.triangle_count, offset, found ? d.distance : -1,
+                   d.triangle_a, d.triangle_b, seconds * 1e3);
+            if (triangles <= CHECK_MAX / 10) { printf(", brute force %.6f", brute_mesh(&m0.mesh, &m1.mesh)); }
+            printf("\n");
+        }
+        bvh_destroy(a);
+        bvh_destroy(b);
+    }
+    bench_mesh_free(&m0);
+    bench_mesh_free(&m1);
+}
+
+/* bench distance [triangles [points]] */
+void bench_distance(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    const int points = argc > 1 ? atoi(argv[1]) : 1000000;
+    check_kernels();
+    const int sizes[] = { 10000, triangles };
+    for (int i = 0; i < 2; i++) {
+        bench_mesh_t m = {0};
+        bvh_t* bvh = null;
+        if (!bench_sphere(&m, sizes[i], 1) || (bvh = bvh_create(&m.mesh)) == null) {
+            printf("out of memory\n");
+        } else {
+            printf("%d triangles, %d threads\n", m.mesh.triangle_count, threads_count());
+            run_points(&m, bvh, i == 0 ? CHECK_POINTS * 10 : points);
+        }
+        bvh_destroy(bvh);
+        bench_mesh_free(&m);
+    }
+    const float offsets[] = { 3, 1 }; // apart and interpenetrating
+    for (int i = 0; i < 2; i++) {
+        run_meshes(1000, offsets[i]);
+        run_meshes(triangles, offsets[i]);
+    }
+}
+
+END_C
@@ -0,0 +1,527 @@
+#include "bench.h"
+#include <string.h>
+#include "../ext/counters.h"
+#include "../ext/intersect_triangle.h"
+#include "../ext/intersections/intersections.h"
+#include "../ext/intersections/fromtorot_simd.h"
+#include "../ext/intersections/tritri_simd.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS() __rdtsc()
+#else
+#define TICKS() 0ULL /* no cycle counter: cycles/test are reported as 0 */
+#endif
+
+/* Every ext/ kernel against five seeded workloads:
+     uniform        random placement
+     near-coplanar  triangles 1.0e-6 off each other's plane, rays and
+                    triangles 1.0e-5 off the plane of the triangle or box
+                    face, rotations 1.0e-4..1.0e-6 off (anti)parallel
+     grazing        touching at edges and corners within 1.0e-6,
+                    rotations around the near parallel switch
+     all-hit        every test intersects, rotations exactly (anti)parallel
+     all-miss       none does (but most are not trivially rejected),
+                    rotations between 10 and 170 degrees
+   hit ratio of rotations is the fraction of near parallel cases.
+   no_div_tri_tri_1x16 and no_div_tri_tri_intersect_n run the same cases
+   with the first triangle shared by FAN of them, scalar and batched.
+   Built with -DEXT_COUNTERS every row is followed by the exits of
+   ext/counters.h per test. */
+
+BEGIN_C
+
+/* cases are repeated, with a few thousand the branch predictor learns
+   the outcomes and all-hit and all-miss look as fast as ideal */
+enum { CASES = 16 * 1024, TRIALS = 5 };
+
+enum { FAN = 16 }; /* triangles against one in the 1 vs N rows */
+
+#define MIN_TIME 0.02 /* seconds per trial */
+#define THRESHOLD 10.0 /* percent */
+
+static const char* workloads[] = { "uniform", "near-coplanar", "grazing", "all-hit", "all-miss" };
+
+enum { UNIFORM, COPLANAR, GRAZING, HIT, MISS, WORKLOADS };
+
+typedef struct cases_s {
+    float v[CASES][3][3];  // triangle
+    float u[CASES][3][3];  // second triangle
+    float us[9][CASES];    // u as structure of arrays for no_div_tri_tri_intersect_n()
+    float o[CASES][3], d[CASES][3];      // ray or box center and half size or from and to
+    double vd[CASES][3][3], od[CASES][3], dd[CASES][3]; // double copies of v, o, d
+    float soa[6][CASES];   // o, d as structure of arrays for from_to_rotations()
+    float m[9][CASES];     // rotations
+    int parallel;          // near parallel rotations
+} cases_t;
+
+static void add(float r[3], const float a[3], const float b[3], float s) {
+    for (int k = 0; k < 3; k++) { r[k] = a[k] + b[k] * s; }
+}
+
+static float dot(const float a[3], const float b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static void normalize(float a[3]) {
+    const float l = sqrtf(dot(a, a));
+    for (int k = 0; k < 3; k++) { a[k] /= l; }
+}
+
+/* unit vectors t, b orthogonal to n */
+static void tangents(const float n[3], float t[3], float b[3]) {
+    const float x[3] = { 1, 0, 0 }, y[3] = { 0, 1, 0 };
+    const float* a = fabsf(n[0]) < 0.5f ? x : y;
+    t[0] = a[1] * n[2] - a[2] * n[1]; t[1] = a[2] * n[0] - a[0] * n[2]; t[2] = a[0] * n[1] - a[1] * n[0];
+    normalize(t);
+    b[0] = n[1] * t[2] - n[2] * t[1]; b[1] = n[2] * t[0] - n[0] * t[2]; b[2] = n[0] * t[1] - n[1] * t[0];
+}
+
+/* well shaped triangle of circumradius r around c in the plane with normal n */
+static void triangle(uint64_t* s, const float c[3], const float n[3], float r, float v[3][3]) {
+    float t[3], b[3];
+    tangents(n, t, b);
+    const float phi = bench_uniform(s) * 6.28318530718f;
+    for (int i = 0; i < 3; i++) {
+        const float a = phi + i * 2.09439510239f;
+        add(v[i], c, t, r * cosf(a));
+        add(v[i], v[i], b, r * sinf(a));
+    }
+}
+
+static void random_point(uint64_t* s, float p[3], float extent) {
+    for (int k = 0; k < 3; k++) { p[k] = (bench_uniform(s) - 0.5f) * extent; }
+}
+
+static void random_triangle(uint64_t* s, float v[3][3], float n[3]) {
+    float c[3];
+    random_point(s, c, 1);
+    bench_direction(s, n);
+    triangle(s, c, n, 0.2f + bench_uniform(s) * 0.2f, v);
+}
+
+/* point of triangle v at barycentric (b1, b2) */
+static void point(const float v[3][3], float b1, float b2, float p[3]) {
+    for (int k = 0; k < 3; k++) { p[k] = v[0][k] + (v[1][k] - v[0][k]) * b1 + (v[2][k] - v[0][k]) * b2; }
+}
+
+/* barycentric coordinates strictly inside (margin > 0) or outside (margin < 0) */
+static void barycentric(uint64_t* s, float margin, float* b1, float* b2) {
+    if (margin > 0) {
+        do {
+            *b1 = bench_uniform(s); *b2 = bench_uniform(s);
+        } while (*b1 < margin || *b2 < margin || 1 - *b1 - *b2 < margin);
+    } else {
+        do {
+            *b1 = bench_uniform(s) * 3 - 1; *b2 = bench_uniform(s) * 3 - 1;
+        } while (*b1 >= margin && *b2 >= margin && 1 - *b1 - *b2 >= margin);
+    }
+}
+
+static float sign(uint64_t* s) { return bench_random(s) & 1 ? 1.0f : -1.0f; }
+
+/* groups of cases share the first triangle (1 vs N kernels), group 1: pairs */
+static void triangle_groups(cases_t* c, int w, uint64_t* s, int group) {
+    float n[3];
+    for (int i = 0; i < CASES; i++) {
+        float m[3], p[3], q[3], t[3], b[3];
+        if (i % group == 0) {
+            random_triangle(s, c->v[i], n);
+        } else {
+            memcpy(c->v[i], c->v[i - 1], sizeof(c->v[i]));
+        }
+        float b1, b2;
+        switch (w) {
+            case UNIFORM:
+                random_triangle(s, c->u[i], m);
+                break;
+            case COPLANAR: // overlapping footprints, 1.0e-6 off the plane
+                barycentric(s, 0.1f, &b1, &b2);
+                point(c->v[i], b1, b2, p);
+                add(p, p, n, sign(s) * 1.0e-6f);
+                triangle(s, p, n, 0.2f, c->u[i]);
+                break;
+            case GRAZING: // one vertex within 1.0e-6 of an edge, the others on one side of the plane
+                point(c->v[i], bench_uniform(s), 0, p);
+                add(c->u[i][0], p, n, sign(s) * 1.0e-6f);
+                tangents(n, t, b);
+                for (int j = 1; j < 3; j++) {
+                    add(q, p, n, 0.3f);
+                    add(c->u[i][j], q, j == 1 ? t : b, 0.3f * sign(s));
+                }
+                break;
+            case HIT: case MISS: // small triangle piercing the plane at p inside or outside
+                barycentric(s, w == HIT ? 0.25f : -0.25f, &b1, &b2);
+                point(c->v[i], b1, b2, p);
+                tangents(n, t, b);
+                add(q, p, n, 0.1f);
+                add(c->u[i][0], q, t, 0.02f);
+                add(c->u[i][1], q, t, -0.02f);
+                add(c->u[i][2], p, n, -0.1f);
+                break;
+        }
+        for (int k = 0; k < 9; k++) { c->us[k][i] = c->u[i][k / 3][k % 3]; }
+    }
+}
+
+static void triangle_pairs(cases_t* c, int w, uint64_t* s) { triangle_groups(c, w, s, 1); }
+
+static void triangle_fans(cases_t* c, int w, uint64_t* s) { triangle_groups(c, w, s, FAN); }
+
+static void rays(cases_t* c, int w, uint64_t* s) {
+    for (int i = 0; i < CASES; i++) {
+        float n[3], p[3] = {0}, t[3], b[3], e[3];
+        random_triangle(s, c->v[i], n);
+        float b1, b2;
+        switch (w) {
+            case UNIFORM:
+                bench_direction(s, c->o[i]);
+                add(c->o[i], c->o[i], c->o[i], 1); // radius 2
+                random_point(s, p, 1);
+                break;
+            case COPLANAR: // 1.0e-5 off the plane of the triangle
+                barycentric(s, bench_random(s) & 1 ? 0.1f : -0.1f, &b1, &b2);
+                point(c->v[i], b1, b2, p);
+                tangents(n, t, b);
+                add(c->o[i], p, t, 1);
+                add(c->o[i], c->o[i], n, sign(s) * 1.0e-5f);
+                break;
+            case GRAZING: // through a point 1.0e-6 off an edge in the plane
+                point(c->v[i], bench_uniform(s), 0, p);
+                for (int k = 0; k < 3; k++) { e[k] = c->v[i][1][k] - c->v[i][0][k]; }
+                t[0] = n[1] * e[2] - n[2] * e[1]; t[1] = n[2] * e[0] - n[0] * e[2]; t[2] = n[0] * e[1] - n[1] * e[0];
+                normalize(t);
+                add(p, p, t, sign(s) * 1.0e-6f);
+                bench_direction(s, e);
+                add(c->o[i], p, n, sign(s));
+                add(c->o[i], c->o[i], e, 0.5f);
+                break;
+            case HIT: case MISS:
+                barycentric(s, w == HIT ? 0.1f : -0.1f, &b1, &b2);
+                point(c->v[i], b1, b2, p);
+                bench_direction(s, e);
+                add(c->o[i], p, n, sign(s));
+                add(c->o[i], c->o[i], e, 0.5f);
+                break;
+        }
+        for (int k = 0; k < 3; k++) { c->d[i][k] = p[k] - c->o[i][k]; } // hits at t = 1
+    }
+}
+
+static void boxes(cases_t* c, int w, uint64_t* s) {
+    for (int i = 0; i < CASES; i++) {
+        float* center = c->o[i];
+        float* half = c->d[i];
+        float n[3], p[3], e[3];
+        random_point(s, center, 1);
+        for (int k = 0; k < 3; k++) { half[k] = 0.1f + bench_uniform(s) * 0.2f; }
+        switch (w) {
+            case UNIFORM:
+                random_triangle(s, c->v[i], n);
+                break;
+            case COPLANAR: { // 1.0e-6 off the +z face over it
+                const float z[3] = { 0, 0, 1 };
+                p[0] = center[0] + (bench_uniform(s) - 0.5f) * half[0];
+                p[1] = center[1] + (bench_uniform(s) - 0.5f) * half[1];
+                p[2] = center[2] + half[2] + sign(s) * 1.0e-6f;
+                triangle(s, p, z, 0.2f, c->v[i]);
+                break;
+            }
+            case GRAZING: // a vertex 1.0e-6 off a corner, the rest outside
+                for (int k = 0; k < 3; k++) {
+                    e[k] = sign(s);
+                    p[k] = center[k] + e[k] * half[k];
+                }
+                normalize(e);
+                add(c->v[i][0], p, e, sign(s) * 1.0e-6f);
+                bench_direction(s, n);
+                if (dot(n, e) < 0) { add(n, n, n, -2); }
+                add(c->v[i][1], p, n, 0.3f);
+                add(c->v[i][1], c->v[i][1], e, 0.1f);
+                add(c->v[i][2], p, e, 0.3f);
+                break;
+            case HIT: // around the center
+                bench_direction(s, n);
+                triangle(s, center, n, 0.1f + bench_uniform(s) * 0.3f, c->v[i]);
+                break;
+            case MISS: { // bounding spheres apart
+                bench_direction(s, e);
+                const float r = 0.1f + bench_uniform(s) * 0.3f;
+                add(p, center, e, sqrtf(dot(half, half)) + r + 0.01f);
+                bench_direction(s, n);
+                triangle(s, p, n, r, c->v[i]);
+                break;
+            }
+        }
+    }
+}
+
+static void rotations(cases_t* c, int w, uint64_t* s) {
+    c->parallel = 0;
+    for (int i = 0; i < CASES; i++) {
+        float* from = c->o[i];
+        float* to = c->d[i];
+        float t[3], b[3];
+        bench_direction(s, from);
+        bench_direction(s, to);
+        const float side = sign(s);
+        switch (w) {
+            case UNIFORM: break;
+            case COPLANAR:
+                tangents(from, t, b);
+                for (int k = 0; k < 3; k++) { to[k] = side * from[k] + t[k] * powf(10, -4 - 2 * bench_uniform(s)); }
+                normalize(to);
+                break;
+            case GRAZING: { // 1 - |from . to| within 1.0e-6 * [0.5..1.5]
+                const float a = sqrtf(2.0e-6f * (0.5f + bench_uniform(s)));
+                tangents(from, t, b);
+                for (int k = 0; k < 3; k++) { to[k] = side * from[k] * cosf(a) + t[k] * sinf(a); }
+                break;
+            }
+            case HIT:
+                for (int k = 0; k < 3; k++) { to[k] = side * from[k]; }
+                break;
+            case MISS:
+                while (fabsf(dot(from, to)) > 0.9848f) { bench_direction(s, to); } // cos(10)
+                break;
+        }
+        c->parallel += fabsf(dot(from, to)) > 1.0f - 0.000001f;
+        for (int k = 0; k < 3; k++) { c->soa[k][i] = from[k]; c->soa[3 + k][i] = to[k]; }
+    }
+}
+
+static int run_intersect_triangle(cases_t* c) {
+    int hits = 0;
+    double t, u, v;
+    for (int i = 0; i < CASES; i++) {
+        hits += intersect_triangle(c->od[i], c->dd[i], c->vd[i][0], c->vd[i][1], c->vd[i][2], &t, &u, &v);
+    }
+    return hits;
+}
+
+static int run_intersect_triangle_f(cases_t* c) {
+    int hits = 0;
+    float t, u, v;
+    for (int i = 0; i < CASES; i++) {
+        hits += intersect_triangle_f(c->o[i], c->d[i], c->v[i][0], c->v[i][1], c->v[i][2], &t, &u, &v);
+    }
+    return hits;
+}
+
+static int run_intersect_triangle_occluded_f(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i++) {
+        hits += intersect_triangle_occluded_f(c->o[i], c->d[i], c->v[i][0], c->v[i][1], c->v[i][2], 0, 2);
+    }
+    return hits;
+}
+
+static int run_no_div_tri_tri_intersect(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i++) {
+        hits += no_div_tri_tri_intersect(c->v[i][0], c->v[i][1], c->v[i][2], c->u[i][0], c->u[i][1], c->u[i][2]);
+    }
+    return hits;
+}
+
+static int run_no_div_tri_tri_intersect_n(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i += FAN) {
+        const float* u[9];
+        for (int k = 0; k < 9; k++) { u[k] = c->us[k] + i; }
+        hits += __builtin_popcountll(no_div_tri_tri_intersect_n(c->v[i][0], c->v[i][1], c->v[i][2], u, FAN));
+    }
+    return hits;
+}
+
+static int run_robust_tri_tri_intersect(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i++) {
+        hits += robust_tri_tri_intersect(c->v[i][0], c->v[i][1], c->v[i][2], c->u[i][0], c->u[i][1], c->u[i][2]);
+    }
+    return hits;
+}
+
+static int run_tri_tri_intersect(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i++) {
+        hits += tri_tri_intersect(c->v[i][0], c->v[i][1], c->v[i][2], c->u[i][0], c->u[i][1], c->u[i][2]);
+    }
+    return hits;
+}
+
+static int run_tri_tri_intersect_line(cases_t* c) {
+    int hits = 0, coplanar;
+    float p[3], q[3];
+    for (int i = 0; i < CASES; i++) {
+        hits += tri_tri_intersect_line(c->v[i][0], c->v[i][1], c->v[i][2], c->u[i][0], c->u[i][1], c->u[i][2],
+                                       &coplanar, p, q);
+    }
+    return hits;
+}
+
+static int run_tri_box_overlap(cases_t* c) {
+    int hits = 0;
+    for (int i = 0; i < CASES; i++) { hits += triBoxOverlap(c->o[i], c->d[i], c->v[i]); }
+    return hits;
+}
+
+static int run_from_to_rotation(cases_t* c) {
+    for (int i = 0; i < CASES; i++) {
+        float m[3][3];
+        fromToRotation(c->o[i], c->d[i], m);
+        for (int k = 0; k < 9; k++) { c->m[k][i] = m[k / 3][k % 3]; }
+    }
+    return c->parallel;
+}
+
+static int run_from_to_rotations(cases_t* c) {
+    const float* from[3] = { c->soa[0], c->soa[1], c->soa[2] };
+    const float* to[3] = { c->soa[3], c->soa[4], c->soa[5] };
+    float* m[9];
+    for (int k = 0; k < 9; k++) { m[k] = c->m[k]; }
+    from_to_rotations(from, to, CASES, m, null);
+    return c->parallel;
+}
+
+static const struct {
+    const char* name;
+    void (*generate)(cases_t* c, int workload, uint64_t* seed);
+    int (*run)(cases_t* c); // returns hits
+} kernels[] = {
+    { "intersect_triangle",            rays,           run_intersect_triangle },
+    { "intersect_triangle_f",          rays,           run_intersect_triangle_f },
+    { "intersect_triangle_occluded_f", rays,           run_intersect_triangle_occluded_f },
+    { "no_div_tri_tri_intersect",      triangle_pairs, run_no_div_tri_tri_intersect },
+    { "no_div_tri_tri_1x16",           triangle_fans,  run_no_div_tri_tri_intersect },
+    { "no_div_tri_tri_intersect_n",    triangle_fans,  run_no_div_tri_tri_intersect_n },
+    { "robust_tri_tri_intersect",      triangle_pairs, run_robust_tri_tri_intersect },
+    { "tri_tri_intersect",             triangle_pairs, run_tri_tri_intersect },
+    { "tri_tri_intersect_line",        triangle_pairs, run_tri_tri_intersect_line },
+    { "triBoxOverlap",                 boxes,          run_tri_box_overlap },
+    { "fromToRotation",                rotations,      run_from_to_rotation },
+    { "from_to_rotations",             rotations,      run_from_to_rotations },
+};
+
+enum { KERNELS = sizeof(kernels) / sizeof(kernels[0]) };
+
+typedef struct result_s {
+    double ns, cycles, hit;
+} result_t;
+
+/* best of TRIALS, each repeating the cases for at least MIN_TIME */
+static result_t measure(int k, cases_t* c) {
+    result_t r = { 0, 0, (double)kernels[k].run(c) / CASES };
+    int repeat = 1;
+    for (;;) {
+        const double time = bench_seconds();
+        for (int i = 0; i < repeat; i++) { kernels[k].run(c); }
+        if (bench_seconds() - time >= MIN_TIME) { break; }
+        repeat *= 2;
+    }
+    for (int t = 0; t < TRIALS; t++) {
+        const uint64_t ticks = TICKS();
+        const double time = bench_seconds();
+        for (int i = 0; i < repeat; i++) { kernels[k].run(c); }
+        const double ns = (bench_seconds() - time) * 1e9 / ((double)repeat * CASES);
+        if (t == 0 || ns < r.ns) {
+            r.ns = ns;
+            r.cycles = (double)(TICKS() - ticks) / ((double)repeat * CASES);
+        }
+    }
+    return r;
+}
+
+/* exits of one pass over the cases when built with -DEXT_COUNTERS */
+static void print_counters(int k, cases_t* c) {
+    uint64_t counts[COUNTER_COUNT];
+    ext_counters_reset();
+    kernels[k].run(c);
+    ext_counters_read(counts);
+    int first = true;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (counts[i] != 0) {
+            printf("%s%s %.3f", first ? "    " : ", ", ext_counter_name(i), (double)counts[i] / CASES);
+            first = false;
+        }
+    }
+    if (!first) { printf("\n"); }
+}
+
+/* ns of a kernel and workload in baseline, 0 when absent, hit ratio in *hit */
+static double baseline_ns(const char* baseline, const char* kernel, const char* workload, double* hit) {
+    FILE* f = baseline != null ? fopen(baseline, "r") : null;
+    double ns = 0;
+    char line[256], name[64], work[32];
+    while (f != null && ns == 0 && fgets(line, sizeof(line), f) != null) {
+        double n, rate, cycles, h;
+        if (sscanf(line, " {\"kernel\": \"%63[^\"]\", \"workload\": \"%31[^\"]\", \"ns\": %lf, "
+                         "\"tests_per_s\": %lf, \"cycles\": %lf, \"hit\": %lf", name, work, &n, &rate, &cycles, &h) == 6 &&
+            strcmp(name, kernel) == 0 && strcmp(work, workload) == 0) {
+            ns = n;
+            *hit = h;
+        }
+    }
+    if (f != null) { fclose(f); }
+    return ns;
+}
+
+/* bench ext [results.json|- [baseline.json [threshold%]]]
+   exits with 1 when any kernel is slower than baseline by more than
+   threshold (10% by default) or its hit ratio differs */
+void bench_ext(int argc, const char* argv[]) {
+    const char* output = argc > 0 && strcmp(argv[0], "-") != 0 ? argv[0] : null;
+    const char* baseline = argc > 1 ? argv[1] : null;
+    const double threshold = argc > 2 ? atof(argv[2]) : THRESHOLD;
+    if (baseline != null) {
+        FILE* f = fopen(baseline, "r");
+        if (f == null) { printf("cannot open %s\n", baseline); exit(1); }
+        fclose(f);
+    }
+    cases_t* c = (cases_t*)malloc(sizeof(cases_t));
+    FILE* json = output != null ? fopen(output, "w") : null;
+    if (c == null || (output != null && json == null)) { printf("out of memory or cannot write %s\n", output); exit(1); }
+    if (json != null) { fprintf(json, "{\n  \"cases\": %d,\n  \"benchmarks\": [\n", CASES); }
+    printf("%-30s %-14s %9s %9s %8s %6s%s\n", "kernel", "workload", "ns/test", "Mtests/s", "cycles", "hit",
+           baseline != null ? "  vs baseline" : "");
+    int regressions = 0;
+    for (int k = 0; k < KERNELS; k++) {
+        for (int w = 0; w < WORKLOADS; w++) {
+            uint64_t seed = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(w + 1); // same cases for all kernels of a family
+            kernels[k].generate(c, w, &seed);
+            for (int i = 0; i < CASES; i++) {
+                for (int k3 = 0; k3 < 3; k3++) {
+                    c->od[i][k3] = c->o[i][k3];
+                    c->dd[i][k3] = c->d[i][k3];
+                    for (int j = 0; j < 3; j++) { c->vd[i][j][k3] = c->v[i][j][k3]; }
+                }
+            }
+            const result_t r = measure(k, c);
+            printf("%-30s %-14s %9.2f %9.1f %8.1f %6.3f", kernels[k].name, workloads[w], r.ns, 1e3 / r.ns,
+                   r.cycles, r.hit);
+            double hit = 0;
+            const double ns = baseline_ns(baseline, kernels[k].name, workloads[w], &hit);
+            if (ns > 0) {
+                const double change = (r.ns / ns - 1) * 100;
+                const int slower = change > threshold, differs = fabs(hit - r.hit) > 0.5 / CASES;
+                printf("  %+6.1f%%%s%s", change, slower ? " REGRESSION" : "", differs ? " HIT RATIO CHANGED" : "");
+                regressions += slower || differs;
+            }
+            printf("\n");
+            print_counters(k, c);
+            if (json != null) {
+                fprintf(json, "    {\"kernel\": \"%s\", \"workload\": \"%s\", \"ns\": %.3f, \"tests_per_s\": %.0f, "
+                              "\"cycles\": %.2f, \"hit\": %.6f}%s\n", kernels[k].name, workloads[w], r.ns,
+                        1e9 / r.ns, r.cycles, r.hit, k == KERNELS - 1 && w == WORKLOADS - 1 ? "" : ",");
+            }
+        }
+    }
+    if (json != null) {
+        fprintf(json, "  ]\n}\n");
+        fclose(json);
+    }
+    free(c);
+    if (regressions > 0) {
+        printf("%d regressions over %.1f%%\n", regressions, threshold);
+        exit(1);
+    }
+}
+
+END_C
@@ -0,0 +1,105 @@
+#include "bench.h"
+#include "../src/inside.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+/* points where the radius decides (bumps of bench_sphere() are within 0.05) */
+static int mismatches(const vec3f_t* points, int n, const uint64_t* bits) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        const float* p = points[i];
+        const float r = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        const int in = (int)((bits[i / 64] >> (i % 64)) & 1);
+        count += fabsf(r - 1) > 0.06f && in != (r < 1);
+    }
+    return count;
+}
+
+static void run(const char* name, const mesh_t* mesh, const vec3f_t* points, int n, uint64_t* bits) {
+    bvh_t* bvh = bvh_create(mesh);
+    if (bvh == null) { printf("out of memory\n"); return; }
+    for (int rays = 1; rays <= 5; rays += 2) {
+        const double time = bench_seconds();
+        bvh_inside_points(bvh, points, n, rays, bits);
+        const double seconds = bench_seconds() - time;
+        int differ = 0; // single point queries agree with the batch
+        for (int i = 0; i < n; i += maximum(1, n / 1000)) {
+            differ += bvh_inside(bvh, points[i], rays) != (int)((bits[i / 64] >> (i % 64)) & 1);
+        }
+        printf("%-8s %d rays %7.3f s %6.2f Mpoints/s, wrong %d, single point differ %d\n",
+               name, rays, seconds, n / seconds / 1e6, mismatches(points, n, bits), differ);
+    }
+    bvh_destroy(bvh);
+}
+
+static void run_file(const bvh_t* bvh, const vec3f_t* points, int n, const uint64_t* expected) {
+    char name[] = "/tmp/bench_inside_XXXXXX";
+    const int fd = mkstemp(name);
+    if (fd < 0) { printf("cannot create %s\n", name); return; }
+    const ssize_t size = (ssize_t)(sizeof(vec3f_t) * (size_t)n);
+    const int written = write(fd, points, (size_t)size) == size;
+    close(fd);
+    if (written) {
+        int count = 0;
+        const double time = bench_seconds();
+        uint64_t* bits = bvh_inside_file(bvh, name, 3, &count);
+        const double seconds = bench_seconds() - time;
+        if (bits == null) {
+            printf("cannot map %s\n", name);
+        } else {
+            const int same = count == n && memcmp(bits, expected, sizeof(uint64_t) * (size_t)(n / 64)) == 0;
+            printf("file     3 rays %7.3f s %6.2f Mpoints/s, %s batch\n", seconds, n / seconds / 1e6,
+                   same ? "same as" : "differs from");
+        }
+        free(bits);
+    }
+    unlink(name);
+}
+
+/* bench inside [triangles [points]] */
+void bench_inside(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    const int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    bench_mesh_t m = {0};
+    vec3f_t* points = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)n);
+    uint64_t* bits = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)((n + 63) / 64));
+    int32_t* cracked = null;
+    if (points != null && bits != null && bench_sphere(&m, triangles, 1)) {
+        cracked = (int32_t*)malloc(sizeof(int32_t) * 3 * (size_t)m.mesh.triangle_count);
+    }
+    if (cracked == null) {
+        printf("out of memory\n");
+    } else {
+        printf("%d triangles, %d points, %d threads\n", m.mesh.triangle_count, n, threads_count());
+        const int side = (int)cbrtf((float)n); // grid in scan order first: coherent packets
+        for (int i = 0; i < n; i++) {
+            const int c[3] = { i % side, i / side % side, i / side / side };
+            for (int k = 0; k < 3; k++) { points[i][k] = ((c[k] + 0.5f) / side * 2 - 1) * 1.2f; }
+        }
+        run("grid", &m.mesh, points, n, bits);
+        uint64_t s = 0x1D5;
+        for (int i = 0; i < n; i++) {
+            for (int k = 0; k < 3; k++) { points[i][k] = (bench_uniform(&s) * 2 - 1) * 1.2f; }
+        }
+        run("closed", &m.mesh, points, n, bits);
+        bvh_t* bvh = bvh_create(&m.mesh);
+        if (bvh != null) {
+            bvh_inside_points(bvh, points, n, 3, bits);
+            run_file(bvh, points, n, bits);
+        }
+        bvh_destroy(bvh);
+        int k = 0; // every 1000th triangle missing
+        for (int i = 0; i < m.mesh.triangle_count; i++) {
+            if (i % 1000 != 999) { memcpy(cracked + k++ * 3, m.indices + i * 3, sizeof(int32_t) * 3); }
+        }
+        const mesh_t mesh = { m.vertices, cracked, m.mesh.vertex_count, k };
+        run("cracked", &mesh, points, n, bits);
+    }
+    free(cracked);
+    free(points);
+    free(bits);
+    bench_mesh_free(&m);
+}
+
+END_C
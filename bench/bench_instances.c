@@ -0,0 +1,160 @@
+#include "bench.h"
+#include "../src/simd.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+enum { REPEAT = 8, OPS = 8 };
+
+static const char* names[OPS] = {
+    "inverse", "affine", "normal", "look_at", "perspective", "compose", "multiply_quat", "slerp"
+};
+
+typedef struct instances_s {
+    int n;
+    mat4x4f_t* m;
+    mat4x4f_t* r;
+    mat4x4f_t* expected;
+    quatf_t* a;
+    quatf_t* b;
+    vec3f_t* v[3];  /* translation, scale or eye, center, up */
+    float* f[4];    /* fovy, aspect, near, far, f[0] is t of slerp */
+} instances_t;
+
+/* results of op for every instance: batch or the single instance functions */
+static void run(const instances_t* d, int op, int batch, mat4x4f_t* r) {
+    const int n = d->n;
+    quatf_t* q = (quatf_t*)r; // quaternions packed at the start of r
+    switch (op) {
+        case 0:
+            if (batch) { inverse_4x4f_batch(r, d->m, n); break; }
+            for (int i = 0; i < n; i++) { inverse_4x4f(r[i], d->m[i]); }
+            break;
+        case 1:
+            if (batch) { inverse_affine_4x4f_batch(r, d->m, n); break; }
+            for (int i = 0; i < n; i++) { inverse_affine_4x4f(r[i], d->m[i]); }
+            break;
+        case 2:
+            if (batch) { normal_4x4f_batch(r, d->m, n); break; }
+            for (int i = 0; i < n; i++) { normal_4x4f(r[i], d->m[i]); }
+            break;
+        case 3:
+            if (batch) { look_at_4x4f_batch(r, d->v[0], d->v[1], d->v[2], n); break; }
+            for (int i = 0; i < n; i++) { look_at_4x4f(r[i], d->v[0][i], d->v[1][i], d->v[2][i]); }
+            break;
+        case 4:
+            if (batch) { perspective_4x4f_batch(r, d->f[0], d->f[1], d->f[2], d->f[3], n); break; }
+            for (int i = 0; i < n; i++) { perspective_4x4f(r[i], d->f[0][i], d->f[1][i], d->f[2][i], d->f[3][i]); }
+            break;
+        case 5:
+            if (batch) { compose_4x4f_batch(r, d->v[0], d->a, d->v[1], n); break; }
+            for (int i = 0; i < n; i++) { compose_4x4f(r[i], d->v[0][i], d->a[i], d->v[1][i]); }
+            break;
+        case 6:
+            if (batch) { multiply_quatf_batch(q, d->a, d->b, n); break; }
+            for (int i = 0; i < n; i++) { multiply_quatf(q[i], d->a[i], d->b[i]); }
+            break;
+        default:
+            if (batch) { slerp_quatf_batch(q, d->a, d->b, d->f[0], n); break; }
+            for (int i = 0; i < n; i++) { slerp_quatf(q[i], d->a[i], d->b[i], d->f[0][i]); }
+            break;
+    }
+}
+
+/* worst |r - expected| / maximum(1, |expected|) over the floats of op */
+static double check(const instances_t* d, int op) {
+    const int floats = d->n * (op >= 6 ? 4 : 16);
+    const float* r = d->r[0];
+    const float* e = d->expected[0];
+    double worst = 0;
+    for (int i = 0; i < floats; i++) {
+        worst = maximum(worst, fabs((double)r[i] - e[i]) / maximum(1.0, fabs(e[i])));
+    }
+    return worst;
+}
+
+static void unit(float* q, uint64_t* s) {
+    float l2 = 0;
+    for (int k = 0; k < 4; k++) { q[k] = bench_uniform(s) * 2 - 1; l2 += q[k] * q[k]; }
+    for (int k = 0; k < 4; k++) { q[k] /= sqrtf(l2); }
+}
+
+static void generate(instances_t* d) {
+    uint64_t s = 0x1A5;
+    for (int i = 0; i < d->n; i++) {
+        unit(d->a[i], &s);
+        unit(d->b[i], &s);
+        for (int j = 0; j < 2; j++) {
+            for (int k = 0; k < 3; k++) { d->v[j][i][k] = bench_uniform(&s) * 4 - 2 + j * 3; }
+        }
+        for (int k = 0; k < 3; k++) { d->v[2][i][k] = k == 1 ? 1 : bench_uniform(&s) * 0.2f - 0.1f; } // up
+        d->f[0][i] = bench_uniform(&s);
+        d->f[1][i] = 1 + bench_uniform(&s);
+        d->f[2][i] = 0.1f + bench_uniform(&s);
+        d->f[3][i] = 100 + bench_uniform(&s);
+        compose_4x4f(d->m[i], d->v[0][i], d->a[i], d->v[1][i]); // invertible affine
+        for (int k = 0; k < 3; k++) { d->m[i][k * 4 + 3] = (bench_uniform(&s) - 0.5f) * 0.1f; }
+    }
+}
+
+/* bench instances [count...]: batches of the math4x4 camera, inverse and
+   quaternion functions per instruction set against the single instance ones */
+void bench_instances(int argc, const char* argv[]) {
+    const int runs = argc > 0 ? argc : 1;
+    for (int c = 0; c < runs; c++) {
+        instances_t d = { argc > 0 ? atoi(argv[c]) : 1000000 };
+        const size_t n = (size_t)maximum(1, d.n);
+        d.m = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+        d.r = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+        d.expected = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+        d.a = (quatf_t*)malloc(sizeof(quatf_t) * n);
+        d.b = (quatf_t*)malloc(sizeof(quatf_t) * n);
+        int ok = d.m != null && d.r != null && d.expected != null && d.a != null && d.b != null;
+        for (int k = 0; k < 3; k++) { ok = (d.v[k] = (vec3f_t*)malloc(sizeof(vec3f_t) * n)) != null && ok; }
+        for (int k = 0; k < 4; k++) { ok = (d.f[k] = (float*)malloc(sizeof(float) * n)) != null && ok; }
+        if (!ok) {
+            printf("out of memory\n");
+        } else {
+            generate(&d);
+            printf("%d instances, %d threads, M/s\n%-8s", d.n, threads_count(), "");
+            for (int op = 0; op < OPS; op++) { printf(" %13s", names[op]); }
+            printf("\n%-8s", "single");
+            for (int op = 0; op < OPS; op++) {
+                const double time = bench_seconds();
+                run(&d, op, false, d.expected);
+                printf(" %13.1f", d.n / (bench_seconds() - time) / 1e6);
+            }
+            printf("\n");
+#ifdef SIMD_X86
+            const int levels[] = { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+#else
+            const int levels[] = { SIMD_SCALAR, SIMD_NEON };
+#endif
+            for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+                simd_force(levels[l]);
+                if (simd_level() != levels[l]) { continue; }
+                double worst = 0;
+                printf("%-8s", simd_name(simd_level()));
+                for (int op = 0; op < OPS; op++) {
+                    run(&d, op, false, d.expected); // singles are scalar at every level
+                    const double time = bench_seconds();
+                    for (int r = 0; r < REPEAT; r++) { run(&d, op, true, d.r); }
+                    const double seconds = (bench_seconds() - time) / REPEAT;
+                    worst = maximum(worst, check(&d, op));
+                    printf(" %13.1f", d.n / seconds / 1e6);
+                }
+                printf(", max error %.1e\n", worst);
+            }
+            simd_force(-1);
+        }
+        free(d.m);
+        free(d.r);
+        free(d.expected);
+        free(d.a);
+        free(d.b);
+        for (int k = 0; k < 3; k++) { free(d.v[k]); }
+        for (int k = 0; k < 4; k++) { free(d.f[k]); }
+    }
+}
+
+END_C
@@ -0,0 +1,109 @@
+#include "bench.h"
+#include "../src/simd.h"
+#include "../src/threads.h"
+#include <float.h>
+
+BEGIN_C
+
+enum { REPEAT = 16 };
+
+typedef struct matrices_s {
+    int n;
+    mat4x4f_t* a;
+    mat4x4f_t* b;
+    mat4x4f_t* r;
+    mat4x4f_t* expected[3]; /* many_one, one_many, pairwise */
+} matrices_t;
+
+/* worst element of r against expected in units of the multiply_4x4f() bound, identical matrices */
+static double check(const mat4x4f_t* r, const mat4x4f_t* expected, const mat4x4f_t* a, int as,
+                    const mat4x4f_t* b, int bs, int n, int* identical) {
+    double worst = 0;
+    *identical = 0;
+    for (int i = 0; i < n; i++) {
+        const float* ma = a[i * as];
+        const float* mb = b[i * bs];
+        for (int e = 0; e < 16; e++) {
+            double bound = 0;
+            for (int k = 0; k < 4; k++) { bound += fabs((double)ma[k * 4 + e % 4] * mb[e / 4 * 4 + k]); }
+            bound *= 3 * FLT_EPSILON;
+            const double d = fabs((double)r[i][e] - expected[i][e]);
+            if (d > 0) { worst = maximum(worst, bound > 0 ? d / bound : INFINITY); }
+        }
+        *identical += memcmp(r[i], expected[i], sizeof(mat4x4f_t)) == 0;
+    }
+    return worst;
+}
+
+static void run(const matrices_t* m) {
+    const int n = m->n;
+    double time = bench_seconds();
+    for (int k = 0; k < REPEAT; k++) {
+        for (int i = 0; i < n; i++) { multiply_4x4f(m->r[i], m->a[i], m->b[i]); }
+    }
+    const double single = (double)n * REPEAT / (bench_seconds() - time);
+    int identical = 0;
+    double worst = check(m->r, m->expected[2], m->a, 1, m->b, 1, n, &identical);
+    printf("%-8s single %7.1f M/s", simd_name(simd_level()), single / 1e6);
+    static const char* names[] = { "many_one", "one_many", "pairwise" };
+    for (int v = 0; v < 3; v++) {
+        const int as = v != 1, bs = v != 0;
+        time = bench_seconds();
+        for (int k = 0; k < REPEAT; k++) {
+            switch (v) {
+                case 0: multiply_4x4f_batch_many_one(m->r, m->a, m->b[0], n); break;
+                case 1: multiply_4x4f_batch_one_many(m->r, m->a[0], m->b, n); break;
+                default: multiply_4x4f_batch_pairwise(m->r, m->a, m->b, n); break;
+            }
+        }
+        const double rate = (double)n * REPEAT / (bench_seconds() - time);
+        int same = 0;
+        worst = maximum(worst, check(m->r, m->expected[v], m->a, as, m->b, bs, n, &same));
+        identical = minimum(identical, same);
+        printf(" %s %7.1f M/s", names[v], rate / 1e6);
+    }
+    printf(", max error %.2f of bound, %s\n", worst,
+           identical == n ? "bit identical" : worst <= 1 ? "within bound" : "OUT OF BOUND");
+}
+
+/* bench matrix [count...]: multiply_4x4f() and batches per instruction set against the scalar reference */
+void bench_matrix(int argc, const char* argv[]) {
+    const int runs = argc > 0 ? argc : 1;
+    for (int c = 0; c < runs; c++) {
+        matrices_t m = { argc > 0 ? atoi(argv[c]) : 100000 };
+        const size_t bytes = sizeof(mat4x4f_t) * (size_t)maximum(1, m.n);
+        mat4x4f_t** arrays[] = { &m.a, &m.b, &m.r, &m.expected[0], &m.expected[1], &m.expected[2] };
+        int ok = true;
+        for (int i = 0; i < 6; i++) { ok = (*arrays[i] = (mat4x4f_t*)aligned_alloc(64, bytes)) != null && ok; }
+        if (!ok) {
+            printf("out of memory\n");
+        } else {
+            uint64_t s = 0x4A4;
+            for (int i = 0; i < m.n; i++) {
+                for (int e = 0; e < 16; e++) {
+                    m.a[i][e] = bench_uniform(&s) * 4 - 2;
+                    m.b[i][e] = bench_uniform(&s) * 4 - 2;
+                }
+            }
+            for (int i = 0; i < m.n; i++) {
+                multiply_4x4f_scalar(m.expected[0][i], m.a[i], m.b[0]);
+                multiply_4x4f_scalar(m.expected[1][i], m.a[0], m.b[i]);
+                multiply_4x4f_scalar(m.expected[2][i], m.a[i], m.b[i]);
+            }
+            printf("%d matrices, %d threads\n", m.n, threads_count());
+#ifdef SIMD_X86
+            const int levels[] = { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+#else
+            const int levels[] = { SIMD_SCALAR, SIMD_NEON };
+#endif
+            for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+                simd_force(levels[l]);
+                if (simd_level() == levels[l]) { run(&m); }
+            }
+            simd_force(-1);
+        }
+        for (int i = 0; i < 6; i++) { free(*arrays[i]); }
+    }
+}
+
+END_C
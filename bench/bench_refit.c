@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "../src/bvh.h"
+
+BEGIN_C
+
+enum { FRAMES = 60, CHECK_RAYS = 4096 };
+
+/* stretches the sphere along x more every frame and twists it around x:
+   like a limb being pulled, overlap of sibling boxes grows */
+static void deform(const vec3f_t* rest, vec3f_t* v, int n, float phase) {
+    for (int i = 0; i < n; i++) {
+        const float x = rest[i][0] * (1 + phase * 3);
+        const float a = rest[i][0] * phase * 6;
+        const float c = cosf(a), s = sinf(a);
+        v[i][0] = x;
+        v[i][1] = rest[i][1] * c - rest[i][2] * s;
+        v[i][2] = rest[i][1] * s + rest[i][2] * c;
+    }
+}
+
+static int check(const bvh_t* bvh, const bvh_t* fresh, uint64_t* seed) {
+    int mismatches = 0;
+    for (int i = 0; i < CHECK_RAYS; i++) {
+        float o[3], d[3];
+        bench_direction(seed, o);
+        bench_direction(seed, d);
+        for (int k = 0; k < 3; k++) { o[k] *= 5; d[k] = d[k] * 0.5f - o[k]; }
+        bvh_hit_t a, b;
+        bvh_closest_hit(bvh, o, d, 0, INFINITY, &a);
+        bvh_closest_hit(fresh, o, d, 0, INFINITY, &b);
+        if (a.triangle != b.triangle && fabsf(a.t - b.t) > 1e-6f * maximum(1.0f, a.t)) { mismatches++; }
+    }
+    return mismatches;
+}
+
+/* bench refit [triangles [threshold]] */
+void bench_refit(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    const float threshold = argc > 1 ? (float)atof(argv[1]) : 1.5f;
+    bench_mesh_t m = {0};
+    if (!bench_sphere(&m, triangles, 1)) { printf("out of memory\n"); return; }
+    const int n = m.mesh.vertex_count;
+    vec3f_t* rest = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)n);
+    if (rest == null) { printf("out of memory\n"); bench_mesh_free(&m); return; }
+    memcpy(rest, m.vertices, sizeof(vec3f_t) * (size_t)n);
+    bvh_t* bvh = bvh_create(&m.mesh);
+    if (bvh == null) { printf("out of memory\n"); free(rest); bench_mesh_free(&m); return; }
+    static const char* results[] = { "out of memory", "refitted", "partial", "rebuilt" };
+    uint64_t seed = 3;
+    double total = 0;
+    for (int f = 1; f <= FRAMES; f++) {
+        deform(rest, m.vertices, n, (float)f / FRAMES);
+        const double time = bench_seconds();
+        const int r = bvh_refit(bvh, threshold);
+        const double refit = bench_seconds() - time;
+        total += refit;
+        if (f % 10 == 0 || r != BVH_REFITTED) {
+            bvh_t* fresh = bvh_create(&m.mesh);
+            const double build = bench_seconds() - time - refit;
+            const int mismatches = fresh != null ? check(bvh, fresh, &seed) : -1;
+            printf("%9d triangles frame %2d %-8s %8.3f ms SAH ratio %5.2f | rebuild %8.3f ms | mismatches %d\n",
+                   m.mesh.triangle_count, f, results[r], refit * 1e3, bvh_sah_ratio(bvh), build * 1e3, mismatches);
+            bvh_destroy(fresh);
+        }
+    }
+    printf("%9d triangles %d frames average %.3f ms per frame\n", m.mesh.triangle_count, FRAMES, total * 1e3 / FRAMES);
+    bvh_destroy(bvh);
+    free(rest);
+    bench_mesh_free(&m);
+}
+
+END_C
@@ -0,0 +1,128 @@
+#include "bench.h"
+#include "../src/simd.h"
+#include "../src/threads.h"
+#include "../ext/intersections/intersections.h"
+#include "../ext/intersections/fromtorot_simd.h"
+
+BEGIN_C
+
+enum { REPEAT = 8 };
+
+typedef struct rotations_s {
+    int n;
+    float* data; // single allocation for all arrays below
+    float* from[3];
+    float* to[3];
+    float* m[9];
+    float* q[4];
+    float* scalar[9];
+} rotations_t;
+
+static int rotations_alloc(rotations_t* r, int n) {
+    r->n = n;
+    r->data = (float*)malloc(sizeof(float) * n * 28);
+    if (r->data == null) { return false; }
+    float* p = r->data;
+    for (int i = 0; i < 3; i++) { r->from[i] = p; p += n; }
+    for (int i = 0; i < 3; i++) { r->to[i] = p; p += n; }
+    for (int i = 0; i < 9; i++) { r->m[i] = p; p += n; }
+    for (int i = 0; i < 4; i++) { r->q[i] = p; p += n; }
+    for (int i = 0; i < 9; i++) { r->scalar[i] = p; p += n; }
+    return true;
+}
+
+/* uniform pairs, every 8th pair nearly parallel and the next nearly
+   antiparallel with angles to (-)from spread over 1.0e-1..1.0e-5 */
+static void rotations_fill(rotations_t* r) {
+    uint64_t s = 11;
+    for (int i = 0; i < r->n; i++) {
+        float f[3], t[3];
+        bench_direction(&s, f);
+        bench_direction(&s, t);
+        if (i % 8 < 2) {
+            const float sign = i % 8 == 0 ? 1 : -1, tiny = powf(10, -1 - 4 * bench_uniform(&s));
+            float l = 0;
+            for (int k = 0; k < 3; k++) { t[k] = sign * f[k] + tiny * t[k]; l += t[k] * t[k]; }
+            for (int k = 0; k < 3; k++) { t[k] /= sqrtf(l); }
+        }
+        for (int k = 0; k < 3; k++) { r->from[k][i] = f[k]; r->to[k][i] = t[k]; }
+    }
+}
+
+static void scalar(rotations_t* r) {
+    for (int i = 0; i < r->n; i++) {
+        float f[3] = { r->from[0][i], r->from[1][i], r->from[2][i] };
+        float t[3] = { r->to[0][i], r->to[1][i], r->to[2][i] };
+        float mtx[3][3];
+        fromToRotation(f, t, mtx);
+        for (int k = 0; k < 9; k++) { r->scalar[k][i] = mtx[k / 3][k % 3]; }
+    }
+}
+
+typedef struct errors_s {
+    double scalar;     // |m - fromToRotation()| for 1 + (from . to) >= 0.1
+    double orthogonal; // |m^T m - I|
+    double to;         // |m from - to|
+    double quaternion; // |matrix(q) - m|
+} errors_t;
+
+static errors_t errors(const rotations_t* r) {
+    errors_t e = {0};
+    for (int i = 0; i < r->n; i++) {
+        double m[3][3], f[3], t[3];
+        for (int k = 0; k < 9; k++) { m[k / 3][k % 3] = r->m[k][i]; }
+        for (int k = 0; k < 3; k++) { f[k] = r->from[k][i]; t[k] = r->to[k][i]; }
+        if (1 + f[0] * t[0] + f[1] * t[1] + f[2] * t[2] >= 0.1) {
+            for (int k = 0; k < 9; k++) { e.scalar = maximum(e.scalar, fabs(m[k / 3][k % 3] - r->scalar[k][i])); }
+        }
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 3; k++) {
+                const double d = m[0][j] * m[0][k] + m[1][j] * m[1][k] + m[2][j] * m[2][k];
+                e.orthogonal = maximum(e.orthogonal, fabs(d - (j == k)));
+            }
+            e.to = maximum(e.to, fabs(m[j][0] * f[0] + m[j][1] * f[1] + m[j][2] * f[2] - t[j]));
+        }
+        const double x = r->q[0][i], y = r->q[1][i], z = r->q[2][i], w = r->q[3][i];
+        const double qm[9] = {
+            1 - 2 * (y * y + z * z), 2 * (x * y - z * w),     2 * (x * z + y * w),
+            2 * (x * y + z * w),     1 - 2 * (x * x + z * z), 2 * (y * z - x * w),
+            2 * (x * z - y * w),     2 * (y * z + x * w),     1 - 2 * (x * x + y * y)
+        };
+        for (int k = 0; k < 9; k++) { e.quaternion = maximum(e.quaternion, fabs(qm[k] - m[k / 3][k % 3])); }
+    }
+    return e;
+}
+
+/* bench rotations [count...]: fromToRotation() against from_to_rotations() */
+void bench_rotations(int argc, const char* argv[]) {
+    const int runs = argc > 0 ? argc : 1;
+    for (int c = 0; c < runs; c++) {
+        rotations_t r = {0};
+        if (!rotations_alloc(&r, argc > 0 ? atoi(argv[c]) : 1000003)) { printf("out of memory\n"); return; }
+        rotations_fill(&r);
+        double time = bench_seconds();
+        for (int k = 0; k < REPEAT; k++) { scalar(&r); }
+        const double rate = (double)r.n * REPEAT / (bench_seconds() - time);
+        printf("%d rotations, %d threads\n%-8s matrix %8.1f M/s\n", r.n, threads_count(), "scalar", rate / 1e6);
+        const int levels[] = { SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512 };
+        for (int l = 0; l < 3; l++) {
+            simd_force(levels[l]);
+            if (l > 0 && simd_level() != levels[l]) { continue; }
+            time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) { from_to_rotations((const float* const*)r.from, (const float* const*)r.to, r.n, r.m, null); }
+            const double matrices = (double)r.n * REPEAT / (bench_seconds() - time);
+            time = bench_seconds();
+            for (int k = 0; k < REPEAT; k++) { from_to_rotations((const float* const*)r.from, (const float* const*)r.to, r.n, null, r.q); }
+            const double quaternions = (double)r.n * REPEAT / (bench_seconds() - time);
+            from_to_rotations((const float* const*)r.from, (const float* const*)r.to, r.n, r.m, r.q);
+            const errors_t e = errors(&r);
+            printf("%-8s matrix %8.1f M/s quaternion %8.1f M/s, max error: scalar %.1e orthogonal %.1e "
+                   "to %.1e quaternion %.1e\n", simd_name(simd_level()), matrices / 1e6, quaternions / 1e6,
+                   e.scalar, e.orthogonal, e.to, e.quaternion);
+        }
+        simd_force(-1);
+        free(r.data);
+    }
+}
+
+END_C
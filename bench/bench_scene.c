@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "../src/scene.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+enum { FRAMES = 16 };
+
+/* small rotation about z, scale near 1 and translation, keeps deep chains finite */
+static void local_matrix(mat4x4f_t m, uint64_t* s) {
+    const float a = (bench_uniform(s) - 0.5f) * 0.5f, k = 0.9f + bench_uniform(s) * 0.2f;
+    const float c = cosf(a) * k, n = sinf(a) * k;
+    const mat4x4f_t r = { c, n, 0, 0,  -n, c, 0, 0,  0, 0, k, 0,
+                          bench_uniform(s) - 0.5f, bench_uniform(s) - 0.5f, bench_uniform(s) - 0.5f, 1 };
+    memcpy(m, r, sizeof(mat4x4f_t));
+}
+
+/* worst |world - reference| / maximum(1, |reference|) with the reference
+   computed by multiply_4x4f_scalar() in depth order from the parents of ids */
+static double check(const scene_t* s, const int32_t* parent, mat4x4f_t* reference) {
+    const int n = s->count;
+    int32_t* order = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, n));
+    double worst = order == null ? -1 : 0;
+    if (order != null) {
+        for (int i = 0; i < n; i++) { order[s->slot[i]] = i; } // slots are parents first
+        for (int i = 0; i < n; i++) {
+            const int id = order[i];
+            if (parent[id] < 0) {
+                memcpy(reference[id], scene_local(s, id), sizeof(mat4x4f_t));
+            } else {
+                multiply_4x4f_scalar(reference[id], reference[parent[id]], scene_local(s, id));
+            }
+            const float* w = scene_world(s, id);
+            for (int k = 0; k < 16; k++) {
+                worst = maximum(worst, fabs((double)w[k] - reference[id][k]) / maximum(1.0, fabs(reference[id][k])));
+            }
+        }
+    }
+    free(order);
+    return worst;
+}
+
+/* bench scene [nodes [changed...]]: scene_update() of a random tree after
+   changing the local matrices of `changed` random nodes per frame against
+   a full update, then reparenting some subtrees */
+void bench_scene(int argc, const char* argv[]) {
+    const int n = maximum(1, argc > 0 ? atoi(argv[0]) : 200000);
+    int32_t* parent = (int32_t*)malloc(sizeof(int32_t) * (size_t)n);
+    mat4x4f_t* reference = (mat4x4f_t*)malloc(sizeof(mat4x4f_t) * (size_t)n);
+    scene_t* s = scene_create(0); // grows
+    if (parent == null || reference == null || s == null) {
+        printf("out of memory\n");
+    } else {
+        uint64_t r = 0x5CE7E;
+        int ok = true;
+        for (int i = 0; i < n && ok; i++) { // wide near the roots, long chains below
+            mat4x4f_t m;
+            local_matrix(m, &r);
+            parent[i] = i < 8 ? -1 : (int)(bench_uniform(&r) * bench_uniform(&r) * i);
+            ok = scene_add(s, parent[i], m) == i;
+        }
+        double time = bench_seconds();
+        const int all = ok ? scene_update(s) : -1;
+        const double first = bench_seconds() - time;
+        if (all != n) {
+            printf("out of memory\n");
+        } else {
+            printf("%d nodes, %d depths, %d threads\n", n, s->depths, threads_count());
+            printf("layout and update of all %8.3f ms, max error %.1e\n", first * 1e3, check(s, parent, reference));
+            const int runs = maximum(1, argc - 1);
+            for (int c = 0; c < runs; c++) {
+                const int changed = argc > 1 ? atoi(argv[c + 1]) : n / 1000;
+                int updated = 0;
+                double seconds = 0;
+                for (int f = 0; f < FRAMES; f++) {
+                    for (int i = 0; i < changed; i++) {
+                        mat4x4f_t m;
+                        local_matrix(m, &r);
+                        scene_set_local(s, (int)(bench_random(&r) % (uint64_t)n), m);
+                    }
+                    time = bench_seconds();
+                    updated += scene_update(s);
+                    seconds += bench_seconds() - time;
+                }
+                printf("%7d changed %8.3f ms, %9d nodes updated per frame, max error %.1e\n", changed,
+                       seconds / FRAMES * 1e3, updated / FRAMES, check(s, parent, reference));
+            }
+            for (int i = 0; i < 100; i++) { // parents of random ids become random non descendants
+                const int node = (int)(bench_random(&r) % (uint64_t)n);
+                const int p = node < 8 ? -1 : (int)(bench_random(&r) % (uint64_t)node);
+                if (scene_set_parent(s, node, p)) { parent[node] = p; }
+            }
+            time = bench_seconds();
+            const int updated = scene_update(s);
+            printf("reparent 100 %8.3f ms, %9d nodes updated, %d depths, max error %.1e\n",
+                   (bench_seconds() - time) * 1e3, updated, s->depths, check(s, parent, reference));
+            time = bench_seconds();
+            for (int i = 0; i < n; i++) {
+                mat4x4f_t m;
+                memcpy(m, scene_local(s, i), sizeof(mat4x4f_t));
+                scene_set_local(s, i, m);
+            }
+            scene_update(s);
+            printf("update of all %8.3f ms\n", (bench_seconds() - time) * 1e3);
+        }
+    }
+    scene_destroy(s);
+    free(parent);
+    free(reference);
+}
+
+END_C
@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "../src/sdf.h"
+#include "../src/distance.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+enum { CHECKS = 10000 };
+
+/* random samples against closest point queries, sign against the radius
+   where it is unambiguous (bumps of bench_sphere() are within 0.05) */
+static void check(const sdf_t* s, const bvh_t* bvh, const sdf_t* dense, int* distance, int* sign, int* band) {
+    uint64_t state = 0x5DF;
+    for (int i = 0; i < CHECKS; i++) {
+        const int x = (int)(bench_uniform(&state) * s->size[0]);
+        const int y = (int)(bench_uniform(&state) * s->size[1]);
+        const int z = (int)(bench_uniform(&state) * s->size[2]);
+        const float p[3] = { s->origin[0] + x * s->cell, s->origin[1] + y * s->cell, s->origin[2] + z * s->cell };
+        const float v = sdf_get(s, x, y, z);
+        bvh_closest_t c;
+        const float d = bvh_closest_point(bvh, p, s->band, &c) ? c.distance : s->band;
+        *distance += fabsf(fabsf(v) - d) > 1e-5f * maximum(1, d);
+        const float r = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (fabsf(r - 1) > 0.06f) { *sign += (v < 0) != (r < 1); }
+        int within = dense != null && d < s->band;
+        for (int k = 0; k < 3 && within; k++) {
+            within = p[k] >= dense->origin[k] && p[k] <= dense->origin[k] + (dense->size[k] - 1) * dense->cell;
+        }
+        if (within) { *band += fabsf(sdf_sample(dense, p) - v) > 1e-4f; } // a sample of the dense field too
+    }
+}
+
+static void run(const bvh_t* bvh, int resolution, float band, const sdf_t* dense, sdf_t** out) {
+    const double time = bench_seconds();
+    sdf_t* s = sdf_create(bvh, resolution, band);
+    const double seconds = bench_seconds() - time;
+    if (s == null) {
+        printf("out of memory\n");
+        return;
+    }
+    int distance = 0, sign = 0, differ = 0;
+    check(s, bvh, dense, &distance, &sign, &differ);
+    const int total = s->size[0] / SDF_BRICK * (s->size[1] / SDF_BRICK) * (s->size[2] / SDF_BRICK);
+    printf("%4d^3 band %-5.3g %7.3f s, %7d of %7d bricks %8.1f MB, distance mismatches %d, sign %d",
+           resolution, band, seconds, s->brick_count, total,
+           s->brick_count * sizeof(s->bricks[0]) / (1024.0 * 1024.0), distance, sign);
+    if (dense != null) { printf(", differ from dense %d", differ); }
+    printf("\n");
+    if (out != null) { *out = s; } else { sdf_destroy(s); }
+}
+
+/* bench sdf [triangles [resolution...]] */
+void bench_sdf(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    bench_mesh_t m = {0};
+    bvh_t* bvh = null;
+    if (!bench_sphere(&m, triangles, 1) || (bvh = bvh_create(&m.mesh)) == null) {
+        printf("out of memory\n");
+    } else {
+        printf("%d triangles, %d threads\n", m.mesh.triangle_count, threads_count());
+        static const char* sizes[] = { "64", "128", "256" };
+        const char** r = argc > 1 ? argv + 1 : sizes;
+        const int n = argc > 1 ? argc - 1 : 3;
+        for (int i = 0; i < n; i++) {
+            const int resolution = atoi(r[i]);
+            sdf_t* dense = null;
+            run(bvh, resolution, INFINITY, null, &dense);
+            // same grid as the dense field: band grows bounds by 4 cells
+            run(bvh, resolution + 8, dense != null ? dense->cell * 4 : 0.1f, dense, null);
+            sdf_destroy(dense);
+        }
+    }
+    bvh_destroy(bvh);
+    bench_mesh_free(&m);
+}
+
+END_C
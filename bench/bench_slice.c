@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "../src/slice.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+/* twice the signed area of a contour, > 0 counterclockwise */
+static double contour_area(const slices_t* s, const slice_contour_t* c) {
+    double a = 0;
+    for (int i = 0; i < c->count; i++) {
+        const float* p = s->points[c->offset + i];
+        const float* q = s->points[c->offset + (i + 1) % c->count];
+        a += (double)p[0] * q[1] - (double)q[0] * p[1];
+    }
+    return a;
+}
+
+static void run(const bench_mesh_t* m, int layers) {
+    float lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < m->mesh.vertex_count; i++) {
+        lo = minimum(lo, m->mesh.vertices[i][2]);
+        hi = maximum(hi, m->mesh.vertices[i][2]);
+    }
+    float* z = (float*)malloc(sizeof(float) * (size_t)layers);
+    if (z == null) { printf("out of memory\n"); return; }
+    for (int l = 0; l < layers; l++) { z[l] = lo + (hi - lo) * (l + 0.5f) / layers; }
+    const double time = bench_seconds();
+    slices_t* s = slices_create(&m->mesh, z, layers);
+    const double seconds = bench_seconds() - time;
+    if (s == null) {
+        printf("out of memory\n");
+    } else {
+        // closed sphere: every layer is closed contours of positive total area
+        int open = 0, empty = 0, negative = 0;
+        for (int l = 0; l < s->layer_count; l++) {
+            double area = 0;
+            for (int c = s->layers[l]; c < s->layers[l + 1]; c++) {
+                open += !s->contours[c].closed;
+                area += contour_area(s, &s->contours[c]);
+            }
+            empty += s->layers[l] == s->layers[l + 1];
+            negative += area <= 0;
+        }
+        printf("%6d layers %7.3f s, %8d contours %10d points, open %d, empty layers %d, "
+               "non positive area layers %d\n",
+               layers, seconds, s->contour_count, s->point_count, open, empty, negative);
+    }
+    slices_destroy(s);
+    free(z);
+}
+
+/* bench slice [triangles [layers...]] */
+void bench_slice(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    bench_mesh_t m = {0};
+    if (!bench_sphere(&m, triangles, 1)) {
+        printf("out of memory\n");
+    } else {
+        printf("%d triangles, %d threads\n", m.mesh.triangle_count, threads_count());
+        if (argc < 2) {
+            const int layers[] = { 100, 1000, 10000 };
+            for (int i = 0; i < 3; i++) { run(&m, layers[i]); }
+        }
+        for (int i = 1; i < argc; i++) { run(&m, atoi(argv[i])); }
+    }
+    bench_mesh_free(&m);
+}
+
+END_C
@@ -0,0 +1,109 @@
+#include "bench.h"
+#include "../src/simd.h"
+#include "../src/threads.h"
+
+BEGIN_C
+
+enum { REPEAT = 4 };
+
+typedef struct points_s {
+    int n;
+    vec3f_t* in;
+    vec3f_t* out;
+    vec3f_t* expected;
+    size_t stride; /* floats per axis of soa, multiple of 16: 64 byte aligned axes */
+    float* soa;    /* in[3] then out[3] */
+} points_t;
+
+/* rotation, scale, translation and then perspective, column major */
+static void matrix(mat4x4f_t m) {
+    const float c = cosf(0.3f), s = sinf(0.3f), f = 1.5f, near = 0.1f, far = 100.0f;
+    const mat4x4f_t model = { c * 2, s * 2, 0, 0,  -s, c, 0, 0,  0, 0, 0.5f, 0,  0.1f, -0.2f, -5, 1 };
+    const mat4x4f_t projection = { f, 0, 0, 0,  0, f, 0, 0,  0, 0, (far + near) / (near - far), -1,
+                                   0, 0, 2 * far * near / (near - far), 0 };
+    multiply_4x4f_scalar(m, projection, model);
+}
+
+/* worst |out - expected| / maximum(1, |expected|) */
+static double check(const vec3f_t* out, const vec3f_t* expected, int n) {
+    double worst = 0;
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            worst = maximum(worst, fabs((double)out[i][k] - expected[i][k]) / maximum(1.0, fabs(expected[i][k])));
+        }
+    }
+    return worst;
+}
+
+static void run(const points_t* p, const mat4x4f_t m, int flags, const char* name) {
+    const int n = p->n;
+    for (int i = 0; i < n; i++) { transform_4x4f_scalar(m, p->in[i], p->expected[i], flags); }
+    double time = bench_seconds();
+    for (int r = 0; r < REPEAT; r++) { transform_4x4f(m, p->in, p->out, n, flags); }
+    const double aos = (bench_seconds() - time) / REPEAT;
+    double worst = check(p->out, p->expected, n);
+    const float* in[3] = { p->soa, p->soa + p->stride, p->soa + 2 * p->stride };
+    float* out[3] = { p->soa + 3 * p->stride, p->soa + 4 * p->stride, p->soa + 5 * p->stride };
+    time = bench_seconds();
+    for (int r = 0; r < REPEAT; r++) { transform_4x4f_soa(m, in, out, n, flags); }
+    const double soa = (bench_seconds() - time) / REPEAT;
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) { p->out[i][k] = out[k][i]; }
+    }
+    worst = maximum(worst, check(p->out, p->expected, n));
+    const double bytes = 2.0 * sizeof(vec3f_t) * n;
+    printf("%-8s %-12s aos %7.4f s %6.2f GB/s soa %7.4f s %6.2f GB/s, max error %.1e\n",
+           simd_name(simd_level()), name, aos, bytes / aos / 1e9, soa, bytes / soa / 1e9, worst);
+}
+
+/* bench transform [count...]: transform_4x4f() and transform_4x4f_soa() per instruction set
+   against transform_4x4f_scalar(), memcpy() of the same bytes is the bandwidth bound */
+void bench_transform(int argc, const char* argv[]) {
+    const int runs = argc > 0 ? argc : 1;
+    for (int c = 0; c < runs; c++) {
+        points_t p = { argc > 0 ? atoi(argv[c]) : 10000000 };
+        const size_t bytes = (sizeof(vec3f_t) * (size_t)maximum(1, p.n) + 63) / 64 * 64;
+        p.in = (vec3f_t*)aligned_alloc(64, bytes);
+        p.out = (vec3f_t*)aligned_alloc(64, bytes);
+        p.expected = (vec3f_t*)aligned_alloc(64, bytes);
+        p.stride = ((size_t)maximum(1, p.n) + 15) / 16 * 16;
+        p.soa = (float*)aligned_alloc(64, sizeof(float) * 6 * p.stride);
+        if (p.in == null || p.out == null || p.expected == null || p.soa == null) {
+            printf("out of memory\n");
+        } else {
+            uint64_t s = 0x7F;
+            for (int i = 0; i < p.n; i++) {
+                for (int k = 0; k < 3; k++) { p.in[i][k] = bench_uniform(&s) * 4 - 2; }
+            }
+            for (int i = 0; i < p.n; i++) {
+                for (int k = 0; k < 3; k++) { p.soa[k * p.stride + i] = p.in[i][k]; }
+            }
+            mat4x4f_t m;
+            matrix(m);
+            double time = bench_seconds();
+            for (int r = 0; r < REPEAT; r++) { memcpy(p.out, p.in, sizeof(vec3f_t) * (size_t)p.n); }
+            const double copy = (bench_seconds() - time) / REPEAT;
+            printf("%d points, %d threads, memcpy %7.4f s %6.2f GB/s\n", p.n, threads_count(), copy,
+                   2.0 * sizeof(vec3f_t) * p.n / copy / 1e9);
+#ifdef SIMD_X86
+            const int levels[] = { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+#else
+            const int levels[] = { SIMD_SCALAR, SIMD_NEON };
+#endif
+            for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+                simd_force(levels[l]);
+                if (simd_level() != levels[l]) { continue; }
+                run(&p, m, TRANSFORM_POINTS, "points");
+                run(&p, m, TRANSFORM_POINTS | TRANSFORM_DIVIDE, "divide");
+                run(&p, m, TRANSFORM_NORMALS, "normals");
+            }
+            simd_force(-1);
+        }
+        free(p.in);
+        free(p.out);
+        free(p.expected);
+        free(p.soa);
+    }
+}
+
+END_C
@@ -0,0 +1,241 @@
+#include "bench.h"
+#include "../src/simd.h"
+#include "../ext/intersect_triangle.h"
+#include "../ext/intersect_triangle_simd.h"
+#include <float.h>
+
+BEGIN_C
+
+enum { PAIRS = 1 << 16, REPEAT = 32, CASES = PAIRS / 4 };
+
+typedef struct pairs_s {
+    double o[PAIRS][3], d[PAIRS][3], v0[PAIRS][3], v1[PAIRS][3], v2[PAIRS][3];
+    float of[PAIRS][3], df[PAIRS][3], v0f[PAIRS][3], v1f[PAIRS][3], v2f[PAIRS][3];
+} pairs_t;
+
+static void make_pairs(pairs_t* p) {
+    uint64_t s = 5;
+    for (int i = 0; i < PAIRS; i++) {
+        float c[3], e[3], t[3];
+        bench_direction(&s, c);
+        for (int k = 0; k < 3; k++) {
+            bench_direction(&s, e);
+            const float* v = k == 0 ? p->v0f[i] : k == 1 ? p->v1f[i] : p->v2f[i];
+            for (int j = 0; j < 3; j++) { ((float*)v)[j] = c[j] * 0.5f + e[j] * 0.3f; }
+        }
+        bench_direction(&s, p->of[i]);
+        bench_direction(&s, t);
+        for (int j = 0; j < 3; j++) {
+            p->of[i][j] *= 2;
+            p->df[i][j] = c[j] * 0.5f + t[j] * 0.3f - p->of[i][j];
+        }
+        for (int j = 0; j < 3; j++) {
+            p->o[i][j] = p->of[i][j]; p->d[i][j] = p->df[i][j];
+            p->v0[i][j] = p->v0f[i][j]; p->v1[i][j] = p->v1f[i][j]; p->v2[i][j] = p->v2f[i][j];
+        }
+    }
+}
+
+typedef struct case_s {
+    float v[2][3][3];    /* triangle and its neighbour across edge v0 v1 */
+    float o[3], d[3][3]; /* unit directions: random, at the shared edge, at a vertex */
+} case_t;
+
+typedef struct check_s {
+    int tests;
+    int mismatches;      /* hit/miss differs outside of the documented bands */
+    int banded;          /* hit/miss differs inside of them */
+    double dt, du, dv;   /* worst |difference| / bound of hits of both */
+    int edges, cracks, doubles; /* rays at shared edges missing / hitting both triangles */
+} check_t;
+
+static void normalize(float d[3]) {
+    const float l = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    for (int j = 0; j < 3; j++) { d[j] /= l; }
+}
+
+static void make_cases(const pairs_t* p, case_t* c) {
+    uint64_t s = 7;
+    for (int i = 0; i < CASES; i++) {
+        const float* v0 = p->v0f[i], * v1 = p->v1f[i], * v2 = p->v2f[i];
+        const float* vertex = i % 3 == 0 ? v0 : i % 3 == 1 ? v1 : v2;
+        const float a = 0.1f + bench_uniform(&s) * 0.8f;
+        for (int j = 0; j < 3; j++) {
+            c[i].v[0][0][j] = v0[j]; c[i].v[0][1][j] = v1[j]; c[i].v[0][2][j] = v2[j];
+            c[i].v[1][0][j] = v1[j]; c[i].v[1][1][j] = v0[j]; c[i].v[1][2][j] = v0[j] + v1[j] - v2[j];
+            c[i].o[j] = p->of[i][j];
+            c[i].d[0][j] = p->df[i][j];
+            c[i].d[1][j] = v0[j] + (v1[j] - v0[j]) * a - p->of[i][j];
+            c[i].d[2][j] = vertex[j] - p->of[i][j];
+        }
+        for (int k = 0; k < 3; k++) { normalize(c[i].d[k]); }
+    }
+}
+
+/* one lane of a packet against intersect_triangle() of the same float inputs
+   in double precision, bounds of intersect_triangle_simd.h, returns scalar hit */
+static int check_lane(check_t* c, const float of[3], const float df[3], const float w[3][3], int flags,
+                      int hit, float t, float u, float v) {
+    double o[3], d[3], v0[3], v1[3], v2[3], e1[3], e2[3], tv[3];
+    for (int j = 0; j < 3; j++) {
+        o[j] = of[j]; d[j] = df[j]; v0[j] = w[0][j]; v1[j] = w[1][j]; v2[j] = w[2][j];
+        e1[j] = v1[j] - v0[j]; e2[j] = v2[j] - v0[j]; tv[j] = o[j] - v0[j];
+    }
+    const double p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+    const double q[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+    const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    const double area = sqrt(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * sqrt(e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+    const double k = area / fabs(det); /* inf for det == 0 */
+    double t0, u0, v0_;
+    const int hit0 = intersect_triangle(o, d, v0, v1, v2, &t0, &u0, &v0_);
+    c->tests++;
+    if (hit0 && hit) {
+        c->dt = maximum(c->dt, fabs(t - t0) / (1e-6 * k * maximum(1, fabs(t0))));
+        c->du = maximum(c->du, fabs(u - u0) / (1e-5 * k));
+        c->dv = maximum(c->dv, fabs(v - v0_) / (1e-5 * k));
+    } else if (hit0 != hit) { /* barycentrics recomputed, intersect_triangle() returns before them on misses */
+        const double bu = (tv[0] * p[0] + tv[1] * p[1] + tv[2] * p[2]) / det;
+        const double bv = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+        const double band = 1e-5 * k, rounding = 8 * FLT_EPSILON * area, epsilon = 0.000001;
+        const int edge = fabs(bu) <= band || fabs(bu - 1) <= band || fabs(bv) <= band || fabs(bv - 1) <= band ||
+                         fabs(bu + bv) <= band || fabs(bu + bv - 1) <= band;
+        const int grazing = (flags & INTERSECT_WATERTIGHT) ? fabs(det) <= epsilon + rounding :
+                                                             fabs(fabs(det) - epsilon) <= rounding;
+        if (edge || grazing) { c->banded++; } else { c->mismatches++; }
+    }
+    return hit0;
+}
+
+/* bits 0 and 1 of the scalar and packet masks are the triangle and its neighbour */
+static void check_edge(check_t* c, int scalar, int mask) {
+    c->edges++;
+    c->cracks += (scalar & 3) != 0 && (mask & 3) == 0;
+    c->doubles += (mask & 3) == 3;
+}
+
+/* every ray of a case against a packet of the triangles and neighbours of the next n / 2 cases */
+static void check_ray_triangles(const case_t* c, int flags, check_t* r) {
+    triangles16_t p;
+    float t[16], u[16], v[16];
+    for (int i = 0; i < CASES; i++) {
+        const int n = 2 + i % 15;
+        for (int lane = 0; lane < 16; lane++) {
+            const float (*w)[3] = c[(i + lane / 2) % CASES].v[lane % 2];
+            triangles16_set(&p, lane, w[0], w[1], w[2]);
+        }
+        for (int k = 0; k < 3; k++) {
+            const int mask = intersect_ray_triangles(c[i].o, c[i].d[k], &p, n, flags, t, u, v);
+            int scalar = 0;
+            for (int lane = 0; lane < n; lane++) {
+                scalar |= check_lane(r, c[i].o, c[i].d[k], c[(i + lane / 2) % CASES].v[lane % 2], flags,
+                                     (mask >> lane) & 1, t[lane], u[lane], v[lane]) << lane;
+            }
+            if (k == 1) { check_edge(r, scalar, mask); }
+        }
+    }
+}
+
+/* triangle and neighbour of a case against a packet of the rays of the next n / 3 cases */
+static void check_rays_triangle(const case_t* c, int flags, check_t* r) {
+    rays8_t p;
+    float t[8], u[8], v[8];
+    for (int i = 0; i < CASES; i++) {
+        const int n = 2 + i % 7;
+        for (int lane = 0; lane < 8; lane++) {
+            const case_t* e = &c[(i + lane / 3) % CASES];
+            rays8_set(&p, lane, e->o, e->d[lane % 3]);
+        }
+        int scalar = 0, mask = 0; /* of the edge ray (lane 1) */
+        for (int s = 0; s < 2; s++) {
+            const float (*w)[3] = c[i].v[s];
+            const int m = intersect_rays_triangle(&p, n, w[0], w[1], w[2], flags, t, u, v);
+            for (int lane = 0; lane < n; lane++) {
+                const case_t* e = &c[(i + lane / 3) % CASES];
+                const int hit = check_lane(r, e->o, e->d[lane % 3], w, flags, (m >> lane) & 1, t[lane], u[lane], v[lane]);
+                if (lane == 1) { scalar |= hit << s; }
+            }
+            mask |= ((m >> 1) & 1) << s;
+        }
+        check_edge(r, scalar, mask);
+    }
+}
+
+static void report(const char* name, int flags, const check_t* r) {
+    printf("%-8s %-23s %-11s mismatches %d of %d (%d in bands), worst dt %.3f du %.3f dv %.3f of bounds\n"
+           "%55s shared edges %d cracks %d double hits %d\n", simd_name(simd_level()), name,
+           flags & INTERSECT_WATERTIGHT ? "watertight" : "", r->mismatches, r->tests, r->banded, r->dt, r->du, r->dv,
+           "", r->edges, r->cracks, r->doubles);
+}
+
+/* packets of intersect_triangle_simd.h at every simd level */
+static void check_packets(const pairs_t* p) {
+    case_t* c = (case_t*)malloc(sizeof(case_t) * CASES);
+    if (c == null) { printf("out of memory\n"); return; }
+    make_cases(p, c);
+    printf("packets against intersect_triangle, %d triangles with a neighbour across one edge, "
+           "rays random, at the shared edge and at a vertex\n", CASES);
+#ifdef SIMD_X86
+    const int levels[] = { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+#else
+    const int levels[] = { SIMD_SCALAR, SIMD_NEON };
+#endif
+    for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++) {
+        simd_force(levels[l]);
+        if (simd_level() != levels[l]) { continue; }
+        for (int flags = 0; flags <= INTERSECT_WATERTIGHT; flags += INTERSECT_WATERTIGHT) {
+            check_t r[2] = { { 0 }, { 0 } };
+            check_ray_triangles(c, flags, &r[0]);
+            check_rays_triangle(c, flags, &r[1]);
+            report("intersect_ray_triangles", flags, &r[0]);
+            report("intersect_rays_triangle", flags, &r[1]);
+        }
+    }
+    simd_force(-1);
+    free(c);
+}
+
+#define MEASURE(name, call) do {                                          \
+    int hits = 0;                                                         \
+    const double time = bench_seconds();                                  \
+    for (int r = 0; r < REPEAT; r++) {                                    \
+        for (int i = 0; i < PAIRS; i++) { hits += (call); }               \
+    }                                                                     \
+    const double rate = (double)PAIRS * REPEAT / (bench_seconds() - time); \
+    printf("%-34s %7.1f Mtests/s hit %.3f\n", name, rate / 1e6, (double)hits / (PAIRS * REPEAT)); \
+} while (0)
+
+/* bench triangle: throughput of compile time specialized ray/triangle kernels
+   and cross check of the packet kernels against intersect_triangle() */
+void bench_triangle(int argc, const char* argv[]) {
+    (void)argc; (void)argv;
+    pairs_t* p = (pairs_t*)malloc(sizeof(pairs_t));
+    if (p == null) { printf("out of memory\n"); return; }
+    make_pairs(p);
+    double t, u, v;
+    float tf, uf, vf;
+    MEASURE("intersect_triangle", intersect_triangle(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], &t, &u, &v));
+    MEASURE("intersect_triangle_cull", intersect_triangle_cull(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], &t, &u, &v));
+    MEASURE("intersect_triangle_range [0..1]", intersect_triangle_range(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], 0, 1, &t, &u, &v));
+    MEASURE("intersect_triangle_occluded [0..1]", intersect_triangle_occluded(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], 0, 1));
+    MEASURE("intersect_triangle_f", intersect_triangle_f(p->of[i], p->df[i], p->v0f[i], p->v1f[i], p->v2f[i], &tf, &uf, &vf));
+    MEASURE("intersect_triangle_cull_f", intersect_triangle_cull_f(p->of[i], p->df[i], p->v0f[i], p->v1f[i], p->v2f[i], &tf, &uf, &vf));
+    MEASURE("intersect_triangle_occluded_f", intersect_triangle_occluded_f(p->of[i], p->df[i], p->v0f[i], p->v1f[i], p->v2f[i], 0, 1));
+    MEASURE("intersect_triangle_occluded_cull_f", intersect_triangle_occluded_cull_f(p->of[i], p->df[i], p->v0f[i], p->v1f[i], p->v2f[i], 0, 1));
+    int mismatches = 0, culled = 0;
+    for (int i = 0; i < PAIRS; i++) { // variants against the reference
+        double t0, u0, v0, t1, u1, v1;
+        const int hit = intersect_triangle(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], &t0, &u0, &v0);
+        const int in_range = hit && 0 <= t0 && t0 <= 1;
+        mismatches += intersect_triangle_range(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], 0, 1, &t1, &u1, &v1) != in_range;
+        mismatches += in_range && (t0 != t1 || u0 != u1 || v0 != v1);
+        mismatches += intersect_triangle_occluded(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], 0, 1) != in_range;
+        const int front = intersect_triangle_cull(p->o[i], p->d[i], p->v0[i], p->v1[i], p->v2[i], &t1, &u1, &v1);
+        mismatches += front && (!hit || fabs(t1 - t0) > 1e-12 * maximum(1, fabs(t0)));
+        culled += hit && !front;
+    }
+    printf("mismatches against intersect_triangle %d of %d, back facing hits culled %d\n", mismatches, PAIRS * 4, culled);
+    check_packets(p);
+    free(p);
+}
+
+END_C
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "../src/bvh.h"
+#include "../src/threads.h"
+#include "../src/voxels.h"
+#include "../ext/intersections/intersections.h"
+
+BEGIN_C
+
+enum { CHECK_TRIANGLES = 2000, CHECK_CELLS = 20000, HITS = 64 };
+
+/* every cell triBoxOverlap() accepts for a sample of triangles must be set */
+static int surface_misses(const voxels_t* v, const mesh_t* m, uint64_t* seed) {
+    int misses = 0;
+    for (int i = 0; i < CHECK_TRIANGLES; i++) {
+        const float* p[3];
+        mesh_triangle(m, (int)(bench_random(seed) % (uint64_t)m->triangle_count), p);
+        float t[3][3];
+        int lo[3], hi[3];
+        for (int k = 0; k < 3; k++) {
+            for (int j = 0; j < 3; j++) { t[j][k] = (p[j][k] - v->origin[k]) * (1 / v->cell); } // as voxels.c
+            lo[k] = maximum(0, (int)floorf(minimum(t[0][k], minimum(t[1][k], t[2][k]))) - 1);
+            hi[k] = minimum(v->size[k] - 1, (int)floorf(maximum(t[0][k], maximum(t[1][k], t[2][k]))) + 1);
+        }
+        for (int z = lo[2]; z <= hi[2]; z++) {
+            for (int y = lo[1]; y <= hi[1]; y++) {
+                for (int x = lo[0]; x <= hi[0]; x++) {
+                    float center[3] = { x + 0.5f, y + 0.5f, z + 0.5f }, half[3] = { 0.5f, 0.5f, 0.5f };
+                    misses += triBoxOverlap(center, half, t) && !voxels_get(v, x, y, z);
+                }
+            }
+        }
+    }
+    return misses;
+}
+
+/* random cells against parity of all hits of rays along +x and -x: inside
+   cells must be set, outside cells only when they are surface cells.
+   Rays through the poles of the sphere may miss or double count
+   (intersect_triangle() is not watertight), cells where the two rays
+   disagree are not counted. */
+static int solid_mismatches(const voxels_t* v, const voxels_t* surface, const bvh_t* bvh, uint64_t* seed) {
+    int mismatches = 0;
+    for (int i = 0; i < CHECK_CELLS; i++) {
+        const int x = (int)(bench_random(seed) % (uint64_t)v->size[0]);
+        const int y = (int)(bench_random(seed) % (uint64_t)v->size[1]);
+        const int z = (int)(bench_random(seed) % (uint64_t)v->size[2]);
+        const float o[3] = { v->origin[0] + (x + 0.5f) * v->cell, v->origin[1] + (y + 0.5f) * v->cell,
+                             v->origin[2] + (z + 0.5f) * v->cell };
+        const float forward[3] = { 1, 0, 0 }, backward[3] = { -1, 0, 0 };
+        bvh_hit_t hits[HITS];
+        const int inside = bvh_all_hits(bvh, o, forward, 0, INFINITY, hits, HITS) & 1;
+        if (inside != (bvh_all_hits(bvh, o, backward, 0, INFINITY, hits, HITS) & 1)) { continue; }
+        const int set = voxels_get(v, x, y, z);
+        mismatches += inside ? !set : set && !voxels_get(surface, x, y, z);
+    }
+    return mismatches;
+}
+
+static void run(const bench_mesh_t* m, const bvh_t* bvh, int resolution) {
+    double time = bench_seconds();
+    voxels_t* s = voxels_create(&m->mesh, resolution, 0);
+    const double surface = bench_seconds() - time;
+    time = bench_seconds();
+    voxels_t* v = voxels_create(&m->mesh, resolution, VOXEL_SOLID);
+    const double solid = bench_seconds() - time;
+    if (s == null || v == null) {
+        printf("out of memory\n");
+    } else {
+        uint64_t seed = 3;
+        const double bytes = (double)v->brick_count * (sizeof(uint32_t) + sizeof(v->bricks[0]) + 1);
+        const double dense = (double)v->size[0] * v->size[1] * v->size[2] / 8;
+        const int misses = surface_misses(s, &m->mesh, &seed);
+        const int mismatches = solid_mismatches(v, s, bvh, &seed);
+        printf("%5d^3 surface %7.3f s solid %7.3f s, %8d bricks %8.1f MB (dense %8.1f MB), "
+               "surface misses %d, solid mismatches %d of %d\n",
+               resolution, surface, solid, v->brick_count, bytes / (1 << 20), dense / (1 << 20),
+               misses, mismatches, CHECK_CELLS);
+    }
+    voxels_destroy(s);
+    voxels_destroy(v);
+}
+
+/* bench voxels [triangles [resolution...]] */
+void bench_voxels(int argc, const char* argv[]) {
+    const int triangles = argc > 0 ? atoi(argv[0]) : 1000000;
+    bench_mesh_t m = {0};
+    bvh_t* bvh = bench_sphere(&m, triangles, 1) ? bvh_create(&m.mesh) : null;
+    if (bvh == null) {
+        printf("out of memory\n");
+    } else {
+        printf("%d triangles, %d threads\n", m.mesh.triangle_count, threads_count());
+        if (argc < 2) {
+            const int resolutions[] = { 256, 1024, 4096 };
+            for (int i = 0; i < 3; i++) { run(&m, bvh, resolutions[i]); }
+        }
+        for (int i = 1; i < argc; i++) { run(&m, bvh, atoi(argv[i])); }
+    }
+    bvh_destroy(bvh);
+    bench_mesh_free(&m);
+}
+
+END_C
@@ -0,0 +1,91 @@
+/*
+ * Per thread intersection counters, see counters.h
+ */
+#include "counters.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+static const char* names[COUNTER_COUNT] = {
+    "ray_triangle_calls", "ray_triangle_det", "ray_triangle_u", "ray_triangle_v", "ray_triangle_t",
+    "ray_triangle_hits",
+    "tri_tri_calls", "tri_tri_plane_v", "tri_tri_plane_u", "tri_tri_coplanar", "tri_tri_coplanar_hits",
+    "tri_tri_interval", "tri_tri_hits", "tri_tri_epsilon", "tri_tri_exact",
+    "tri_box_calls", "tri_box_axis", "tri_box_aabb", "tri_box_plane", "tri_box_hits"
+};
+
+const char* ext_counter_name(int counter) {
+    return 0 <= counter && counter < COUNTER_COUNT ? names[counter] : "";
+}
+
+#ifdef EXT_COUNTERS
+
+typedef struct slot_s {
+    _Alignas(64) uint64_t counts[COUNTER_COUNT];
+    atomic_int used;
+} slot_t;
+
+static slot_t slots[EXT_COUNTERS_THREADS];
+static uint64_t retired[COUNTER_COUNT]; /* counts of exited threads */
+static pthread_key_t key;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+_Alignas(64) uint64_t ext_counters_overflow[COUNTER_COUNT];
+
+__thread uint64_t* ext_counters_slot;
+
+static void release(void* p) {
+    slot_t* s = (slot_t*)p;
+    for (int j = 0; j < COUNTER_COUNT; j++) {
+        __atomic_fetch_add(&retired[j], __atomic_load_n(&s->counts[j], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        __atomic_store_n(&s->counts[j], 0, __ATOMIC_RELAXED);
+    }
+    ext_counters_slot = 0;
+    atomic_store_explicit(&s->used, 0, memory_order_release);
+}
+
+static void create_key(void) { pthread_key_create(&key, release); }
+
+uint64_t* ext_counters_claim(void) {
+    pthread_once(&once, create_key);
+    for (int i = 0; i < EXT_COUNTERS_THREADS; i++) {
+        int expected = 0;
+        if (atomic_load_explicit(&slots[i].used, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong_explicit(&slots[i].used, &expected, 1,
+                memory_order_acquire, memory_order_relaxed)) {
+            pthread_setspecific(key, &slots[i]);
+            ext_counters_slot = slots[i].counts;
+            return ext_counters_slot;
+        }
+    }
+    ext_counters_slot = ext_counters_overflow;
+    return ext_counters_slot;
+}
+
+void ext_counters_read(uint64_t counts[COUNTER_COUNT]) {
+    for (int j = 0; j < COUNTER_COUNT; j++) {
+        counts[j] = __atomic_load_n(&retired[j], __ATOMIC_RELAXED) +
+                    __atomic_load_n(&ext_counters_overflow[j], __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < EXT_COUNTERS_THREADS; i++) {
+        for (int j = 0; j < COUNTER_COUNT; j++) {
+            counts[j] += __atomic_load_n(&slots[i].counts[j], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void ext_counters_reset(void) {
+    for (int i = 0; i < EXT_COUNTERS_THREADS; i++) { memset(slots[i].counts, 0, sizeof(slots[i].counts)); }
+    memset(retired, 0, sizeof(retired));
+    memset(ext_counters_overflow, 0, sizeof(ext_counters_overflow));
+}
+
+#else
+
+void ext_counters_read(uint64_t counts[COUNTER_COUNT]) {
+    memset(counts, 0, sizeof(uint64_t) * COUNTER_COUNT);
+}
+
+void ext_counters_reset(void) { }
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+/*
+ * Optional per thread counters of where the intersection kernels of ext/
+ * leave: compiled in with -DEXT_COUNTERS, otherwise EXT_COUNT() is empty
+ * and ext_counters_read() returns zeros.
+ * Each thread increments its own cache line aligned slot: first use claims
+ * a free one, thread exit folds its counts into a retired total and frees
+ * it. Threads past EXT_COUNTERS_THREADS live ones share an overflow slot
+ * with atomic increments. ext_counters_read() sums the slots on demand
+ * with relaxed loads, totals read while kernels run are approximate.
+ */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum { /* every call leaves through exactly one of the counters after *_CALLS */
+    COUNTER_RAY_TRIANGLE_CALLS,    /* intersect_triangle*() */
+    COUNTER_RAY_TRIANGLE_DET,      /* |det| < EPSILON (det < EPSILON culling): ray parallel to plane */
+    COUNTER_RAY_TRIANGLE_U,        /* u outside [0..1] */
+    COUNTER_RAY_TRIANGLE_V,        /* v < 0 or u + v > 1 */
+    COUNTER_RAY_TRIANGLE_T,        /* t outside [tmin..tmax] */
+    COUNTER_RAY_TRIANGLE_HITS,
+    COUNTER_TRI_TRI_CALLS,         /* *tri_tri_intersect*() */
+    COUNTER_TRI_TRI_PLANE_V,       /* U is on one side of the plane of V */
+    COUNTER_TRI_TRI_PLANE_U,       /* V is on one side of the plane of U */
+    COUNTER_TRI_TRI_COPLANAR,      /* coplanar_tri_tri() missed */
+    COUNTER_TRI_TRI_COPLANAR_HITS, /* coplanar_tri_tri() hit */
+    COUNTER_TRI_TRI_INTERVAL,      /* disjoint intervals on the line of intersection */
+    COUNTER_TRI_TRI_HITS,
+    COUNTER_TRI_TRI_EPSILON,       /* not an exit: distances to a plane below EPSILON clamped to 0 */
+    COUNTER_TRI_TRI_EXACT,         /* not an exit: robust_tri_tri_intersect() orientations the filter left to exact arithmetic */
+    COUNTER_TRI_BOX_CALLS,         /* triBoxOverlap() */
+    COUNTER_TRI_BOX_AXIS,          /* separated along edge x {x,y,z} */
+    COUNTER_TRI_BOX_AABB,          /* separated along x, y or z */
+    COUNTER_TRI_BOX_PLANE,         /* box is on one side of the triangle plane */
+    COUNTER_TRI_BOX_HITS,
+    COUNTER_COUNT
+};
+
+enum { EXT_COUNTERS_THREADS = 256 };
+
+void ext_counters_read(uint64_t counts[COUNTER_COUNT]); /* sum of all threads */
+void ext_counters_reset(void); /* no kernel may run concurrently */
+const char* ext_counter_name(int counter);
+
+#ifdef EXT_COUNTERS
+
+extern __thread uint64_t* ext_counters_slot; /* null until first EXT_COUNT() of a thread */
+extern uint64_t ext_counters_overflow[COUNTER_COUNT];
+
+uint64_t* ext_counters_claim(void);
+
+static inline void ext_count(int counter) {
+    uint64_t* s = ext_counters_slot != 0 ? ext_counters_slot : ext_counters_claim();
+    if (s == ext_counters_overflow) {
+        __atomic_fetch_add(&s[counter], 1, __ATOMIC_RELAXED);
+    } else { /* only this thread writes: plain increment, atomic for the readers */
+        __atomic_store_n(&s[counter], __atomic_load_n(&s[counter], __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    }
+}
+
+#define EXT_COUNT(counter) ext_count(counter)
+
+#else
+
+#define EXT_COUNT(counter) ((void)0)
+
+#endif
+
+/* hit or miss counted, value of hit */
+#define EXT_COUNTED(hit, hits, misses) ((hit) ? (EXT_COUNT(hits), 1) : (EXT_COUNT(misses), 0))
+
+#ifdef __cplusplus
+}
+#endif
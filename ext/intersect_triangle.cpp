@@ -0,0 +1,79 @@
+/*
+ * C instantiations of intersect_triangle.hpp
+ * see intersect_triangle.h for the list
+ * https://en.wikipedia.org/wiki/Möller–Trumbore_intersection_algorithm
+ * http://fileadmin.cs.lth.se/cs/Personal/Tomas_Akenine-Moller/code/
+ */
+#include "intersect_triangle.h"
+#include "intersect_triangle.hpp"
+
+using namespace intersect;
+
+extern "C" {
+
+int intersect_triangle(double orig[3], double dir[3],
+                       double vert0[3], double vert1[3], double vert2[3],
+                       double *t, double *u, double *v) {
+    return triangle<double, TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, 0, 0, t, u, v);
+}
+
+int intersect_triangle_cull(double orig[3], double dir[3],
+                            double vert0[3], double vert1[3], double vert2[3],
+                            double *t, double *u, double *v) {
+    return triangle<double, TRIANGLE_CULL | TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, 0, 0, t, u, v);
+}
+
+int intersect_triangle_range(const double orig[3], const double dir[3],
+                             const double vert0[3], const double vert1[3], const double vert2[3],
+                             double tmin, double tmax, double *t, double *u, double *v) {
+    return triangle<double, TRIANGLE_RANGE | TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, tmin, tmax, t, u, v);
+}
+
+int intersect_triangle_occluded(const double orig[3], const double dir[3],
+                                const double vert0[3], const double vert1[3], const double vert2[3],
+                                double tmin, double tmax) {
+    double t;
+    return triangle<double, TRIANGLE_RANGE>(orig, dir, vert0, vert1, vert2, tmin, tmax, &t, 0, 0);
+}
+
+int intersect_triangle_f(const float orig[3], const float dir[3],
+                         const float vert0[3], const float vert1[3], const float vert2[3],
+                         float *t, float *u, float *v) {
+    return triangle<float, TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, 0, 0, t, u, v);
+}
+
+int intersect_triangle_cull_f(const float orig[3], const float dir[3],
+                              const float vert0[3], const float vert1[3], const float vert2[3],
+                              float *t, float *u, float *v) {
+    return triangle<float, TRIANGLE_CULL | TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, 0, 0, t, u, v);
+}
+
+int intersect_triangle_range_f(const float orig[3], const float dir[3],
+                               const float vert0[3], const float vert1[3], const float vert2[3],
+                               float tmin, float tmax, float *t, float *u, float *v) {
+    return triangle<float, TRIANGLE_RANGE | TRIANGLE_BARYCENTRIC>(orig, dir, vert0, vert1, vert2, tmin, tmax, t, u, v);
+}
+
+int intersect_triangle_occluded_f(const float orig[3], const float dir[3],
+                                  const float vert0[3], const float vert1[3], const float vert2[3],
+                                  float tmin, float tmax) {
+    float t;
+    return triangle<float, TRIANGLE_RANGE>(orig, dir, vert0, vert1, vert2, tmin, tmax, &t, 0, 0);
+}
+
+int intersect_triangle_occluded_cull_f(const float orig[3], const float dir[3],
+                                       const float vert0[3], const float vert1[3], const float vert2[3],
+                                       float tmin, float tmax) {
+    float t;
+    return triangle<float, TRIANGLE_CULL | TRIANGLE_RANGE>(orig, dir, vert0, vert1, vert2, tmin, tmax, &t, 0, 0);
+}
+
+} // extern "C"
+
+/*
+ "One advantage of this method is that the plane equation need not be computed on the fly
+ nor be stored, which can amount to significant memory savings for triangle meshes.
+ As we found our method to be comparable in speed to previous methods,
+ we believe it is the fastest ray-triangle intersection routine for triangles
+ that do not have precomputed plane equations." Tomas Moller and Ben Trumbore 1997
+ */
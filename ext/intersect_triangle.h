@@ -14,6 +14,55 @@
   https://en.wikipedia.org/wiki/Barycentric_coordinate_system
 */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 int intersect_triangle(double orig[3], double dir[3],
                        double vert0[3], double vert1[3], double vert2[3],
                        double *t, double *u, double *v);
+
+/*
+ intersect_triangle() and its variants are instantiated from
+ intersect_triangle.hpp (intersect_triangle.cpp):
+   _cull      back facing triangles (det < EPSILON) miss
+   _range     hits with t outside of [tmin..tmax] miss
+   _occluded  shadow rays: range checked, t, u, v are not computed
+   _f         single precision
+*/
+
+int intersect_triangle_cull(double orig[3], double dir[3],
+                            double vert0[3], double vert1[3], double vert2[3],
+                            double *t, double *u, double *v);
+
+int intersect_triangle_range(const double orig[3], const double dir[3],
+                             const double vert0[3], const double vert1[3], const double vert2[3],
+                             double tmin, double tmax, double *t, double *u, double *v);
+
+int intersect_triangle_occluded(const double orig[3], const double dir[3],
+                                const double vert0[3], const double vert1[3], const double vert2[3],
+                                double tmin, double tmax);
+
+int intersect_triangle_f(const float orig[3], const float dir[3],
+                         const float vert0[3], const float vert1[3], const float vert2[3],
+                         float *t, float *u, float *v);
+
+int intersect_triangle_cull_f(const float orig[3], const float dir[3],
+                              const float vert0[3], const float vert1[3], const float vert2[3],
+                              float *t, float *u, float *v);
+
+int intersect_triangle_range_f(const float orig[3], const float dir[3],
+                               const float vert0[3], const float vert1[3], const float vert2[3],
+                               float tmin, float tmax, float *t, float *u, float *v);
+
+int intersect_triangle_occluded_f(const float orig[3], const float dir[3],
+                                  const float vert0[3], const float vert1[3], const float vert2[3],
+                                  float tmin, float tmax);
+
+int intersect_triangle_occluded_cull_f(const float orig[3], const float dir[3],
+                                       const float vert0[3], const float vert1[3], const float vert2[3],
+                                       float tmin, float tmax);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+/*
+ * Tomas Moller and Ben Trumbore.
+ * Fast, minimum storage ray-triangle intersection.
+ * Journal of graphics tools, 2(1):21-28, 1997.
+ *
+ * Compile time specialized variants of intersect_triangle():
+ *     T                      float or double
+ *     TRIANGLE_CULL          back faces (det < EPSILON) miss, division is
+ *                            deferred until the hit is certain
+ *     TRIANGLE_RANGE         hits outside of [tmin..tmax] miss
+ *     TRIANGLE_BARYCENTRIC   u and v are written (t is always written)
+ * Without TRIANGLE_CULL the arithmetic is exactly the one of the original
+ * non culling code (intersect_triangle() is that instantiation). With culling the range test compares
+ * unscaled t against tmin * det and tmax * det which may differ from
+ * t in [tmin..tmax] by the rounding of a single division.
+ * C programs use the instantiations declared in intersect_triangle.h
+ */
+#include "counters.h"
+
+namespace intersect {
+
+enum {
+    TRIANGLE_CULL        = 1,
+    TRIANGLE_RANGE       = 2,
+    TRIANGLE_BARYCENTRIC = 4
+};
+
+template <typename T> inline T epsilon() { return T(0.000001); }
+
+template <typename T> inline void cross(T dest[3], const T v1[3], const T v2[3]) {
+    dest[0] = v1[1] * v2[2] - v1[2] * v2[1];
+    dest[1] = v1[2] * v2[0] - v1[0] * v2[2];
+    dest[2] = v1[0] * v2[1] - v1[1] * v2[0];
+}
+
+template <typename T> inline T dot(const T v1[3], const T v2[3]) {
+    return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
+}
+
+template <typename T> inline void sub(T dest[3], const T v1[3], const T v2[3]) {
+    dest[0] = v1[0] - v2[0];
+    dest[1] = v1[1] - v2[1];
+    dest[2] = v1[2] - v2[2];
+}
+
+/* flags are constant: the compiler removes the branches of other variants */
+template <typename T, int flags>
+inline int triangle(const T orig[3], const T dir[3],
+                    const T vert0[3], const T vert1[3], const T vert2[3],
+                    T tmin, T tmax, T* t, T* u, T* v) {
+    T edge1[3], edge2[3], tvec[3], pvec[3], qvec[3];
+    EXT_COUNT(COUNTER_RAY_TRIANGLE_CALLS);
+    sub(edge1, vert1, vert0); /* find vectors for two edges sharing vert0 */
+    sub(edge2, vert2, vert0);
+    cross(pvec, dir, edge2); /* begin calculating determinant - also used to calculate U parameter */
+    const T det = dot(edge1, pvec); /* if determinant is near zero, ray lies in plane of triangle */
+    if (flags & TRIANGLE_CULL) {
+        if (det < epsilon<T>()) { EXT_COUNT(COUNTER_RAY_TRIANGLE_DET); return 0; }
+        sub(tvec, orig, vert0); /* calculate distance from vert0 to ray origin */
+        const T uu = dot(tvec, pvec); /* calculate U parameter and test bounds */
+        if (uu < 0 || uu > det) { EXT_COUNT(COUNTER_RAY_TRIANGLE_U); return 0; }
+        cross(qvec, tvec, edge1); /* prepare to test V parameter */
+        const T vv = dot(dir, qvec); /* calculate V parameter and test bounds */
+        if (vv < 0 || uu + vv > det) { EXT_COUNT(COUNTER_RAY_TRIANGLE_V); return 0; }
+        const T tt = dot(edge2, qvec);
+        if ((flags & TRIANGLE_RANGE) && (tt < tmin * det || tt > tmax * det)) {
+            EXT_COUNT(COUNTER_RAY_TRIANGLE_T);
+            return 0;
+        }
+        const T inv_det = T(1) / det; /* ray intersects triangle, scale parameters */
+        *t = tt * inv_det;
+        if (flags & TRIANGLE_BARYCENTRIC) {
+            *u = uu * inv_det;
+            *v = vv * inv_det;
+        }
+    } else {
+        if (det > -epsilon<T>() && det < epsilon<T>()) { EXT_COUNT(COUNTER_RAY_TRIANGLE_DET); return 0; }
+        const T inv_det = T(1) / det;
+        sub(tvec, orig, vert0); /* calculate distance from vert0 to ray origin */
+        const T uu = dot(tvec, pvec) * inv_det; /* calculate U parameter and test bounds */
+        if (uu < 0 || uu > 1) { EXT_COUNT(COUNTER_RAY_TRIANGLE_U); return 0; }
+        cross(qvec, tvec, edge1); /* prepare to test V parameter */
+        const T vv = dot(dir, qvec) * inv_det; /* calculate V parameter and test bounds */
+        if (vv < 0 || uu + vv > 1) { EXT_COUNT(COUNTER_RAY_TRIANGLE_V); return 0; }
+        const T tt = dot(edge2, qvec) * inv_det; /* calculate t, ray intersects triangle */
+        if ((flags & TRIANGLE_RANGE) && (tt < tmin || tt > tmax)) {
+            EXT_COUNT(COUNTER_RAY_TRIANGLE_T);
+            return 0;
+        }
+        *t = tt;
+        if (flags & TRIANGLE_BARYCENTRIC) {
+            *u = uu;
+            *v = vv;
+        }
+    }
+    EXT_COUNT(COUNTER_RAY_TRIANGLE_HITS);
+    return 1;
+}
+
+} // namespace intersect
@@ -0,0 +1,154 @@
+/*
+ * Batched Moller-Trumbore and Woop-Benthin-Wald ray/triangle tests.
+ * see intersect_triangle_simd.h for semantics and tolerance
+ */
+#include "intersect_triangle_simd.h"
+#include "../src/simd.h"
+
+/* the avx2 and avx512 targets enable fma: a contracted product makes the
+   edge functions of a shared edge differ in more than sign (cracks and
+   double hits with INTERSECT_WATERTIGHT) */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define EPSILON 0.000001f
+
+void triangles16_set(triangles16_t* p, int lane, const float v0[3], const float v1[3], const float v2[3]) {
+    assert(0 <= lane && lane < 16);
+    for (int i = 0; i < 3; i++) {
+        p->v[0][i][lane] = v0[i];
+        p->v[1][i][lane] = v1[i];
+        p->v[2][i][lane] = v2[i];
+    }
+}
+
+void rays8_set(rays8_t* r, int lane, const float orig[3], const float dir[3]) {
+    assert(0 <= lane && lane < 8);
+    for (int i = 0; i < 3; i++) {
+        r->orig[i][lane] = orig[i];
+        r->dir[i][lane] = dir[i];
+    }
+}
+
+/* kz is dimension where ray direction is maximal, kx, ky swapped to preserve winding */
+static void watertight_setup(const float dir[3], int* kx, int* ky, int* kz, float* sx, float* sy, float* sz) {
+    const float ax = fabsf(dir[0]), ay = fabsf(dir[1]), az = fabsf(dir[2]);
+    int z = ax > ay ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2);
+    int x = z + 1 == 3 ? 0 : z + 1;
+    int y = x + 1 == 3 ? 0 : x + 1;
+    if (dir[z] < 0) { int swap = x; x = y; y = swap; }
+    *kx = x; *ky = y; *kz = z;
+    *sx = dir[x] / dir[z];
+    *sy = dir[y] / dir[z];
+    *sz = 1.0f / dir[z];
+}
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "intersect_triangle_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+
+#define ISA sse
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET SIMD_TARGET_SSE
+#include "intersect_triangle_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "intersect_triangle_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA avx512
+#define W 16
+#define VF f32x16
+#define VI i32x16
+#define TARGET SIMD_TARGET_AVX512
+#include "intersect_triangle_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#endif
+
+int intersect_ray_triangles(const float orig[3], const float dir[3],
+                            const triangles16_t* p, int n, int flags,
+                            float t[16], float u[16], float v[16]) {
+    assert(1 <= n && n <= 16);
+    int mask = 0;
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512:
+            mask = ray_triangles_avx512(orig, dir, p, 0, flags, t, u, v);
+            break;
+        case SIMD_AVX2:
+            mask = ray_triangles_avx2(orig, dir, p, 0, flags, t, u, v);
+            if (n > 8) { mask |= ray_triangles_avx2(orig, dir, p, 8, flags, t, u, v) << 8; }
+            break;
+        case SIMD_SSE:
+            for (int lane = 0; lane < n; lane += 4) {
+                mask |= ray_triangles_sse(orig, dir, p, lane, flags, t, u, v) << lane;
+            }
+            break;
+#endif
+        default:
+            for (int lane = 0; lane < n; lane += 4) {
+                mask |= ray_triangles_generic(orig, dir, p, lane, flags, t, u, v) << lane;
+            }
+            break;
+    }
+    return mask & ((1 << n) - 1);
+}
+
+int intersect_rays_triangle(const rays8_t* r, int n,
+                            const float vert0[3], const float vert1[3], const float vert2[3], int flags,
+                            float t[8], float u[8], float v[8]) {
+    assert(1 <= n && n <= 8);
+    int mask = 0;
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: /* 8 lanes fit ymm registers, avx2 kernel is the one */
+        case SIMD_AVX2:
+            mask = rays_triangle_avx2(r, 0, vert0, vert1, vert2, flags, t, u, v);
+            break;
+        case SIMD_SSE:
+            for (int lane = 0; lane < n; lane += 4) {
+                mask |= rays_triangle_sse(r, lane, vert0, vert1, vert2, flags, t, u, v) << lane;
+            }
+            break;
+#endif
+        default:
+            for (int lane = 0; lane < n; lane += 4) {
+                mask |= rays_triangle_generic(r, lane, vert0, vert1, vert2, flags, t, u, v) << lane;
+            }
+            break;
+    }
+    return mask & ((1 << n) - 1);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+/*
+ * Batched single precision variants of intersect_triangle():
+ * one ray against up to 16 triangles and 8 rays against one triangle,
+ * structure of arrays, kernels picked at runtime by simd_level().
+ * Unlike the scalar code in ext/ this one is not standalone: vector types,
+ * target attributes and simd_level() come from src/simd.h, link src/simd.c.
+ *
+ * Tomas Moller and Ben Trumbore.
+ * Fast, minimum storage ray-triangle intersection.
+ * Journal of graphics tools, 2(1):21-28, 1997.
+ *
+ * Sven Woop, Carsten Benthin, Ingo Wald.
+ * Watertight Ray/Triangle Intersection.
+ * Journal of Computer Graphics Techniques, 2(1):65-82, 2013.
+ * (INTERSECT_WATERTIGHT: no cracks on shared edges and vertices; edges are
+ *  inclusive, a ray exactly through a shared edge hits both triangles)
+ */
+
+/*
+ Semantics are the ones of the scalar non culling intersect_triangle():
+ det within +/-EPSILON (0.000001) is a miss, u, v, u + v must be in [0..1]
+ and t is NOT range checked (negative t is reported, callers test it).
+ t[], u[], v[] are written for all lanes but only hit lanes are meaningful.
+ Return value is the bitmask of hit lanes.
+
+ Tolerance against the double precision scalar path, for unit length ray
+ directions and with the conditioning k = |edge1| * |edge2| / |det|
+ (~1 for triangles facing the ray, large for grazing ones):
+     |u - u_scalar|, |v - v_scalar| <= 1.0e-5 * k
+     |t - t_scalar| <= 1.0e-6 * k * maximum(1, |t|)
+ hit/miss can only differ when the scalar u, v or u + v is within
+ 1.0e-5 * k of 0 or 1 or |det| is within float rounding of EPSILON.
+ With INTERSECT_WATERTIGHT there is no det epsilon (only det == 0 misses),
+ edges and vertices are inclusive and the same tolerance applies to t/u/v.
+*/
+
+enum {
+    INTERSECT_WATERTIGHT = 1
+};
+
+typedef struct triangles16_s { /* vertex[0..2] axis[x,y,z] lane[0..15] */
+    float v[3][3][16];
+} __attribute__((aligned(64))) triangles16_t;
+
+typedef struct rays8_s { /* axis[x,y,z] lane[0..7] */
+    float orig[3][8];
+    float dir[3][8];
+} __attribute__((aligned(64))) rays8_t;
+
+void triangles16_set(triangles16_t* p, int lane, const float v0[3], const float v1[3], const float v2[3]);
+void rays8_set(rays8_t* r, int lane, const float orig[3], const float dir[3]);
+
+/* 1 ray against first n (1..16) triangles of packet */
+int intersect_ray_triangles(const float orig[3], const float dir[3],
+                            const triangles16_t* p, int n, int flags,
+                            float t[16], float u[16], float v[16]);
+
+/* first n (1..8) rays of packet against 1 triangle */
+int intersect_rays_triangle(const rays8_t* r, int n,
+                            const float vert0[3], const float vert1[3], const float vert2[3], int flags,
+                            float t[8], float u[8], float v[8]);
@@ -0,0 +1,177 @@
+/* width generic kernels of intersect_triangle_simd.c
+   included once per instruction set with:
+       ISA     name suffix
+       W       lanes
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+*/
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline void FN(store)(float* p, VF v) { memcpy(p, &v, sizeof(v)); }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VI FN(splati)(int32_t s) {
+    VI r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline int FN(movemask)(VI m) {
+    int r = 0;
+    for (int i = 0; i < W; i++) { r |= (m[i] != 0) << i; }
+    return r;
+}
+
+/* Moller-Trumbore for one lane set, everything in vectors (ray and/or triangle may be broadcast) */
+static TARGET inline int FN(moller_trumbore)(const VF o[3], const VF d[3], const VF v0[3], const VF v1[3], const VF v2[3],
+                                             VF* t, VF* u, VF* v) {
+    VF e1[3] = { v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2] };
+    VF e2[3] = { v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2] };
+    VF p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+    VF det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    VF inv_det = FN(splat)(1.0f) / det;
+    VF tv[3] = { o[0] - v0[0], o[1] - v0[1], o[2] - v0[2] };
+    *u = (tv[0] * p[0] + tv[1] * p[1] + tv[2] * p[2]) * inv_det;
+    VF q[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+    *v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv_det;
+    *t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+    const VF zero = FN(splat)(0), one = FN(splat)(1), eps = FN(splat)(EPSILON);
+    VI hit = (det <= -eps) | (det >= eps);
+    hit &= (*u >= zero) & (*u <= one) & (*v >= zero) & (*u + *v <= one);
+    return FN(movemask)(hit);
+}
+
+/* Woop, Benthin, Wald watertight test, a[], b[], c[] are vertices relative to ray origin
+   already permuted to (kx, ky, kz) of each lane; sx, sy, sz shear constants of each lane */
+static TARGET inline int FN(watertight)(const VF a[3], const VF b[3], const VF c[3],
+                                        VF sx, VF sy, VF sz, VF* t, VF* u, VF* v) {
+    VF ax = a[0] - sx * a[2], ay = a[1] - sy * a[2];
+    VF bx = b[0] - sx * b[2], by = b[1] - sy * b[2];
+    VF cx = c[0] - sx * c[2], cy = c[1] - sy * c[2];
+    VF U = cx * by - cy * bx;
+    VF V = ax * cy - ay * cx;
+    VF X = bx * ay - by * ax;
+    const VF zero = FN(splat)(0);
+    int edge = FN(movemask)((U == zero) | (V == zero) | (X == zero));
+    if (edge != 0) { /* recompute edge functions in double precision for lanes exactly on an edge */
+        for (int i = 0; i < W; i++) {
+            if (edge & (1 << i)) {
+                U[i] = (float)((double)cx[i] * (double)by[i] - (double)cy[i] * (double)bx[i]);
+                V[i] = (float)((double)ax[i] * (double)cy[i] - (double)ay[i] * (double)cx[i]);
+                X[i] = (float)((double)bx[i] * (double)ay[i] - (double)by[i] * (double)ax[i]);
+            }
+        }
+    }
+    VI miss = ((U < zero) | (V < zero) | (X < zero)) & ((U > zero) | (V > zero) | (X > zero));
+    VF det = U + V + X;
+    miss |= det == zero;
+    VF T = U * (sz * a[2]) + V * (sz * b[2]) + X * (sz * c[2]);
+    VF inv_det = FN(splat)(1.0f) / det;
+    *t = T * inv_det;
+    *u = V * inv_det;
+    *v = X * inv_det;
+    return FN(movemask)(~miss);
+}
+
+/* one ray against lanes [lane..lane + W) of triangle packet */
+static TARGET int FN(ray_triangles)(const float orig[3], const float dir[3], const triangles16_t* p, int lane,
+                                    int flags, float* t, float* u, float* v) {
+    VF vt, vu, vv;
+    int mask;
+    if (flags & INTERSECT_WATERTIGHT) {
+        int kx, ky, kz;
+        float sx, sy, sz;
+        watertight_setup(dir, &kx, &ky, &kz, &sx, &sy, &sz);
+        const int k[3] = { kx, ky, kz };
+        VF a[3], b[3], c[3];
+        for (int i = 0; i < 3; i++) {
+            VF o = FN(splat)(orig[k[i]]);
+            a[i] = FN(load)(&p->v[0][k[i]][lane]) - o;
+            b[i] = FN(load)(&p->v[1][k[i]][lane]) - o;
+            c[i] = FN(load)(&p->v[2][k[i]][lane]) - o;
+        }
+        mask = FN(watertight)(a, b, c, FN(splat)(sx), FN(splat)(sy), FN(splat)(sz), &vt, &vu, &vv);
+    } else {
+        VF o[3], d[3], v0[3], v1[3], v2[3];
+        for (int i = 0; i < 3; i++) {
+            o[i] = FN(splat)(orig[i]);
+            d[i] = FN(splat)(dir[i]);
+            v0[i] = FN(load)(&p->v[0][i][lane]);
+            v1[i] = FN(load)(&p->v[1][i][lane]);
+            v2[i] = FN(load)(&p->v[2][i][lane]);
+        }
+        mask = FN(moller_trumbore)(o, d, v0, v1, v2, &vt, &vu, &vv);
+    }
+    FN(store)(t + lane, vt);
+    FN(store)(u + lane, vu);
+    FN(store)(v + lane, vv);
+    return mask;
+}
+
+#if W <= 8 /* ray packets are 8 wide */
+
+/* rays [lane..lane + W) of ray packet against one triangle */
+static TARGET int FN(rays_triangle)(const rays8_t* r, int lane, const float* vert0, const float* vert1, const float* vert2,
+                                    int flags, float* t, float* u, float* v) {
+    VF vt, vu, vv;
+    int mask;
+    if (flags & INTERSECT_WATERTIGHT) {
+        VI kx, ky, kz;
+        VF sx, sy, sz;
+        for (int i = 0; i < W; i++) {
+            const float d[3] = { r->dir[0][lane + i], r->dir[1][lane + i], r->dir[2][lane + i] };
+            int x, y, z;
+            watertight_setup(d, &x, &y, &z, &sx[i], &sy[i], &sz[i]);
+            kx[i] = x; ky[i] = y; kz[i] = z;
+        }
+        VF a[3], b[3], c[3]; /* per axis first, then permuted per lane below */
+        for (int i = 0; i < 3; i++) {
+            VF o = FN(load)(&r->orig[i][lane]);
+            a[i] = FN(splat)(vert0[i]) - o;
+            b[i] = FN(splat)(vert1[i]) - o;
+            c[i] = FN(splat)(vert2[i]) - o;
+        }
+        VF pa[3], pb[3], pc[3];
+        const VI k[3] = { kx, ky, kz };
+        const VI k0 = FN(splati)(0), k1 = FN(splati)(1);
+        for (int i = 0; i < 3; i++) {
+            VI m0 = k[i] == k0, m1 = k[i] == k1;
+            pa[i] = FN(select)(m0, a[0], FN(select)(m1, a[1], a[2]));
+            pb[i] = FN(select)(m0, b[0], FN(select)(m1, b[1], b[2]));
+            pc[i] = FN(select)(m0, c[0], FN(select)(m1, c[1], c[2]));
+        }
+        mask = FN(watertight)(pa, pb, pc, sx, sy, sz, &vt, &vu, &vv);
+    } else {
+        VF o[3], d[3], v0[3], v1[3], v2[3];
+        for (int i = 0; i < 3; i++) {
+            o[i] = FN(load)(&r->orig[i][lane]);
+            d[i] = FN(load)(&r->dir[i][lane]);
+            v0[i] = FN(splat)(vert0[i]);
+            v1[i] = FN(splat)(vert1[i]);
+            v2[i] = FN(splat)(vert2[i]);
+        }
+        mask = FN(moller_trumbore)(o, d, v0, v1, v2, &vt, &vu, &vv);
+    }
+    FN(store)(t + lane, vt);
+    FN(store)(u + lane, vu);
+    FN(store)(v + lane, vv);
+    return mask;
+}
+
+#endif
+
+#undef FN
+#undef PASTE
+#undef PASTE_
@@ -0,0 +1,118 @@
+/*
+ * Batched fromToRotation().
+ * see fromtorot_simd.h for layout and tolerance
+ */
+#include "fromtorot_simd.h"
+#include "../../src/simd.h"
+#include "../../src/threads.h"
+
+#define EPSILON 0.000001f
+
+enum {
+    LANES = 16,        // widest kernel
+    CHUNK = 16 * 1024, // lanes per parallel_for() body call, multiple of LANES
+    PARALLEL = 4 * CHUNK
+};
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "fromtorot_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "fromtorot_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA avx512
+#define W 16
+#define VF f32x16
+#define VI i32x16
+#define TARGET SIMD_TARGET_AVX512
+#include "fromtorot_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#endif
+
+typedef struct rotations_s {
+    const float* const* from;
+    const float* const* to;
+    float* const* m;
+    float* const* q;
+} rotations_t;
+
+typedef void (*kernel_t)(const float* const from[3], const float* const to[3], int i,
+                         float* const m[9], float* const q[4]);
+
+static int kernel(kernel_t* k) {
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: *k = rotations_avx512; return 16;
+        case SIMD_AVX2: *k = rotations_avx2; return 8;
+#endif
+        default: *k = rotations_generic; return 4;
+    }
+}
+
+/* lanes [from..to), to - from < W only at the end of the batch */
+static void rotations(const rotations_t* r, int from, int to) {
+    kernel_t k;
+    const int w = kernel(&k);
+    int i = from;
+    for (; i + w <= to; i += w) { k(r->from, r->to, i, r->m, r->q); }
+    if (i < to) { // tail through zero padded copies, padding lanes rotate x to x
+        const int n = to - i;
+        float in[6][LANES] = {0};
+        float out[13][LANES];
+        const float* f[3] = { in[0], in[1], in[2] };
+        const float* t[3] = { in[3], in[4], in[5] };
+        float* m[9];
+        float* q[4];
+        for (int j = 0; j < 3; j++) {
+            memcpy(in[j], r->from[j] + i, n * sizeof(float));
+            memcpy(in[3 + j], r->to[j] + i, n * sizeof(float));
+        }
+        for (int j = n; j < w; j++) { in[0][j] = 1; in[3][j] = 1; }
+        for (int j = 0; j < 9; j++) { m[j] = out[j]; }
+        for (int j = 0; j < 4; j++) { q[j] = out[9 + j]; }
+        k(f, t, 0, r->m != null ? m : null, r->q != null ? q : null);
+        for (int j = 0; j < 9 && r->m != null; j++) { memcpy(r->m[j] + i, m[j], n * sizeof(float)); }
+        for (int j = 0; j < 4 && r->q != null; j++) { memcpy(r->q[j] + i, q[j], n * sizeof(float)); }
+    }
+}
+
+static void rotations_body(void* that, int i, int j) {
+    rotations(that, i * CHUNK, j * CHUNK);
+}
+
+void from_to_rotations(const float* const from[3], const float* const to[3], int n,
+                       float* const m[9], float* const q[4]) {
+    rotations_t r = { from, to, m, q };
+    if (n < PARALLEL || threads_count() <= 1) {
+        rotations(&r, 0, n);
+    } else {
+        const int chunks = n / CHUNK;
+        parallel_for(0, chunks, 1, &r, rotations_body);
+        rotations(&r, chunks * CHUNK, n);
+    }
+}
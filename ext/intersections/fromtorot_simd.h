@@ -0,0 +1,34 @@
+#pragma once
+/*
+ * Batched fromToRotation(): structure of arrays in and out,
+ * kernels picked at runtime by simd_level(), large batches
+ * are split across threads (needs src/simd.c and src/threads.c).
+ *
+ * Tomas Moller, John F. Hughes.
+ * Efficiently Building a Matrix to Rotate One Vector to Another.
+ * Journal of Graphics Tools, 4(4):1-4, 1999.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ from[axis][i] and to[axis][i] must be normalized. Lanes compute both the
+ general and the near parallel (|from . to| > 1 - EPSILON) case of
+ fromToRotation() and blend them, there are no branches on data.
+ m[r * 3 + c][i] is mtx[r][c] of fromToRotation(),
+ q[0..3][i] is quaternion x, y, z, w of the same rotation.
+ Either m or q may be null. Matrices are orthonormal within 1.0e-5 and
+ match fromToRotation() within 1.0e-5 except:
+   close to the parallel switch where fromToRotation() jumps by ~2.0e-3
+   and the last bit of from . to (fused multiply add) may pick the other side;
+   1 + (from . to) < 0.1 where its h = 1 / (1 + e) loses precision and
+   no longer gives orthonormal matrices below ~1.0e-3.
+*/
+void from_to_rotations(const float* const from[3], const float* const to[3], int n,
+                       float* const m[9], float* const q[4]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+/* width generic kernel of fromtorot_simd.c
+   included once per instruction set with:
+       ISA     name suffix
+       W       lanes
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+*/
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline void FN(store)(float* p, VF v) { memcpy(p, &v, sizeof(v)); }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline VF FN(abs)(VF a) {
+    VI mask;
+    for (int i = 0; i < W; i++) { mask[i] = 0x7FFFFFFF; }
+    return (VF)((VI)a & mask);
+}
+
+static TARGET inline VF FN(sqrt)(VF a) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = sqrtf(a[i]); }
+    return r;
+}
+
+/* lanes [i..i + W) */
+static TARGET void FN(rotations)(const float* const from[3], const float* const to[3], int i,
+                                 float* const m[9], float* const q[4]) {
+    const VF zero = FN(splat)(0), one = FN(splat)(1), two = FN(splat)(2);
+    const VF f[3] = { FN(load)(from[0] + i), FN(load)(from[1] + i), FN(load)(from[2] + i) };
+    const VF t[3] = { FN(load)(to[0] + i), FN(load)(to[1] + i), FN(load)(to[2] + i) };
+    const VF v[3] = { f[1] * t[2] - f[2] * t[1], f[2] * t[0] - f[0] * t[2], f[0] * t[1] - f[1] * t[0] };
+    const VF e = f[0] * t[0] + f[1] * t[1] + f[2] * t[2];
+    const VI parallel = FN(abs)(e) > FN(splat)(1.0f - EPSILON);
+    // general case with h = (1 - e) / (v . v) of the paper: 1 + e of the
+    // faster h = 1 / (1 + e) has no significant bits left near e = -1.
+    // Infinite h of parallel lanes is blended away below.
+    const VF h = (one - e) / (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    const VF hvx = h * v[0], hvz = h * v[2];
+    const VF hvxy = hvx * v[1], hvxz = hvx * v[2], hvyz = hvz * v[1];
+    VF r[3][3] = {
+        { e + hvx * v[0], hvxy - v[2],        hvxz + v[1] },
+        { hvxy + v[2],    e + h * v[1] * v[1], hvyz - v[0] },
+        { hvxz - v[1],    hvyz + v[0],        e + hvz * v[2] }
+    };
+    // near parallel: reflect from to the axis x most nearly orthogonal to it, then x to to
+    const VF a[3] = { FN(abs)(f[0]), FN(abs)(f[1]), FN(abs)(f[2]) };
+    const VI ax = (a[0] < a[1]) & (a[0] < a[2]);
+    const VI ay = ~(a[0] < a[1]) & (a[1] < a[2]);
+    const VI az = ~(ax | ay);
+    const VF x[3] = { FN(select)(ax, one, zero), FN(select)(ay, one, zero), FN(select)(az, one, zero) };
+    const VF u[3] = { x[0] - f[0], x[1] - f[1], x[2] - f[2] };
+    const VF w[3] = { x[0] - t[0], x[1] - t[1], x[2] - t[2] };
+    const VF c1 = two / (u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    const VF c2 = two / (w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    const VF c3 = c1 * c2 * (u[0] * w[0] + u[1] * w[1] + u[2] * w[2]);
+    for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) {
+            VF p = c3 * w[j] * u[k] - c1 * u[j] * u[k] - c2 * w[j] * w[k];
+            if (j == k) { p += one; }
+            r[j][k] = FN(select)(parallel, p, r[j][k]);
+        }
+    }
+    if (m != null) {
+        for (int j = 0; j < 9; j++) { FN(store)(m[j] + i, r[j / 3][j % 3]); }
+    }
+    if (q != null) { // Shepperd: largest of w, x, y, z from the diagonal, the rest from off diagonal sums
+        const VF trace = r[0][0] + r[1][1] + r[2][2];
+        const VI qw = trace > zero;
+        const VI qx = ~qw & (r[0][0] >= r[1][1]) & (r[0][0] >= r[2][2]);
+        const VI qy = ~qw & ~qx & (r[1][1] >= r[2][2]);
+        const VF s = FN(sqrt)(FN(select)(qw, one + trace,
+                              FN(select)(qx, one + r[0][0] - r[1][1] - r[2][2],
+                              FN(select)(qy, one - r[0][0] + r[1][1] - r[2][2],
+                                              one - r[0][0] - r[1][1] + r[2][2])))) * two;
+        const VF inv = one / s, half = s * FN(splat)(0.25f);
+        const VF dx = (r[2][1] - r[1][2]) * inv, dy = (r[0][2] - r[2][0]) * inv, dz = (r[1][0] - r[0][1]) * inv;
+        const VF sxy = (r[0][1] + r[1][0]) * inv, sxz = (r[0][2] + r[2][0]) * inv, syz = (r[1][2] + r[2][1]) * inv;
+        FN(store)(q[0] + i, FN(select)(qw, dx, FN(select)(qx, half, FN(select)(qy, sxy, sxz))));
+        FN(store)(q[1] + i, FN(select)(qw, dy, FN(select)(qx, sxy, FN(select)(qy, half, syz))));
+        FN(store)(q[2] + i, FN(select)(qw, dz, FN(select)(qx, sxz, FN(select)(qy, syz, half))));
+        FN(store)(q[3] + i, FN(select)(qw, half, FN(select)(qx, dx, FN(select)(qy, dy, dz))));
+    }
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
@@ -0,0 +1,41 @@
+#pragma once
+/*
+ * Tomas Moller, Tomas Akenine-Moller, John Hughes.
+ * Triangle/triangle, triangle/box intersection and vector to vector rotation,
+ * see the comments at the top of each source file for details.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* opttritri.c: returns 1 if the triangles intersect, otherwise 0 */
+int no_div_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
+                             float U0[3], float U1[3], float U2[3]);
+
+/* tritri_isectline.c */
+int tri_tri_intersect(float V0[3], float V1[3], float V2[3],
+                      float U0[3], float U1[3], float U2[3]);
+
+int no_div_tri_tri_intersect_line(float V0[3], float V1[3], float V2[3],
+                                  float U0[3], float U1[3], float U2[3]);
+
+/* *coplanar is set when triangles are coplanar, the segment is not computed then */
+int tri_tri_intersect_line(float V0[3], float V1[3], float V2[3],
+                           float U0[3], float U1[3], float U2[3], int *coplanar,
+                           float isectpt1[3], float isectpt2[3]);
+
+/* tritri_robust.c: exact, touching triangles intersect, zero area triangles
+   are the segment or point they cover, symmetric in V and U */
+int robust_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
+                             float U0[3], float U1[3], float U2[3]);
+
+/* tribox3.c */
+int triBoxOverlap(float boxcenter[3], float boxhalfsize[3], float triverts[3][3]);
+
+/* fromtorot.c: from and to must be normalized, mtx is column-major */
+void fromToRotation(float from[3], float to[3], float mtx[3][3]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,15 @@
  *
  */
 #include <math.h>
+#include "../counters.h"
+
+/* no fused multiply add: no_div_tri_tri_intersect_n() (tritri_simd.c)
+   reproduces the results of this test bit for bit */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
 
 #define FABS(x) ((float)fabs(x)) /* implement as is fastest on your machine */
 
@@ -169,7 +178,7 @@ static int coplanar_tri_tri(float N[3],float V0[3],float V1[3],float V2[3],
     else \
     { \
         /* triangles are coplanar */ \
-        return coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2); \
+        return EXT_COUNTED(coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR); \
     } \
 }
 
@@ -185,6 +194,7 @@ int no_div_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
     float vp0, vp1, vp2;
     float up0, up1, up2;
     float bb, cc, max;
+    EXT_COUNT(COUNTER_TRI_TRI_CALLS);
     /* compute plane equation of triangle(V0,V1,V2) */
     SUB(E1,V1,V0);
     SUB(E2,V2,V0);
@@ -197,14 +207,14 @@ int no_div_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
     du2 = DOT(N1,U2)+d1;
     /* coplanarity robustness check */
 #if USE_EPSILON_TEST==TRUE
-    if (FABS(du0) < EPSILON) du0 = 0.0;
-    if (FABS(du1) < EPSILON) du1 = 0.0;
-    if (FABS(du2) < EPSILON) du2 = 0.0;
+    if (FABS(du0) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du0 = 0.0; }
+    if (FABS(du1) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du1 = 0.0; }
+    if (FABS(du2) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du2 = 0.0; }
 #endif
     du0du1 = du0*du1;
     du0du2 = du0*du2;
     if (du0du1 > 0.0f && du0du2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_V); return 0; } /* no intersection occurs */
     /* compute plane of triangle (U0,U1,U2) */
     SUB(E1,U1,U0);
     SUB(E2,U2,U0);
@@ -216,14 +226,14 @@ int no_div_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
     dv1 = DOT(N2,V1)+d2;
     dv2 = DOT(N2,V2)+d2;
 #if USE_EPSILON_TEST==TRUE
-    if (FABS(dv0) < EPSILON) dv0 = 0.0;
-    if (FABS(dv1) < EPSILON) dv1 = 0.0;
-    if (FABS(dv2) < EPSILON) dv2 = 0.0;
+    if (FABS(dv0) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv0 = 0.0; }
+    if (FABS(dv1) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv1 = 0.0; }
+    if (FABS(dv2) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv2 = 0.0; }
 #endif
     dv0dv1 = dv0*dv1;
     dv0dv2 = dv0*dv2;
     if (dv0dv1 > 0.0f && dv0dv2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_U); return 0; } /* no intersection occurs */
     /* compute direction of intersection line */
     CROSS(D,N1,N2);
     /* compute and index to the largest component of D */
@@ -258,6 +268,7 @@ int no_div_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
     isect2[1] = tmp + f * xx * y0;
     SORT(isect1[0], isect1[1]);
     SORT(isect2[0], isect2[1]);
-    if (isect1[1] < isect2[0] || isect2[1] < isect1[0]) return 0;
+    if (isect1[1] < isect2[0] || isect2[1] < isect1[0]) { EXT_COUNT(COUNTER_TRI_TRI_INTERVAL); return 0; }
+    EXT_COUNT(COUNTER_TRI_TRI_HITS);
     return 1;
 }
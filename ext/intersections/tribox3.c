@@ -14,6 +14,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include "../counters.h"
 
 #define X 0
 #define Y 1
@@ -64,14 +65,14 @@ int planeBoxOverlap(float normal[3], float vert[3], float maxbox[3]) { // -NJMP-
     p2 = a * v2[Y] - b * v2[Z];                                       \
     if (p0 < p2) { min = p0; max = p2; } else { min = p2; max = p0; } \
     rad = fa * boxhalfsize[Y] + fb * boxhalfsize[Z];                  \
-    if (min > rad || max < -rad) return 0;
+    if (min > rad || max < -rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 #define AXISTEST_X2(a, b, fa, fb)                                     \
     p0 = a * v0[Y] - b * v0[Z];                                       \
     p1 = a * v1[Y] - b * v1[Z];                                       \
     if (p0 < p1) { min = p0; max = p1; } else { min = p1; max = p0; } \
     rad = fa * boxhalfsize[Y] + fb * boxhalfsize[Z];                  \
-    if (min > rad || max<-rad) return 0;
+    if (min > rad || max<-rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 /*======================== Y-tests ========================*/
 
@@ -80,14 +81,14 @@ int planeBoxOverlap(float normal[3], float vert[3], float maxbox[3]) { // -NJMP-
     p2 = -a*v2[X] + b*v2[Z];                                          \
     if (p0 < p2) { min = p0; max = p2; } else { min = p2; max = p0; } \
     rad = fa * boxhalfsize[X] + fb * boxhalfsize[Z];                  \
-    if(min>rad || max<-rad) return 0;
+    if(min>rad || max<-rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 #define AXISTEST_Y1(a, b, fa, fb)                                     \
     p0 = -a*v0[X] + b*v0[Z];                                          \
     p1 = -a*v1[X] + b*v1[Z];                                          \
     if (p0 < p1) { min = p0; max = p1; } else { min = p1; max = p0; } \
     rad = fa * boxhalfsize[X] + fb * boxhalfsize[Z];                  \
-    if (min > rad || max < -rad) return 0;
+    if (min > rad || max < -rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 /*======================== Z-tests ========================*/
 
@@ -96,14 +97,14 @@ int planeBoxOverlap(float normal[3], float vert[3], float maxbox[3]) { // -NJMP-
     p2 = a*v2[X] - b*v2[Y];                                           \
     if (p2 < p1) { min = p2; max = p1; } else { min = p1; max = p2; } \
     rad = fa * boxhalfsize[X] + fb * boxhalfsize[Y];                  \
-    if(min>rad || max < -rad) return 0;
+    if(min>rad || max < -rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 #define AXISTEST_Z0(a, b, fa, fb)                                     \
     p0 = a*v0[X] - b*v0[Y];                                           \
     p1 = a*v1[X] - b*v1[Y];                                           \
     if (p0 < p1) { min = p0; max = p1; } else { min = p1; max = p0; } \
     rad = fa * boxhalfsize[X] + fb * boxhalfsize[Y];                  \
-    if (min>rad || max<-rad) return 0;
+    if (min>rad || max<-rad) { EXT_COUNT(COUNTER_TRI_BOX_AXIS); return 0; }
 
 int triBoxOverlap(float boxcenter[3],float boxhalfsize[3],float triverts[3][3]) {
   /*    use separating axis theorem to test overlap between triangle and box */
@@ -117,6 +118,7 @@ int triBoxOverlap(float boxcenter[3],float boxhalfsize[3],float triverts[3][3])
 //  float axis[3];
     float min,max,p0,p1,p2,rad,fex,fey,fez;		// -NJMP- "d" local variable removed
     float normal[3],e0[3],e1[3],e2[3];
+    EXT_COUNT(COUNTER_TRI_BOX_CALLS);
     /* This is the fastest branch on Sun */
     /* move everything so that the boxcenter is in (0,0,0) */
     SUB(v0,triverts[0],boxcenter);
@@ -153,18 +155,19 @@ int triBoxOverlap(float boxcenter[3],float boxhalfsize[3],float triverts[3][3])
     /*  the triangle against the AABB */
     /* test in X-direction */
     FINDMINMAX(v0[X],v1[X],v2[X],min,max);
-    if(min>boxhalfsize[X] || max<-boxhalfsize[X]) return 0;
+    if(min>boxhalfsize[X] || max<-boxhalfsize[X]) { EXT_COUNT(COUNTER_TRI_BOX_AABB); return 0; }
     /* test in Y-direction */
     FINDMINMAX(v0[Y],v1[Y],v2[Y],min,max);
-    if(min>boxhalfsize[Y] || max<-boxhalfsize[Y]) return 0;
+    if(min>boxhalfsize[Y] || max<-boxhalfsize[Y]) { EXT_COUNT(COUNTER_TRI_BOX_AABB); return 0; }
     /* test in Z-direction */
     FINDMINMAX(v0[Z],v1[Z],v2[Z],min,max);
-    if(min>boxhalfsize[Z] || max<-boxhalfsize[Z]) return 0;
+    if(min>boxhalfsize[Z] || max<-boxhalfsize[Z]) { EXT_COUNT(COUNTER_TRI_BOX_AABB); return 0; }
     /* Bullet 2: */
     /*  test if the box intersects the plane of the triangle */
     /*  compute plane equation of triangle: normal*x+d=0 */
     CROSS(normal,e0,e1);
     // -NJMP- (line removed here)
-    if(!planeBoxOverlap(normal,v0,boxhalfsize)) return 0;	// -NJMP-
+    if(!planeBoxOverlap(normal,v0,boxhalfsize)) { EXT_COUNT(COUNTER_TRI_BOX_PLANE); return 0; }	// -NJMP-
+    EXT_COUNT(COUNTER_TRI_BOX_HITS);
     return 1;   /* box and triangle overlaps */
 }
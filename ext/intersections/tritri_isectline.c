@@ -24,6 +24,7 @@
  */
 
 #include <math.h>
+#include "../counters.h"
 
 #define FABS(x) ((float)fabs(x))        /* implement as is fastest on your machine */
 
@@ -94,7 +95,7 @@
   else                                                  \
   {                                                     \
     /* triangles are coplanar */                        \
-    return coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2);      \
+    return EXT_COUNTED(coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR);      \
   }
 
 
@@ -222,6 +223,7 @@ int tri_tri_intersect(float V0[3],float V1[3],float V2[3],
   float up0,up1,up2;
   float b,c,max;
 
+  EXT_COUNT(COUNTER_TRI_TRI_CALLS);
   /* compute plane equation of triangle(V0,V1,V2) */
   SUB(E1,V1,V0);
   SUB(E2,V2,V0);
@@ -236,14 +238,14 @@ int tri_tri_intersect(float V0[3],float V1[3],float V2[3],
 
   /* coplanarity robustness check */
 #if USE_EPSILON_TEST==TRUE
-  if(fabs(du0)<EPSILON) du0=0.0;
-  if(fabs(du1)<EPSILON) du1=0.0;
-  if(fabs(du2)<EPSILON) du2=0.0;
+  if(fabs(du0)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du0=0.0; }
+  if(fabs(du1)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du1=0.0; }
+  if(fabs(du2)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du2=0.0; }
 #endif
   du0du1=du0*du1;
   du0du2=du0*du2;
   if (du0du1 > 0.0f && du0du2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-    return 0;                         /* no intersection occurs */
+    { EXT_COUNT(COUNTER_TRI_TRI_PLANE_V); return 0; } /* no intersection occurs */
   /* compute plane of triangle (U0,U1,U2) */
   SUB(E1,U1,U0);
   SUB(E2,U2,U0);
@@ -257,14 +259,14 @@ int tri_tri_intersect(float V0[3],float V1[3],float V2[3],
   dv2=DOT(N2,V2)+d2;
 
 #if USE_EPSILON_TEST==TRUE
-  if(fabs(dv0)<EPSILON) dv0=0.0;
-  if(fabs(dv1)<EPSILON) dv1=0.0;
-  if(fabs(dv2)<EPSILON) dv2=0.0;
+  if(fabs(dv0)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv0=0.0; }
+  if(fabs(dv1)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv1=0.0; }
+  if(fabs(dv2)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv2=0.0; }
 #endif
     dv0dv1 = dv0 * dv1;
     dv0dv2 = dv0 * dv2;
     if (dv0dv1 > 0.0f && dv0dv2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_U); return 0; } /* no intersection occurs */
     /* compute direction of intersection line */
     CROSS(D,N1,N2);
     /* compute and index to the largest component of D */
@@ -288,7 +290,8 @@ int tri_tri_intersect(float V0[3],float V1[3],float V2[3],
     COMPUTE_INTERVALS(up0,up1,up2,du0,du1,du2,du0du1,du0du2,isect2[0],isect2[1]);
     SORT(isect1[0],isect1[1]);
     SORT(isect2[0],isect2[1]);
-    if (isect1[1]<isect2[0] || isect2[1]<isect1[0]) return 0;
+    if (isect1[1]<isect2[0] || isect2[1]<isect1[0]) { EXT_COUNT(COUNTER_TRI_TRI_INTERVAL); return 0; }
+    EXT_COUNT(COUNTER_TRI_TRI_HITS);
     return 1;
 }
 
@@ -321,7 +324,7 @@ int tri_tri_intersect(float V0[3],float V1[3],float V2[3],
         else \
         { \
                 /* triangles are coplanar */ \
-                return coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2); \
+                return EXT_COUNTED(coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR); \
         } \
 }
 
@@ -340,6 +343,7 @@ int no_div_tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     float a,b,c,x0,x1;
     float d,e,f,y0,y1;
     float xx,yy,xxyy,tmp;
+    EXT_COUNT(COUNTER_TRI_TRI_CALLS);
     /* compute plane equation of triangle(V0,V1,V2) */
     SUB(E1,V1,V0);
     SUB(E2,V2,V0);
@@ -352,14 +356,14 @@ int no_div_tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     du2 = DOT(N1,U2)+d1;
     /* coplanarity robustness check */
 #if USE_EPSILON_TEST==TRUE
-    if (FABS(du0) < EPSILON) du0 = 0.0;
-    if (FABS(du1) < EPSILON) du1 = 0.0;
-    if (FABS(du2) < EPSILON) du2 = 0.0;
+    if (FABS(du0) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du0 = 0.0; }
+    if (FABS(du1) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du1 = 0.0; }
+    if (FABS(du2) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du2 = 0.0; }
 #endif
     du0du1 = du0*du1;
     du0du2 = du0*du2;
     if (du0du1 > 0.0f && du0du2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_V); return 0; } /* no intersection occurs */
     /* compute plane of triangle (U0,U1,U2) */
     SUB(E1,U1,U0);
     SUB(E2,U2,U0);
@@ -371,14 +375,14 @@ int no_div_tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     dv1 = DOT(N2,V1)+d2;
     dv2 = DOT(N2,V2)+d2;
 #if USE_EPSILON_TEST==TRUE
-    if (FABS(dv0) < EPSILON) dv0=0.0;
-    if (FABS(dv1) < EPSILON) dv1=0.0;
-    if (FABS(dv2) < EPSILON) dv2=0.0;
+    if (FABS(dv0) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv0=0.0; }
+    if (FABS(dv1) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv1=0.0; }
+    if (FABS(dv2) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv2=0.0; }
 #endif
     dv0dv1=dv0*dv1;
     dv0dv2=dv0*dv2;
     if (dv0dv1 > 0.0f && dv0dv2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_U); return 0; } /* no intersection occurs */
     /* compute direction of intersection line */
     CROSS(D,N1,N2);
     /* compute and index to the largest component of D */
@@ -413,7 +417,8 @@ int no_div_tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     isect2[1]=tmp+f*xx*y0;
     SORT(isect1[0],isect1[1]);
     SORT(isect2[0],isect2[1]);
-    if(isect1[1]<isect2[0] || isect2[1]<isect1[0]) return 0;
+    if(isect1[1]<isect2[0] || isect2[1]<isect1[0]) { EXT_COUNT(COUNTER_TRI_TRI_INTERVAL); return 0; }
+    EXT_COUNT(COUNTER_TRI_TRI_HITS);
     return 1;
 }
 
@@ -514,7 +519,7 @@ static inline int compute_intervals_isectline(float VERT0[3],float VERT1[3],floa
   {                                                     \
     /* triangles are coplanar */                        \
     coplanar=1;                                         \
-    return coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2);      \
+    return EXT_COUNTED(coplanar_tri_tri(N1,V0,V1,V2,U0,U1,U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR);      \
   }
 #endif
 
@@ -535,6 +540,7 @@ int tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     float b,c,max;
 //  float tmp,diff[3];
     int smallest1,smallest2;
+    EXT_COUNT(COUNTER_TRI_TRI_CALLS);
     /* compute plane equation of triangle(V0,V1,V2) */
     SUB(E1,V1,V0);
     SUB(E2,V2,V0);
@@ -547,14 +553,14 @@ int tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     du2 = DOT(N1,U2)+d1;
     /* coplanarity robustness check */
 #if USE_EPSILON_TEST==TRUE
-    if (fabs(du0)<EPSILON) du0 = 0.0;
-    if (fabs(du1)<EPSILON) du1 = 0.0;
-    if (fabs(du2)<EPSILON) du2 = 0.0;
+    if (fabs(du0)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du0 = 0.0; }
+    if (fabs(du1)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du1 = 0.0; }
+    if (fabs(du2)<EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); du2 = 0.0; }
 #endif
     du0du1=du0*du1;
     du0du2=du0*du2;
     if (du0du1 > 0.0f && du0du2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_V); return 0; } /* no intersection occurs */
     /* compute plane of triangle (U0,U1,U2) */
     SUB(E1,U1,U0);
     SUB(E2,U2,U0);
@@ -566,14 +572,14 @@ int tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     dv1=DOT(N2,V1)+d2;
     dv2=DOT(N2,V2)+d2;
 #if USE_EPSILON_TEST==TRUE
-    if(fabs(dv0) < EPSILON) dv0 = 0.0;
-    if(fabs(dv1) < EPSILON) dv1 = 0.0;
-    if(fabs(dv2) < EPSILON) dv2 = 0.0;
+    if(fabs(dv0) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv0 = 0.0; }
+    if(fabs(dv1) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv1 = 0.0; }
+    if(fabs(dv2) < EPSILON) { EXT_COUNT(COUNTER_TRI_TRI_EPSILON); dv2 = 0.0; }
 #endif
     dv0dv1 = dv0 * dv1;
     dv0dv2 = dv0 * dv2;
     if (dv0dv1 > 0.0f && dv0dv2 > 0.0f) /* same sign on all of them + not equal 0 ? */
-        return 0;                       /* no intersection occurs */
+        { EXT_COUNT(COUNTER_TRI_TRI_PLANE_U); return 0; } /* no intersection occurs */
     /* compute direction of intersection line */
     CROSS(D,N1,N2);
     /* compute and index to the largest component of D */
@@ -594,14 +600,17 @@ int tri_tri_intersect_line(float V0[3],float V1[3],float V2[3],
     /* compute interval for triangle 1 */
     *coplanar=compute_intervals_isectline(V0, V1, V2, vp0, vp1, vp2, dv0, dv1, dv2,
                                           dv0dv1, dv0dv2, &isect1[0], &isect1[1], isectpointA1, isectpointA2);
-    if(*coplanar) return coplanar_tri_tri(N1, V0, V1, V2, U0, U1, U2);
+    if(*coplanar) return EXT_COUNTED(coplanar_tri_tri(N1, V0, V1, V2, U0, U1, U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR);
     /* compute interval for triangle 2 */
-    compute_intervals_isectline(U0, U1, U2, up0, up1, up2, du0, du1, du2,
-                                du0du1, du0du2, &isect2[0], &isect2[1], isectpointB1, isectpointB2);
+    *coplanar=compute_intervals_isectline(U0, U1, U2, up0, up1, up2, du0, du1, du2,
+                                          du0du1, du0du2, &isect2[0], &isect2[1], isectpointB1, isectpointB2);
+    /* epsilon test is not symmetric: U may look coplanar when V did not, isect2 is not computed then */
+    if(*coplanar) return EXT_COUNTED(coplanar_tri_tri(N1, V0, V1, V2, U0, U1, U2), COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR);
     SORT2(isect1[0], isect1[1], smallest1);
     SORT2(isect2[0], isect2[1], smallest2);
-    if (isect1[1] < isect2[0] || isect2[1] < isect1[0]) return 0;
+    if (isect1[1] < isect2[0] || isect2[1] < isect1[0]) { EXT_COUNT(COUNTER_TRI_TRI_INTERVAL); return 0; }
     /* at this point, we know that the triangles intersect */
+    EXT_COUNT(COUNTER_TRI_TRI_HITS);
     if (isect2[0] < isect1[0]) {
         if (smallest1 == 0) { SET(isectpt1, isectpointA1); }
         else { SET(isectpt1,isectpointA2); }
@@ -0,0 +1,525 @@
+/* Robust triangle/triangle overlap test.
+ *
+ * Philippe Guigue, Olivier Devillers.
+ * Fast and Robust Triangle-Triangle Overlap Test Using Orientation Predicates.
+ * Journal of Graphics Tools, 8(1):25-42, 2003.
+ *
+ * Every decision is the sign of an orientation determinant, 3x3 for the
+ * planes and 2x2 inside the common plane of coplanar triangles. The sign is
+ * taken from a double evaluation when it exceeds a semi-static error bound
+ * (a constant times the largest coordinate differences per axis, certified
+ * for any finite float input: no underflow or overflow is possible in double).
+ * Only inconclusive determinants are evaluated again exactly with
+ * floating-point expansions:
+ *
+ * Jonathan Richard Shewchuk.
+ * Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric
+ * Predicates. Discrete & Computational Geometry 18(3):305-363, 1997.
+ *
+ * int robust_tri_tri_intersect(float V0[3],float V1[3],float V2[3],
+ *                              float U0[3],float U1[3],float U2[3])
+ *
+ * parameters: vertices of triangle 1: V0, V1, V2
+ *             vertices of triangle 2: U0, U1, U2
+ * result    : returns 1 if the closed triangles share at least one point,
+ *             otherwise 0. The answer is exact: no EPSILON, touching at a
+ *             vertex or along an edge intersects. Degenerate (zero area)
+ *             triangles are the segment or point they cover, the result
+ *             does not depend on the order of the triangles.
+ */
+#include <math.h>
+#include <string.h>
+#include "../counters.h"
+
+/* Monomials of d . (a x b) with rounded differences go through at most
+   8 roundings (3 differences, 2 products, 3 sums) and there are 6 of them,
+   each bounded by mx * my * mz: 48 * 2^-53 plus room for rounding of the
+   bound itself. The 2x2 case has 4 roundings and 2 monomials: 8 * 2^-53.
+   BOUND3_SHARED is for differences of differences to a common vertex each
+   bounded by m per axis: entries within 2 m off by at most 4 m * 2^-53,
+   3 * 16 per monomial, and 5 roundings of monomials up to 8 * mx * my * mz:
+   6 * (48 + 40) = 528 * 2^-53. */
+#define BOUND3 5.4e-15
+#define BOUND3_SHARED 6.0e-14
+#define BOUND2 8.9e-16
+
+enum { TERMS = 192 }; /* d . (a x b) of two component differences: 3 * (8 + 8) * 2 * 2 */
+
+/* fmax() is a library call, NaN handling is not needed */
+static inline double larger(double a, double b) { return a > b ? a : b; }
+static inline double smaller(double a, double b) { return a < b ? a : b; }
+
+/* a + b = x + y exactly, |y| <= ulp(x) / 2 */
+static inline void two_sum(double a, double b, double* x, double* y) {
+    *x = a + b;
+    const double bv = *x - a, av = *x - bv;
+    *y = (a - av) + (b - bv);
+}
+
+/* a * b = x + y exactly (no underflow: products of float differences) */
+static inline void two_product(double a, double b, double* x, double* y) {
+    *x = a * b;
+    *y = fma(a, b, -*x);
+}
+
+/* Expansions are nonoverlapping components of increasing magnitude without
+   zeros (a single 0 for zero): the sign is the sign of the last one. */
+
+static int difference(double a, double b, double* h) {
+    double x, y;
+    two_sum(a, -b, &x, &y);
+    if (y == 0) { h[0] = x; return 1; }
+    h[0] = y;
+    h[1] = x;
+    return 2;
+}
+
+/* h = e + b */
+static int grow(const double* e, int n, double b, double* h) {
+    double q = b;
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        double s, t;
+        two_sum(q, e[i], &s, &t);
+        q = s;
+        if (t != 0) { h[k++] = t; }
+    }
+    if (q != 0 || k == 0) { h[k++] = q; }
+    return k;
+}
+
+/* h = e + f, h may be e */
+static int sum(const double* e, int n, const double* f, int m, double* h) {
+    double t[TERMS];
+    if (h != e) { memcpy(h, e, n * sizeof(double)); }
+    for (int j = 0; j < m; j++) {
+        n = grow(h, n, f[j], t);
+        memcpy(h, t, n * sizeof(double));
+    }
+    return n;
+}
+
+/* h = e * b */
+static int scale(const double* e, int n, double b, double* h) {
+    double q, t;
+    int k = 0;
+    two_product(e[0], b, &q, &t);
+    if (t != 0) { h[k++] = t; }
+    for (int i = 1; i < n; i++) {
+        double p1, p0, s;
+        two_product(e[i], b, &p1, &p0);
+        two_sum(q, p0, &s, &t);
+        if (t != 0) { h[k++] = t; }
+        two_sum(p1, s, &q, &t);
+        if (t != 0) { h[k++] = t; }
+    }
+    if (q != 0 || k == 0) { h[k++] = q; }
+    return k;
+}
+
+/* h = e * f */
+static int product(const double* e, int n, const double* f, int m, double* h) {
+    double s[TERMS];
+    int k = scale(e, n, f[0], h);
+    for (int j = 1; j < m; j++) {
+        const int ns = scale(e, n, f[j], s);
+        k = sum(h, k, s, ns, h);
+    }
+    return k;
+}
+
+static int negate(double* e, int n) {
+    for (int i = 0; i < n; i++) { e[i] = -e[i]; }
+    return n;
+}
+
+static inline int sign(const double* e, int n) {
+    return (e[n - 1] > 0) - (e[n - 1] < 0);
+}
+
+/* h = a0 * b1 - a1 * b0 */
+static int cross(const double* a0, int na0, const double* a1, int na1,
+                 const double* b0, int nb0, const double* b1, int nb1, double* h) {
+    double t[TERMS];
+    const int n = product(a0, na0, b1, nb1, h);
+    const int m = negate(t, product(a1, na1, b0, nb0, t));
+    return sum(h, n, t, m, h);
+}
+
+/* sign of ((a - c) x (b - c)) . (d - c) */
+static int orient3d_exact(const float a[3], const float b[3], const float c[3], const float d[3]) {
+    EXT_COUNT(COUNTER_TRI_TRI_EXACT);
+    double u[3][2], v[3][2], w[3][2], n[TERMS], t[TERMS], r[TERMS];
+    int nu[3], nv[3], nw[3];
+    for (int k = 0; k < 3; k++) {
+        nu[k] = difference(a[k], c[k], u[k]);
+        nv[k] = difference(b[k], c[k], v[k]);
+        nw[k] = difference(d[k], c[k], w[k]);
+    }
+    int nr = 1;
+    r[0] = 0;
+    for (int k = 0; k < 3; k++) {
+        const int i = (k + 1) % 3, j = (k + 2) % 3;
+        const int nn = cross(u[i], nu[i], u[j], nu[j], v[i], nv[i], v[j], nv[j], n);
+        const int nt = product(n, nn, w[k], nw[k], t);
+        nr = sum(r, nr, t, nt, r);
+    }
+    return sign(r, nr);
+}
+
+/* sign of (a - c) x (b - c) in the plane of axes x, y */
+static int orient2d_exact(const float a[3], const float b[3], const float c[3], int x, int y) {
+    EXT_COUNT(COUNTER_TRI_TRI_EXACT);
+    double ux[2], uy[2], vx[2], vy[2], r[TERMS];
+    const int nux = difference(a[x], c[x], ux), nuy = difference(a[y], c[y], uy);
+    const int nvx = difference(b[x], c[x], vx), nvy = difference(b[y], c[y], vy);
+    return sign(r, cross(ux, nux, uy, nuy, vx, nvx, vy, nvy, r));
+}
+
+/* plane of triangle (a, b, c) for the orientation of many points d */
+typedef struct plane_s {
+    const float* a;
+    const float* b;
+    const float* c;
+    double x[2][3]; /* a - c, b - c */
+    double n[3];    /* (a - c) x (b - c) */
+    double m[3];    /* max |a - c|, |b - c| per axis, and |d[i] - c| after orient3d() */
+} plane_t;
+
+static inline void plane(plane_t* p, const float a[3], const float b[3], const float c[3]) {
+    double* u = p->x[0];
+    double* v = p->x[1];
+    p->a = a;
+    p->b = b;
+    p->c = c;
+    for (int k = 0; k < 3; k++) {
+        u[k] = (double)a[k] - c[k];
+        v[k] = (double)b[k] - c[k];
+        p->m[k] = larger(fabs(u[k]), fabs(v[k]));
+    }
+    p->n[0] = u[1] * v[2] - u[2] * v[1];
+    p->n[1] = u[2] * v[0] - u[0] * v[2];
+    p->n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+static inline int filtered(double det, double eps) {
+    return (det > eps) - (det < -eps);
+}
+
+/* signs of ((a - c) x (b - c)) . (d[i] - c), positive above the plane,
+   one bound for all three points: larger than each of their own bounds.
+   d[i] - c are stored in w[i] unless w is NULL */
+static inline void orient3d(plane_t* p, const float* const d[3], int s[3], double w[3][3]) {
+    double det[3], m[3] = { p->m[0], p->m[1], p->m[2] };
+    for (int i = 0; i < 3; i++) {
+        const double x[3] = { (double)d[i][0] - p->c[0], (double)d[i][1] - p->c[1], (double)d[i][2] - p->c[2] };
+        det[i] = x[0] * p->n[0] + x[1] * p->n[1] + x[2] * p->n[2];
+        for (int k = 0; k < 3; k++) { m[k] = larger(m[k], fabs(x[k])); }
+        if (w != NULL) { memcpy(w[i], x, sizeof(x)); }
+    }
+    for (int k = 0; k < 3; k++) { p->m[k] = m[k]; }
+    const double eps = BOUND3 * m[0] * m[1] * m[2];
+    for (int i = 0; i < 3; i++) {
+        s[i] = filtered(det[i], eps);
+        // eps == 0: all points share a coordinate, det is 0
+        if (s[i] == 0 && eps != 0) { s[i] = orient3d_exact(p->a, p->b, p->c, d[i]); }
+    }
+}
+
+/* p1 and p2 alone on their sides of the plane of the other triangle,
+   true when orient(p2, p1, q1, q2) or orient(p2, r1, p1, r2) is positive:
+   (p2 - p1) . ((q2 - p1) x (q1 - p1)) and (p2 - p1) . ((r1 - p1) x (r2 - p1))
+   with the differences x.. of the points to a common vertex,
+   eps = BOUND3_SHARED * mx * my * mz of their bounds m */
+static inline int separated(const float* p1, const float* q1, const float* r1,
+                            const float* p2, const float* q2, const float* r2,
+                            const double* xp1, const double* xq1, const double* xr1,
+                            const double* xp2, const double* xq2, const double* xr2, double eps) {
+    double p[3], q[3], r[3], a[3], b[3];
+    for (int k = 0; k < 3; k++) {
+        p[k] = xp2[k] - xp1[k];
+        q[k] = xq1[k] - xp1[k];
+        r[k] = xr1[k] - xp1[k];
+        a[k] = xq2[k] - xp1[k];
+        b[k] = xr2[k] - xp1[k];
+    }
+    const double d1 = p[0] * (a[1] * q[2] - a[2] * q[1]) + p[1] * (a[2] * q[0] - a[0] * q[2]) +
+                      p[2] * (a[0] * q[1] - a[1] * q[0]);
+    int s = filtered(d1, eps);
+    if (s == 0 && eps != 0) { s = orient3d_exact(p2, p1, q1, q2); }
+    if (s > 0) { return 1; }
+    const double d2 = p[0] * (r[1] * b[2] - r[2] * b[1]) + p[1] * (r[2] * b[0] - r[0] * b[2]) +
+                      p[2] * (r[0] * b[1] - r[1] * b[0]);
+    s = filtered(d2, eps);
+    if (s == 0 && eps != 0) { s = orient3d_exact(p2, r1, p1, r2); }
+    return s > 0;
+}
+
+static int orient2d(const float a[3], const float b[3], const float c[3], int x, int y) {
+    const double ux = (double)a[x] - c[x], uy = (double)a[y] - c[y];
+    const double vx = (double)b[x] - c[x], vy = (double)b[y] - c[y];
+    const double det = ux * vy - uy * vx;
+    const double eps = BOUND2 * larger(fabs(ux), fabs(vx)) * larger(fabs(uy), fabs(vy));
+    const int s = filtered(det, eps);
+    return s != 0 || eps == 0 ? s : orient2d_exact(a, b, c, x, y);
+}
+
+/* Coplanar triangles are projected along an axis the plane is not parallel
+   to, every predicate below is orient2d() in that projection. */
+
+typedef struct projection_s {
+    int x;
+    int y;
+} projection_t;
+
+#define ORIENT_2D(a, b, c) orient2d(a, b, c, pr.x, pr.y)
+
+static int intersection_test_vertex(projection_t pr, const float* p1, const float* q1, const float* r1,
+                                    const float* p2, const float* q2, const float* r2) {
+    if (ORIENT_2D(r2, p2, q1) >= 0) {
+        if (ORIENT_2D(r2, q2, q1) <= 0) {
+            if (ORIENT_2D(p1, p2, q1) > 0) {
+                return ORIENT_2D(p1, q2, q1) <= 0;
+            } else {
+                return ORIENT_2D(p1, p2, r1) >= 0 && ORIENT_2D(q1, r1, p2) >= 0;
+            }
+        } else {
+            return ORIENT_2D(p1, q2, q1) <= 0 && ORIENT_2D(r2, q2, r1) <= 0 && ORIENT_2D(q1, r1, q2) >= 0;
+        }
+    } else if (ORIENT_2D(r2, p2, r1) >= 0) {
+        if (ORIENT_2D(q1, r1, r2) >= 0) {
+            return ORIENT_2D(p1, p2, r1) >= 0;
+        } else {
+            return ORIENT_2D(q1, r1, q2) >= 0 && ORIENT_2D(r2, r1, q2) >= 0;
+        }
+    }
+    return 0;
+}
+
+static int intersection_test_edge(projection_t pr, const float* p1, const float* q1, const float* r1,
+                                  const float* p2, const float* r2) {
+    if (ORIENT_2D(r2, p2, q1) >= 0) {
+        if (ORIENT_2D(p1, p2, q1) >= 0) {
+            return ORIENT_2D(p1, q1, r2) >= 0;
+        } else {
+            return ORIENT_2D(q1, r1, p2) >= 0 && ORIENT_2D(r1, p1, p2) >= 0;
+        }
+    } else if (ORIENT_2D(r2, p2, r1) >= 0) {
+        return ORIENT_2D(p1, p2, r1) >= 0 && (ORIENT_2D(p1, r1, r2) >= 0 || ORIENT_2D(q1, r1, r2) >= 0);
+    }
+    return 0;
+}
+
+/* both triangles counterclockwise in the projection */
+static int ccw_tri_tri_2d(projection_t pr, const float* p1, const float* q1, const float* r1,
+                          const float* p2, const float* q2, const float* r2) {
+    if (ORIENT_2D(p2, q2, p1) >= 0) {
+        if (ORIENT_2D(q2, r2, p1) >= 0) {
+            if (ORIENT_2D(r2, p2, p1) >= 0) { return 1; }
+            return intersection_test_edge(pr, p1, q1, r1, p2, r2);
+        } else if (ORIENT_2D(r2, p2, p1) >= 0) {
+            return intersection_test_edge(pr, p1, q1, r1, r2, q2);
+        } else {
+            return intersection_test_vertex(pr, p1, q1, r1, p2, q2, r2);
+        }
+    } else if (ORIENT_2D(q2, r2, p1) >= 0) {
+        if (ORIENT_2D(r2, p2, p1) >= 0) {
+            return intersection_test_edge(pr, p1, q1, r1, q2, p2);
+        } else {
+            return intersection_test_vertex(pr, p1, q1, r1, q2, r2, p2);
+        }
+    }
+    return intersection_test_vertex(pr, p1, q1, r1, r2, p2, q2);
+}
+
+#undef ORIENT_2D
+
+/* Zero area triangles are the segment (or point) between their extreme
+   vertices along the axis of the largest extent, other vertices are on it.
+   A degenerate triangle has no plane: the other triangle is coplanar with
+   it for orient3d(), both cases end up in coplanar_tri_tri(). */
+
+static int degenerate(const float* p, const float* q, const float* r) {
+    for (int k = 0; k < 3; k++) {
+        if (orient2d(p, q, r, (k + 1) % 3, (k + 2) % 3) != 0) { return 0; }
+    }
+    return 1;
+}
+
+static void extremes(const float* const t[3], const float** a, const float** b) {
+    int axis = 0;
+    double range = -1;
+    for (int k = 0; k < 3; k++) {
+        const double lo = smaller(t[0][k], smaller(t[1][k], t[2][k]));
+        const double hi = larger(t[0][k], larger(t[1][k], t[2][k]));
+        if (hi - lo > range) { range = hi - lo; axis = k; }
+    }
+    int i = 0, j = 0;
+    for (int k = 1; k < 3; k++) {
+        if (t[k][axis] < t[i][axis]) { i = k; }
+        if (t[k][axis] > t[j][axis]) { j = k; }
+    }
+    *a = t[i];
+    *b = t[j];
+}
+
+/* sign of ((a - c) x (b - c)) . (d - c) of a single point */
+static int orientation(const float* a, const float* b, const float* c, const float* d) {
+    plane_t p;
+    const float* const e[3] = { d, d, d };
+    int s[3];
+    plane(&p, a, b, c);
+    orient3d(&p, e, s, NULL);
+    return s[0];
+}
+
+/* closed segments (p, q) and (r, s) in the projection x, y, either may be a point */
+static int segments_2d(const float* p, const float* q, const float* r, const float* s, int x, int y) {
+    const int o1 = orient2d(p, q, r, x, y), o2 = orient2d(p, q, s, x, y);
+    const int o3 = orient2d(r, s, p, x, y), o4 = orient2d(r, s, q, x, y);
+    if (o1 * o2 > 0 || o3 * o4 > 0) { return 0; }
+    if (o1 != 0 || o2 != 0 || o3 != 0 || o4 != 0) { return 1; }
+    // collinear: intervals overlap on both axes
+    return smaller(p[x], q[x]) <= larger(r[x], s[x]) && smaller(r[x], s[x]) <= larger(p[x], q[x]) &&
+           smaller(p[y], q[y]) <= larger(r[y], s[y]) && smaller(r[y], s[y]) <= larger(p[y], q[y]);
+}
+
+/* segment (p, q) and triangle (a, b, c) of orientation o != 0 in the projection x, y */
+static int segment_triangle_2d(const float* p, const float* q, const float* a, const float* b, const float* c,
+                               int o, int x, int y) {
+    const int inside = orient2d(a, b, p, x, y) * o >= 0 && orient2d(b, c, p, x, y) * o >= 0 &&
+                       orient2d(c, a, p, x, y) * o >= 0;
+    return inside || segments_2d(p, q, a, b, x, y) || segments_2d(p, q, b, c, x, y) ||
+           segments_2d(p, q, c, a, x, y);
+}
+
+/* segment (p, q) and non degenerate triangle (a, b, c) */
+static int segment_triangle(const float* p, const float* q, const float* a, const float* b, const float* c) {
+    const int sp = orientation(a, b, c, p), sq = orientation(a, b, c, q);
+    if (sp * sq > 0) { return 0; }
+    if (sp == 0 && sq == 0) { // in the plane: any projection the triangle keeps its area in
+        for (int k = 0; k < 3; k++) {
+            const int x = (k + 1) % 3, y = (k + 2) % 3;
+            const int o = orient2d(a, b, c, x, y);
+            if (o != 0) { return segment_triangle_2d(p, q, a, b, c, o, x, y); }
+        }
+    }
+    // p != q cross the plane: the line hits the triangle when it passes all edges on the same side
+    const int o1 = orientation(p, q, a, b), o2 = orientation(p, q, b, c), o3 = orientation(p, q, c, a);
+    return !((o1 > 0 || o2 > 0 || o3 > 0) && (o1 < 0 || o2 < 0 || o3 < 0));
+}
+
+/* coplanar sets meet when their projections along every axis do: one of
+   the projections is one-to-one on a plane containing both */
+static int segment_segment(const float* p, const float* q, const float* r, const float* s) {
+    if (orientation(p, q, r, s) != 0) { return 0; }
+    for (int k = 0; k < 3; k++) {
+        if (!segments_2d(p, q, r, s, (k + 1) % 3, (k + 2) % 3)) { return 0; }
+    }
+    return 1;
+}
+
+/* coplanar triangles or one of them (or both) degenerate */
+static int coplanar_tri_tri(const plane_t* n1, const float* p1, const float* q1, const float* r1,
+                            const float* p2, const float* q2, const float* r2) {
+    // largest normal component first, the exact orientation of the projected
+    // first triangle rejects an axis the plane is parallel to
+    int axis[3] = { 0, 1, 2 };
+    for (int i = 0; i < 2; i++) {
+        for (int j = 2; j > i; j--) {
+            if (fabs(n1->n[axis[j]]) > fabs(n1->n[axis[j - 1]])) {
+                const int t = axis[j]; axis[j] = axis[j - 1]; axis[j - 1] = t;
+            }
+        }
+    }
+    const float* const t2[3] = { p2, q2, r2 };
+    const float *a2, *b2;
+    int hit = -1;
+    for (int i = 0; i < 3 && hit < 0; i++) {
+        const projection_t pr = { (axis[i] + 1) % 3, (axis[i] + 2) % 3 };
+        const int s1 = orient2d(p1, q1, r1, pr.x, pr.y);
+        if (s1 == 0) { continue; }
+        if (degenerate(p2, q2, r2)) {
+            extremes(t2, &a2, &b2);
+            hit = segment_triangle(a2, b2, p1, q1, r1);
+        } else {
+            const int s2 = orient2d(p2, q2, r2, pr.x, pr.y);
+            const float* a = s1 > 0 ? q1 : r1;
+            const float* b = s1 > 0 ? r1 : q1;
+            const float* c = s2 >= 0 ? q2 : r2;
+            const float* d = s2 >= 0 ? r2 : q2;
+            hit = ccw_tri_tri_2d(pr, p1, a, b, p2, c, d);
+        }
+    }
+    if (hit < 0) { // degenerate first triangle
+        const float* const t1[3] = { p1, q1, r1 };
+        const float *a1, *b1;
+        extremes(t1, &a1, &b1);
+        if (degenerate(p2, q2, r2)) {
+            extremes(t2, &a2, &b2);
+            hit = segment_segment(a1, b1, a2, b2);
+        } else {
+            hit = segment_triangle(a1, b1, p2, q2, r2);
+        }
+    }
+    return EXT_COUNTED(hit, COUNTER_TRI_TRI_COPLANAR_HITS, COUNTER_TRI_TRI_COPLANAR);
+}
+
+/* Canonical form of the paper for the signs (p, q, r) of the vertices of
+   one triangle to the plane of the other, instead of its nested branches:
+   bits 0..1 rotate the triangle so that its first vertex is alone on its
+   side of the plane (or on it), bit 2 swaps the last two vertices of the
+   other triangle to put the first vertex above that one. -1: coplanar.
+   Index (p + 1) * 9 + (q + 1) * 3 + r + 1, all of one sign never gets here. */
+static const signed char canonical[27] = {
+    2, 2, 2, 1, 4, 4, 1, 4, 4,
+    0, 5, 5, 6, -1, 2, 1, 1, 4,
+    0, 0, 5, 0, 0, 5, 6, 6, 6
+};
+
+static inline int canonical_form(const int s[3]) {
+    return canonical[(s[0] + 1) * 9 + (s[1] + 1) * 3 + s[2] + 1];
+}
+
+int robust_tri_tri_intersect(float V0[3], float V1[3], float V2[3],
+                             float U0[3], float U1[3], float U2[3]) {
+    const float* const t1[3] = { V0, V1, V2 };
+    const float* const t2[3] = { U0, U1, U2 };
+    EXT_COUNT(COUNTER_TRI_TRI_CALLS);
+    plane_t n1, n2;
+    int s1[3], s2[3];
+    double x2[3][3]; /* U - V2 */
+    plane(&n2, U0, U1, U2);
+    orient3d(&n2, t1, s1, NULL);
+    if (s1[0] * s1[1] > 0 && s1[0] * s1[2] > 0) {
+        EXT_COUNT(COUNTER_TRI_TRI_PLANE_U);
+        return 0;
+    }
+    plane(&n1, V0, V1, V2);
+    orient3d(&n1, t2, s2, x2);
+    if (s2[0] * s2[1] > 0 && s2[0] * s2[2] > 0) {
+        EXT_COUNT(COUNTER_TRI_TRI_PLANE_V);
+        return 0;
+    }
+    const int c1 = canonical_form(s1);
+    if (c1 < 0) { return coplanar_tri_tri(&n1, V0, V1, V2, U0, U1, U2); }
+    const int k1 = c1 & 3, w1 = c1 >> 2;
+    const int a[3] = { k1, (k1 + 1) % 3, (k1 + 2) % 3 };
+    const int b[3] = { 0, 1 + w1, 2 - w1 };
+    const int d2[3] = { s2[0], s2[1 + w1], s2[2 - w1] };
+    const int c2 = canonical_form(d2);
+    if (c2 < 0) { return coplanar_tri_tri(&n1, V0, V1, V2, U0, U1, U2); }
+    const int k2 = c2 & 3, w2 = c2 >> 2;
+    const int p1 = a[0], q1 = a[1 + w2], r1 = a[2 - w2];
+    const int p2 = b[k2], q2 = b[(k2 + 1) % 3], r2 = b[(k2 + 2) % 3];
+    // p1 and p2 are alone on their sides of the other plane: the segments
+    // both planes cut out of the triangles on their common line overlap
+    // unless one ends before the other starts, one orientation per end.
+    // Both reuse the differences of all six vertices to V2 of n1 and their bound.
+    static const double origin[3] = { 0, 0, 0 };
+    const double* const x1[3] = { n1.x[0], n1.x[1], origin };
+    const double eps = BOUND3_SHARED * n1.m[0] * n1.m[1] * n1.m[2];
+    const int apart = separated(t1[p1], t1[q1], t1[r1], t2[p2], t2[q2], t2[r2],
+                                x1[p1], x1[q1], x1[r1], x2[p2], x2[q2], x2[r2], eps);
+    return EXT_COUNTED(!apart, COUNTER_TRI_TRI_HITS, COUNTER_TRI_TRI_INTERVAL);
+}
@@ -0,0 +1,111 @@
+/*
+ * Batched no_div_tri_tri_intersect().
+ * see tritri_simd.h for layout and semantics
+ */
+#include "tritri_simd.h"
+#include "intersections.h"
+#include "../../src/simd.h"
+
+/* the avx2 and avx512 targets enable fma: contracted products would
+   round differently from the scalar test and flip borderline lanes */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+/* no_div_tri_tri_intersect() clamps float |d| < 0.000001 (double):
+   for floats the same as |d| <= 0.000001f, the float just below */
+#define EPSILON 0.000001f
+
+enum { LANES = 16 }; // widest kernel
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "tritri_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "tritri_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA avx512
+#define W 16
+#define VF f32x16
+#define VI i32x16
+#define TARGET SIMD_TARGET_AVX512
+#include "tritri_simd.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#endif
+
+typedef int (*kernel_t)(const float v[3][3], const float* const u[9], int i, int* coplanar);
+
+static int kernel(kernel_t* k) {
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: *k = tri_tris_avx512; return 16;
+        case SIMD_AVX2: *k = tri_tris_avx2; return 8;
+#endif
+        default: *k = tri_tris_generic; return 4;
+    }
+}
+
+uint64_t no_div_tri_tri_intersect_n(const float V0[3], const float V1[3], const float V2[3],
+                                    const float* const u[9], int n) {
+    assert(0 <= n && n <= 64);
+    const float v[3][3] = {
+        { V0[0], V0[1], V0[2] }, { V1[0], V1[1], V1[2] }, { V2[0], V2[1], V2[2] }
+    };
+    kernel_t k;
+    const int w = kernel(&k);
+    uint64_t hits = 0;
+    for (int i = 0; i < n; i += w) {
+        int coplanar, mask;
+        if (i + w <= n) {
+            mask = k(v, u, i, &coplanar);
+        } else { // tail through zero padded copies
+            const int lanes = n - i;
+            float pad[9][LANES] = {0};
+            const float* p[9];
+            for (int j = 0; j < 9; j++) {
+                memcpy(pad[j], u[j] + i, lanes * sizeof(float));
+                p[j] = pad[j];
+            }
+            mask = k(v, p, 0, &coplanar) & ((1 << lanes) - 1);
+            coplanar &= (1 << lanes) - 1;
+        }
+        for (int j = 0; j < w; j++) {
+            if (coplanar & (1 << j)) {
+                float t[3][3];
+                for (int m = 0; m < 9; m++) { t[m / 3][m % 3] = u[m][i + j]; }
+                float a[3][3];
+                memcpy(a, v, sizeof(a));
+                mask |= no_div_tri_tri_intersect(a[0], a[1], a[2], t[0], t[1], t[2]) << j;
+            }
+        }
+        hits |= (uint64_t)mask << i;
+    }
+    return hits;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+/*
+ * Batched no_div_tri_tri_intersect(): one triangle against up to 64,
+ * structure of arrays, kernels picked at runtime by simd_level()
+ * (needs src/simd.h and src/simd.c, like ext/intersect_triangle_simd.c).
+ *
+ * Tomas Moller.
+ * A Fast Triangle-Triangle Intersection Test.
+ * Journal of Graphics Tools, 2(2):25-30, 1997.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ V0, V1, V2 against triangles u[vertex * 3 + axis][i] for i in [0..n), n <= 64.
+ Bit i of the result is set when no_div_tri_tri_intersect(V0, V1, V2, Ui...)
+ returns 1: plane distance tests and the intervals on the line of
+ intersection run 4, 8 or 16 lanes at a time with the same float
+ operations in the same order (no fused multiply add), lanes of coplanar
+ triangles (distances within EPSILON) go through the scalar test.
+*/
+uint64_t no_div_tri_tri_intersect_n(const float V0[3], const float V1[3], const float V2[3],
+                                    const float* const u[9], int n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+/* width generic kernel of tritri_simd.c
+   included once per instruction set with:
+       ISA     name suffix
+       W       lanes
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+   every expression follows no_div_tri_tri_intersect() operation by operation
+*/
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VI FN(splati)(int32_t s) {
+    VI r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline VF FN(abs)(VF a) {
+    VI mask;
+    for (int i = 0; i < W; i++) { mask[i] = 0x7FFFFFFF; }
+    return (VF)((VI)a & mask);
+}
+
+static TARGET inline int FN(movemask)(VI m) {
+    int r = 0;
+    for (int i = 0; i < W; i++) { r |= (m[i] != 0) << i; }
+    return r;
+}
+
+/* NEWCOMPUTE_INTERVALS: vertex p alone on its side of the plane is the
+   pivot, a and b are the other two in the order of the macro */
+static TARGET inline VI FN(intervals)(const VF vv[3], const VF d[3], VF d0d1, VF d0d2,
+                                      VF* a, VF* b, VF* c, VF* x0, VF* x1) {
+    const VF zero = FN(splat)(0);
+    VI left = FN(splati)(-1);
+    VI p2 = d0d1 > zero;
+    left &= ~p2;
+    VI p1 = left & (d0d2 > zero);
+    left &= ~p1;
+    const VI p0 = left & ((d[1] * d[2] > zero) | (d[0] != zero));
+    left &= ~p0;
+    const VI q1 = left & (d[1] != zero);
+    p1 |= q1;
+    left &= ~q1;
+    p2 |= left & (d[2] != zero);
+    left &= ~(d[2] != zero);
+    // pivot 0: others 1, 2; pivot 1: 0, 2; pivot 2: 0, 1
+    const VF vp = FN(select)(p0, vv[0], FN(select)(p1, vv[1], vv[2]));
+    const VF dp = FN(select)(p0, d[0], FN(select)(p1, d[1], d[2]));
+    const VF va = FN(select)(p0, vv[1], vv[0]), da = FN(select)(p0, d[1], d[0]);
+    const VF vb = FN(select)(p2, vv[1], vv[2]), db = FN(select)(p2, d[1], d[2]);
+    *a = vp;
+    *b = (va - vp) * dp;
+    *c = (vb - vp) * dp;
+    *x0 = dp - da;
+    *x1 = dp - db;
+    return left; // coplanar
+}
+
+/* lanes [i..i + W) of u against v, *coplanar: lanes left to the scalar test */
+static TARGET int FN(tri_tris)(const float v[3][3], const float* const u[9], int i, int* coplanar) {
+    const VF zero = FN(splat)(0), eps = FN(splat)(EPSILON);
+    float e1[3], e2[3], n1[3];
+    for (int k = 0; k < 3; k++) { e1[k] = v[1][k] - v[0][k]; e2[k] = v[2][k] - v[0][k]; }
+    n1[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n1[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n1[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    const float d1 = -(n1[0] * v[0][0] + n1[1] * v[0][1] + n1[2] * v[0][2]);
+    const VF N1[3] = { FN(splat)(n1[0]), FN(splat)(n1[1]), FN(splat)(n1[2]) };
+    VF U[3][3], V[3][3], du[3], dv[3];
+    for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) {
+            U[j][k] = FN(load)(u[j * 3 + k] + i);
+            V[j][k] = FN(splat)(v[j][k]);
+        }
+    }
+    for (int j = 0; j < 3; j++) {
+        du[j] = N1[0] * U[j][0] + N1[1] * U[j][1] + N1[2] * U[j][2] + FN(splat)(d1);
+        du[j] = FN(select)(FN(abs)(du[j]) <= eps, zero, du[j]);
+    }
+    const VF du0du1 = du[0] * du[1], du0du2 = du[0] * du[2];
+    VI miss = (du0du1 > zero) & (du0du2 > zero);
+    if (FN(movemask)(~miss) == 0) { *coplanar = 0; return 0; }
+    const VF E1[3] = { U[1][0] - U[0][0], U[1][1] - U[0][1], U[1][2] - U[0][2] };
+    const VF E2[3] = { U[2][0] - U[0][0], U[2][1] - U[0][1], U[2][2] - U[0][2] };
+    const VF N2[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+    const VF d2 = -(N2[0] * U[0][0] + N2[1] * U[0][1] + N2[2] * U[0][2]);
+    for (int j = 0; j < 3; j++) {
+        dv[j] = N2[0] * V[j][0] + N2[1] * V[j][1] + N2[2] * V[j][2] + d2;
+        dv[j] = FN(select)(FN(abs)(dv[j]) <= eps, zero, dv[j]);
+    }
+    const VF dv0dv1 = dv[0] * dv[1], dv0dv2 = dv[0] * dv[2];
+    miss |= (dv0dv1 > zero) & (dv0dv2 > zero);
+    if (FN(movemask)(~miss) == 0) { *coplanar = 0; return 0; }
+    const VF D[3] = { N1[1] * N2[2] - N1[2] * N2[1], N1[2] * N2[0] - N1[0] * N2[2], N1[0] * N2[1] - N1[1] * N2[0] };
+    const VF a0 = FN(abs)(D[0]), a1 = FN(abs)(D[1]), a2 = FN(abs)(D[2]);
+    const VI i1 = a1 > a0;
+    const VI i2 = a2 > FN(select)(i1, a1, a0);
+    VF vp[3], up[3];
+    for (int j = 0; j < 3; j++) {
+        vp[j] = FN(select)(i2, V[j][2], FN(select)(i1, V[j][1], V[j][0]));
+        up[j] = FN(select)(i2, U[j][2], FN(select)(i1, U[j][1], U[j][0]));
+    }
+    VF a, b, c, x0, x1, d, e, f, y0, y1;
+    VI flat = FN(intervals)(vp, dv, dv0dv1, dv0dv2, &a, &b, &c, &x0, &x1);
+    flat |= FN(intervals)(up, du, du0du1, du0du2, &d, &e, &f, &y0, &y1);
+    const VF xx = x0 * x1, yy = y0 * y1, xxyy = xx * yy;
+    VF tmp = a * xxyy;
+    VF isect10 = tmp + b * x1 * yy, isect11 = tmp + c * x0 * yy;
+    tmp = d * xxyy;
+    VF isect20 = tmp + e * xx * y1, isect21 = tmp + f * xx * y0;
+    const VI swap1 = isect10 > isect11, swap2 = isect20 > isect21;
+    const VF lo1 = FN(select)(swap1, isect11, isect10), hi1 = FN(select)(swap1, isect10, isect11);
+    const VF lo2 = FN(select)(swap2, isect21, isect20), hi2 = FN(select)(swap2, isect20, isect21);
+    const VI separated = (hi1 < lo2) | (hi2 < lo1);
+    *coplanar = FN(movemask)(flat & ~miss);
+    return FN(movemask)(~(miss | flat | separated));
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
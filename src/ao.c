@@ -0,0 +1,160 @@
+#include "ao.h"
+#include "simd.h"
+#include "threads.h"
+#include "../ext/intersect_triangle_simd.h"
+
+BEGIN_C
+
+/* A packet is 8 rays (rays8_t) of one vertex traversing the hierarchy
+   together with a bit per lane: children are visited when any live lane
+   of the parent hits their box, nearer child first for the leading lane,
+   leaves test every triangle against the whole packet with one
+   intersect_rays_triangle() call. A lane retires at its first hit within
+   distance, stacked masks drop retired lanes when popped.
+   Ray j of n is the Fibonacci lattice point ((j + 0.5) / n, j / golden)
+   shifted modulo 1 by a per vertex hash of seed, mapped to the cosine
+   weighted hemisphere (Malley) and rotated to the normal
+   (Duff et al. Building an Orthonormal Basis, Revisited. JCGT 6(1), 2017). */
+
+enum {
+    LANES = 8,         /* rays per packet */
+    VERTEX_GRAIN = 64  /* vertices per parallel_for chunk */
+};
+
+typedef struct packet_s {
+    rays8_t r;
+    float inv[3][LANES]; /* 1 / dir, huge instead of infinite for 0 */
+} packet_t;
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "ao.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "ao.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+#endif
+
+static int occluded(const bvh_t* bvh, const packet_t* p, int active, float tmax) {
+#ifdef SIMD_X86
+    if (simd_level() >= SIMD_AVX2) { return occluded_avx2(bvh, p, active, tmax); }
+#endif
+    return occluded_generic(bvh, p, active, tmax);
+}
+
+static uint64_t mix(uint64_t x) { /* splitmix64 finalizer */
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static inline float fraction(float x) { return x - floorf(x); }
+
+void ao_direction(const float normal[3], uint64_t seed, int vertex, int ray, int rays, float d[3]) {
+    const uint64_t h = mix(seed ^ mix((uint64_t)(uint32_t)vertex));
+    const float s0 = (float)(h >> 40) * (1.0f / (1 << 24));
+    const float s1 = (float)(h & 0xFFFFFF) * (1.0f / (1 << 24));
+    const float u0 = fraction((ray + 0.5f) / rays + s0);
+    const float u1 = fraction(ray * 0.618033988749f + s1);
+    const float r = sqrtf(u0), phi = 6.28318530718f * u1;
+    const float x = r * cosf(phi), y = r * sinf(phi), z = sqrtf(maximum(0.0f, 1 - u0));
+    const float* n = normal;
+    const float sign = copysignf(1.0f, n[2]);
+    const float a = -1 / (sign + n[2]), b = n[0] * n[1] * a;
+    const float t[3] = { 1 + sign * n[0] * n[0] * a, sign * b, -sign * n[0] };
+    const float c[3] = { b, sign + n[1] * n[1] * a, -n[1] };
+    for (int k = 0; k < 3; k++) { d[k] = x * t[k] + y * c[k] + z * n[k]; }
+}
+
+void ao_origin(const bvh_t* bvh, const float vertex[3], const float normal[3], float o[3]) {
+    float extent = 0;
+    if (bvh->node_count > 0) {
+        const bvh_node_t* root = &bvh->nodes[0];
+        for (int k = 0; k < 3; k++) { extent = maximum(extent, root->max[k] - root->min[k]); }
+    }
+    const float offset = extent * 1e-4f; // off the triangles around the vertex
+    for (int k = 0; k < 3; k++) { o[k] = vertex[k] + normal[k] * offset; }
+}
+
+typedef struct bake_s {
+    const bvh_t* bvh;
+    const vec3f_t* normals;
+    int rays;
+    float distance;
+    uint64_t seed;
+    float* ao;
+} bake_t;
+
+static void bake_body(void* that, int from, int to) {
+    const bake_t* b = (const bake_t*)that;
+    for (int i = from; i < to; i++) {
+        const float* m = b->normals[i];
+        const float length = sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+        if (!(length > 0) || b->bvh->node_count == 0) {
+            b->ao[i] = 1;
+            continue;
+        }
+        const float n[3] = { m[0] / length, m[1] / length, m[2] / length };
+        float o[3];
+        ao_origin(b->bvh, b->bvh->mesh.vertices[i], n, o);
+        int hits = 0;
+        for (int first = 0; first < b->rays; first += LANES) {
+            const int lanes = minimum(LANES, b->rays - first);
+            packet_t p;
+            for (int j = 0; j < LANES; j++) {
+                float d[3];
+                ao_direction(n, b->seed, i, first + minimum(j, lanes - 1), b->rays, d);
+                rays8_set(&p.r, j, o, d);
+                for (int k = 0; k < 3; k++) { p.inv[k][j] = d[k] != 0 ? 1 / d[k] : copysignf(1e30f, d[k]); }
+            }
+            hits += __builtin_popcount((unsigned)occluded(b->bvh, &p, (1 << lanes) - 1, b->distance));
+        }
+        b->ao[i] = 1 - (float)hits / b->rays;
+    }
+}
+
+int ao_bake(const bvh_t* bvh, const vec3f_t* normals, int rays, float distance, uint64_t seed, float* ao) {
+    const mesh_t* mesh = &bvh->mesh;
+    vec3f_t* area = null;
+    if (normals == null) { // sum of triangle cross products: area weighted
+        area = (vec3f_t*)calloc((size_t)maximum(1, mesh->vertex_count), sizeof(vec3f_t));
+        if (area == null) { return 0; }
+        for (int i = 0; i < mesh->triangle_count; i++) {
+            const float* v[3];
+            mesh_triangle(mesh, i, v);
+            const float e1[3] = { v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2] };
+            const float e2[3] = { v[2][0] - v[0][0], v[2][1] - v[0][1], v[2][2] - v[0][2] };
+            const float c[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                                 e1[0] * e2[1] - e1[1] * e2[0] };
+            for (int j = 0; j < 3; j++) {
+                float* a = area[mesh->indices[i * 3 + j]];
+                for (int k = 0; k < 3; k++) { a[k] += c[k]; }
+            }
+        }
+    }
+    bake_t b = { bvh, normals != null ? normals : area, maximum(1, minimum(AO_RAYS_MAX, rays)),
+                 distance, seed, ao };
+    parallel_for(0, mesh->vertex_count, VERTEX_GRAIN, &b, bake_body);
+    free(area);
+    return 1;
+}
+
+END_C
@@ -0,0 +1,29 @@
+#pragma once
+#include "bvh.h"
+
+/* per vertex ambient occlusion of static meshes.
+   Every vertex casts rays over the cosine weighted hemisphere around its
+   normal, ao is the fraction of rays that escape within distance (1 is
+   unoccluded). Rays of a vertex travel through bvh_t in packets of 8 as
+   any hit (occlusion) queries: lanes retire at their first hit and the
+   traversal ends when all lanes did. Directions are a rotated Fibonacci
+   lattice with the rotation hashed from seed and vertex index, so results
+   do not depend on the number of threads or the order of work. */
+
+BEGIN_C
+
+enum {
+    AO_RAYS_MAX = 1024
+};
+
+/* ao[vertex_count] of bvh.mesh, normals (not necessarily unit length) may be
+   null for area weighted normals of the triangles around vertices,
+   vertices without a normal (not used by any triangle) get 1.
+   rays are clamped to [1..AO_RAYS_MAX], returns 0 on out of memory */
+int ao_bake(const bvh_t* bvh, const vec3f_t* normals, int rays, float distance, uint64_t seed, float* ao);
+/* direction of ray [0..rays) of vertex around unit normal, as ao_bake() casts it */
+void ao_direction(const float normal[3], uint64_t seed, int vertex, int ray, int rays, float d[3]);
+/* ray origin: vertex moved along unit normal off the surface, as ao_bake() casts it */
+void ao_origin(const bvh_t* bvh, const float vertex[3], const float normal[3], float o[3]);
+
+END_C
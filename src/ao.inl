@@ -0,0 +1,101 @@
+/* packet occlusion traversal of ao.c included once per instruction set with:
+       ISA     name suffix
+       W       lanes: rays of a packet tested together, LANES / W vectors per packet
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty) */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+/* bit per lane hitting the box within [0..tmax] */
+static TARGET inline int FN(packet_box)(const bvh_node_t* n, const packet_t* p, float tmax) {
+    int mask = 0;
+    for (int j = 0; j < LANES; j += W) {
+        VF t_near = FN(splat)(0), t_far = FN(splat)(tmax);
+        for (int k = 0; k < 3; k++) {
+            const VF o = FN(load)(&p->r.orig[k][j]), inv = FN(load)(&p->inv[k][j]);
+            const VF t0 = (FN(splat)(n->min[k]) - o) * inv;
+            const VF t1 = (FN(splat)(n->max[k]) - o) * inv;
+            const VI m = t0 < t1;
+            const VF lo = FN(select)(m, t0, t1), hi = FN(select)(m, t1, t0);
+            t_near = FN(select)(lo > t_near, lo, t_near);
+            t_far = FN(select)(hi < t_far, hi, t_far);
+        }
+        const VI hit = t_near <= t_far;
+        for (int i = 0; i < W; i++) { mask |= (hit[i] & 1) << (j + i); }
+    }
+    return mask;
+}
+
+/* bit per lane of active hitting a triangle at 0 < t <= tmax */
+static TARGET int FN(occluded)(const bvh_t* bvh, const packet_t* p, int active, float tmax) {
+    uint32_t stack[BVH_STACK];
+    int masks[BVH_STACK];
+    int sp = 0;
+    int occluded = 0;
+    uint32_t i = 0;
+    int mask = FN(packet_box)(&bvh->nodes[0], p, tmax) & active;
+    for (;;) {
+        mask &= ~occluded;
+        if (mask != 0) {
+            const bvh_node_t* n = &bvh->nodes[i];
+            if (n->count == 0) {
+                const int ma = FN(packet_box)(&bvh->nodes[i + 1], p, tmax) & mask;
+                const int mb = FN(packet_box)(&bvh->nodes[n->offset], p, tmax) & mask;
+                // first child along the split axis for the leading lane first
+                const int lane = __builtin_ctz((unsigned)mask);
+                const int flip = p->r.dir[n->axis][lane] < 0;
+                const uint32_t near = flip ? n->offset : i + 1, far = flip ? i + 1 : n->offset;
+                const int mn = flip ? mb : ma, mf = flip ? ma : mb;
+                if (mf != 0) {
+                    if (mn == 0) {
+                        i = far;
+                        mask = mf;
+                        continue;
+                    }
+                    masks[sp] = mf;
+                    stack[sp++] = far;
+                }
+                if (mn != 0) {
+                    i = near;
+                    mask = mn;
+                    continue;
+                }
+            } else {
+                for (uint32_t k = n->offset; k < n->offset + n->count && mask != 0; k++) {
+                    const float* v[3];
+                    float t[LANES], u[LANES], w[LANES];
+                    mesh_triangle(&bvh->mesh, bvh->triangles[k], v);
+                    int hits = intersect_rays_triangle(&p->r, LANES, v[0], v[1], v[2], 0, t, u, w) & mask;
+                    while (hits != 0) {
+                        const int l = __builtin_ctz((unsigned)hits);
+                        hits &= hits - 1;
+                        if (t[l] > 0 && t[l] <= tmax) { occluded |= 1 << l; }
+                    }
+                    mask &= ~occluded;
+                }
+                if (occluded == active) { break; }
+            }
+        }
+        if (sp == 0) { break; }
+        sp--;
+        i = stack[sp];
+        mask = masks[sp];
+    }
+    return occluded;
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
@@ -0,0 +1,1212 @@
+#include "bvh.h"
+#include "bvh_hits.h"
+#include "threads.h"
+
+BEGIN_C
+
+/* Ingo Wald. On fast Construction of SAH-based Bounding Volume Hierarchies.
+   IEEE Symposium on Interactive Ray Tracing, 2007. (binned SAH)
+
+   Subtrees of TASK_MIN or more triangles are built as tasks, ranges of
+   PARALLEL_MIN or more triangles are also bounded, binned and partitioned
+   with parallel_for. Everything that decides the shape of the tree depends
+   on triangle counts only (never on the number of threads) and the large
+   ranges use a stable partition, so the output is identical for any number
+   of threads. Concurrent subtrees are written to reserved node ranges
+   (k triangles make at most 2k - 1 nodes), the holes are compacted at the end. */
+
+typedef struct box_s {
+    float min[3];
+    float max[3];
+} box_t;
+
+typedef struct builder_s {
+    bvh_t* bvh;
+    box_t* boxes;        /* per triangle bounds */
+    vec3f_t* centroids;  /* per triangle bounds centers */
+    int32_t* scratch;    /* stable partition of large ranges */
+    uint8_t* used;       /* nodes written when subtrees are built concurrently */
+} builder_t;
+
+typedef struct split_s {
+    int axis;
+    int bin;   /* triangles in bins [0..bin) go to the first child */
+    int bins;  /* fewer bins for small ranges */
+    float cost;
+    float scale; /* bin = (centroid - cmin) * scale */
+} split_t;
+
+typedef struct bins_s {
+    box_t box[3][BVH_BINS];
+    int count[3][BVH_BINS];
+} bins_t;
+
+enum {
+    MEDIAN_DEPTH = 32,     /* deeper than that only median splits keep depth under BVH_STACK */
+    TASK_MIN     = 4096,   /* subtrees built as tasks */
+    PARALLEL_MIN = 65536,  /* ranges processed with parallel_for */
+    CHUNK        = 16384   /* triangles per parallel_for chunk */
+};
+
+static const float traversal_cost = 1.0f; /* relative to triangle intersection cost */
+
+static inline void box_empty(box_t* b) {
+    b->min[0] = b->min[1] = b->min[2] = INFINITY;
+    b->max[0] = b->max[1] = b->max[2] = -INFINITY;
+}
+
+static inline void box_grow(box_t* b, const box_t* a) {
+    for (int i = 0; i < 3; i++) {
+        b->min[i] = minimum(b->min[i], a->min[i]);
+        b->max[i] = maximum(b->max[i], a->max[i]);
+    }
+}
+
+static inline void box_grow_point(box_t* b, const float p[3]) {
+    for (int i = 0; i < 3; i++) {
+        b->min[i] = minimum(b->min[i], p[i]);
+        b->max[i] = maximum(b->max[i], p[i]);
+    }
+}
+
+static inline float box_area(const box_t* b) {
+    const float dx = b->max[0] - b->min[0], dy = b->max[1] - b->min[1], dz = b->max[2] - b->min[2];
+    return dx < 0 ? 0 : 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+static inline int bin_of(const split_t* s, const float c[3], const box_t* cb) {
+    return minimum(s->bins - 1, (int)((c[s->axis] - cb->min[s->axis]) * s->scale));
+}
+
+/* parallel_for over CHUNK sized pieces of [first..first + count), chunk index is stable */
+typedef struct chunks_s {
+    builder_t* b;
+    int first;
+    int count;
+    const box_t* cb;
+    const split_t* s;      /* s[0..2] binning setup per axis, s[0] partition split */
+    box_t* box;            /* [chunk] bounds of triangles */
+    box_t* centers;        /* [chunk] bounds of centroids */
+    bins_t* bins;          /* [chunk] */
+    int* lefts;            /* [chunk] triangles going left, then exclusive prefix sum */
+    int left;              /* total */
+    void (*run)(struct chunks_s* c, int chunk, int i, int j);
+} chunks_t;
+
+static void chunks_body(void* that, int from, int to) {
+    chunks_t* c = (chunks_t*)that;
+    for (int k = from; k < to; k++) {
+        const int i = c->first + k * CHUNK;
+        c->run(c, k, i, minimum(i + CHUNK, c->first + c->count));
+    }
+}
+
+static void chunks_run(chunks_t* c, void (*run)(chunks_t* c, int chunk, int i, int j)) {
+    c->run = run;
+    parallel_for(0, (c->count + CHUNK - 1) / CHUNK, 1, c, chunks_body);
+}
+
+static void bounds_range(const builder_t* b, int i, int j, box_t* box, box_t* cb) {
+    box_empty(box);
+    box_empty(cb);
+    for (; i < j; i++) {
+        const int32_t t = b->bvh->triangles[i];
+        box_grow(box, &b->boxes[t]);
+        box_grow_point(cb, b->centroids[t]);
+    }
+}
+
+static void bounds_chunk(chunks_t* c, int chunk, int i, int j) {
+    bounds_range(c->b, i, j, &c->box[chunk], &c->centers[chunk]);
+}
+
+static int bounds(builder_t* b, int first, int count, box_t* box, box_t* cb) {
+    if (count < PARALLEL_MIN) {
+        bounds_range(b, first, first + count, box, cb);
+        return 1;
+    }
+    const int n = (count + CHUNK - 1) / CHUNK;
+    chunks_t c = { b, first, count };
+    c.box = (box_t*)malloc(sizeof(box_t) * 2 * (size_t)n);
+    if (c.box == null) { return 0; }
+    c.centers = c.box + n;
+    chunks_run(&c, bounds_chunk);
+    box_empty(box);
+    box_empty(cb);
+    for (int k = 0; k < n; k++) {
+        box_grow(box, &c.box[k]);
+        box_grow(cb, &c.centers[k]);
+    }
+    free(c.box);
+    return 1;
+}
+
+static void bin_range(const builder_t* b, int i, int j, const box_t* cb, const split_t s[3], bins_t* bins) {
+    const int nb = s[0].bins;
+    for (int a = 0; a < 3; a++) {
+        for (int k = 0; k < nb; k++) { box_empty(&bins->box[a][k]); bins->count[a][k] = 0; }
+    }
+    for (; i < j; i++) {
+        const int32_t t = b->bvh->triangles[i];
+        for (int a = 0; a < 3; a++) {
+            const int k = bin_of(&s[a], b->centroids[t], cb);
+            box_grow(&bins->box[a][k], &b->boxes[t]);
+            bins->count[a][k]++;
+        }
+    }
+}
+
+static void bin_chunk(chunks_t* c, int chunk, int i, int j) {
+    bin_range(c->b, i, j, c->cb, c->s, &c->bins[chunk]);
+}
+
+static int find_split(builder_t* b, int first, int count, const box_t* cb, split_t* best) {
+    split_t s[3];
+    const int nb = minimum(BVH_BINS, maximum(4, count));
+    for (int a = 0; a < 3; a++) {
+        const float extent = cb->max[a] - cb->min[a];
+        s[a].axis = a;
+        s[a].bins = nb;
+        s[a].scale = extent > 0 ? nb * (1 - 1e-6f) / extent : 0;
+    }
+    bins_t bins;
+    if (count < PARALLEL_MIN) {
+        bin_range(b, first, first + count, cb, s, &bins);
+    } else {
+        const int n = (count + CHUNK - 1) / CHUNK;
+        chunks_t c = { b, first, count, cb, s };
+        c.bins = (bins_t*)malloc(sizeof(bins_t) * (size_t)n);
+        if (c.bins == null) { return 0; }
+        chunks_run(&c, bin_chunk);
+        bins = c.bins[0];
+        for (int k = 1; k < n; k++) {
+            for (int a = 0; a < 3; a++) {
+                for (int i = 0; i < nb; i++) {
+                    box_grow(&bins.box[a][i], &c.bins[k].box[a][i]);
+                    bins.count[a][i] += c.bins[k].count[a][i];
+                }
+            }
+        }
+        free(c.bins);
+    }
+    best->axis = -1;
+    best->cost = INFINITY;
+    for (int a = 0; a < 3; a++) {
+        if (s[a].scale == 0) { continue; }
+        float right_area[BVH_BINS];
+        int right_count[BVH_BINS];
+        box_t r;
+        box_empty(&r);
+        int n = 0;
+        for (int k = nb - 1; k > 0; k--) {
+            box_grow(&r, &bins.box[a][k]);
+            n += bins.count[a][k];
+            right_area[k] = box_area(&r);
+            right_count[k] = n;
+        }
+        box_t l;
+        box_empty(&l);
+        n = 0;
+        for (int k = 1; k < nb; k++) {
+            box_grow(&l, &bins.box[a][k - 1]);
+            n += bins.count[a][k - 1];
+            const float cost = box_area(&l) * n + right_area[k] * right_count[k];
+            if (n > 0 && right_count[k] > 0 && cost < best->cost) {
+                *best = s[a];
+                best->cost = cost;
+                best->bin = k;
+            }
+        }
+    }
+    return 1;
+}
+
+static void count_chunk(chunks_t* c, int chunk, int i, int j) {
+    int n = 0;
+    for (; i < j; i++) { n += bin_of(c->s, c->b->centroids[c->b->bvh->triangles[i]], c->cb) < c->s->bin; }
+    c->lefts[chunk] = n;
+}
+
+static void scatter_chunk(chunks_t* c, int chunk, int i, int j) {
+    const int32_t* triangles = c->b->bvh->triangles;
+    int left = c->first + c->lefts[chunk];
+    int right = c->first + c->left + (i - c->first - c->lefts[chunk]);
+    for (; i < j; i++) {
+        const int32_t t = triangles[i];
+        if (bin_of(c->s, c->b->centroids[t], c->cb) < c->s->bin) {
+            c->b->scratch[left++] = t;
+        } else {
+            c->b->scratch[right++] = t;
+        }
+    }
+}
+
+static void copy_chunk(chunks_t* c, int chunk, int i, int j) {
+    memcpy(c->b->bvh->triangles + i, c->b->scratch + i, sizeof(int32_t) * (size_t)(j - i));
+    (void)chunk;
+}
+
+/* returns number of triangles in the first child or -1 on out of memory */
+static int partition(builder_t* b, int first, int count, const box_t* cb, const split_t* s) {
+    int32_t* triangles = b->bvh->triangles;
+    if (count < PARALLEL_MIN) {
+        int i = first, j = first + count - 1;
+        while (i <= j) {
+            if (bin_of(s, b->centroids[triangles[i]], cb) < s->bin) {
+                i++;
+            } else {
+                int32_t swap = triangles[i]; triangles[i] = triangles[j]; triangles[j] = swap;
+                j--;
+            }
+        }
+        return i - first;
+    }
+    const int n = (count + CHUNK - 1) / CHUNK;
+    chunks_t c = { b, first, count, cb, s };
+    c.lefts = (int*)malloc(sizeof(int) * (size_t)n);
+    if (c.lefts == null) { return -1; }
+    chunks_run(&c, count_chunk);
+    for (int k = 0; k < n; k++) { // exclusive prefix sum
+        const int left = c.lefts[k];
+        c.lefts[k] = c.left;
+        c.left += left;
+    }
+    chunks_run(&c, scatter_chunk);
+    chunks_run(&c, copy_chunk);
+    free(c.lefts);
+    return c.left;
+}
+
+/* quickselect: triangles[first + half] is the median along axis afterwards */
+static int median(builder_t* b, int first, int count, const box_t* cb, uint16_t* axis) {
+    int a = 0;
+    for (int i = 1; i < 3; i++) {
+        if (cb->max[i] - cb->min[i] > cb->max[a] - cb->min[a]) { a = i; }
+    }
+    *axis = (uint16_t)a;
+    const int half = count / 2;
+    if (cb->max[a] <= cb->min[a]) { return half; } // all centroids coincide
+    int32_t* triangles = b->bvh->triangles;
+    int lo = first, hi = first + count - 1;
+    const int k = first + half;
+    while (lo < hi) {
+        const float pivot = b->centroids[triangles[(lo + hi) / 2]][a];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (b->centroids[triangles[i]][a] < pivot) { i++; }
+            while (b->centroids[triangles[j]][a] > pivot) { j--; }
+            if (i <= j) {
+                int32_t swap = triangles[i]; triangles[i] = triangles[j]; triangles[j] = swap;
+                i++; j--;
+            }
+        }
+        if (k <= j) { hi = j; } else if (k >= i) { lo = i; } else { break; }
+    }
+    return half;
+}
+
+typedef struct subtree_s {
+    builder_t* b;
+    int first;
+    int count;
+    int depth;
+    int index;
+    int end;
+} subtree_t;
+
+static int build(builder_t* b, int first, int count, int depth, int index);
+
+static void build_task(void* that, void* message) {
+    subtree_t* t = (subtree_t*)message;
+    t->end = build(t->b, t->first, t->count, t->depth, t->index);
+    (void)that;
+}
+
+/* builds subtree with root at nodes[index], returns index past its last node or -1 on out of memory */
+static int build(builder_t* b, int first, int count, int depth, int index) {
+    box_t box, cb;
+    if (!bounds(b, first, count, &box, &cb)) { return -1; }
+    bvh_node_t* n = &b->bvh->nodes[index];
+    if (b->used != null) { b->used[index] = 1; }
+    memcpy(n->min, box.min, sizeof(n->min));
+    memcpy(n->max, box.max, sizeof(n->max));
+    n->axis = 0;
+    int left = 0; // number of triangles in the first child, 0 makes a leaf
+    if (depth >= MEDIAN_DEPTH) {
+        if (count > BVH_MAX_LEAF) { left = median(b, first, count, &cb, &n->axis); }
+    } else if (count > 1) {
+        split_t s;
+        if (!find_split(b, first, count, &cb, &s)) { return -1; }
+        const float split_cost = s.axis < 0 ? INFINITY : traversal_cost + s.cost / box_area(&box);
+        if (s.axis >= 0 && (count > BVH_MAX_LEAF || split_cost < (float)count)) {
+            left = partition(b, first, count, &cb, &s);
+            if (left < 0) { return -1; }
+            n->axis = (uint16_t)s.axis;
+        }
+        if (count > BVH_MAX_LEAF && (left == 0 || left == count)) {
+            left = median(b, first, count, &cb, &n->axis);
+        }
+    }
+    if (left == 0) {
+        n->offset = (uint32_t)first;
+        n->count = (uint16_t)count;
+        return index + 1;
+    }
+    n->count = 0;
+    if (count < TASK_MIN) {
+        const int second = build(b, first, left, depth + 1, index + 1);
+        n->offset = (uint32_t)second;
+        return build(b, first + left, count - left, depth + 1, second);
+    } else {
+        subtree_t t = { b, first, left, depth + 1, index + 1, 0 };
+        tasks_t g = {0};
+        tasks_spawn(&g, null, &t, build_task);
+        const int second = index + 2 * left; // first child reserves 2 * left - 1 nodes
+        n->offset = (uint32_t)second;
+        const int end = build(b, first + left, count - left, depth + 1, second);
+        tasks_wait(&g);
+        return t.end < 0 ? -1 : end;
+    }
+}
+
+typedef struct compact_s {
+    builder_t* b;
+    int slots;
+    int* counts;   /* [chunk] used nodes, then exclusive prefix sum */
+    int32_t* remap;
+    bvh_node_t* nodes;
+} compact_t;
+
+static void compact_count(void* that, int from, int to) {
+    compact_t* c = (compact_t*)that;
+    for (int k = from; k < to; k++) {
+        int n = 0;
+        for (int i = k * CHUNK; i < minimum((k + 1) * CHUNK, c->slots); i++) { n += c->b->used[i]; }
+        c->counts[k] = n;
+    }
+}
+
+static void compact_remap(void* that, int from, int to) {
+    compact_t* c = (compact_t*)that;
+    for (int k = from; k < to; k++) {
+        int n = c->counts[k];
+        for (int i = k * CHUNK; i < minimum((k + 1) * CHUNK, c->slots); i++) {
+            c->remap[i] = n;
+            n += c->b->used[i];
+        }
+    }
+}
+
+static void compact_move(void* that, int from, int to) {
+    compact_t* c = (compact_t*)that;
+    const bvh_node_t* nodes = c->b->bvh->nodes;
+    for (int k = from; k < to; k++) {
+        for (int i = k * CHUNK; i < minimum((k + 1) * CHUNK, c->slots); i++) {
+            if (c->b->used[i]) {
+                bvh_node_t* n = &c->nodes[c->remap[i]];
+                *n = nodes[i];
+                if (n->count == 0) { n->offset = (uint32_t)c->remap[n->offset]; }
+            }
+        }
+    }
+}
+
+/* squeezes out the holes left after concurrently built subtrees */
+static int compact(builder_t* b, int slots) {
+    const int n = (slots + CHUNK - 1) / CHUNK;
+    compact_t c = { b, slots };
+    c.counts = (int*)malloc(sizeof(int) * (size_t)n);
+    c.remap = (int32_t*)malloc(sizeof(int32_t) * (size_t)slots);
+    int ok = c.counts != null && c.remap != null;
+    if (ok) {
+        parallel_for(0, n, 1, &c, compact_count);
+        int used = 0;
+        for (int k = 0; k < n; k++) {
+            const int count = c.counts[k];
+            c.counts[k] = used;
+            used += count;
+        }
+        c.nodes = (bvh_node_t*)malloc(sizeof(bvh_node_t) * (size_t)used);
+        ok = c.nodes != null;
+        if (ok) {
+            parallel_for(0, n, 1, &c, compact_remap);
+            parallel_for(0, n, 1, &c, compact_move);
+            free(b->bvh->nodes);
+            b->bvh->nodes = c.nodes;
+            b->bvh->node_count = used;
+        }
+    }
+    free(c.counts);
+    free(c.remap);
+    return ok;
+}
+
+static void prepare(void* that, int from, int to) {
+    builder_t* b = (builder_t*)that;
+    for (int i = from; i < to; i++) {
+        const float* v[3];
+        mesh_triangle(&b->bvh->mesh, i, v);
+        box_empty(&b->boxes[i]);
+        for (int k = 0; k < 3; k++) { box_grow_point(&b->boxes[i], v[k]); }
+        for (int k = 0; k < 3; k++) { b->centroids[i][k] = (b->boxes[i].min[k] + b->boxes[i].max[k]) * 0.5f; }
+        b->bvh->triangles[i] = i;
+    }
+}
+
+bvh_t* bvh_create(const mesh_t* mesh) {
+    const int n = mesh->triangle_count;
+    const int slots = maximum(1, 2 * n - 1);
+    bvh_t* bvh = (bvh_t*)calloc(1, sizeof(bvh_t));
+    builder_t b = { bvh };
+    if (bvh != null) {
+        bvh->mesh = *mesh;
+        bvh->triangle_count = n;
+        bvh->nodes = (bvh_node_t*)malloc(sizeof(bvh_node_t) * (size_t)slots);
+        bvh->triangles = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, n));
+        b.boxes = (box_t*)malloc(sizeof(box_t) * (size_t)maximum(1, n));
+        b.centroids = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)maximum(1, n));
+        if (n >= PARALLEL_MIN) { b.scratch = (int32_t*)malloc(sizeof(int32_t) * (size_t)n); }
+        if (n >= TASK_MIN) { b.used = (uint8_t*)calloc((size_t)slots, 1); }
+    }
+    int ok = bvh != null && bvh->nodes != null && bvh->triangles != null && b.boxes != null && b.centroids != null &&
+             (n < PARALLEL_MIN || b.scratch != null) && (n < TASK_MIN || b.used != null);
+    if (ok && n > 0) {
+        parallel_for(0, n, CHUNK, &b, prepare);
+        bvh->node_count = build(&b, 0, n, 0, 0);
+        ok = bvh->node_count > 0;
+        if (ok && b.used != null) {
+            ok = compact(&b, slots);
+        } else if (ok) {
+            bvh_node_t* shrunk = (bvh_node_t*)realloc(bvh->nodes, sizeof(bvh_node_t) * (size_t)bvh->node_count);
+            if (shrunk != null) { bvh->nodes = shrunk; }
+        }
+    }
+    free(b.boxes);
+    free(b.centroids);
+    free(b.scratch);
+    free(b.used);
+    if (!ok) {
+        bvh_destroy(bvh);
+        bvh = null;
+    }
+    return bvh;
+}
+
+/* Tero Karras. Maximizing Parallelism in the Construction of BVHs, Octrees,
+   and k-d Trees. High Performance Graphics, 2012. (linear BVH)
+
+   Triangles are sorted by Morton code of their centroids, the hierarchy
+   is a radix tree over the sorted codes: every inner node is found
+   independently, bounds are fitted bottom-up, the first of two children to
+   arrive at a parent terminates and the second continues. Subtrees deeper
+   than MEDIAN_DEPTH are split at the middle of their (Morton ordered)
+   range to keep traversal within BVH_STACK. Quality is below the binned
+   SAH build, time is a fraction of it. */
+
+enum {
+    LINEAR_LEAF = 4,    /* radix tree subtrees of that many triangles are collapsed into leaves */
+    RADIX_BITS  = 11,   /* radix sort digit */
+    RADIX       = 1 << RADIX_BITS
+};
+
+typedef struct radix_node_s {
+    box_t box;
+    int32_t child[2]; /* negative: leaf ~index */
+    int32_t parent;
+    int32_t first;    /* [first..last] range of sorted triangles */
+    int32_t last;
+    atomic_int visits;
+} radix_node_t;
+
+typedef struct linear_s {
+    builder_t* b;
+    uint64_t* keys;
+    uint64_t* keys_swap;
+    int32_t* swap;       /* values of keys_swap */
+    int bits;            /* Morton code bits 30 or 63 */
+    int shift;           /* radix sort digit shift of current pass */
+    int* histograms;     /* [chunk][RADIX] */
+    box_t cb;            /* centroids bounds */
+    radix_node_t* nodes; /* n - 1 inner nodes */
+    int32_t* parents;    /* of n leaves */
+} linear_t;
+
+static inline uint64_t morton_spread(uint64_t x, int bits) { /* inserts two 0 bits after each of bits */
+    if (bits == 10) {
+        x &= 0x3FF;
+        x = (x | (x << 16)) & 0x30000FF;
+        x = (x | (x << 8)) & 0x300F00F;
+        x = (x | (x << 4)) & 0x30C30C3;
+        x = (x | (x << 2)) & 0x9249249;
+    } else {
+        x &= 0x1FFFFF;
+        x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+        x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+        x = (x | (x << 8)) & 0x100F00F00F00F00FULL;
+        x = (x | (x << 4)) & 0x10C30C30C30C30C3ULL;
+        x = (x | (x << 2)) & 0x1249249249249249ULL;
+    }
+    return x;
+}
+
+static void morton_codes(void* that, int from, int to) {
+    linear_t* l = (linear_t*)that;
+    const int bits = l->bits / 3;
+    const float cells = (float)(1 << bits);
+    float scale[3];
+    for (int k = 0; k < 3; k++) {
+        const float extent = l->cb.max[k] - l->cb.min[k];
+        scale[k] = extent > 0 ? cells * (1 - 1e-6f) / extent : 0;
+    }
+    for (int i = from; i < to; i++) {
+        const float* c = l->b->centroids[i];
+        uint64_t code = 0;
+        for (int k = 0; k < 3; k++) {
+            const uint64_t q = (uint64_t)minimum(cells - 1, (c[k] - l->cb.min[k]) * scale[k]);
+            code |= morton_spread(q, bits) << (2 - k);
+        }
+        l->keys[i] = code;
+    }
+}
+
+static void radix_count(void* that, int from, int to) {
+    linear_t* l = (linear_t*)that;
+    const int n = l->b->bvh->triangle_count;
+    for (int k = from; k < to; k++) {
+        int* h = l->histograms + (size_t)k * RADIX;
+        memset(h, 0, sizeof(int) * RADIX);
+        for (int i = k * CHUNK; i < minimum((k + 1) * CHUNK, n); i++) {
+            h[(l->keys[i] >> l->shift) & (RADIX - 1)]++;
+        }
+    }
+}
+
+static void radix_scatter(void* that, int from, int to) {
+    linear_t* l = (linear_t*)that;
+    const int n = l->b->bvh->triangle_count;
+    const int32_t* values = l->b->bvh->triangles;
+    for (int k = from; k < to; k++) {
+        int* h = l->histograms + (size_t)k * RADIX; // exclusive offsets after the scan
+        for (int i = k * CHUNK; i < minimum((k + 1) * CHUNK, n); i++) {
+            const int j = h[(l->keys[i] >> l->shift) & (RADIX - 1)]++;
+            l->keys_swap[j] = l->keys[i];
+            l->swap[j] = values[i];
+        }
+    }
+}
+
+/* LSD radix sort of (keys, bvh.triangles), stable, passes with a single digit value are skipped */
+static void radix_sort(linear_t* l) {
+    const int n = l->b->bvh->triangle_count;
+    const int chunks = (n + CHUNK - 1) / CHUNK;
+    for (l->shift = 0; l->shift < l->bits; l->shift += RADIX_BITS) {
+        parallel_for(0, chunks, 1, l, radix_count);
+        int sum = 0;
+        int skip = 0;
+        for (int d = 0; d < RADIX && !skip; d++) {
+            const int start = sum;
+            for (int k = 0; k < chunks; k++) {
+                int* h = l->histograms + (size_t)k * RADIX + d;
+                const int count = *h;
+                *h = sum;
+                sum += count;
+            }
+            skip = sum - start == n;
+        }
+        if (!skip) {
+            parallel_for(0, chunks, 1, l, radix_scatter);
+            uint64_t* keys = l->keys; l->keys = l->keys_swap; l->keys_swap = keys;
+            int32_t* values = l->b->bvh->triangles; l->b->bvh->triangles = l->swap; l->swap = values;
+        }
+    }
+}
+
+static inline int clz64(uint64_t x) { return x == 0 ? 64 : __builtin_clzll(x); }
+
+/* common prefix of keys i and j, equal keys are told apart by index */
+static inline int delta(const linear_t* l, int n, int i, int j) {
+    if (j < 0 || j >= n) { return -1; }
+    const uint64_t a = l->keys[i], b = l->keys[j];
+    return a != b ? clz64(a ^ b) : 64 + clz64((uint64_t)(uint32_t)(i ^ j)) - 32;
+}
+
+static void radix_tree(void* that, int from, int to) {
+    linear_t* l = (linear_t*)that;
+    const int n = l->b->bvh->triangle_count;
+    for (int i = from; i < to; i++) {
+        const int d = delta(l, n, i, i + 1) > delta(l, n, i, i - 1) ? 1 : -1;
+        const int dmin = delta(l, n, i, i - d);
+        int lmax = 2;
+        while (delta(l, n, i, i + lmax * d) > dmin) { lmax *= 2; }
+        int len = 0;
+        for (int t = lmax / 2; t >= 1; t /= 2) {
+            if (delta(l, n, i, i + (len + t) * d) > dmin) { len += t; }
+        }
+        const int j = i + len * d;
+        const int dnode = delta(l, n, i, j);
+        int s = 0;
+        for (int div = 2, t = len; t > 1; div *= 2) {
+            t = (len + div - 1) / div;
+            if (delta(l, n, i, i + (s + t) * d) > dnode) { s += t; }
+        }
+        const int gamma = i + s * d + minimum(d, 0);
+        radix_node_t* node = &l->nodes[i];
+        node->first = minimum(i, j);
+        node->last = maximum(i, j);
+        node->child[0] = node->first == gamma ? ~gamma : gamma;
+        node->child[1] = node->last == gamma + 1 ? ~(gamma + 1) : gamma + 1;
+        for (int c = 0; c < 2; c++) {
+            if (node->child[c] < 0) {
+                l->parents[~node->child[c]] = i;
+            } else {
+                l->nodes[node->child[c]].parent = i;
+            }
+        }
+        atomic_store(&node->visits, 0);
+    }
+}
+
+static inline const box_t* radix_box(const linear_t* l, int32_t child) {
+    return child < 0 ? &l->b->boxes[l->b->bvh->triangles[~child]] : &l->nodes[child].box;
+}
+
+static void radix_fit(void* that, int from, int to) {
+    linear_t* l = (linear_t*)that;
+    for (int i = from; i < to; i++) {
+        int32_t p = l->parents[i];
+        while (p >= 0 && atomic_fetch_add(&l->nodes[p].visits, 1) == 1) { // second to arrive
+            radix_node_t* node = &l->nodes[p];
+            node->box = *radix_box(l, node->child[0]);
+            box_grow(&node->box, radix_box(l, node->child[1]));
+            p = node->parent;
+        }
+    }
+}
+
+typedef struct linear_subtree_s {
+    linear_t* l;
+    int32_t node;
+    int depth;
+    int index;
+    int end;
+} linear_subtree_t;
+
+static int linear_emit(linear_t* l, int32_t node, int depth, int index);
+
+static void linear_task(void* that, void* message) {
+    linear_subtree_t* t = (linear_subtree_t*)message;
+    t->end = linear_emit(t->l, t->node, t->depth, t->index);
+    (void)that;
+}
+
+static void linear_node(linear_t* l, const box_t* box, int index) {
+    bvh_node_t* n = &l->b->bvh->nodes[index];
+    if (l->b->used != null) { l->b->used[index] = 1; }
+    memcpy(n->min, box->min, sizeof(n->min));
+    memcpy(n->max, box->max, sizeof(n->max));
+    n->axis = 0;
+}
+
+/* deeper than MEDIAN_DEPTH: halves of the Morton ordered range */
+static int linear_median(linear_t* l, int first, int count, int index) {
+    box_t box, cb;
+    bounds_range(l->b, first, first + count, &box, &cb);
+    linear_node(l, &box, index);
+    bvh_node_t* n = &l->b->bvh->nodes[index];
+    if (count <= LINEAR_LEAF) {
+        n->offset = (uint32_t)first;
+        n->count = (uint16_t)count;
+        return index + 1;
+    }
+    n->count = 0;
+    const int half = count / 2;
+    const int second = linear_median(l, first, half, index + 1);
+    n->offset = (uint32_t)second;
+    return linear_median(l, first + half, count - half, second);
+}
+
+/* converts radix tree into depth first bvh nodes, same node layout as build() */
+static int linear_emit(linear_t* l, int32_t node, int depth, int index) {
+    const int first = node < 0 ? ~node : l->nodes[node].first;
+    const int count = node < 0 ? 1 : l->nodes[node].last - first + 1;
+    if (depth >= MEDIAN_DEPTH) { return linear_median(l, first, count, index); }
+    linear_node(l, radix_box(l, node), index);
+    bvh_node_t* n = &l->b->bvh->nodes[index];
+    if (count <= LINEAR_LEAF) { // fitted box already is the union of the collapsed subtree
+        n->offset = (uint32_t)first;
+        n->count = (uint16_t)count;
+        return index + 1;
+    }
+    n->count = 0;
+    const int32_t* child = l->nodes[node].child;
+    const int left = child[0] < 0 ? 1 : l->nodes[child[0]].last - first + 1;
+    if (count < TASK_MIN) {
+        const int second = linear_emit(l, child[0], depth + 1, index + 1);
+        n->offset = (uint32_t)second;
+        return linear_emit(l, child[1], depth + 1, second);
+    } else {
+        linear_subtree_t t = { l, child[0], depth + 1, index + 1, 0 };
+        tasks_t g = {0};
+        tasks_spawn(&g, null, &t, linear_task);
+        const int second = index + 2 * left;
+        n->offset = (uint32_t)second;
+        const int end = linear_emit(l, child[1], depth + 1, second);
+        tasks_wait(&g);
+        return end;
+    }
+}
+
+bvh_t* bvh_create_linear(const mesh_t* mesh) {
+    const int n = mesh->triangle_count;
+    const int slots = maximum(1, 2 * n - 1);
+    const int chunks = maximum(1, (n + CHUNK - 1) / CHUNK);
+    bvh_t* bvh = (bvh_t*)calloc(1, sizeof(bvh_t));
+    builder_t b = { bvh };
+    linear_t l = { &b };
+    if (bvh != null) {
+        bvh->mesh = *mesh;
+        bvh->triangle_count = n;
+        bvh->nodes = (bvh_node_t*)malloc(sizeof(bvh_node_t) * (size_t)slots);
+        bvh->triangles = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, n));
+        b.boxes = (box_t*)malloc(sizeof(box_t) * (size_t)maximum(1, n));
+        b.centroids = (vec3f_t*)malloc(sizeof(vec3f_t) * (size_t)maximum(1, n));
+        if (n >= TASK_MIN) { b.used = (uint8_t*)calloc((size_t)slots, 1); }
+        l.keys = (uint64_t*)malloc(sizeof(uint64_t) * 2 * (size_t)maximum(1, n));
+        l.swap = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, n));
+        l.histograms = (int*)malloc(sizeof(int) * RADIX * (size_t)chunks);
+        l.nodes = (radix_node_t*)malloc(sizeof(radix_node_t) * (size_t)maximum(1, n - 1));
+        l.parents = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, n));
+    }
+    int ok = bvh != null && bvh->nodes != null && bvh->triangles != null && b.boxes != null &&
+             b.centroids != null && (n < TASK_MIN || b.used != null) && l.keys != null &&
+             l.swap != null && l.histograms != null && l.nodes != null && l.parents != null;
+    uint64_t* keys = l.keys; // radix_sort() swaps buffers
+    if (ok && n > 0) {
+        l.keys_swap = l.keys + n;
+        parallel_for(0, n, CHUNK, &b, prepare);
+        box_t box;
+        ok = bounds(&b, 0, n, &box, &l.cb);
+    }
+    if (ok && n > 0) {
+        l.bits = n <= (1 << 22) ? 30 : 63; // 10 or 21 bits per axis, equal codes are split by index
+        parallel_for(0, n, CHUNK, &l, morton_codes);
+        radix_sort(&l);
+        if (n > 1) {
+            l.nodes[0].parent = -1;
+            parallel_for(0, n - 1, CHUNK, &l, radix_tree);
+            parallel_for(0, n, CHUNK, &l, radix_fit);
+        }
+        bvh->linear = 1;
+        bvh->node_count = linear_emit(&l, n > 1 ? 0 : ~0, 0, 0);
+        if (b.used != null) {
+            ok = compact(&b, slots);
+        } else {
+            bvh_node_t* shrunk = (bvh_node_t*)realloc(bvh->nodes, sizeof(bvh_node_t) * (size_t)bvh->node_count);
+            if (shrunk != null) { bvh->nodes = shrunk; }
+        }
+    }
+    free(keys);
+    free(l.swap);
+    free(l.histograms);
+    free(l.nodes);
+    free(l.parents);
+    free(b.boxes);
+    free(b.centroids);
+    free(b.used);
+    if (!ok) {
+        bvh_destroy(bvh);
+        bvh = null;
+    }
+    return bvh;
+}
+
+/* Refit keeps the topology and recomputes bounds from moved vertices.
+   Nodes are depth first so children always follow their parent and every
+   subtree is a contiguous range of nodes: reverse order is bottom-up.
+   The tree is cut into subtrees of at most `grain` nodes, these are
+   refitted in parallel, nodes above them afterwards. SAH cost of every
+   subtree (relative to its own root area, so it is scale invariant) is
+   compared with its cost right after the build. */
+
+typedef struct refit_root_s {
+    int32_t node;
+    int32_t end;      /* one past last node of subtree */
+    int depth;
+    float baseline;   /* SAH cost after build, 0 unknown */
+    float cost;
+    double sum;       /* sum of area * cost of subtree nodes */
+} refit_root_t;
+
+typedef struct bvh_refit_s {
+    refit_root_t* roots;
+    int count;
+    int grain;        /* maximum nodes per subtree */
+    float baseline;   /* whole tree */
+    float ratio;      /* SAH cost relative to baseline after last refit */
+} bvh_refit_t;
+
+static int subtree_end(const bvh_t* bvh, int32_t i) {
+    while (bvh->nodes[i].count == 0) { i = (int32_t)bvh->nodes[i].offset; }
+    return i + 1;
+}
+
+/* appends roots of subtrees of at most grain nodes in depth first order */
+static int refit_roots(const bvh_t* bvh, int32_t i, int depth, int grain, refit_root_t** roots, int* count) {
+    const int32_t end = subtree_end(bvh, i);
+    if (end - i <= grain || bvh->nodes[i].count > 0) {
+        if ((*count & (*count - 1)) == 0) { // powers of 2 double capacity
+            refit_root_t* r = (refit_root_t*)realloc(*roots, sizeof(refit_root_t) * (size_t)maximum(1, *count * 2));
+            if (r == null) { return 0; }
+            *roots = r;
+        }
+        refit_root_t* r = &(*roots)[(*count)++];
+        memset(r, 0, sizeof(*r));
+        r->node = i;
+        r->end = end;
+        r->depth = depth;
+        return 1;
+    }
+    return refit_roots(bvh, i + 1, depth + 1, grain, roots, count) &&
+           refit_roots(bvh, (int32_t)bvh->nodes[i].offset, depth + 1, grain, roots, count);
+}
+
+static inline float node_area(const bvh_node_t* n) {
+    box_t b;
+    memcpy(&b, n, sizeof(b));
+    return box_area(&b);
+}
+
+/* refit nodes [from..to) in reverse, with moved = false only sums cost of current bounds */
+static double refit_range(bvh_t* bvh, int32_t from, int32_t to, int moved) {
+    double sum = 0;
+    for (int32_t i = to - 1; i >= from; i--) {
+        bvh_node_t* n = &bvh->nodes[i];
+        if (moved) {
+            box_t box;
+            box_empty(&box);
+            if (n->count > 0) {
+                for (uint32_t k = n->offset; k < n->offset + n->count; k++) {
+                    const float* v[3];
+                    mesh_triangle(&bvh->mesh, bvh->triangles[k], v);
+                    for (int j = 0; j < 3; j++) { box_grow_point(&box, v[j]); }
+                }
+            } else {
+                box_t c;
+                memcpy(&c, &bvh->nodes[i + 1], sizeof(c));
+                box_grow(&box, &c);
+                memcpy(&c, &bvh->nodes[n->offset], sizeof(c));
+                box_grow(&box, &c);
+            }
+            memcpy(n->min, box.min, sizeof(n->min));
+            memcpy(n->max, box.max, sizeof(n->max));
+        }
+        sum += node_area(n) * (n->count > 0 ? (float)n->count : traversal_cost);
+    }
+    return sum;
+}
+
+typedef struct refit_pass_s {
+    bvh_t* bvh;
+    int moved;
+} refit_pass_t;
+
+static void refit_subtrees(void* that, int from, int to) {
+    refit_pass_t* p = (refit_pass_t*)that;
+    for (int k = from; k < to; k++) {
+        refit_root_t* r = &p->bvh->refit->roots[k];
+        r->sum = refit_range(p->bvh, r->node, r->end, p->moved);
+        const float area = node_area(&p->bvh->nodes[r->node]);
+        r->cost = area > 0 ? (float)(r->sum / area) : 0;
+        if (r->baseline == 0) { r->baseline = r->cost; }
+    }
+}
+
+/* refits subtrees in parallel and nodes above them, returns whole tree SAH cost */
+static float refit_pass(bvh_t* bvh, int moved) {
+    bvh_refit_t* s = bvh->refit;
+    refit_pass_t p = { bvh, moved };
+    parallel_for(0, s->count, 1, &p, refit_subtrees);
+    double sum = 0;
+    int32_t to = bvh->node_count;
+    for (int k = s->count - 1; k >= 0; k--) { // nodes between subtrees are above them
+        sum += refit_range(bvh, s->roots[k].end, to, moved) + s->roots[k].sum;
+        to = s->roots[k].node;
+    }
+    sum += refit_range(bvh, 0, to, moved);
+    const float area = node_area(&bvh->nodes[0]);
+    return area > 0 ? (float)(sum / area) : 0;
+}
+
+static void prepare_subset(void* that, int from, int to) {
+    builder_t* b = (builder_t*)that;
+    for (int i = from; i < to; i++) {
+        const int32_t t = b->bvh->triangles[i];
+        const float* v[3];
+        mesh_triangle(&b->bvh->mesh, t, v);
+        box_empty(&b->boxes[t]);
+        for (int k = 0; k < 3; k++) { box_grow_point(&b->boxes[t], v[k]); }
+        for (int k = 0; k < 3; k++) { b->centroids[t][k] = (b->boxes[t].min[k] + b->boxes[t].max[k]) * 0.5f; }
+    }
+}
+
+/* SAH rebuild of roots[k] subtree spliced into bvh.nodes in place of the old one */
+static int rebuild_subtree(bvh_t* bvh, int k) {
+    bvh_refit_t* s = bvh->refit;
+    const refit_root_t root = s->roots[k];
+    int first = bvh->triangle_count, last = 0;
+    for (int32_t i = root.node; i < root.end; i++) {
+        const bvh_node_t* n = &bvh->nodes[i];
+        if (n->count > 0) {
+            first = minimum(first, (int)n->offset);
+            last = maximum(last, (int)(n->offset + n->count));
+        }
+    }
+    const int count = last - first;
+    const int slots = 2 * count - 1;
+    const size_t n = (size_t)bvh->triangle_count;
+    bvh_t t = *bvh; // shares triangles, own nodes
+    builder_t b = { &t };
+    t.nodes = (bvh_node_t*)malloc(sizeof(bvh_node_t) * (size_t)slots);
+    b.boxes = (box_t*)malloc(sizeof(box_t) * n);
+    b.centroids = (vec3f_t*)malloc(sizeof(vec3f_t) * n);
+    if (count >= PARALLEL_MIN) { b.scratch = (int32_t*)malloc(sizeof(int32_t) * n); }
+    if (count >= TASK_MIN) { b.used = (uint8_t*)calloc((size_t)slots, 1); }
+    int ok = t.nodes != null && b.boxes != null && b.centroids != null &&
+             (count < PARALLEL_MIN || b.scratch != null) && (count < TASK_MIN || b.used != null);
+    if (ok) {
+        parallel_for(first, last, CHUNK, &b, prepare_subset);
+        t.node_count = build(&b, first, count, root.depth, 0);
+        ok = t.node_count > 0 && (b.used == null || compact(&b, slots));
+    }
+    bvh_node_t* nodes = null;
+    const int delta = t.node_count - (root.end - root.node);
+    if (ok) {
+        nodes = (bvh_node_t*)malloc(sizeof(bvh_node_t) * (size_t)(bvh->node_count + delta));
+        ok = nodes != null;
+    }
+    int count_before = s->count;
+    if (ok) { // roots of the new subtree are appended and moved in place of roots[k] below
+        ok = refit_roots(&t, 0, root.depth, s->grain, &s->roots, &s->count);
+        if (!ok) { s->count = count_before; }
+    }
+    if (ok) {
+        for (int32_t i = 0; i < root.node; i++) {
+            nodes[i] = bvh->nodes[i];
+            if (nodes[i].count == 0 && nodes[i].offset >= (uint32_t)root.end) { nodes[i].offset += delta; }
+        }
+        for (int32_t i = 0; i < t.node_count; i++) {
+            nodes[root.node + i] = t.nodes[i];
+            if (t.nodes[i].count == 0) { nodes[root.node + i].offset += root.node; }
+        }
+        for (int32_t i = root.end; i < bvh->node_count; i++) {
+            nodes[i + delta] = bvh->nodes[i];
+            if (nodes[i + delta].count == 0) { nodes[i + delta].offset += delta; }
+        }
+        free(bvh->nodes);
+        bvh->nodes = nodes;
+        bvh->node_count += delta;
+        const int added = s->count - count_before;
+        refit_root_t* roots = (refit_root_t*)malloc(sizeof(refit_root_t) * (size_t)added);
+        ok = roots != null;
+        if (ok) { // roots[k] := new roots shifted by root.node, following ones by delta
+            memcpy(roots, s->roots + count_before, sizeof(refit_root_t) * (size_t)added);
+            memmove(s->roots + k + added, s->roots + k + 1, sizeof(refit_root_t) * (size_t)(count_before - k - 1));
+            for (int i = k + added; i < count_before - 1 + added; i++) { s->roots[i].node += delta; s->roots[i].end += delta; }
+            for (int i = 0; i < added; i++) {
+                s->roots[k + i] = roots[i];
+                s->roots[k + i].node += root.node;
+                s->roots[k + i].end += root.node;
+            }
+            s->count = count_before - 1 + added;
+            free(roots);
+        } else { // nodes already spliced, forget all roots: recomputed on next refit
+            free(s->roots);
+            s->roots = null;
+            s->count = 0;
+        }
+    }
+    free(t.nodes);
+    free(b.boxes);
+    free(b.centroids);
+    free(b.scratch);
+    free(b.used);
+    return ok;
+}
+
+static int rebuild(bvh_t* bvh) {
+    bvh_t* r = bvh->linear ? bvh_create_linear(&bvh->mesh) : bvh_create(&bvh->mesh);
+    if (r == null) { return 0; }
+    free(bvh->nodes);
+    free(bvh->triangles);
+    bvh->nodes = r->nodes;
+    bvh->triangles = r->triangles;
+    bvh->node_count = r->node_count;
+    r->nodes = null;
+    r->triangles = null;
+    bvh_destroy(r);
+    return 1;
+}
+
+static int refit_state(bvh_t* bvh) {
+    bvh_refit_t* s = (bvh_refit_t*)calloc(1, sizeof(bvh_refit_t));
+    if (s == null) { return 0; }
+    s->grain = maximum(4096, bvh->node_count / 64);
+    if (!refit_roots(bvh, 0, 0, s->grain, &s->roots, &s->count)) {
+        free(s);
+        return 0;
+    }
+    bvh->refit = s;
+    s->baseline = refit_pass(bvh, false); // bounds are still as built
+    return 1;
+}
+
+static void refit_free(bvh_t* bvh) {
+    if (bvh->refit != null) {
+        free(bvh->refit->roots);
+        free(bvh->refit);
+        bvh->refit = null;
+    }
+}
+
+int bvh_refit(bvh_t* bvh, float threshold) {
+    if (bvh->node_count == 0) { return BVH_REFITTED; }
+    if (bvh->refit == null && !refit_state(bvh)) { return 0; }
+    bvh_refit_t* s = bvh->refit;
+    float cost = refit_pass(bvh, true);
+    s->ratio = s->baseline > 0 ? cost / s->baseline : 1;
+    int rebuilt = 0;
+    for (int k = s->count - 1; k >= 0; k--) { // backwards: splicing moves following roots only
+        refit_root_t* r = &s->roots[k];
+        if (r->end - r->node > 1 && r->baseline > 0 && r->cost > r->baseline * threshold) {
+            rebuilt += r->end - r->node;
+            if (!rebuild_subtree(bvh, k)) { return 0; } // refitted tree is still valid
+            if (s->roots == null) { refit_free(bvh); return 0; }
+        }
+    }
+    if (rebuilt > 0) {
+        cost = refit_pass(bvh, false);
+        s->ratio = s->baseline > 0 ? cost / s->baseline : 1;
+    }
+    if (s->ratio > threshold || rebuilt > bvh->node_count / 2) {
+        if (!rebuild(bvh)) { return 0; }
+        refit_free(bvh);
+        return BVH_REBUILT;
+    }
+    return rebuilt > 0 ? BVH_REBUILT_PARTIAL : BVH_REFITTED;
+}
+
+float bvh_sah_ratio(const bvh_t* bvh) {
+    return bvh->refit != null ? bvh->refit->ratio : 1;
+}
+
+void bvh_destroy(bvh_t* bvh) {
+    if (bvh != null) {
+        refit_free(bvh);
+        free(bvh->nodes);
+        free(bvh->triangles);
+        free(bvh);
+    }
+}
+
+typedef struct ray_s {
+    float orig[3];
+    float inv[3];  /* 1 / dir */
+    double o[3];   /* intersect_triangle() is double precision */
+    double d[3];
+} ray_t;
+
+static inline void ray_init(ray_t* r, const float orig[3], const float dir[3]) {
+    for (int i = 0; i < 3; i++) {
+        r->orig[i] = orig[i];
+        r->inv[i] = 1.0f / dir[i];
+        r->o[i] = orig[i];
+        r->d[i] = dir[i];
+    }
+}
+
+/* slab test, NaN from 0 * inf (ray in the slab plane) keeps the interval as is */
+static inline int ray_box(const bvh_node_t* n, const ray_t* r, float tmin, float tmax, float* tnear) {
+    for (int i = 0; i < 3; i++) {
+        float t0 = (n->min[i] - r->orig[i]) * r->inv[i];
+        float t1 = (n->max[i] - r->orig[i]) * r->inv[i];
+        if (t0 > t1) { float swap = t0; t0 = t1; t1 = swap; }
+        tmin = t0 > tmin ? t0 : tmin;
+        tmax = t1 < tmax ? t1 : tmax;
+    }
+    *tnear = tmin;
+    return tmin <= tmax;
+}
+
+/* one traversal loop for all three queries, mode is a constant in each caller */
+static inline int traverse(const bvh_t* bvh, const float orig[3], const float dir[3], float tmin, float tmax,
+                           int mode, bvh_hit_t hits[], int capacity) {
+    if (bvh->node_count == 0) { return 0; }
+    ray_t r;
+    ray_init(&r, orig, dir);
+    uint32_t stack[BVH_STACK];
+    float near[BVH_STACK];
+    int sp = 0;
+    int found = 0;
+    float tfar = tmax;
+    float tn;
+    if (!ray_box(&bvh->nodes[0], &r, tmin, tfar, &tn)) { return 0; }
+    uint32_t i = 0;
+    for (;;) {
+        const bvh_node_t* n = &bvh->nodes[i];
+        if (n->count == 0) {
+            uint32_t a = i + 1, c = n->offset;
+            float ta, tc;
+            const int ha = ray_box(&bvh->nodes[a], &r, tmin, tfar, &ta);
+            const int hc = ray_box(&bvh->nodes[c], &r, tmin, tfar, &tc);
+            if (ha && hc) {
+                if (tc < ta) { uint32_t s = a; a = c; c = s; float f = ta; ta = tc; tc = f; }
+                near[sp] = tc;
+                stack[sp++] = c;
+                i = a;
+                continue;
+            } else if (ha || hc) {
+                i = ha ? a : c;
+                continue;
+            }
+        } else {
+            for (uint32_t k = n->offset; k < n->offset + n->count; k++) {
+                bvh_hit_t h;
+                if (bvh_triangle_hit(&bvh->mesh, bvh->triangles[k], r.o, r.d, tmin, tfar, mode, &h)) {
+                    if (mode == ANY) { return 1; }
+                    if (mode == CLOSEST) {
+                        hits[0] = h;
+                        tfar = h.t;
+                        found = 1;
+                    } else {
+                        bvh_keep_nearest(hits, capacity, found, &h);
+                        found++;
+                    }
+                }
+            }
+        }
+        do {
+            if (sp == 0) { return found; }
+            sp--;
+        } while (near[sp] > tfar);
+        i = stack[sp];
+    }
+}
+
+int bvh_closest_hit(const bvh_t* bvh, const float orig[3], const float dir[3],
+                    float tmin, float tmax, bvh_hit_t* hit) {
+    hit->triangle = -1;
+    hit->t = tmax;
+    return traverse(bvh, orig, dir, tmin, tmax, CLOSEST, hit, 1);
+}
+
+int bvh_any_hit(const bvh_t* bvh, const float orig[3], const float dir[3],
+                float tmin, float tmax) {
+    return traverse(bvh, orig, dir, tmin, tmax, ANY, null, 0);
+}
+
+int bvh_all_hits(const bvh_t* bvh, const float orig[3], const float dir[3],
+                 float tmin, float tmax, bvh_hit_t hits[], int capacity) {
+    return bvh_sort_hits(hits, capacity, traverse(bvh, orig, dir, tmin, tmax, ALL, hits, capacity));
+}
+
+END_C
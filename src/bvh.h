@@ -0,0 +1,72 @@
+#pragma once
+#include "mesh.h"
+
+/* bounding volume hierarchy over indexed triangle mesh.
+   Binned surface area heuristic or linear (Morton order) build,
+   nodes flattened depth first:
+   first child of inner node is the next node, second child is at .offset.
+   Ray queries call intersect_triangle() in the leaves. */
+
+BEGIN_C
+
+typedef struct bvh_node_s { /* 32 bytes */
+    float min[3];
+    float max[3];
+    uint32_t offset; /* inner: index of second child, leaf: first index into bvh.triangles */
+    uint16_t count;  /* 0 for inner nodes, number of triangles in a leaf */
+    uint16_t axis;   /* split axis of inner node */
+} bvh_node_t;
+
+typedef struct bvh_s {
+    mesh_t mesh;         /* not owned, vertices and indices must outlive bvh */
+    bvh_node_t* nodes;   /* nodes[0] is the root */
+    int32_t* triangles;  /* leaf triangle references into mesh */
+    int node_count;
+    int triangle_count;
+    int linear;          /* built by bvh_create_linear() */
+    struct bvh_refit_s* refit; /* bvh_refit() state */
+} bvh_t;
+
+typedef struct bvh_hit_s {
+    float t;
+    float u; /* barycentric coordinates as in intersect_triangle() */
+    float v;
+    int triangle; /* -1 when there is no hit */
+} bvh_hit_t;
+
+enum {
+    BVH_BINS     = 32, /* SAH bins per axis */
+    BVH_MAX_LEAF = 8,  /* maximum triangles per leaf */
+    BVH_STACK    = 64  /* traversal stack depth, deeper trees are not built */
+};
+
+enum { /* bvh_refit() results, 0 is out of memory (tree is refitted and usable) */
+    BVH_REFITTED        = 1,
+    BVH_REBUILT_PARTIAL = 2, /* some subtrees were rebuilt */
+    BVH_REBUILT         = 3
+};
+
+bvh_t* bvh_create(const mesh_t* mesh); /* returns null on out of memory */
+/* linear BVH from Morton codes, few times faster to build, slower to
+   traverse, meant for per frame rebuilds of deforming meshes */
+bvh_t* bvh_create_linear(const mesh_t* mesh);
+void bvh_destroy(bvh_t* bvh);
+
+/* after vertices moved (same indices, bvh.mesh.vertices may be replaced)
+   recomputes bounds bottom-up. Subtrees whose SAH cost grew more than
+   threshold times (e.g. 1.5) since they were built are rebuilt, whole tree
+   is rebuilt when its cost still exceeds threshold or most of it was. */
+int bvh_refit(bvh_t* bvh, float threshold);
+float bvh_sah_ratio(const bvh_t* bvh); /* SAH cost after last refit relative to build */
+
+/* ray queries consider hits with tmin <= t <= tmax, dir need not be normalized */
+int bvh_closest_hit(const bvh_t* bvh, const float orig[3], const float dir[3],
+                    float tmin, float tmax, bvh_hit_t* hit);
+int bvh_any_hit(const bvh_t* bvh, const float orig[3], const float dir[3],
+                float tmin, float tmax); /* occlusion: stops at first hit */
+/* all hits sorted by t, returns total number of hits which may exceed capacity,
+   hits[] then holds the capacity nearest of them */
+int bvh_all_hits(const bvh_t* bvh, const float orig[3], const float dir[3],
+                 float tmin, float tmax, bvh_hit_t hits[], int capacity);
+
+END_C
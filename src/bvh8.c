@@ -0,0 +1,247 @@
+#include "bvh8.h"
+#include "bvh_hits.h"
+#include "simd.h"
+
+BEGIN_C
+
+typedef uint8_t u8x4 __attribute__((vector_size(4)));
+typedef uint8_t u8x8 __attribute__((vector_size(8)));
+
+enum {
+    BVH8_STACK = (BVH8_WIDTH - 1) * BVH_STACK + 1 /* every node visited replaces itself by at most 8 entries */
+};
+
+typedef struct entry_s {
+    uint32_t index; /* node or first triangle reference */
+    uint32_t count; /* 0 for node or number of triangles */
+    float t;        /* entry distance */
+} entry_t;
+
+typedef struct ray8_s {
+    float orig[3];
+    float inv[3];
+    int negative[3]; /* sign of inv: near plane is qmax */
+    double o[3];
+    double d[3];
+} ray8_t;
+
+static inline float grid_step(int8_t exponent) {
+    const uint32_t bits = (uint32_t)(exponent + 127) << 23;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline void ray8_init(ray8_t* r, const float orig[3], const float dir[3]) {
+    for (int i = 0; i < 3; i++) {
+        r->orig[i] = orig[i];
+        r->inv[i] = 1.0f / dir[i];
+        r->negative[i] = signbit(r->inv[i]) != 0;
+        r->o[i] = orig[i];
+        r->d[i] = dir[i];
+    }
+}
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define VU u8x4
+#define TARGET
+#include "bvh8.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef VU
+#undef TARGET
+
+#ifdef SIMD_X86
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define VU u8x8
+#define TARGET SIMD_TARGET_AVX2
+#include "bvh8.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef VU
+#undef TARGET
+#endif
+
+typedef struct collapse_s {
+    const bvh_t* bvh;
+    bvh8_t* bvh8;
+} collapse_t;
+
+/* triangles of binary subtree are contiguous in bvh.triangles */
+static int subtree_triangles(const bvh_t* bvh, int32_t i, uint32_t* first) {
+    int32_t l = i, r = i;
+    while (bvh->nodes[l].count == 0) { l++; }
+    while (bvh->nodes[r].count == 0) { r = (int32_t)bvh->nodes[r].offset; }
+    *first = bvh->nodes[l].offset;
+    return (int)(bvh->nodes[r].offset + bvh->nodes[r].count - *first);
+}
+
+static inline float node_area(const bvh_node_t* n) {
+    const float dx = n->max[0] - n->min[0], dy = n->max[1] - n->min[1], dz = n->max[2] - n->min[2];
+    return 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+/* decoded plane must be on the outer side of v for both a + q * s and fmaf(q, s, a)
+   because kernels compiled with FMA enabled may contract the decode */
+static uint8_t quantize(float v, float origin, float scale, int upper) {
+    const double q = ((double)v - origin) / scale;
+    int i = upper ? (int)ceil(q) : (int)floor(q);
+    i = minimum(255, maximum(0, i));
+    if (upper) {
+        while (i < 255 && (origin + i * scale < v || fmaf((float)i, scale, origin) < v)) { i++; }
+    } else {
+        while (i > 0 && (origin + i * scale > v || fmaf((float)i, scale, origin) > v)) { i--; }
+    }
+    return (uint8_t)i;
+}
+
+/* wide node w from binary inner node i (or binary leaf i when the tree is a single leaf) */
+static void collapse(collapse_t* c, int32_t i, int w) {
+    const bvh_t* bvh = c->bvh;
+    bvh8_t* bvh8 = c->bvh8;
+    int32_t slot[BVH8_WIDTH];
+    int leaf[BVH8_WIDTH]; /* triangles when slot is (collapsed into) a leaf, 0 for inner */
+    uint32_t first[BVH8_WIDTH];
+    int n = 0;
+    if (bvh->nodes[i].count > 0) {
+        slot[n++] = i;
+    } else { // greedily open the inner child with the largest area
+        slot[n++] = i + 1;
+        slot[n++] = (int32_t)bvh->nodes[i].offset;
+        while (n < BVH8_WIDTH) {
+            int best = -1;
+            float area = -1;
+            for (int k = 0; k < n; k++) {
+                const bvh_node_t* s = &bvh->nodes[slot[k]];
+                if (s->count == 0 && node_area(s) > area &&
+                    subtree_triangles(bvh, slot[k], &first[k]) > BVH8_LEAF) {
+                    area = node_area(s);
+                    best = k;
+                }
+            }
+            if (best < 0) { break; }
+            const int32_t open = slot[best];
+            slot[best] = open + 1;
+            slot[n++] = (int32_t)bvh->nodes[open].offset;
+        }
+    }
+    for (int k = 0; k < n; k++) {
+        const int count = subtree_triangles(bvh, slot[k], &first[k]);
+        leaf[k] = count <= BVH8_LEAF || bvh->nodes[slot[k]].count > 0 ? count : 0;
+    }
+    bvh8_node_t* node = &bvh8->nodes[w];
+    memset(node, 0, sizeof(*node));
+    float min[3] = { INFINITY, INFINITY, INFINITY }, max[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int k = 0; k < n; k++) {
+        const bvh_node_t* s = &bvh->nodes[slot[k]];
+        for (int a = 0; a < 3; a++) {
+            min[a] = minimum(min[a], s->min[a]);
+            max[a] = maximum(max[a], s->max[a]);
+        }
+    }
+    float scale[3];
+    for (int a = 0; a < 3; a++) {
+        int e = -126;
+        const float extent = max[a] - min[a];
+        if (extent > 0) { frexpf(extent / 255, &e); } // 2^e * 255 >= extent
+        e = minimum(127, maximum(-126, e));
+        node->origin[a] = min[a];
+        node->exponent[a] = (int8_t)e;
+        scale[a] = grid_step(node->exponent[a]);
+    }
+    node->child = (uint32_t)bvh8->node_count;
+    node->triangle = (uint32_t)bvh8->triangle_count;
+    int inner = 0;
+    for (int k = 0; k < BVH8_WIDTH; k++) {
+        if (k >= n) {
+            for (int a = 0; a < 3; a++) { node->qmin[a][k] = 255; node->qmax[a][k] = 0; }
+            continue;
+        }
+        const bvh_node_t* s = &bvh->nodes[slot[k]];
+        for (int a = 0; a < 3; a++) {
+            node->qmin[a][k] = quantize(s->min[a], node->origin[a], scale[a], false);
+            node->qmax[a][k] = quantize(s->max[a], node->origin[a], scale[a], true);
+        }
+        if (leaf[k] == 0) {
+            node->meta[k] = BVH8_INNER;
+            node->inner |= (uint8_t)(1u << k);
+            inner++;
+        } else {
+            node->meta[k] = (uint8_t)leaf[k];
+            memcpy(bvh8->triangles + bvh8->triangle_count, bvh->triangles + first[k], sizeof(int32_t) * (size_t)leaf[k]);
+            bvh8->triangle_count += leaf[k];
+        }
+    }
+    bvh8->node_count += inner;
+    int child = (int)node->child;
+    for (int k = 0; k < n; k++) {
+        if (leaf[k] == 0) { collapse(c, slot[k], child++); }
+    }
+}
+
+bvh8_t* bvh8_create(const bvh_t* bvh) {
+    bvh8_t* bvh8 = (bvh8_t*)calloc(1, sizeof(bvh8_t));
+    if (bvh8 != null) {
+        bvh8->mesh = bvh->mesh;
+        // every wide node consumes at least one binary inner node (or the single leaf)
+        bvh8->nodes = (bvh8_node_t*)malloc(sizeof(bvh8_node_t) * (size_t)maximum(1, bvh->node_count / 2 + 1));
+        bvh8->triangles = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, bvh->triangle_count));
+    }
+    if (bvh8 == null || bvh8->nodes == null || bvh8->triangles == null) {
+        bvh8_destroy(bvh8);
+        return null;
+    }
+    if (bvh->node_count > 0) {
+        collapse_t c = { bvh, bvh8 };
+        bvh8->node_count = 1;
+        collapse(&c, 0, 0);
+        bvh8_node_t* shrunk = (bvh8_node_t*)realloc(bvh8->nodes, sizeof(bvh8_node_t) * (size_t)bvh8->node_count);
+        if (shrunk != null) { bvh8->nodes = shrunk; }
+    }
+    return bvh8;
+}
+
+void bvh8_destroy(bvh8_t* bvh8) {
+    if (bvh8 != null) {
+        free(bvh8->nodes);
+        free(bvh8->triangles);
+        free(bvh8);
+    }
+}
+
+static int traverse(const bvh8_t* bvh8, const float orig[3], const float dir[3], float tmin, float tmax,
+                    int mode, bvh_hit_t hits[], int capacity) {
+#ifdef SIMD_X86
+    if (simd_level() >= SIMD_AVX2) { return traverse_avx2(bvh8, orig, dir, tmin, tmax, mode, hits, capacity); }
+#endif
+    return traverse_generic(bvh8, orig, dir, tmin, tmax, mode, hits, capacity);
+}
+
+int bvh8_closest_hit(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                     float tmin, float tmax, bvh_hit_t* hit) {
+    hit->triangle = -1;
+    hit->t = tmax;
+    return traverse(bvh8, orig, dir, tmin, tmax, CLOSEST, hit, 1);
+}
+
+int bvh8_any_hit(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                 float tmin, float tmax) {
+    return traverse(bvh8, orig, dir, tmin, tmax, ANY, null, 0);
+}
+
+int bvh8_all_hits(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                  float tmin, float tmax, bvh_hit_t hits[], int capacity) {
+    return bvh_sort_hits(hits, capacity, traverse(bvh8, orig, dir, tmin, tmax, ALL, hits, capacity));
+}
+
+END_C
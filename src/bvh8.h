@@ -0,0 +1,51 @@
+#pragma once
+#include "bvh.h"
+
+/* compressed 8-wide BVH for ray queries, about a third of bvh_t memory.
+   Nodes are collapsed from a binary bvh_t, child bounds are quantized to
+   8 bits per plane on a power of two grid anchored at the node origin and
+   always rounded outwards, so the decoded boxes are conservative.
+   Child slots of a node are tested together with SIMD, leaves call
+   intersect_triangle() exactly like bvh_t queries do.
+   Ylitie, Karras, Laine. Efficient Incoherent Ray Traversal on GPUs Through
+   Compressed Wide BVHs. High Performance Graphics, 2017. */
+
+BEGIN_C
+
+enum {
+    BVH8_WIDTH = 8,
+    BVH8_LEAF  = 4,   /* binary subtrees of that many triangles are collapsed into leaves */
+    BVH8_INNER = 0x80 /* bvh8_node_t.meta of inner child, leaf: number of triangles, empty slot: 0 */
+};
+
+typedef struct bvh8_node_s { /* 80 bytes */
+    float origin[3];      /* grid origin, minimum of node bounds */
+    int8_t exponent[3];   /* grid step is 2^exponent along each axis */
+    uint8_t inner;        /* bit per inner child slot */
+    uint32_t child;       /* index of first inner child, inner children are contiguous in slot order */
+    uint32_t triangle;    /* first triangle reference of leaf children, contiguous in slot order */
+    uint8_t meta[BVH8_WIDTH];
+    uint8_t qmin[3][BVH8_WIDTH];
+    uint8_t qmax[3][BVH8_WIDTH];
+} bvh8_node_t;
+
+typedef struct bvh8_s {
+    mesh_t mesh;         /* not owned, vertices and indices must outlive bvh8 */
+    bvh8_node_t* nodes;  /* nodes[0] is the root */
+    int32_t* triangles;  /* leaf triangle references into mesh */
+    int node_count;
+    int triangle_count;
+} bvh8_t;
+
+bvh8_t* bvh8_create(const bvh_t* bvh); /* returns null on out of memory, bvh may be destroyed afterwards */
+void bvh8_destroy(bvh8_t* bvh8);
+
+/* same semantics as bvh_closest_hit(), bvh_any_hit() and bvh_all_hits() */
+int bvh8_closest_hit(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                     float tmin, float tmax, bvh_hit_t* hit);
+int bvh8_any_hit(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                 float tmin, float tmax);
+int bvh8_all_hits(const bvh8_t* bvh8, const float orig[3], const float dir[3],
+                  float tmin, float tmax, bvh_hit_t hits[], int capacity);
+
+END_C
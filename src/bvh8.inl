@@ -0,0 +1,106 @@
+/* traversal of bvh8.c included once per instruction set with:
+       ISA     name suffix
+       W       lanes, 4 or 8: child slots are tested in 8 / W passes
+       VF, VI  float and int32 vector types of W lanes
+       VU      uint8_t vector type of W lanes
+       TARGET  function attribute (may be empty) */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline VF FN(decode)(const uint8_t q[W], float scale, float origin) {
+    VU b;
+    memcpy(&b, q, sizeof(b));
+    return __builtin_convertvector(__builtin_convertvector(b, VI), VF) * FN(splat)(scale) + FN(splat)(origin);
+}
+
+/* returns bit mask of child slots hit within [tmin..tfar], entry distances in tnear[] */
+static TARGET inline int FN(children)(const bvh8_node_t* n, const ray8_t* r, float tmin, float tfar, float tnear[8]) {
+    int mask = 0;
+    for (int s = 0; s < BVH8_WIDTH; s += W) {
+        VF tn = FN(splat)(tmin), tf = FN(splat)(tfar);
+        for (int a = 0; a < 3; a++) {
+            const float scale = grid_step(n->exponent[a]);
+            const VF o = FN(splat)(r->orig[a]), inv = FN(splat)(r->inv[a]);
+            const VF t0 = (FN(decode)((r->negative[a] ? n->qmax[a] : n->qmin[a]) + s, scale, n->origin[a]) - o) * inv;
+            const VF t1 = (FN(decode)((r->negative[a] ? n->qmin[a] : n->qmax[a]) + s, scale, n->origin[a]) - o) * inv;
+            tn = FN(select)(t0 > tn, t0, tn); // NaN from 0 * inf keeps the interval as is
+            tf = FN(select)(t1 < tf, t1, tf);
+        }
+        const VI hit = tn <= tf;
+        for (int i = 0; i < W; i++) { mask |= (hit[i] != 0 && n->meta[s + i] != 0) << (s + i); }
+        memcpy(tnear + s, &tn, sizeof(tn));
+    }
+    return mask;
+}
+
+static TARGET int FN(traverse)(const bvh8_t* bvh8, const float orig[3], const float dir[3], float tmin, float tmax,
+                               int mode, bvh_hit_t hits[], int capacity) {
+    if (bvh8->node_count == 0) { return 0; }
+    ray8_t r;
+    ray8_init(&r, orig, dir);
+    entry_t stack[BVH8_STACK];
+    int sp = 0;
+    int found = 0;
+    float tfar = tmax;
+    stack[sp++] = (entry_t){ 0, 0, tmin };
+    while (sp > 0) {
+        const entry_t e = stack[--sp];
+        if (e.t > tfar) { continue; }
+        if (e.count == 0) {
+            const bvh8_node_t* n = &bvh8->nodes[e.index];
+            float tnear[8];
+            int mask = FN(children)(n, &r, tmin, tfar, tnear);
+            const int base = sp;
+            uint64_t meta;
+            memcpy(&meta, n->meta, sizeof(meta));
+            // bytes of leaf triangle counts (inner 0x80 masked out), byte k of prefix is sum of bytes [0..k)
+            const uint64_t prefix = ((meta & 0x7F7F7F7F7F7F7F7FULL) << 8) * 0x0101010101010101ULL;
+            while (mask != 0) { // insertion sort, far first, nearest ends on top of the stack
+                const int k = __builtin_ctz((unsigned)mask);
+                mask &= mask - 1;
+                entry_t c;
+                if (n->meta[k] == BVH8_INNER) {
+                    c.index = n->child + (uint32_t)__builtin_popcount(n->inner & ((1u << k) - 1));
+                    c.count = 0;
+                } else {
+                    c.index = n->triangle + (uint32_t)((prefix >> (8 * k)) & 0xFF);
+                    c.count = n->meta[k];
+                }
+                c.t = tnear[k];
+                int j = sp++;
+                while (j > base && stack[j - 1].t < c.t) { stack[j] = stack[j - 1]; j--; }
+                stack[j] = c;
+            }
+        } else {
+            for (uint32_t k = e.index; k < e.index + e.count; k++) {
+                bvh_hit_t h;
+                if (bvh_triangle_hit(&bvh8->mesh, bvh8->triangles[k], r.o, r.d, tmin, tfar, mode, &h)) {
+                    if (mode == ANY) { return 1; }
+                    if (mode == CLOSEST) {
+                        hits[0] = h;
+                        tfar = h.t;
+                        found = 1;
+                    } else {
+                        bvh_keep_nearest(hits, capacity, found, &h);
+                        found++;
+                    }
+                }
+            }
+        }
+    }
+    return found;
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
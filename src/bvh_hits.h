@@ -0,0 +1,57 @@
+#pragma once
+#include "bvh.h"
+#include "../ext/intersect_triangle.h"
+
+/* leaf tests and hit lists of the ray queries, shared by bvh.c and bvh8.c */
+
+BEGIN_C
+
+enum { CLOSEST = 0, ANY = 1, ALL = 2 };
+
+/* any hit (shadow ray) mode skips t, u, v computation */
+static inline int bvh_triangle_hit(const mesh_t* mesh, int32_t triangle, const double orig[3], const double dir[3],
+                                   float tmin, float tmax, int mode, bvh_hit_t* hit) {
+    const float* v[3];
+    mesh_triangle(mesh, triangle, v);
+    double v0[3] = { v[0][0], v[0][1], v[0][2] };
+    double v1[3] = { v[1][0], v[1][1], v[1][2] };
+    double v2[3] = { v[2][0], v[2][1], v[2][2] };
+    double o[3] = { orig[0], orig[1], orig[2] };
+    double d[3] = { dir[0], dir[1], dir[2] };
+    if (mode == ANY) { return intersect_triangle_occluded(o, d, v0, v1, v2, tmin, tmax); }
+    double t, u, w;
+    if (intersect_triangle(o, d, v0, v1, v2, &t, &u, &w) && tmin <= t && t <= tmax) {
+        hit->t = (float)t;
+        hit->u = (float)u;
+        hit->v = (float)w;
+        hit->triangle = triangle;
+        return 1;
+    }
+    return 0;
+}
+
+/* hit number found of an all hits query: hits[] keeps the capacity
+   nearest ones (unsorted), the farthest is replaced once it is full */
+static inline void bvh_keep_nearest(bvh_hit_t hits[], int capacity, int found, const bvh_hit_t* h) {
+    if (found < capacity) {
+        hits[found] = *h;
+    } else if (capacity > 0) {
+        int far = 0;
+        for (int i = 1; i < capacity; i++) { far = hits[i].t > hits[far].t ? i : far; }
+        if (h->t < hits[far].t) { hits[far] = *h; }
+    }
+}
+
+/* orders the kept hits of an all hits query by t, returns found */
+static inline int bvh_sort_hits(bvh_hit_t hits[], int capacity, int found) {
+    const int n = minimum(found, capacity);
+    for (int i = 1; i < n; i++) { // insertion sort, hit lists are short
+        bvh_hit_t h = hits[i];
+        int j = i - 1;
+        while (j >= 0 && hits[j].t > h.t) { hits[j + 1] = hits[j]; j--; }
+        hits[j + 1] = h;
+    }
+    return found;
+}
+
+END_C
@@ -0,0 +1,290 @@
+#include "collide.h"
+#include "threads.h"
+#include "../ext/intersections/intersections.h"
+
+BEGIN_C
+
+/* Simultaneous descent of two hierarchies (Gottschalk, Lin, Manocha.
+   OBBTree: A Hierarchical Structure for Rapid Interference Detection.
+   SIGGRAPH 1996), with axis aligned boxes: of a pair of overlapping inner
+   nodes the larger one is split. Self intersection descends a hierarchy
+   against itself: a node paired with itself splits into pairs of both
+   children with themselves and with each other, so every pair of triangles
+   is reached once.
+   Overlapping node pairs are expanded breadth first until there are at least
+   FRONTIER of them, frontier pairs are descended depth first in parallel,
+   each into its own output. Outputs are concatenated in frontier order:
+   the result depends on the trees only, not on the number of threads. */
+
+typedef struct node_pair_s {
+    int32_t a;
+    int32_t b;
+} node_pair_t;
+
+typedef struct output_s {
+    collide_pair_t* pairs;
+    vec3f_t (*segments)[2];
+    int count;
+    int capacity;
+} output_t;
+
+typedef struct collider_s {
+    const bvh_t* a;
+    const bvh_t* b;
+    int flags;
+    int self; /* a == b, pairs of triangles sharing a vertex are skipped */
+    const node_pair_t* frontier;
+    output_t* outputs; /* one per frontier pair */
+    atomic_int oom;
+} collider_t;
+
+typedef struct leaf_triangle_s {
+    float v[3][3];
+    float min[3];
+    float max[3];
+} leaf_triangle_t;
+
+enum {
+    FRONTIER = 1024, /* node pairs distributed among threads */
+    PAIR_STACK = 4 * BVH_STACK + 1 /* every split pushes at most 3 pairs one or two levels deeper */
+};
+
+static inline int boxes_overlap(const float amin[3], const float amax[3], const float bmin[3], const float bmax[3]) {
+    return amin[0] <= bmax[0] && bmin[0] <= amax[0] &&
+           amin[1] <= bmax[1] && bmin[1] <= amax[1] &&
+           amin[2] <= bmax[2] && bmin[2] <= amax[2];
+}
+
+static inline int nodes_overlap(const bvh_node_t* a, const bvh_node_t* b) {
+    return boxes_overlap(a->min, a->max, b->min, b->max);
+}
+
+static inline float node_area(const bvh_node_t* n) {
+    const float dx = n->max[0] - n->min[0], dy = n->max[1] - n->min[1], dz = n->max[2] - n->min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+/* children of a pair of overlapping nodes that still overlap, -1 for a pair of leaves */
+static int split(const collider_t* c, node_pair_t p, node_pair_t children[3]) {
+    const bvh_node_t* na = &c->a->nodes[p.a];
+    const bvh_node_t* nb = &c->b->nodes[p.b];
+    if (na->count > 0 && nb->count > 0) { return -1; }
+    if (p.a == p.b && c->self) {
+        const int32_t first = p.a + 1, second = (int32_t)na->offset;
+        children[0].a = children[0].b = first;
+        children[1].a = children[1].b = second;
+        children[2].a = first;
+        children[2].b = second;
+        return nodes_overlap(&c->a->nodes[first], &c->a->nodes[second]) ? 3 : 2;
+    }
+    const int split_a = nb->count > 0 || (na->count == 0 && node_area(na) >= node_area(nb));
+    int n = 0;
+    if (split_a) {
+        const int32_t kids[2] = { p.a + 1, (int32_t)na->offset };
+        for (int i = 0; i < 2; i++) {
+            if (nodes_overlap(&c->a->nodes[kids[i]], nb)) { children[n].a = kids[i]; children[n].b = p.b; n++; }
+        }
+    } else {
+        const int32_t kids[2] = { p.b + 1, (int32_t)nb->offset };
+        for (int i = 0; i < 2; i++) {
+            if (nodes_overlap(na, &c->b->nodes[kids[i]])) { children[n].a = p.a; children[n].b = kids[i]; n++; }
+        }
+    }
+    return n;
+}
+
+static int output_grow(collider_t* c, output_t* o) {
+    const int capacity = o->capacity == 0 ? 64 : o->capacity * 2;
+    collide_pair_t* pairs = (collide_pair_t*)realloc(o->pairs, sizeof(collide_pair_t) * (size_t)capacity);
+    if (pairs != null) { o->pairs = pairs; }
+    int ok = pairs != null;
+    if (ok && (c->flags & COLLIDE_SEGMENTS)) {
+        vec3f_t (*segments)[2] = (vec3f_t(*)[2])realloc(o->segments, sizeof(vec3f_t) * 2 * (size_t)capacity);
+        if (segments != null) { o->segments = segments; }
+        ok = segments != null;
+    }
+    if (ok) {
+        o->capacity = capacity;
+    } else {
+        atomic_store(&c->oom, 1);
+    }
+    return ok;
+}
+
+static void leaf_triangle(const bvh_t* bvh, int32_t triangle, leaf_triangle_t* t) {
+    const float* v[3];
+    mesh_triangle(&bvh->mesh, triangle, v);
+    for (int k = 0; k < 3; k++) {
+        t->min[k] = minimum(v[0][k], minimum(v[1][k], v[2][k]));
+        t->max[k] = maximum(v[0][k], maximum(v[1][k], v[2][k]));
+        for (int i = 0; i < 3; i++) { t->v[i][k] = v[i][k]; }
+    }
+}
+
+/* neighbors touch along the shared edge or at the shared vertex, compared
+   by position so that unwelded meshes (split normals, uv seams) work too */
+static int adjacent(const leaf_triangle_t* a, const leaf_triangle_t* b) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (a->v[i][0] == b->v[j][0] && a->v[i][1] == b->v[j][1] && a->v[i][2] == b->v[j][2]) { return true; }
+        }
+    }
+    return false;
+}
+
+/* tri_tri_intersect_line() rejects some of the pairs no_div_tri_tri_intersect()
+   or robust_tri_tri_intersect() accept (near touching, nearly coplanar), the
+   latter decide for both queries to return the same pairs, the former only
+   computes the segment */
+static void segment(leaf_triangle_t* a, leaf_triangle_t* b, vec3f_t s[2]) {
+    int coplanar = 0;
+    if (!tri_tri_intersect_line(a->v[0], a->v[1], a->v[2], b->v[0], b->v[1], b->v[2], &coplanar, s[0], s[1]) || coplanar) {
+        for (int k = 0; k < 3; k++) { s[0][k] = NAN; s[1][k] = NAN; }
+    }
+}
+
+static void leaves(collider_t* c, output_t* o, node_pair_t p) {
+    const bvh_node_t* na = &c->a->nodes[p.a];
+    const bvh_node_t* nb = &c->b->nodes[p.b];
+    const int same = p.a == p.b && c->self; // only pairs j > i
+    leaf_triangle_t tb[BVH_MAX_LEAF];
+    assert(nb->count <= BVH_MAX_LEAF);
+    for (int j = 0; j < nb->count; j++) { leaf_triangle(c->b, c->b->triangles[nb->offset + j], &tb[j]); }
+    for (int i = 0; i < na->count; i++) {
+        const int32_t ta_index = c->a->triangles[na->offset + i];
+        leaf_triangle_t ta;
+        leaf_triangle(c->a, ta_index, &ta);
+        if (!boxes_overlap(ta.min, ta.max, nb->min, nb->max)) { continue; }
+        for (int j = same ? i + 1 : 0; j < nb->count; j++) {
+            if (!boxes_overlap(ta.min, ta.max, tb[j].min, tb[j].max)) { continue; }
+            if (c->self && adjacent(&ta, &tb[j])) { continue; }
+            const int hit = (c->flags & COLLIDE_EPSILON) ?
+                no_div_tri_tri_intersect(ta.v[0], ta.v[1], ta.v[2], tb[j].v[0], tb[j].v[1], tb[j].v[2]) :
+                robust_tri_tri_intersect(ta.v[0], ta.v[1], ta.v[2], tb[j].v[0], tb[j].v[1], tb[j].v[2]);
+            if (hit && (o->count < o->capacity || output_grow(c, o))) {
+                const int32_t tb_index = c->b->triangles[nb->offset + j];
+                o->pairs[o->count].a = c->self ? minimum(ta_index, tb_index) : ta_index;
+                o->pairs[o->count].b = c->self ? maximum(ta_index, tb_index) : tb_index;
+                if (c->flags & COLLIDE_SEGMENTS) { segment(&ta, &tb[j], o->segments[o->count]); }
+                o->count++;
+            }
+        }
+    }
+}
+
+static void descend(void* that, int from, int to) {
+    collider_t* c = (collider_t*)that;
+    for (int k = from; k < to && !atomic_load(&c->oom); k++) {
+        output_t* o = &c->outputs[k];
+        node_pair_t stack[PAIR_STACK];
+        int top = 0;
+        stack[top++] = c->frontier[k];
+        while (top > 0) {
+            const node_pair_t p = stack[--top];
+            node_pair_t children[3];
+            const int n = split(c, p, children);
+            if (n < 0) {
+                leaves(c, o, p);
+            } else {
+                assert(top + n <= PAIR_STACK);
+                for (int i = n - 1; i >= 0; i--) { stack[top++] = children[i]; } // first child on top
+            }
+        }
+    }
+}
+
+/* breadth first expansion to at least FRONTIER node pairs (or all leaf pairs) */
+static node_pair_t* expand(const collider_t* c, int* count) {
+    node_pair_t* pairs = (node_pair_t*)malloc(sizeof(node_pair_t));
+    if (pairs == null) { return null; }
+    int n = 0;
+    if (nodes_overlap(&c->a->nodes[0], &c->b->nodes[0])) { pairs[n].a = 0; pairs[n].b = 0; n++; }
+    int inner = n;
+    while (n > 0 && n < FRONTIER && inner > 0) {
+        node_pair_t* next = (node_pair_t*)malloc(sizeof(node_pair_t) * 3 * (size_t)n);
+        if (next == null) { free(pairs); return null; }
+        int m = 0;
+        inner = 0;
+        for (int i = 0; i < n; i++) {
+            const int k = split(c, pairs[i], next + m);
+            if (k < 0) {
+                next[m++] = pairs[i];
+            } else {
+                m += k;
+                inner++;
+            }
+        }
+        free(pairs);
+        pairs = next;
+        n = m;
+    }
+    *count = n;
+    return pairs;
+}
+
+static collide_t* gather(collider_t* c, int count) {
+    int total = 0;
+    for (int k = 0; k < count; k++) { total += c->outputs[k].count; }
+    collide_t* r = (collide_t*)calloc(1, sizeof(collide_t));
+    if (r == null) { return null; }
+    r->pairs = (collide_pair_t*)malloc(sizeof(collide_pair_t) * (size_t)maximum(1, total));
+    if (c->flags & COLLIDE_SEGMENTS) {
+        r->segments = (vec3f_t(*)[2])malloc(sizeof(vec3f_t) * 2 * (size_t)maximum(1, total));
+    }
+    if (r->pairs == null || ((c->flags & COLLIDE_SEGMENTS) && r->segments == null)) {
+        collide_destroy(r);
+        return null;
+    }
+    for (int k = 0; k < count; k++) {
+        const output_t* o = &c->outputs[k];
+        if (o->count > 0) {
+            memcpy(r->pairs + r->count, o->pairs, sizeof(collide_pair_t) * (size_t)o->count);
+            if (r->segments != null) {
+                memcpy(r->segments + r->count, o->segments, sizeof(vec3f_t) * 2 * (size_t)o->count);
+            }
+            r->count += o->count;
+        }
+    }
+    return r;
+}
+
+static collide_t* collide(const bvh_t* a, const bvh_t* b, int flags, int self) {
+    collider_t c = { a, b, flags, self, null, null };
+    atomic_init(&c.oom, 0);
+    if (a->node_count == 0 || b->node_count == 0) { return (collide_t*)calloc(1, sizeof(collide_t)); }
+    int count = 0;
+    node_pair_t* frontier = expand(&c, &count);
+    output_t* outputs = frontier != null ? (output_t*)calloc((size_t)maximum(1, count), sizeof(output_t)) : null;
+    collide_t* r = null;
+    if (outputs != null) {
+        c.frontier = frontier;
+        c.outputs = outputs;
+        parallel_for(0, count, 1, &c, descend);
+        if (!atomic_load(&c.oom)) { r = gather(&c, count); }
+        for (int k = 0; k < count; k++) {
+            free(outputs[k].pairs);
+            free(outputs[k].segments);
+        }
+    }
+    free(outputs);
+    free(frontier);
+    return r;
+}
+
+collide_t* collide_meshes(const bvh_t* a, const bvh_t* b, int flags) {
+    return collide(a, b, flags, false);
+}
+
+collide_t* collide_self(const bvh_t* bvh, int flags) {
+    return collide(bvh, bvh, flags, true);
+}
+
+void collide_destroy(collide_t* c) {
+    if (c != null) {
+        free(c->pairs);
+        free(c->segments);
+        free(c);
+    }
+}
+
+END_C
@@ -0,0 +1,610 @@
+#include "distance.h"
+#include "simd.h"
+#include "threads.h"
+
+BEGIN_C
+
+/* Point/triangle: projection onto the plane when it falls inside (all
+   barycentric numerators >= 0), otherwise the nearest of the three edges.
+   Triangle/triangle: the minimum over vertices against the other triangle
+   (both ways), the 9 edge pairs and edges piercing the other triangle,
+   which is 0 at the piercing point: disjoint triangles have their closest
+   pair among the first two kinds, intersecting ones have an edge through
+   the other triangle (or, coplanar, crossing edges or a vertex inside).
+   bvh_closest_point() keeps a stack of (node, squared box distance), the
+   nearer child is descended first and popped nodes farther than the best
+   triangle so far are dropped. Leaves are gathered into structure of arrays
+   and tested LANES at a time.
+   bvh_mesh_distance() descends both hierarchies together splitting the
+   larger node (as collide.c does) with the same pruning on box to box
+   distance. The triangle of a nearest to a vertex of b seeds the result and
+   the bound, node pairs within it are expanded breadth first to at least
+   FRONTIER and sorted by box distance, frontier pairs are descended in
+   parallel and share the best distance found so far through an atomic
+   (non negative floats order as their bits). */
+
+enum {
+    LANES = 8,                  /* widest kernel, BVH_MAX_LEAF triangles in one call */
+    POINT_GRAIN = 256,          /* points per parallel_for chunk */
+    FRONTIER = 1024,            /* node pairs distributed among threads */
+    PAIR_STACK = 2 * BVH_STACK + 2
+};
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "distance.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "distance.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+#endif
+
+typedef struct kernels_s {
+    int w;
+    void (*points)(const float p[3], const float* const v[9], float* d2, float* const c[3]);
+    void (*triangles)(const float t[3][3], const float* const v[9], float* d2, float* const a[3], float* const b[3]);
+} kernels_t;
+
+static kernels_t kernels(void) {
+#ifdef SIMD_X86
+    if (simd_level() >= SIMD_AVX2) { return (kernels_t){ 8, point_triangles_avx2, triangle_triangles_avx2 }; }
+#endif
+    return (kernels_t){ 4, point_triangles_generic, triangle_triangles_generic };
+}
+
+static inline float dot(const float a[3], const float b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static inline void sub(const float a[3], const float b[3], float r[3]) {
+    r[0] = a[0] - b[0];
+    r[1] = a[1] - b[1];
+    r[2] = a[2] - b[2];
+}
+
+static inline float clamp01(float x) { return x < 0 ? 0 : (x > 1 ? 1 : x); }
+
+static inline float distance2(const float a[3], const float b[3]) {
+    float d[3];
+    sub(a, b, d);
+    return dot(d, d);
+}
+
+static int inside(const float p[3], const float a[3], const float b[3], const float c[3], float* v, float* w) {
+    float ab[3], ac[3], ap[3], bp[3], cp[3];
+    sub(b, a, ab);
+    sub(c, a, ac);
+    sub(p, a, ap);
+    sub(p, b, bp);
+    sub(p, c, cp);
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    const float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+    const float sum = va + vb + vc;
+    if (va < 0 || vb < 0 || vc < 0 || !(sum > 0)) { return false; }
+    *v = vb / sum;
+    *w = vc / sum;
+    return true;
+}
+
+static float point_segment(const float p[3], const float a[3], const float b[3], float c[3]) {
+    float ab[3], ap[3];
+    sub(b, a, ab);
+    sub(p, a, ap);
+    const float l2 = dot(ab, ab);
+    const float t = l2 > 0 ? clamp01(dot(ap, ab) / l2) : 0;
+    for (int k = 0; k < 3; k++) { c[k] = a[k] + ab[k] * t; }
+    return distance2(p, c);
+}
+
+float point_triangle_distance2(const float p[3], const float v0[3], const float v1[3], const float v2[3],
+                               float c[3]) {
+    float q[3], v, w;
+    if (inside(p, v0, v1, v2, &v, &w)) {
+        for (int k = 0; k < 3; k++) { q[k] = v0[k] + (v1[k] - v0[k]) * v + (v2[k] - v0[k]) * w; }
+    } else {
+        float best = point_segment(p, v0, v1, q), e[3];
+        const float* ends[2][2] = { { v1, v2 }, { v2, v0 } };
+        for (int i = 0; i < 2; i++) {
+            const float d2 = point_segment(p, ends[i][0], ends[i][1], e);
+            if (d2 < best) { best = d2; memcpy(q, e, sizeof(q)); }
+        }
+    }
+    if (c != null) { memcpy(c, q, sizeof(q)); }
+    return distance2(p, q);
+}
+
+static float segment_segment(const float p1[3], const float q1[3], const float p2[3], const float q2[3],
+                             float c1[3], float c2[3]) {
+    float d1[3], d2[3], r[3];
+    sub(q1, p1, d1);
+    sub(q2, p2, d2);
+    sub(p1, p2, r);
+    const float a = dot(d1, d1), e = dot(d2, d2), f = dot(d2, r);
+    float s = 0, t = 0;
+    if (a > 0 && e > 0) {
+        const float c = dot(d1, r), b = dot(d1, d2);
+        const float denom = a * e - b * b;
+        s = denom > 0 ? clamp01((b * f - c * e) / denom) : 0;
+        t = (b * s + f) / e;
+        if (t < 0) {
+            t = 0;
+            s = clamp01(-c / a);
+        } else if (t > 1) {
+            t = 1;
+            s = clamp01((b - c) / a);
+        }
+    } else if (a > 0) {
+        s = clamp01(-dot(d1, r) / a);
+    } else if (e > 0) {
+        t = clamp01(f / e);
+    }
+    for (int k = 0; k < 3; k++) {
+        c1[k] = p1[k] + d1[k] * s;
+        c2[k] = p2[k] + d2[k] * t;
+    }
+    return distance2(c1, c2);
+}
+
+/* edge pq through the interior of triangle abc with normal n */
+static int pierce(const float p[3], const float q[3], const float* const t[3], const float n[3], float x[3]) {
+    float ap[3], aq[3];
+    sub(p, t[0], ap);
+    sub(q, t[0], aq);
+    const float dp = dot(n, ap), dq = dot(n, aq);
+    if ((dp > 0 && dq > 0) || (dp < 0 && dq < 0) || dp == dq) { return false; }
+    const float s = dp / (dp - dq);
+    for (int k = 0; k < 3; k++) { x[k] = p[k] + (q[k] - p[k]) * s; }
+    float v, w;
+    return inside(x, t[0], t[1], t[2], &v, &w);
+}
+
+static void normal(const float* const t[3], float n[3]) {
+    float u[3], v[3];
+    sub(t[1], t[0], u);
+    sub(t[2], t[0], v);
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+float triangle_triangle_distance2(const float t[3][3], const float u[3][3], float a[3], float b[3]) {
+    const float* T[3] = { t[0], t[1], t[2] };
+    const float* U[3] = { u[0], u[1], u[2] };
+    float best = INFINITY, ba[3], bb[3], x[3], y[3];
+    memcpy(ba, t[0], sizeof(ba));
+    memcpy(bb, u[0], sizeof(bb));
+    for (int i = 0; i < 3; i++) {
+        float d2 = point_triangle_distance2(T[i], U[0], U[1], U[2], y);
+        if (d2 < best) { best = d2; memcpy(ba, T[i], sizeof(ba)); memcpy(bb, y, sizeof(bb)); }
+        d2 = point_triangle_distance2(U[i], T[0], T[1], T[2], x);
+        if (d2 < best) { best = d2; memcpy(ba, x, sizeof(ba)); memcpy(bb, U[i], sizeof(bb)); }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            const float d2 = segment_segment(T[i], T[(i + 1) % 3], U[j], U[(j + 1) % 3], x, y);
+            if (d2 < best) { best = d2; memcpy(ba, x, sizeof(ba)); memcpy(bb, y, sizeof(bb)); }
+        }
+    }
+    float nt[3], nu[3];
+    normal(T, nt);
+    normal(U, nu);
+    for (int i = 0; i < 3 && best > 0; i++) {
+        if (pierce(T[i], T[(i + 1) % 3], U, nu, x) || pierce(U[i], U[(i + 1) % 3], T, nt, x)) {
+            best = 0;
+            memcpy(ba, x, sizeof(ba));
+            memcpy(bb, x, sizeof(bb));
+        }
+    }
+    if (a != null) { memcpy(a, ba, sizeof(ba)); }
+    if (b != null) { memcpy(b, bb, sizeof(bb)); }
+    return best;
+}
+
+/* n lanes of v in steps of k.w, tail through zero padded copies */
+void point_triangles_distance2(const float p[3], const float* const v[9], int n,
+                               float d2[], float* const c[3]) {
+    const kernels_t k = kernels();
+    for (int i = 0; i < n; i += k.w) {
+        const int lanes = minimum(k.w, n - i);
+        float pad[9][LANES] = {0}, d[LANES], q[3][LANES];
+        const float* vp[9];
+        for (int j = 0; j < 9; j++) {
+            memcpy(pad[j], v[j] + i, sizeof(float) * (size_t)lanes);
+            vp[j] = pad[j];
+        }
+        float* const cp[3] = { q[0], q[1], q[2] };
+        k.points(p, vp, d, cp);
+        memcpy(d2 + i, d, sizeof(float) * (size_t)lanes);
+        for (int j = 0; j < 3 && c != null; j++) {
+            if (c[j] != null) { memcpy(c[j] + i, q[j], sizeof(float) * (size_t)lanes); }
+        }
+    }
+}
+
+void triangle_triangles_distance2(const float t[3][3], const float* const v[9], int n,
+                                  float d2[], float* const a[3], float* const b[3]) {
+    const kernels_t k = kernels();
+    for (int i = 0; i < n; i += k.w) {
+        const int lanes = minimum(k.w, n - i);
+        float pad[9][LANES] = {0}, d[LANES], qa[3][LANES], qb[3][LANES];
+        const float* vp[9];
+        for (int j = 0; j < 9; j++) {
+            memcpy(pad[j], v[j] + i, sizeof(float) * (size_t)lanes);
+            vp[j] = pad[j];
+        }
+        float* const ap[3] = { qa[0], qa[1], qa[2] };
+        float* const bp[3] = { qb[0], qb[1], qb[2] };
+        k.triangles(t, vp, d, ap, bp);
+        memcpy(d2 + i, d, sizeof(float) * (size_t)lanes);
+        for (int j = 0; j < 3; j++) {
+            if (a != null && a[j] != null) { memcpy(a[j] + i, qa[j], sizeof(float) * (size_t)lanes); }
+            if (b != null && b[j] != null) { memcpy(b[j] + i, qb[j], sizeof(float) * (size_t)lanes); }
+        }
+    }
+}
+
+typedef struct leaf_s { /* triangles of a leaf as structure of arrays, zero padded to LANES */
+    float v[9][LANES];
+    const float* p[9];
+    int count;
+} leaf_t;
+
+static void leaf_gather(const bvh_t* bvh, const bvh_node_t* n, leaf_t* l) {
+    assert(n->count <= LANES);
+    memset(l->v, 0, sizeof(l->v));
+    for (int i = 0; i < n->count; i++) {
+        const float* v[3];
+        mesh_triangle(&bvh->mesh, bvh->triangles[n->offset + i], v);
+        for (int j = 0; j < 9; j++) { l->v[j][i] = v[j / 3][j % 3]; }
+    }
+    for (int j = 0; j < 9; j++) { l->p[j] = l->v[j]; }
+    l->count = n->count;
+}
+
+static inline float box_distance2(const float min[3], const float max[3], const float p[3]) {
+    float d2 = 0;
+    for (int k = 0; k < 3; k++) {
+        const float d = maximum(0.0f, maximum(min[k] - p[k], p[k] - max[k]));
+        d2 += d * d;
+    }
+    return d2;
+}
+
+static inline float boxes_distance2(const float amin[3], const float amax[3], const float bmin[3], const float bmax[3]) {
+    float d2 = 0;
+    for (int k = 0; k < 3; k++) {
+        const float d = maximum(0.0f, maximum(amin[k] - bmax[k], bmin[k] - amax[k]));
+        d2 += d * d;
+    }
+    return d2;
+}
+
+/* strict bound: max_distance itself is within */
+static float bound2(float max_distance) {
+    const float b = max_distance * max_distance;
+    return b < INFINITY ? nextafterf(b, INFINITY) : b;
+}
+
+static int closest(const bvh_t* bvh, const kernels_t* k, const float p[3], float bound, bvh_closest_t* c) {
+    c->distance = INFINITY;
+    c->triangle = -1;
+    if (bvh->node_count == 0) { return false; }
+    uint32_t stack[BVH_STACK];
+    float near[BVH_STACK];
+    int sp = 0;
+    uint32_t i = 0;
+    if (box_distance2(bvh->nodes[0].min, bvh->nodes[0].max, p) >= bound) { return false; }
+    for (;;) {
+        const bvh_node_t* n = &bvh->nodes[i];
+        if (n->count == 0) {
+            uint32_t a = i + 1, b = n->offset;
+            float da = box_distance2(bvh->nodes[a].min, bvh->nodes[a].max, p);
+            float db = box_distance2(bvh->nodes[b].min, bvh->nodes[b].max, p);
+            if (db < da) { uint32_t s = a; a = b; b = s; float f = da; da = db; db = f; }
+            if (da < bound) {
+                if (db < bound) { near[sp] = db; stack[sp++] = b; }
+                i = a;
+                continue;
+            }
+        } else {
+            leaf_t l;
+            leaf_gather(bvh, n, &l);
+            float d2[LANES], q[3][LANES];
+            float* const qp[3] = { q[0], q[1], q[2] };
+            for (int j = 0; j < l.count; j += k->w) {
+                const float* v[9];
+                float* const qj[3] = { qp[0] + j, qp[1] + j, qp[2] + j };
+                for (int m = 0; m < 9; m++) { v[m] = l.p[m] + j; }
+                k->points(p, v, d2 + j, qj);
+            }
+            for (int j = 0; j < l.count; j++) {
+                if (d2[j] < bound) {
+                    bound = d2[j];
+                    c->triangle = bvh->triangles[n->offset + j];
+                    for (int m = 0; m < 3; m++) { c->point[m] = q[m][j]; }
+                }
+            }
+        }
+        do {
+            if (sp == 0) {
+                if (c->triangle >= 0) { c->distance = sqrtf(bound); }
+                return c->triangle >= 0;
+            }
+            sp--;
+        } while (near[sp] >= bound);
+        i = stack[sp];
+    }
+}
+
+int bvh_closest_point(const bvh_t* bvh, const float p[3], float max_distance, bvh_closest_t* c) {
+    const kernels_t k = kernels();
+    return closest(bvh, &k, p, bound2(max_distance), c);
+}
+
+typedef struct points_s {
+    const bvh_t* bvh;
+    const vec3f_t* points;
+    float bound;
+    bvh_closest_t* c;
+} points_t;
+
+static void points_body(void* that, int from, int to) {
+    const points_t* q = (const points_t*)that;
+    const kernels_t k = kernels();
+    for (int i = from; i < to; i++) { closest(q->bvh, &k, q->points[i], q->bound, &q->c[i]); }
+}
+
+void bvh_closest_points(const bvh_t* bvh, const vec3f_t* points, int n, float max_distance,
+                        bvh_closest_t* c) {
+    points_t q = { bvh, points, bound2(max_distance), c };
+    parallel_for(0, n, POINT_GRAIN, &q, points_body);
+}
+
+typedef struct node_pair_s {
+    int32_t a;
+    int32_t b;
+    float d2; /* box to box */
+} node_pair_t;
+
+typedef struct result_s {
+    float d2;
+    int32_t ta;
+    int32_t tb;
+    float a[3];
+    float b[3];
+} result_t;
+
+typedef struct measure_s {
+    const bvh_t* a;
+    const bvh_t* b;
+    const node_pair_t* frontier;
+    result_t* results; /* one per frontier pair */
+    atomic_int bound;  /* bits of best squared distance so far */
+} measure_t;
+
+static inline float shared_bound(measure_t* m) {
+    const int bits = atomic_load_explicit(&m->bound, memory_order_relaxed);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static void lower_bound(measure_t* m, float d2) {
+    int bits;
+    memcpy(&bits, &d2, sizeof(bits));
+    int old = atomic_load_explicit(&m->bound, memory_order_relaxed);
+    while (bits < old && !atomic_compare_exchange_weak(&m->bound, &old, bits)) { }
+}
+
+static inline float node_area(const bvh_node_t* n) {
+    const float dx = n->max[0] - n->min[0], dy = n->max[1] - n->min[1], dz = n->max[2] - n->min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static inline node_pair_t node_pair(const measure_t* m, int32_t a, int32_t b) {
+    const bvh_node_t* na = &m->a->nodes[a];
+    const bvh_node_t* nb = &m->b->nodes[b];
+    return (node_pair_t){ a, b, boxes_distance2(na->min, na->max, nb->min, nb->max) };
+}
+
+/* two children of the larger node, nearer first, -1 for a pair of leaves */
+static int split(const measure_t* m, node_pair_t p, node_pair_t children[2]) {
+    const bvh_node_t* na = &m->a->nodes[p.a];
+    const bvh_node_t* nb = &m->b->nodes[p.b];
+    if (na->count > 0 && nb->count > 0) { return -1; }
+    if (nb->count > 0 || (na->count == 0 && node_area(na) >= node_area(nb))) {
+        children[0] = node_pair(m, p.a + 1, p.b);
+        children[1] = node_pair(m, (int32_t)na->offset, p.b);
+    } else {
+        children[0] = node_pair(m, p.a, p.b + 1);
+        children[1] = node_pair(m, p.a, (int32_t)nb->offset);
+    }
+    if (children[1].d2 < children[0].d2) {
+        const node_pair_t s = children[0]; children[0] = children[1]; children[1] = s;
+    }
+    return 2;
+}
+
+static void leaves(measure_t* m, const kernels_t* k, node_pair_t p, result_t* r) {
+    const bvh_node_t* na = &m->a->nodes[p.a];
+    const bvh_node_t* nb = &m->b->nodes[p.b];
+    leaf_t l;
+    leaf_gather(m->b, nb, &l);
+    for (int i = 0; i < na->count; i++) {
+        const int32_t ta = m->a->triangles[na->offset + i];
+        const float* v[3];
+        mesh_triangle(&m->a->mesh, ta, v);
+        float t[3][3], lo[3], hi[3];
+        for (int j = 0; j < 3; j++) {
+            memcpy(t[j], v[j], sizeof(t[j]));
+            lo[j] = minimum(v[0][j], minimum(v[1][j], v[2][j]));
+            hi[j] = maximum(v[0][j], maximum(v[1][j], v[2][j]));
+        }
+        const float bound = minimum(r->d2, shared_bound(m));
+        if (boxes_distance2(lo, hi, nb->min, nb->max) >= bound) { continue; }
+        float d2[LANES], qa[3][LANES], qb[3][LANES];
+        for (int j = 0; j < l.count; j += k->w) {
+            const float* u[9];
+            for (int c = 0; c < 9; c++) { u[c] = l.p[c] + j; }
+            float* const pa[3] = { qa[0] + j, qa[1] + j, qa[2] + j };
+            float* const pb[3] = { qb[0] + j, qb[1] + j, qb[2] + j };
+            k->triangles((const float (*)[3])t, u, d2 + j, pa, pb);
+        }
+        for (int j = 0; j < l.count; j++) {
+            if (d2[j] < r->d2) {
+                r->d2 = d2[j];
+                r->ta = ta;
+                r->tb = m->b->triangles[nb->offset + j];
+                for (int c = 0; c < 3; c++) { r->a[c] = qa[c][j]; r->b[c] = qb[c][j]; }
+            }
+        }
+        lower_bound(m, r->d2);
+    }
+}
+
+static void descend(measure_t* m, node_pair_t root, result_t* r) {
+    const kernels_t k = kernels();
+    node_pair_t stack[PAIR_STACK];
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+        const node_pair_t p = stack[--top];
+        if (p.d2 >= minimum(r->d2, shared_bound(m))) { continue; }
+        node_pair_t children[2];
+        if (split(m, p, children) < 0) {
+            leaves(m, &k, p, r);
+        } else {
+            assert(top + 2 <= PAIR_STACK);
+            stack[top++] = children[1];
+            stack[top++] = children[0]; // nearer on top
+        }
+    }
+}
+
+static void frontier_body(void* that, int from, int to) {
+    measure_t* m = (measure_t*)that;
+    for (int i = from; i < to; i++) { descend(m, m->frontier[i], &m->results[i]); }
+}
+
+/* breadth first expansion of pairs within the bound to at least FRONTIER */
+static node_pair_t* expand(measure_t* m, int* count) {
+    node_pair_t* pairs = (node_pair_t*)malloc(sizeof(node_pair_t));
+    if (pairs == null) { return null; }
+    const float bound = shared_bound(m);
+    int n = 0;
+    pairs[0] = node_pair(m, 0, 0);
+    n += pairs[0].d2 < bound;
+    int inner = n;
+    while (n > 0 && n < FRONTIER && inner > 0) {
+        node_pair_t* next = (node_pair_t*)malloc(sizeof(node_pair_t) * 2 * (size_t)n);
+        if (next == null) { free(pairs); return null; }
+        int k = 0;
+        inner = 0;
+        for (int i = 0; i < n; i++) {
+            node_pair_t children[2];
+            if (split(m, pairs[i], children) < 0) {
+                next[k++] = pairs[i];
+            } else {
+                for (int j = 0; j < 2; j++) {
+                    if (children[j].d2 < bound) { next[k++] = children[j]; }
+                }
+                inner++;
+            }
+        }
+        free(pairs);
+        pairs = next;
+        n = k;
+    }
+    *count = n;
+    return pairs;
+}
+
+static int compare_pairs(const void* x, const void* y) {
+    const node_pair_t* a = (const node_pair_t*)x;
+    const node_pair_t* b = (const node_pair_t*)y;
+    if (a->d2 != b->d2) { return a->d2 < b->d2 ? -1 : 1; }
+    if (a->a != b->a) { return a->a < b->a ? -1 : 1; }
+    return (a->b > b->b) - (a->b < b->b);
+}
+
+int bvh_mesh_distance(const bvh_t* a, const bvh_t* b, float max_distance, bvh_distance_t* d) {
+    d->distance = INFINITY;
+    d->triangle_a = -1;
+    d->triangle_b = -1;
+    if (a->node_count == 0 || b->node_count == 0) { return false; }
+    result_t seed = { bound2(max_distance), -1, -1, {0}, {0} };
+    bvh_closest_t c; // triangle of a nearest to a vertex of b: a pair that bounds the answer
+    const float* v[3];
+    mesh_triangle(&b->mesh, b->triangles[0], v);
+    if (bvh_closest_point(a, v[0], max_distance, &c)) {
+        float t[3][3], u[3][3];
+        const float* w[3];
+        mesh_triangle(&a->mesh, c.triangle, w);
+        for (int k = 0; k < 3; k++) {
+            memcpy(t[k], w[k], sizeof(t[k]));
+            memcpy(u[k], v[k], sizeof(u[k]));
+        }
+        const float d2 = triangle_triangle_distance2((const float (*)[3])t, (const float (*)[3])u, seed.a, seed.b);
+        if (d2 < seed.d2) {
+            seed.d2 = d2;
+            seed.ta = c.triangle;
+            seed.tb = b->triangles[0];
+        }
+    }
+    const float bound = seed.d2;
+    measure_t m = { a, b };
+    int bits;
+    memcpy(&bits, &bound, sizeof(bits));
+    atomic_init(&m.bound, bits);
+    int count = 0;
+    node_pair_t root = node_pair(&m, 0, 0);
+    result_t single;
+    node_pair_t* frontier = expand(&m, &count);
+    result_t* r = frontier != null ? (result_t*)malloc(sizeof(result_t) * (size_t)maximum(1, count)) : null;
+    if (r == null) { // out of memory: one sequential descent
+        free(frontier);
+        frontier = &root;
+        r = &single;
+        count = 1;
+    }
+    qsort(frontier, (size_t)count, sizeof(node_pair_t), compare_pairs); // nearest first: bound drops early
+    for (int i = 0; i < count; i++) { r[i].d2 = bound; r[i].ta = -1; }
+    m.frontier = frontier;
+    m.results = r;
+    parallel_for(0, count, 1, &m, frontier_body);
+    const result_t* best = &seed; // pairs found improve on the seed strictly
+    for (int i = 0; i < count; i++) {
+        if (r[i].ta >= 0 && r[i].d2 < best->d2) { best = &r[i]; }
+    }
+    if (best->ta >= 0) {
+        d->distance = sqrtf(best->d2);
+        d->triangle_a = best->ta;
+        d->triangle_b = best->tb;
+        memcpy(d->a, best->a, sizeof(d->a));
+        memcpy(d->b, best->b, sizeof(d->b));
+    }
+    if (r != &single) {
+        free(r);
+        free(frontier);
+    }
+    return best->ta >= 0;
+}
+
+END_C
@@ -0,0 +1,50 @@
+#pragma once
+#include "bvh.h"
+
+/* closest points between points, triangles and meshes.
+   Kernels return squared distances and the closest points, batches take
+   triangles as structure of arrays v[vertex * 3 + axis][i] and run 4 or 8
+   lanes at a time (simd_level()), results match the scalar kernels within
+   float rounding. Queries descend bvh_t branch and bound: nearer child
+   first, nodes farther than the best distance found so far are skipped.
+   Ericson. Real-Time Collision Detection. Morgan Kaufmann, 2005. 5.1 */
+
+BEGIN_C
+
+typedef struct bvh_closest_s {
+    float point[3];   /* closest point on the mesh */
+    float distance;   /* INFINITY when no triangle is within max_distance */
+    int triangle;     /* -1 when no triangle is within max_distance */
+} bvh_closest_t;
+
+typedef struct bvh_distance_s {
+    float a[3];       /* closest point on the first mesh */
+    float b[3];       /* closest point on the second mesh, same as a for intersecting meshes */
+    float distance;   /* INFINITY when no pair is within max_distance */
+    int triangle_a;   /* -1 when no pair is within max_distance */
+    int triangle_b;
+} bvh_distance_t;
+
+/* c may be null */
+float point_triangle_distance2(const float p[3], const float v0[3], const float v1[3], const float v2[3],
+                               float c[3]);
+/* 0 for intersecting triangles with a and b at a common point, a and b may be null */
+float triangle_triangle_distance2(const float t[3][3], const float u[3][3], float a[3], float b[3]);
+
+/* triangles v[vertex * 3 + axis][i] for i in [0..n), any of c, a, b may be null */
+void point_triangles_distance2(const float p[3], const float* const v[9], int n,
+                               float d2[], float* const c[3]);
+void triangle_triangles_distance2(const float t[3][3], const float* const v[9], int n,
+                                  float d2[], float* const a[3], float* const b[3]);
+
+/* nearest point of the mesh to p within max_distance (may be INFINITY), returns 0 when none */
+int bvh_closest_point(const bvh_t* bvh, const float p[3], float max_distance, bvh_closest_t* c);
+/* n points split across threads, spatially coherent order (grids, scan lines) is faster */
+void bvh_closest_points(const bvh_t* bvh, const vec3f_t* points, int n, float max_distance,
+                        bvh_closest_t* c);
+/* closest pair of triangles of two meshes within max_distance, returns 0 when none.
+   The distance does not depend on the number of threads, which pair is
+   reported among pairs at the same distance (intersecting meshes) may */
+int bvh_mesh_distance(const bvh_t* a, const bvh_t* b, float max_distance, bvh_distance_t* d);
+
+END_C
@@ -0,0 +1,195 @@
+/* width generic kernels of distance.c
+   included once per instruction set with:
+       ISA     name suffix
+       W       lanes
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+   every lane evaluates all features of the scalar kernels and keeps the
+   nearest with selects, there are no branches on data */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline void FN(store)(float* p, VF v) { memcpy(p, &v, sizeof(v)); }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline VF FN(dot)(const VF a[3], const VF b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static TARGET inline VF FN(clamp01)(VF x) {
+    const VF zero = FN(splat)(0), one = FN(splat)(1);
+    x = FN(select)(x < zero, zero, x);
+    return FN(select)(x > one, one, x);
+}
+
+static TARGET inline VF FN(distance2)(const VF a[3], const VF b[3]) {
+    const VF d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    return FN(dot)(d, d);
+}
+
+/* keeps the nearer of (d2, a, b) and (best, ba, bb) */
+static TARGET inline void FN(keep)(VF d2, const VF a[3], const VF b[3], VF* best, VF ba[3], VF bb[3]) {
+    const VI m = d2 < *best;
+    *best = FN(select)(m, d2, *best);
+    for (int k = 0; k < 3; k++) {
+        ba[k] = FN(select)(m, a[k], ba[k]);
+        bb[k] = FN(select)(m, b[k], bb[k]);
+    }
+}
+
+/* barycentric numerators of the projection of p, all >= 0 inside */
+static TARGET inline VI FN(inside)(const VF p[3], const VF a[3], const VF b[3], const VF c[3],
+                                   VF* v, VF* w) {
+    const VF ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const VF ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    const VF ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    const VF bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+    const VF cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+    const VF d1 = FN(dot)(ab, ap), d2 = FN(dot)(ac, ap);
+    const VF d3 = FN(dot)(ab, bp), d4 = FN(dot)(ac, bp);
+    const VF d5 = FN(dot)(ab, cp), d6 = FN(dot)(ac, cp);
+    const VF va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+    const VF zero = FN(splat)(0), sum = va + vb + vc;
+    *v = vb / sum;
+    *w = vc / sum;
+    return (va >= zero) & (vb >= zero) & (vc >= zero) & (sum > zero);
+}
+
+static TARGET inline VF FN(point_segment)(const VF p[3], const VF a[3], const VF b[3], VF c[3]) {
+    const VF ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const VF ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    const VF l2 = FN(dot)(ab, ab);
+    const VF t = FN(select)(l2 > FN(splat)(0), FN(clamp01)(FN(dot)(ap, ab) / l2), FN(splat)(0));
+    for (int k = 0; k < 3; k++) { c[k] = a[k] + ab[k] * t; }
+    return FN(distance2)(p, c);
+}
+
+/* projection when inside, otherwise nearest point of the three edges */
+static TARGET inline VF FN(point_triangle)(const VF p[3], const VF a[3], const VF b[3], const VF c[3], VF q[3]) {
+    VF best = FN(point_segment)(p, a, b, q), e[3];
+    const VF* ends[2][2] = { { b, c }, { c, a } };
+    for (int i = 0; i < 2; i++) {
+        const VF d2 = FN(point_segment)(p, ends[i][0], ends[i][1], e);
+        const VI m = d2 < best;
+        best = FN(select)(m, d2, best);
+        for (int k = 0; k < 3; k++) { q[k] = FN(select)(m, e[k], q[k]); }
+    }
+    VF v, w;
+    const VI in = FN(inside)(p, a, b, c, &v, &w);
+    VF f[3];
+    for (int k = 0; k < 3; k++) {
+        f[k] = a[k] + (b[k] - a[k]) * v + (c[k] - a[k]) * w;
+        q[k] = FN(select)(in, f[k], q[k]);
+    }
+    return FN(select)(in, FN(distance2)(p, f), best);
+}
+
+/* Ericson 5.1.9 with the degenerate (point) cases as selects */
+static TARGET inline VF FN(segment_segment)(const VF p1[3], const VF q1[3], const VF p2[3], const VF q2[3],
+                                            VF c1[3], VF c2[3]) {
+    const VF zero = FN(splat)(0), one = FN(splat)(1);
+    const VF d1[3] = { q1[0] - p1[0], q1[1] - p1[1], q1[2] - p1[2] };
+    const VF d2[3] = { q2[0] - p2[0], q2[1] - p2[1], q2[2] - p2[2] };
+    const VF r[3] = { p1[0] - p2[0], p1[1] - p2[1], p1[2] - p2[2] };
+    const VF a = FN(dot)(d1, d1), e = FN(dot)(d2, d2), f = FN(dot)(d2, r);
+    const VF c = FN(dot)(d1, r), b = FN(dot)(d1, d2);
+    const VF denom = a * e - b * b;
+    VF s = FN(select)(denom > zero, FN(clamp01)((b * f - c * e) / denom), zero);
+    VF t = (b * s + f) / e;
+    s = FN(select)(t < zero, FN(clamp01)(-c / a), FN(select)(t > one, FN(clamp01)((b - c) / a), s));
+    t = FN(clamp01)(t);
+    const VI pa = a > zero, pe = e > zero; // segment is not a point
+    s = FN(select)(pa, s, zero);
+    t = FN(select)(pa, t, FN(clamp01)(f / e));
+    t = FN(select)(pe, t, zero);
+    s = FN(select)(pe | ~pa, s, FN(clamp01)(-c / a));
+    for (int k = 0; k < 3; k++) {
+        c1[k] = p1[k] + d1[k] * s;
+        c2[k] = p2[k] + d2[k] * t;
+    }
+    return FN(distance2)(c1, c2);
+}
+
+/* edge pq through the interior of triangle abc: 0 at the crossing point x */
+static TARGET inline void FN(pierce)(const VF p[3], const VF q[3], const VF a[3], const VF b[3], const VF c[3],
+                                     const VF n[3], VF* best, VF ba[3], VF bb[3]) {
+    const VF zero = FN(splat)(0);
+    const VF ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    const VF aq[3] = { q[0] - a[0], q[1] - a[1], q[2] - a[2] };
+    const VF dp = FN(dot)(n, ap), dq = FN(dot)(n, aq);
+    const VI crosses = ((dp <= zero) & (dq >= zero)) | ((dp >= zero) & (dq <= zero));
+    const VF t = dp / (dp - dq);
+    VF x[3], v, w;
+    for (int k = 0; k < 3; k++) { x[k] = p[k] + (q[k] - p[k]) * t; }
+    const VI in = crosses & (dp != dq) & FN(inside)(x, a, b, c, &v, &w);
+    const VF d2 = FN(select)(in, zero, FN(splat)(INFINITY));
+    FN(keep)(d2, x, x, best, ba, bb);
+}
+
+static TARGET inline void FN(cross)(const VF a[3], const VF b[3], const VF c[3], VF n[3]) {
+    const VF u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const VF v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/* W lanes of v against p, c: closest points */
+static TARGET void FN(point_triangles)(const float p[3], const float* const v[9], float* d2, float* const c[3]) {
+    VF P[3], V[3][3], q[3];
+    for (int k = 0; k < 3; k++) {
+        P[k] = FN(splat)(p[k]);
+        for (int j = 0; j < 3; j++) { V[j][k] = FN(load)(v[j * 3 + k]); }
+    }
+    FN(store)(d2, FN(point_triangle)(P, V[0], V[1], V[2], q));
+    for (int k = 0; k < 3; k++) { FN(store)(c[k], q[k]); }
+}
+
+/* W lanes of v against t: vertices against triangles both ways, edges
+   against edges, and edges piercing the other triangle (intersection) */
+static TARGET void FN(triangle_triangles)(const float t[3][3], const float* const v[9],
+                                          float* d2, float* const a[3], float* const b[3]) {
+    VF T[3][3], V[3][3], nt[3], nv[3];
+    for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) {
+            T[j][k] = FN(splat)(t[j][k]);
+            V[j][k] = FN(load)(v[j * 3 + k]);
+        }
+    }
+    VF best = FN(splat)(INFINITY), ba[3], bb[3], x[3], y[3];
+    for (int k = 0; k < 3; k++) { ba[k] = T[0][k]; bb[k] = V[0][k]; }
+    for (int i = 0; i < 3; i++) {
+        FN(keep)(FN(point_triangle)(T[i], V[0], V[1], V[2], y), T[i], y, &best, ba, bb);
+        FN(keep)(FN(point_triangle)(V[i], T[0], T[1], T[2], x), x, V[i], &best, ba, bb);
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            const VF d = FN(segment_segment)(T[i], T[(i + 1) % 3], V[j], V[(j + 1) % 3], x, y);
+            FN(keep)(d, x, y, &best, ba, bb);
+        }
+    }
+    FN(cross)(T[0], T[1], T[2], nt);
+    FN(cross)(V[0], V[1], V[2], nv);
+    for (int i = 0; i < 3; i++) {
+        FN(pierce)(T[i], T[(i + 1) % 3], V[0], V[1], V[2], nv, &best, ba, bb);
+        FN(pierce)(V[i], V[(i + 1) % 3], T[0], T[1], T[2], nt, &best, ba, bb);
+    }
+    FN(store)(d2, best);
+    for (int k = 0; k < 3; k++) {
+        FN(store)(a[k], ba[k]);
+        FN(store)(b[k], bb[k]);
+    }
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
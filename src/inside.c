@@ -0,0 +1,168 @@
+#include "inside.h"
+#include "simd.h"
+#include "threads.h"
+#include "../ext/intersect_triangle_simd.h"
+#include <limits.h>
+#include <sys/mman.h>
+
+BEGIN_C
+
+/* A packet is 8 rays (rays8_t) traversing the hierarchy together with a
+   bit per lane: children are visited when any lane of the parent mask hits
+   their box, leaves test every triangle against the whole packet with one
+   intersect_rays_triangle() call and toggle the parity of hit lanes with
+   t > 0. Parity needs all crossings, so there is no ordering or early out.
+   Batches take 8 points at a time and cast one packet per direction:
+   parallel rays from neighboring points visit mostly the same nodes.
+   Directions avoid the axes and their diagonals, where edges and vertices
+   of axis aligned geometry line up with rays. parallel_for chunks are whole
+   64 bit words of the result, there are no shared writes. */
+
+enum {
+    LANES = 8,          /* rays per packet */
+    WORD_GRAIN = 8,     /* 64 bit words of bits (512 points) per parallel_for chunk */
+    STREAM = 1 << 20    /* points of a mapped file classified at a time, multiple of 64 */
+};
+
+static const float directions[INSIDE_RAYS_MAX][3] = {
+    {  0.9017f,  0.3181f,  0.2927f },
+    { -0.2632f,  0.9240f,  0.2774f },
+    {  0.2399f, -0.1935f,  0.9513f },
+    { -0.7310f, -0.5413f,  0.4155f },
+    {  0.3347f, -0.8163f, -0.4710f },
+    { -0.4870f,  0.2120f, -0.8474f },
+    {  0.6420f,  0.5210f, -0.5630f }
+};
+
+typedef struct packet_s {
+    rays8_t r;
+    float orig[3][LANES];
+    float inv[3][LANES]; /* 1 / dir, no direction has a 0 component */
+} packet_t;
+
+static inline int odd_rays(int rays) { return maximum(1, minimum(INSIDE_RAYS_MAX, rays | 1)); }
+
+static inline int in_box(const bvh_node_t* n, const float p[3]) {
+    return n->min[0] <= p[0] && p[0] <= n->max[0] && n->min[1] <= p[1] && p[1] <= n->max[1] &&
+           n->min[2] <= p[2] && p[2] <= n->max[2];
+}
+
+static void packet_set(packet_t* p, int lane, const float orig[3], const float dir[3]) {
+    rays8_set(&p->r, lane, orig, dir);
+    for (int k = 0; k < 3; k++) {
+        p->orig[k][lane] = orig[k];
+        p->inv[k][lane] = 1.0f / dir[k];
+    }
+}
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "inside.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "inside.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+#endif
+
+static int crossings(const bvh_t* bvh, const packet_t* p, int active) {
+#ifdef SIMD_X86
+    if (simd_level() >= SIMD_AVX2) { return crossings_avx2(bvh, p, active); }
+#endif
+    return crossings_generic(bvh, p, active);
+}
+
+int bvh_inside(const bvh_t* bvh, const float p[3], int rays) {
+    if (bvh->node_count == 0 || !in_box(&bvh->nodes[0], p)) { return false; }
+    rays = odd_rays(rays);
+    packet_t packet;
+    for (int i = 0; i < LANES; i++) { packet_set(&packet, i, p, directions[i % rays]); }
+    const int votes = __builtin_popcount((unsigned)crossings(bvh, &packet, (1 << rays) - 1));
+    return votes > rays / 2;
+}
+
+typedef struct batch_s {
+    const bvh_t* bvh;
+    const vec3f_t* points;
+    int n;
+    int rays;
+    uint64_t* bits;
+} batch_t;
+
+static void words_body(void* that, int from, int to) {
+    const batch_t* b = (const batch_t*)that;
+    const bvh_node_t* root = &b->bvh->nodes[0];
+    for (int w = from; w < to; w++) {
+        uint64_t word = 0;
+        for (int first = w * 64; first < minimum(b->n, w * 64 + 64); first += LANES) {
+            const int lanes = minimum(LANES, b->n - first);
+            int active = 0;
+            for (int i = 0; i < lanes; i++) { active |= in_box(root, b->points[first + i]) << i; }
+            int votes[LANES] = {0};
+            for (int d = 0; d < b->rays && active != 0; d++) {
+                packet_t packet;
+                for (int i = 0; i < LANES; i++) {
+                    packet_set(&packet, i, b->points[first + minimum(i, lanes - 1)], directions[d]);
+                }
+                const int parity = crossings(b->bvh, &packet, active);
+                for (int i = 0; i < LANES; i++) { votes[i] += (parity >> i) & 1; }
+            }
+            for (int i = 0; i < lanes; i++) {
+                word |= (uint64_t)(votes[i] > b->rays / 2) << (first + i - w * 64);
+            }
+        }
+        b->bits[w] = word;
+    }
+}
+
+void bvh_inside_points(const bvh_t* bvh, const vec3f_t* points, int n, int rays, uint64_t* bits) {
+    const int words = (n + 63) / 64;
+    if (bvh->node_count == 0) {
+        memset(bits, 0, sizeof(uint64_t) * (size_t)words);
+        return;
+    }
+    batch_t b = { bvh, points, n, odd_rays(rays), bits };
+    parallel_for(0, words, WORD_GRAIN, &b, words_body);
+}
+
+uint64_t* bvh_inside_file(const bvh_t* bvh, const char* filename, int rays, int* n) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) { return null; }
+    struct stat s = {0};
+    const int ok = fstat(fd, &s) == 0 && s.st_size / (off_t)sizeof(vec3f_t) <= INT_MAX;
+    const int count = ok ? (int)(s.st_size / (off_t)sizeof(vec3f_t)) : 0;
+    void* a = ok && count > 0 ? mmap(null, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (!ok || (count > 0 && a == MAP_FAILED)) { return null; }
+    uint64_t* bits = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)maximum(1, (count + 63) / 64));
+    if (bits != null && count > 0) {
+        const vec3f_t* points = (const vec3f_t*)a;
+        madvise(a, (size_t)s.st_size, MADV_SEQUENTIAL);
+        for (int i = 0; i < count; i += STREAM) {
+            const int m = minimum(STREAM, count - i);
+            bvh_inside_points(bvh, points + i, m, rays, bits + i / 64);
+            madvise((void*)(points + i), sizeof(vec3f_t) * (size_t)m, MADV_DONTNEED); // done with the pages
+        }
+    }
+    if (count > 0) { munmap(a, (size_t)s.st_size); }
+    if (bits != null) { *n = count; }
+    return bits;
+}
+
+END_C
@@ -0,0 +1,26 @@
+#pragma once
+#include "bvh.h"
+
+/* inside/outside classification of points against a closed mesh.
+   Every point casts rays in fixed directions and counts crossings
+   (Moller-Trumbore, intersect_rays_triangle()), odd is a vote for inside
+   and the majority decides, so a crack or a double hit at a shared edge on
+   one of the rays does not flip the answer. Rays travel through bvh_t in
+   packets of 8: the rays of one point, or 8 points along one direction in
+   the batch forms. Points outside of the mesh bounds cast no rays. */
+
+BEGIN_C
+
+enum {
+    INSIDE_RAYS_MAX = 7 /* rays are made odd and clamped to [1..INSIDE_RAYS_MAX] */
+};
+
+int bvh_inside(const bvh_t* bvh, const float p[3], int rays);
+/* bit i % 64 of bits[i / 64] for i in [0..n), (n + 63) / 64 words are written */
+void bvh_inside_points(const bvh_t* bvh, const vec3f_t* points, int n, int rays, uint64_t* bits);
+/* points streamed from a memory mapped file of packed float x, y, z,
+   returns bits (free() them) and sets n, null when the file cannot be
+   mapped or on out of memory */
+uint64_t* bvh_inside_file(const bvh_t* bvh, const char* filename, int rays, int* n);
+
+END_C
@@ -0,0 +1,91 @@
+/* packet traversal of inside.c included once per instruction set with:
+       ISA     name suffix
+       W       lanes: rays of a packet tested together, LANES / W vectors per packet
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty) */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+/* bit per lane hitting the box at t >= 0 */
+static TARGET inline int FN(packet_box)(const bvh_node_t* n, const packet_t* p) {
+    int mask = 0;
+    for (int j = 0; j < LANES; j += W) {
+        VF tmin = FN(splat)(0), tmax = FN(splat)(INFINITY);
+        for (int k = 0; k < 3; k++) {
+            const VF o = FN(load)(&p->orig[k][j]), inv = FN(load)(&p->inv[k][j]);
+            const VF t0 = (FN(splat)(n->min[k]) - o) * inv;
+            const VF t1 = (FN(splat)(n->max[k]) - o) * inv;
+            const VI m = t0 < t1;
+            const VF lo = FN(select)(m, t0, t1), hi = FN(select)(m, t1, t0);
+            tmin = FN(select)(lo > tmin, lo, tmin);
+            tmax = FN(select)(hi < tmax, hi, tmax);
+        }
+        const VI hit = tmin <= tmax;
+        for (int i = 0; i < W; i++) { mask |= (hit[i] & 1) << (j + i); }
+    }
+    return mask;
+}
+
+/* bit per lane of active: odd number of crossings */
+static TARGET int FN(crossings)(const bvh_t* bvh, const packet_t* p, int active) {
+    uint32_t stack[BVH_STACK];
+    int masks[BVH_STACK];
+    int sp = 0;
+    int parity = 0;
+    uint32_t i = 0;
+    int mask = FN(packet_box)(&bvh->nodes[0], p) & active;
+    while (mask != 0) {
+        const bvh_node_t* n = &bvh->nodes[i];
+        if (n->count == 0) {
+            const int ma = FN(packet_box)(&bvh->nodes[i + 1], p) & mask;
+            const int mb = FN(packet_box)(&bvh->nodes[n->offset], p) & mask;
+            if (mb != 0) {
+                if (ma == 0) {
+                    i = n->offset;
+                    mask = mb;
+                    continue;
+                }
+                masks[sp] = mb;
+                stack[sp++] = n->offset;
+            }
+            if (ma != 0) {
+                i = i + 1;
+                mask = ma;
+                continue;
+            }
+        } else {
+            for (uint32_t k = n->offset; k < n->offset + n->count; k++) {
+                const float* v[3];
+                float t[LANES], u[LANES], w[LANES];
+                mesh_triangle(&bvh->mesh, bvh->triangles[k], v);
+                int hits = intersect_rays_triangle(&p->r, LANES, v[0], v[1], v[2], 0, t, u, w) & mask;
+                while (hits != 0) {
+                    const int lane = __builtin_ctz((unsigned)hits);
+                    hits &= hits - 1;
+                    if (t[lane] > 0) { parity ^= 1 << lane; }
+                }
+            }
+        }
+        if (sp == 0) { break; }
+        sp--;
+        i = stack[sp];
+        mask = masks[sp];
+    }
+    return parity;
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
@@ -1,4 +1,6 @@
 #include "math4x4.h"
+#include "simd.h"
+#include "threads.h"
 #include <math.h>
 #include <memory.h>
 
@@ -6,14 +8,539 @@ BEGIN_C
 
 const float identity_4x4f[16] = IDENTITY_MATRIX_4x4F;
 
-// there is hundreds of good NEON and SSE optimizations of multiply_4x4f when it is needed
+enum {
+    CHUNK = 16 * 1024,   // matrices per parallel_for() body call
+    PARALLEL = 4 * CHUNK, // smaller batches are not worth waking up threads
+    LANES = 16,          // widest kernel
+    POINTS = 64 * 1024,  // points per parallel_for() body call, multiple of LANES
+    STREAM = 4 << 20     // output bytes from which transforms bypass the caches
+};
 
-void multiply_4x4f(mat4x4f_t r, const mat4x4f_t a, const mat4x4f_t b) {
+typedef void (*kernel_t)(mat4x4f_t r[], const mat4x4f_t a[], int as, const mat4x4f_t b[], int bs, int n);
+
+static void multiply_scalar(mat4x4f_t r[], const mat4x4f_t a[], int as, const mat4x4f_t b[], int bs, int n) {
+    for (int i = 0; i < n; i++) { multiply_4x4f_scalar(r[i], a[i * as], b[i * bs]); }
+}
+
+enum { /* instances_t.op */
+    OP_PERSPECTIVE,
+    OP_ORTHOGRAPHIC,
+    OP_LOOK_AT,
+    OP_INVERSE,
+    OP_INVERSE_AFFINE,
+    OP_NORMAL,
+    OP_MULTIPLY_QUAT,
+    OP_SLERP,
+    OP_COMPOSE
+};
+
+enum { ARGUMENTS = 6 };
+
+typedef struct instances_s { /* batch of one of the instance kernels of math4x4.inl */
+    int op;
+    float* r;
+    int results;                  // floats per instance of r
+    int arguments;
+    const float* in[ARGUMENTS];
+    int count[ARGUMENTS];         // floats per instance of in[a]
+    int stride[ARGUMENTS];        // count[a], 0 for a default shared by all instances
+    atomic_int ok;                // instances that succeeded
+    int (*kernel)(const struct instances_s* b, int from, int to);
+} instances_t;
+
+/* sin(t * a) / sin(a) = t * (1 + b0 * (1 + b1 * (1 + ...))) with
+   bi = (u[i] * t^2 - v[i]) * (cos(a) - 1), u[i] = 1 / ((i + 1) * (2i + 3)),
+   v[i] = (i + 1) / (2i + 3) (Eberly. A Fast and Accurate Algorithm for
+   Computing SLERP. JGT 15(3), 2011), truncated where a <= 45 degrees
+   is below FLT_EPSILON */
+enum { SLERP_TERMS = 8 };
+
+static const float slerp_u[SLERP_TERMS] = {
+    1.0f / 3, 1.0f / 10, 1.0f / 21, 1.0f / 36, 1.0f / 55, 1.0f / 78, 1.0f / 105, 1.0f / 136
+};
+static const float slerp_v[SLERP_TERMS] = {
+    1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9, 5.0f / 11, 6.0f / 13, 7.0f / 15, 8.0f / 17
+};
+
+#define ISA scalar
+#define W 1
+#define VF float
+#define VI int32_t
+#define TARGET
+#include "math4x4.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "math4x4.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "math4x4.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#define ISA avx512
+#define W 16
+#define VF f32x16
+#define VI i32x16
+#define TARGET SIMD_TARGET_AVX512
+#include "math4x4.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#endif
+
+static kernel_t kernel(void) {
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: return multiply_avx512;
+        case SIMD_AVX2: return multiply_avx2;
+#endif
+        case SIMD_SCALAR: return multiply_scalar;
+        default: return multiply_generic; // sse4.1 and neon
+    }
+}
+
+void multiply_4x4f_scalar(mat4x4f_t r, const mat4x4f_t a, const mat4x4f_t b) {
+    mat4x4f_t p; // r may be a or b
     for (int i = 0; i <= 12; i += 4) {
         for (int j = 0; j < 4; j++) {
-            r[i + j] = b[i] * a[j] + b[i + 1] * a[j + 4] + b[i + 2] * a[j + 8] + b[i + 3] * a[j + 12];
+            p[i + j] = b[i] * a[j] + b[i + 1] * a[j + 4] + b[i + 2] * a[j + 8] + b[i + 3] * a[j + 12];
+        }
+    }
+    memcpy(r, p, sizeof(p));
+}
+
+void multiply_4x4f(mat4x4f_t r, const mat4x4f_t a, const mat4x4f_t b) {
+#ifdef SIMD_X86
+    if (simd_level() == SIMD_AVX512) { // whole matrix broadcasts only pay off when shared by a batch
+        multiply_avx2((mat4x4f_t*)r, (const mat4x4f_t*)a, 0, (const mat4x4f_t*)b, 0, 1);
+        return;
+    }
+#endif
+    kernel()((mat4x4f_t*)r, (const mat4x4f_t*)a, 0, (const mat4x4f_t*)b, 0, 1);
+}
+
+typedef struct batch_s {
+    mat4x4f_t* r;
+    const mat4x4f_t* a;
+    int as;
+    const mat4x4f_t* b;
+    int bs;
+    kernel_t k;
+} batch_t;
+
+static void batch_body(void* that, int i, int j) {
+    const batch_t* b = (const batch_t*)that;
+    const int from = i * CHUNK, to = j * CHUNK;
+    b->k(b->r + from, b->a + from * b->as, b->as, b->b + from * b->bs, b->bs, to - from);
+}
+
+static void batch(mat4x4f_t r[], const mat4x4f_t a[], int as, const mat4x4f_t b[], int bs, int n) {
+    const kernel_t k = kernel();
+    if (n < PARALLEL || threads_count() <= 1) {
+        k(r, a, as, b, bs, n);
+    } else {
+        batch_t t = { r, a, as, b, bs, k };
+        const int chunks = n / CHUNK;
+        parallel_for(0, chunks, 1, &t, batch_body);
+        const int done = chunks * CHUNK;
+        k(r + done, a + done * as, as, b + done * bs, bs, n - done);
+    }
+}
+
+void multiply_4x4f_batch_many_one(mat4x4f_t r[], const mat4x4f_t a[], const mat4x4f_t b, int n) {
+    batch(r, a, 1, (const mat4x4f_t*)b, 0, n);
+}
+
+void multiply_4x4f_batch_one_many(mat4x4f_t r[], const mat4x4f_t a, const mat4x4f_t b[], int n) {
+    batch(r, (const mat4x4f_t*)a, 0, b, 1, n);
+}
+
+void multiply_4x4f_batch_pairwise(mat4x4f_t r[], const mat4x4f_t a[], const mat4x4f_t b[], int n) {
+    batch(r, a, 1, b, 1, n);
+}
+
+typedef void (*soa_t)(const float e[16], int divide, int normalize,
+                      const float* const in[3], float* const out[3], int n, int stream);
+typedef void (*aos_t)(const float e[16], int divide, int normalize,
+                      const vec3f_t* in, vec3f_t* out, int n, int stream);
+
+static void transform_point(const float e[16], int divide, int normalize, const float in[3], float out[3]) {
+    float r[3];
+    for (int k = 0; k < 3; k++) { r[k] = e[k] * in[0] + e[4 + k] * in[1] + e[8 + k] * in[2] + e[12 + k]; }
+    if (divide) {
+        const float w = e[3] * in[0] + e[7] * in[1] + e[11] * in[2] + e[15];
+        for (int k = 0; k < 3; k++) { r[k] = r[k] / w; }
+    }
+    if (normalize) {
+        const float l2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        const float s = 1 / sqrtf(l2);
+        for (int k = 0; k < 3; k++) { r[k] = l2 > 0 ? r[k] * s : r[k]; }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+static void transform_soa_scalar(const float e[16], int divide, int normalize,
+                                 const float* const in[3], float* const out[3], int n, int stream) {
+    (void)stream;
+    for (int i = 0; i < n; i++) {
+        float p[3] = { in[0][i], in[1][i], in[2][i] };
+        transform_point(e, divide, normalize, p, p);
+        for (int k = 0; k < 3; k++) { out[k][i] = p[k]; }
+    }
+}
+
+static void transform_aos_scalar(const float e[16], int divide, int normalize,
+                                 const vec3f_t* in, vec3f_t* out, int n, int stream) {
+    (void)stream;
+    for (int i = 0; i < n; i++) { transform_point(e, divide, normalize, in[i], out[i]); }
+}
+
+static int soa_kernel(soa_t* k) {
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: *k = transform_soa_avx512; return 16;
+        case SIMD_AVX2: *k = transform_soa_avx2; return 8;
+#endif
+        case SIMD_SCALAR: *k = transform_soa_scalar; return 1;
+        default: *k = transform_soa_generic; return 4;
+    }
+}
+
+/* interleaved points are shuffled 4 at a time, wider shuffles cost more than they save */
+static int aos_kernel(aos_t* k) {
+    if (simd_level() == SIMD_SCALAR) { *k = transform_aos_scalar; return 1; }
+    *k = transform_aos_generic;
+    return 4;
+}
+
+/* matrix applied to (x, y, z, 1): m, m without translation, or for normals
+   the cofactors of the upper 3x3, which is its inverse transpose times the
+   determinant, with the sign of the determinant taken out */
+static void transform_matrix(const mat4x4f_t m, int flags, mat4x4f_t e) {
+    memcpy(e, m, sizeof(mat4x4f_t));
+    if (flags & TRANSFORM_NORMALS) {
+        for (int c = 0; c < 3; c++) {
+            const float* a = m + (c + 1) % 3 * 4;
+            const float* b = m + (c + 2) % 3 * 4;
+            e[c * 4 + 0] = a[1] * b[2] - a[2] * b[1];
+            e[c * 4 + 1] = a[2] * b[0] - a[0] * b[2];
+            e[c * 4 + 2] = a[0] * b[1] - a[1] * b[0];
+        }
+        const float det = m[0] * e[0] + m[1] * e[1] + m[2] * e[2];
+        if (det < 0) {
+            for (int i = 0; i < 12; i++) { e[i] = -e[i]; }
         }
     }
+    if (flags & (TRANSFORM_DIRECTIONS | TRANSFORM_NORMALS)) {
+        e[12] = 0;
+        e[13] = 0;
+        e[14] = 0;
+    }
+}
+
+static int transform_divide(int flags) {
+    return (flags & TRANSFORM_DIVIDE) && !(flags & (TRANSFORM_DIRECTIONS | TRANSFORM_NORMALS));
+}
+
+void transform_4x4f_scalar(const mat4x4f_t m, const float in[3], float out[3], int flags) {
+    mat4x4f_t e;
+    transform_matrix(m, flags, e);
+    transform_point(e, transform_divide(flags), (flags & TRANSFORM_NORMALS) != 0, in, out);
+}
+
+typedef struct transform_s {
+    mat4x4f_t e;
+    int divide;
+    int normalize;
+    int stream;
+    const vec3f_t* in;      // interleaved, null for structure of arrays
+    vec3f_t* out;
+    const float* const* soa_in;
+    float* const* soa_out;
+} transform_t;
+
+/* points [from..to), tail of less than W points through zero padded copies */
+static void transform_range(const transform_t* t, int from, int to) {
+    if (t->in != null) {
+        aos_t aos;
+        const int w = aos_kernel(&aos);
+        const int n = (to - from) / w * w, i = from + n, tail = to - i;
+        aos(t->e, t->divide, t->normalize, t->in + from, t->out + from, n, t->stream);
+        if (tail > 0) {
+            vec3f_t p[LANES] = {{0}};
+            memcpy(p, t->in + i, sizeof(vec3f_t) * (size_t)tail);
+            aos(t->e, t->divide, t->normalize, p, p, w, false);
+            memcpy(t->out + i, p, sizeof(vec3f_t) * (size_t)tail);
+        }
+    } else {
+        soa_t soa;
+        const int w = soa_kernel(&soa);
+        const int n = (to - from) / w * w, i = from + n, tail = to - i;
+        const float* in[3] = { t->soa_in[0] + from, t->soa_in[1] + from, t->soa_in[2] + from };
+        float* out[3] = { t->soa_out[0] + from, t->soa_out[1] + from, t->soa_out[2] + from };
+        soa(t->e, t->divide, t->normalize, in, out, n, t->stream);
+        if (tail > 0) {
+            float p[3][LANES] = {{0}};
+            float* pp[3] = { p[0], p[1], p[2] };
+            for (int k = 0; k < 3; k++) { memcpy(p[k], t->soa_in[k] + i, sizeof(float) * (size_t)tail); }
+            soa(t->e, t->divide, t->normalize, (const float* const*)pp, pp, w, false);
+            for (int k = 0; k < 3; k++) { memcpy(t->soa_out[k] + i, p[k], sizeof(float) * (size_t)tail); }
+        }
+    }
+#ifdef SIMD_NONTEMPORAL
+    if (t->stream) { simd_stream_fence(); } // streaming stores are weakly ordered
+#endif
+}
+
+static void transform_body(void* that, int i, int j) {
+    transform_range((const transform_t*)that, i * POINTS, j * POINTS);
+}
+
+static void transform(transform_t* t, int n, int flags) {
+    t->divide = transform_divide(flags);
+    t->normalize = (flags & TRANSFORM_NORMALS) != 0;
+    if (n < 2 * POINTS || threads_count() <= 1) {
+        transform_range(t, 0, n);
+    } else {
+        const int chunks = n / POINTS;
+        parallel_for(0, chunks, 1, t, transform_body);
+        transform_range(t, chunks * POINTS, n);
+    }
+}
+
+static int aligned(const void* p) { return ((uintptr_t)p & 63) == 0; }
+
+void transform_4x4f(const mat4x4f_t m, const vec3f_t* in, vec3f_t* out, int n, int flags) {
+    transform_t t;
+    memset(&t, 0, sizeof(t));
+    transform_matrix(m, flags, t.e);
+    t.in = in;
+    t.out = out;
+    t.stream = sizeof(vec3f_t) * (size_t)n >= STREAM && aligned(out);
+    transform(&t, n, flags);
+}
+
+void transform_4x4f_soa(const mat4x4f_t m, const float* const in[3], float* const out[3], int n, int flags) {
+    transform_t t;
+    memset(&t, 0, sizeof(t));
+    transform_matrix(m, flags, t.e);
+    t.soa_in = in;
+    t.soa_out = out;
+    t.stream = sizeof(vec3f_t) * (size_t)n >= STREAM && aligned(out[0]) && aligned(out[1]) && aligned(out[2]);
+    transform(&t, n, flags);
+}
+
+typedef int (*instances_kernel_t)(const instances_t* b, int from, int to);
+
+static instances_kernel_t instances_kernel(void) {
+    switch (simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: return instances_avx512;
+        case SIMD_AVX2: return instances_avx2;
+#endif
+        case SIMD_SCALAR: return instances_scalar;
+        default: return instances_generic;
+    }
+}
+
+static void instances_init(instances_t* b, int op, void* r, int results) {
+    memset(b, 0, sizeof(*b));
+    b->op = op;
+    b->r = (float*)r;
+    b->results = results;
+    atomic_init(&b->ok, 0);
+}
+
+/* p of count floats per instance, or otherwise shared by all instances when p is null */
+static void argument(instances_t* b, const void* p, int count, const float* otherwise) {
+    b->in[b->arguments] = p != null ? (const float*)p : otherwise;
+    b->count[b->arguments] = count;
+    b->stride[b->arguments] = p != null ? count : 0;
+    b->arguments++;
+}
+
+static void instances_body(void* that, int i, int j) {
+    instances_t* b = (instances_t*)that;
+    atomic_fetch_add(&b->ok, b->kernel(b, i * CHUNK, j * CHUNK));
+}
+
+static int instances(instances_t* b, int n) {
+    b->kernel = instances_kernel();
+    if (n < PARALLEL || threads_count() <= 1) { return b->kernel(b, 0, n); }
+    const int chunks = n / CHUNK, done = chunks * CHUNK;
+    parallel_for(0, chunks, 1, b, instances_body);
+    return atomic_load(&b->ok) + b->kernel(b, done, n);
+}
+
+static const float zero3[3] = { 0, 0, 0 };
+static const float one3[3] = { 1, 1, 1 };
+
+void perspective_4x4f(mat4x4f_t m, float fovy, float aspect, float near, float far) {
+    const float x[4] = { fovy, aspect, near, far };
+    perspective_scalar(x, m);
+}
+
+void perspective_4x4f_batch(mat4x4f_t r[], const float fovy[], const float aspect[],
+                            const float near[], const float far[], int n) {
+    instances_t b;
+    instances_init(&b, OP_PERSPECTIVE, r, 16);
+    argument(&b, fovy, 1, null);
+    argument(&b, aspect, 1, null);
+    argument(&b, near, 1, null);
+    argument(&b, far, 1, null);
+    instances(&b, n);
+}
+
+void orthographic_4x4f(mat4x4f_t m, float left, float right, float bottom, float top, float near, float far) {
+    const float x[6] = { left, right, bottom, top, near, far };
+    orthographic_scalar(x, m);
+}
+
+void orthographic_4x4f_batch(mat4x4f_t r[], const float left[], const float right[], const float bottom[],
+                             const float top[], const float near[], const float far[], int n) {
+    instances_t b;
+    instances_init(&b, OP_ORTHOGRAPHIC, r, 16);
+    const float* x[6] = { left, right, bottom, top, near, far };
+    for (int i = 0; i < 6; i++) { argument(&b, x[i], 1, null); }
+    instances(&b, n);
+}
+
+void look_at_4x4f(mat4x4f_t m, const vec3f_t eye, const vec3f_t center, const vec3f_t up) {
+    float x[9];
+    memcpy(x, eye, sizeof(vec3f_t));
+    memcpy(x + 3, center, sizeof(vec3f_t));
+    memcpy(x + 6, up, sizeof(vec3f_t));
+    look_at_scalar(x, m);
+}
+
+void look_at_4x4f_batch(mat4x4f_t r[], const vec3f_t eye[], const vec3f_t center[], const vec3f_t up[], int n) {
+    instances_t b;
+    instances_init(&b, OP_LOOK_AT, r, 16);
+    argument(&b, eye, 3, null);
+    argument(&b, center, 3, null);
+    argument(&b, up, 3, null);
+    instances(&b, n);
+}
+
+void viewport_4x4f(mat4x4f_t m, float x, float y, float w, float h) {
+    memcpy(m, identity_4x4f, sizeof(mat4x4f_t));
+    m[0] = w / 2;
+    m[5] = h / 2;
+    m[10] = 0.5f;
+    m[12] = x + w / 2;
+    m[13] = y + h / 2;
+    m[14] = 0.5f;
+}
+
+/* single instances call the scalar kernels directly, on a copy of the arguments as r may alias them */
+static int matrix(int32_t (*kernel)(const float* x, float* y), mat4x4f_t r, const mat4x4f_t m) {
+    mat4x4f_t x;
+    memcpy(x, m, sizeof(x));
+    return kernel(x, r) != 0;
+}
+
+static int matrices(int op, mat4x4f_t r[], const mat4x4f_t m[], int n) {
+    instances_t b;
+    instances_init(&b, op, r, 16);
+    argument(&b, m, 16, null);
+    return instances(&b, n);
+}
+
+int inverse_4x4f(mat4x4f_t r, const mat4x4f_t m) { return matrix(inverse_scalar, r, m); }
+
+int inverse_affine_4x4f(mat4x4f_t r, const mat4x4f_t m) { return matrix(inverse_affine_scalar, r, m); }
+
+int normal_4x4f(mat4x4f_t r, const mat4x4f_t m) { return matrix(normal_scalar, r, m); }
+
+int inverse_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n) { return matrices(OP_INVERSE, r, m, n); }
+
+int inverse_affine_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n) {
+    return matrices(OP_INVERSE_AFFINE, r, m, n);
+}
+
+int normal_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n) { return matrices(OP_NORMAL, r, m, n); }
+
+void multiply_quatf(quatf_t r, const quatf_t a, const quatf_t b) {
+    float x[8];
+    memcpy(x, a, sizeof(quatf_t));
+    memcpy(x + 4, b, sizeof(quatf_t));
+    multiply_quat_scalar(x, r);
+}
+
+void multiply_quatf_batch(quatf_t r[], const quatf_t a[], const quatf_t b[], int n) {
+    instances_t t;
+    instances_init(&t, OP_MULTIPLY_QUAT, r, 4);
+    argument(&t, a, 4, null);
+    argument(&t, b, 4, null);
+    instances(&t, n);
+}
+
+void slerp_quatf(quatf_t r, const quatf_t a, const quatf_t b, float t) {
+    float x[9];
+    memcpy(x, a, sizeof(quatf_t));
+    memcpy(x + 4, b, sizeof(quatf_t));
+    x[8] = t;
+    slerp_scalar(x, r);
+}
+
+void slerp_quatf_batch(quatf_t r[], const quatf_t a[], const quatf_t b[], const float t[], int n) {
+    instances_t s;
+    instances_init(&s, OP_SLERP, r, 4);
+    argument(&s, a, 4, null);
+    argument(&s, b, 4, null);
+    argument(&s, t, 1, null);
+    instances(&s, n);
+}
+
+void axis_angle_quatf(quatf_t q, const vec3f_t axis, float angle) {
+    const float l = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    const float s = l > 0 ? sinf(angle / 2) / l : 0;
+    for (int k = 0; k < 3; k++) { q[k] = axis[k] * s; }
+    q[3] = l > 0 ? cosf(angle / 2) : 1;
+}
+
+void compose_4x4f(mat4x4f_t m, const vec3f_t translation, const quatf_t rotation, const vec3f_t scale) {
+    float x[10];
+    memcpy(x, rotation, sizeof(quatf_t));
+    memcpy(x + 4, translation != null ? translation : zero3, sizeof(vec3f_t));
+    memcpy(x + 7, scale != null ? scale : one3, sizeof(vec3f_t));
+    compose_scalar(x, m);
+}
+
+void compose_4x4f_batch(mat4x4f_t r[], const vec3f_t translation[], const quatf_t rotation[],
+                        const vec3f_t scale[], int n) {
+    instances_t b;
+    instances_init(&b, OP_COMPOSE, r, 16);
+    argument(&b, rotation, 4, null);
+    argument(&b, translation, 3, zero3);
+    argument(&b, scale, 3, one3);
+    instances(&b, n);
 }
 
 END_C
@@ -4,7 +4,8 @@
 BEGIN_C
 
 typedef float vec3f_t[3];
-typedef float vec4f_t[3];
+typedef float vec4f_t[4];
+typedef float quatf_t[4]; /* x, y, z, w: w + xi + yj + zk */
 typedef float mat4x4f_t[16];
 
 #define IDENTITY_MATRIX_4x4F { \
@@ -15,6 +16,84 @@ typedef float mat4x4f_t[16];
 
 extern const mat4x4f_t identity_4x4f;
 
+/* column major r = a * b. Kernels are picked at runtime by simd_level():
+   a column (sse4.1, neon), a column pair (avx2) or the whole matrix
+   (avx512 batches) per vector. Kernels with FMA may contract the products,
+   every element is within 3 * FLT_EPSILON * sum of |a[k * 4 + j] * b[c * 4 + k]|
+   of multiply_4x4f_scalar(), bit identical without contraction.
+   r may be a or b. */
 void multiply_4x4f(mat4x4f_t r, const mat4x4f_t a, const mat4x4f_t b);
+void multiply_4x4f_scalar(mat4x4f_t r, const mat4x4f_t a, const mat4x4f_t b); /* reference */
+
+/* batches of n: r[i] = a[i] * b, r[i] = a * b[i] and r[i] = a[i] * b[i].
+   Any alignment works, arrays aligned to 64 bytes (SIMD_ALIGN,
+   aligned_alloc(64, ...)) keep every matrix in one cache line.
+   Large batches are split across threads. r may be a[] or b[] of
+   the pairwise batch, otherwise it must not overlap the inputs. */
+void multiply_4x4f_batch_many_one(mat4x4f_t r[], const mat4x4f_t a[], const mat4x4f_t b, int n);
+void multiply_4x4f_batch_one_many(mat4x4f_t r[], const mat4x4f_t a, const mat4x4f_t b[], int n);
+void multiply_4x4f_batch_pairwise(mat4x4f_t r[], const mat4x4f_t a[], const mat4x4f_t b[], int n);
+
+enum { /* transform_4x4f() flags */
+    TRANSFORM_POINTS     = 0, /* (x, y, z, 1) */
+    TRANSFORM_DIRECTIONS = 1, /* (x, y, z, 0), no translation */
+    TRANSFORM_NORMALS    = 2, /* inverse transpose of the upper 3x3, results are unit length (0 stays 0) */
+    TRANSFORM_DIVIDE     = 4  /* points only: divided by the transformed w */
+};
+
+/* out[i] = m * in[i] for i in [0..n), same kernels and tolerance as
+   multiply_4x4f() against transform_4x4f_scalar(). Outputs of more than
+   a few MB aligned to 64 bytes are written with streaming stores where
+   the compiler has them (__builtin_nontemporal_store), large batches are
+   split across threads. out may be in. */
+void transform_4x4f(const mat4x4f_t m, const vec3f_t* in, vec3f_t* out, int n, int flags);
+/* structure of arrays: in[axis][i], out[axis][i] */
+void transform_4x4f_soa(const mat4x4f_t m, const float* const in[3], float* const out[3], int n, int flags);
+void transform_4x4f_scalar(const mat4x4f_t m, const float in[3], float out[3], int flags); /* reference */
+
+/* camera and window, OpenGL conventions: eye space is right handed looking
+   down -z, clip space z is in [-w..w] (gluPerspective(), glOrtho(),
+   gluLookAt()), viewport_4x4f() maps normalized device coordinates to
+   window pixels and depth to [0..1] (glViewport(), glDepthRange(0, 1)).
+   fovy is the vertical field of view in radians. */
+void perspective_4x4f(mat4x4f_t m, float fovy, float aspect, float near, float far);
+void orthographic_4x4f(mat4x4f_t m, float left, float right, float bottom, float top, float near, float far);
+void look_at_4x4f(mat4x4f_t m, const vec3f_t eye, const vec3f_t center, const vec3f_t up);
+void viewport_4x4f(mat4x4f_t m, float x, float y, float w, float h);
+
+/* inverses return false and zero r when the determinant is 0 or too small
+   for its reciprocal to be finite. inverse_affine_4x4f() expects a bottom
+   row of 0, 0, 0, 1. normal_4x4f() is the inverse transpose of the upper
+   3x3 (for transform_4x4f() with TRANSFORM_DIRECTIONS), without translation. */
+int inverse_4x4f(mat4x4f_t r, const mat4x4f_t m);
+int inverse_affine_4x4f(mat4x4f_t r, const mat4x4f_t m);
+int normal_4x4f(mat4x4f_t r, const mat4x4f_t m);
+
+/* r = a * b rotates by b, then by a. slerp_quatf() takes the shorter arc
+   between unit a and b, exact to a few FLT_EPSILON without trigonometry.
+   compose_4x4f() is translation * rotation * scale, translation and scale
+   may be null, rotation need not be unit length (0 is identity). */
+void multiply_quatf(quatf_t r, const quatf_t a, const quatf_t b);
+void slerp_quatf(quatf_t r, const quatf_t a, const quatf_t b, float t);
+void axis_angle_quatf(quatf_t q, const vec3f_t axis, float angle); /* radians, right handed */
+void compose_4x4f(mat4x4f_t m, const vec3f_t translation, const quatf_t rotation, const vec3f_t scale);
+
+/* batches take an array per argument above and run an instance per lane
+   (kernels picked like multiply_4x4f()), the functions above are the
+   scalar kernel: bit identical without FMA contraction. Inverses return
+   the number of invertible matrices. Large batches are split across
+   threads, r may be an argument array but must not overlap one otherwise. */
+void perspective_4x4f_batch(mat4x4f_t r[], const float fovy[], const float aspect[],
+                            const float near[], const float far[], int n);
+void orthographic_4x4f_batch(mat4x4f_t r[], const float left[], const float right[], const float bottom[],
+                             const float top[], const float near[], const float far[], int n);
+void look_at_4x4f_batch(mat4x4f_t r[], const vec3f_t eye[], const vec3f_t center[], const vec3f_t up[], int n);
+int  inverse_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n);
+int  inverse_affine_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n);
+int  normal_4x4f_batch(mat4x4f_t r[], const mat4x4f_t m[], int n);
+void multiply_quatf_batch(quatf_t r[], const quatf_t a[], const quatf_t b[], int n);
+void slerp_quatf_batch(quatf_t r[], const quatf_t a[], const quatf_t b[], const float t[], int n);
+void compose_4x4f_batch(mat4x4f_t r[], const vec3f_t translation[], const quatf_t rotation[],
+                        const vec3f_t scale[], int n);
 
 END_C
@@ -0,0 +1,235 @@
+#pragma once
+/*
+ * C++ fixed size vectors and matrices over the arrays of math4x4.h.
+ * vec<N, T> and mat<R, C, T> are aggregates of one T array in the column
+ * major layout of vec3f_t and mat4x4f_t, so they have the same size. They
+ * are aligned to their size when that is a power of 2 up to 64 bytes
+ * (vec<4>, mat<4, 4>). They convert to T* for the C functions and are
+ * constexpr constructible from the C initializers:
+ *     constexpr mat4x4f identity = { IDENTITY_MATRIX_4x4F };
+ * Element loops are expanded at compile time from index packs.
+ * Matrix products are lazy expressions, evaluated left to right:
+ *     mat4x4f mvp = projection * view * model;       two products
+ *     vec4f v = projection * view * model * p;        two products, one matrix vector
+ *     vec4f w = apply(projection * view * model, p);  reassociated right to left,
+ *                                                     three matrix vector products
+ * apply() needs fewer multiplications, but the evaluated matrix can be
+ * reused for many vectors and its loop invariant part (projection * view)
+ * hoisted, which is faster in bench chain.
+ * Operands are held by value, so an expression outlives its operands.
+ * Sums of products run in the order of multiply_4x4f_scalar(), so float
+ * products are bit identical to it without FMA contraction.
+ * C++11, no standard library.
+ */
+#include "math4x4.h"
+
+namespace linear {
+
+template <int... I> struct indices {};
+template <int N, int... I> struct make_indices : make_indices<N - 1, N - 1, I...> {};
+template <int... I> struct make_indices<0, I...> { typedef indices<I...> type; };
+
+/* sizeof(T) * n when that is a power of 2 up to 64 bytes, otherwise alignof(T) */
+template <typename T, int N> struct alignment {
+    enum {
+        bytes = sizeof(T) * N,
+        value = (bytes & (bytes - 1)) == 0 && bytes <= 64 ? bytes : alignof(T)
+    };
+};
+
+template <int N, typename T = float> struct alignas(alignment<T, N>::value) vec {
+    typedef T type;
+    enum { size = N };
+    T e[N];
+    operator T*() { return e; }
+    constexpr operator const T*() const { return e; }
+};
+
+template <int R, int C, typename T = float> struct alignas(alignment<T, R * C>::value) mat {
+    typedef T type;
+    typedef mat matrix;
+    enum { rows = R, columns = C, size = R * C };
+    T e[R * C]; /* row i, column j at e[j * R + i] */
+    constexpr T operator()(int i, int j) const { return e[j * R + i]; }
+    T& at(int i, int j) { return e[j * R + i]; }
+    operator T*() { return e; }
+    constexpr operator const T*() const { return e; }
+};
+
+typedef vec<3, float> vec3f;
+typedef vec<4, float> vec4f;
+typedef mat<4, 4, float> mat4x4f;
+
+static_assert(sizeof(vec3f) == sizeof(vec3f_t) && sizeof(vec4f) == sizeof(vec4f_t) &&
+              sizeof(mat4x4f) == sizeof(mat4x4f_t), "layout of math4x4.h");
+
+/* copy of a C array, p needs no alignment */
+template <typename V> inline V load(const typename V::type* p) {
+    V v;
+    memcpy(v.e, p, sizeof(v.e));
+    return v;
+}
+
+/* C array seen in place, p must be aligned to alignof(V) */
+template <typename V> inline V& view(typename V::type* p) {
+    assert(((uintptr_t)p & (alignof(V) - 1)) == 0);
+    return *reinterpret_cast<V*>(p);
+}
+
+template <int N, typename T, int... I> constexpr mat<N, N, T> identity(indices<I...>) {
+    return mat<N, N, T>{{ T(I % (N + 1) == 0)... }};
+}
+
+template <int N, typename T = float> constexpr mat<N, N, T> identity() {
+    return identity<N, T>(typename make_indices<N * N>::type());
+}
+
+/* element wise, V is a vec or a mat */
+
+template <typename V, int... I> constexpr V add(const V& a, const V& b, indices<I...>) {
+    return V{{ (a.e[I] + b.e[I])... }};
+}
+
+template <typename V, int... I> constexpr V subtract(const V& a, const V& b, indices<I...>) {
+    return V{{ (a.e[I] - b.e[I])... }};
+}
+
+template <typename V, int... I> constexpr V scale(const V& a, typename V::type s, indices<I...>) {
+    return V{{ (a.e[I] * s)... }};
+}
+
+template <int N, typename T> constexpr vec<N, T> operator+(const vec<N, T>& a, const vec<N, T>& b) {
+    return add(a, b, typename make_indices<N>::type());
+}
+
+template <int N, typename T> constexpr vec<N, T> operator-(const vec<N, T>& a, const vec<N, T>& b) {
+    return subtract(a, b, typename make_indices<N>::type());
+}
+
+template <int N, typename T> constexpr vec<N, T> operator-(const vec<N, T>& a) {
+    return scale(a, T(-1), typename make_indices<N>::type());
+}
+
+template <int N, typename T> constexpr vec<N, T> operator*(const vec<N, T>& a, T s) {
+    return scale(a, s, typename make_indices<N>::type());
+}
+
+template <int N, typename T> constexpr vec<N, T> operator*(T s, const vec<N, T>& a) { return a * s; }
+
+template <int R, int C, typename T> constexpr mat<R, C, T> operator+(const mat<R, C, T>& a, const mat<R, C, T>& b) {
+    return add(a, b, typename make_indices<R * C>::type());
+}
+
+template <int R, int C, typename T> constexpr mat<R, C, T> operator-(const mat<R, C, T>& a, const mat<R, C, T>& b) {
+    return subtract(a, b, typename make_indices<R * C>::type());
+}
+
+template <int R, int C, typename T> constexpr mat<R, C, T> operator*(const mat<R, C, T>& a, T s) {
+    return scale(a, s, typename make_indices<R * C>::type());
+}
+
+/* sum over k in [0..K) of a(i, k) * b(k, j), a(i, k) * v[k] or a[k] * b[k], k ascending */
+template <int K> struct inner {
+    template <typename A, typename B> static constexpr typename A::type at(const A& a, const B& b, int i, int j) {
+        return inner<K - 1>::at(a, b, i, j) + a(i, K - 1) * b(K - 1, j);
+    }
+    template <typename A, typename V> static constexpr typename A::type apply(const A& a, const V& v, int i) {
+        return inner<K - 1>::apply(a, v, i) + a(i, K - 1) * v.e[K - 1];
+    }
+    template <typename V> static constexpr typename V::type dot(const V& a, const V& b) {
+        return inner<K - 1>::dot(a, b) + a.e[K - 1] * b.e[K - 1];
+    }
+};
+
+template <> struct inner<1> {
+    template <typename A, typename B> static constexpr typename A::type at(const A& a, const B& b, int i, int j) {
+        return a(i, 0) * b(0, j);
+    }
+    template <typename A, typename V> static constexpr typename A::type apply(const A& a, const V& v, int i) {
+        return a(i, 0) * v.e[0];
+    }
+    template <typename V> static constexpr typename V::type dot(const V& a, const V& b) { return a.e[0] * b.e[0]; }
+};
+
+template <int N, typename T> constexpr T dot(const vec<N, T>& a, const vec<N, T>& b) { return inner<N>::dot(a, b); }
+
+template <typename T> constexpr vec<3, T> cross(const vec<3, T>& a, const vec<3, T>& b) {
+    return vec<3, T>{{ a.e[1] * b.e[2] - a.e[2] * b.e[1], a.e[2] * b.e[0] - a.e[0] * b.e[2],
+                       a.e[0] * b.e[1] - a.e[1] * b.e[0] }};
+}
+
+template <int R, int C, typename T, int... I> constexpr mat<C, R, T> transpose(const mat<R, C, T>& a, indices<I...>) {
+    return mat<C, R, T>{{ a(I / C, I % C)... }};
+}
+
+template <int R, int C, typename T> constexpr mat<C, R, T> transpose(const mat<R, C, T>& a) {
+    return transpose(a, typename make_indices<R * C>::type());
+}
+
+template <int R, int K, int C, typename T, int... I>
+constexpr mat<R, C, T> multiply(const mat<R, K, T>& a, const mat<K, C, T>& b, indices<I...>) {
+    return mat<R, C, T>{{ inner<K>::at(a, b, I % R, I / R)... }};
+}
+
+template <int R, int C, typename T, int... I>
+constexpr vec<R, T> multiply(const mat<R, C, T>& a, const vec<C, T>& v, indices<I...>) {
+    return vec<R, T>{{ inner<C>::apply(a, v, I)... }};
+}
+
+/* lazy l * r of matrices or products */
+template <typename L, typename R> struct product {
+    typedef typename L::type type;
+    typedef mat<L::matrix::rows, R::matrix::columns, type> matrix;
+    static_assert(int(L::matrix::columns) == int(R::matrix::rows), "shapes");
+    L l;
+    R r;
+    constexpr operator matrix() const { return evaluate(*this); }
+};
+
+template <int R, int C, typename T> constexpr const mat<R, C, T>& evaluate(const mat<R, C, T>& m) { return m; }
+
+template <typename L, typename R> constexpr typename product<L, R>::matrix evaluate(const product<L, R>& p) {
+    return multiply(evaluate(p.l), evaluate(p.r), typename make_indices<product<L, R>::matrix::size>::type());
+}
+
+template <int R, int K, int C, typename T>
+constexpr product<mat<R, K, T>, mat<K, C, T>> operator*(const mat<R, K, T>& a, const mat<K, C, T>& b) {
+    return product<mat<R, K, T>, mat<K, C, T>>{ a, b };
+}
+
+template <typename L, typename R, int K, int C, typename T>
+constexpr product<product<L, R>, mat<K, C, T>> operator*(const product<L, R>& a, const mat<K, C, T>& b) {
+    return product<product<L, R>, mat<K, C, T>>{ a, b };
+}
+
+template <int R, int K, typename T, typename L, typename M>
+constexpr product<mat<R, K, T>, product<L, M>> operator*(const mat<R, K, T>& a, const product<L, M>& b) {
+    return product<mat<R, K, T>, product<L, M>>{ a, b };
+}
+
+template <typename L, typename R, typename M, typename N>
+constexpr product<product<L, R>, product<M, N>> operator*(const product<L, R>& a, const product<M, N>& b) {
+    return product<product<L, R>, product<M, N>>{ a, b };
+}
+
+template <int R, int C, typename T> constexpr vec<R, T> operator*(const mat<R, C, T>& a, const vec<C, T>& v) {
+    return multiply(a, v, typename make_indices<R>::type());
+}
+
+/* (l * r) * v with l * r evaluated first */
+template <typename L, typename R, int N, typename T>
+constexpr vec<product<L, R>::matrix::rows, T> operator*(const product<L, R>& p, const vec<N, T>& v) {
+    return evaluate(p) * v;
+}
+
+/* (l * r) * v reassociated to l * (r * v), matrix vector products only */
+template <int R, int C, typename T> constexpr vec<R, T> apply(const mat<R, C, T>& a, const vec<C, T>& v) {
+    return a * v;
+}
+
+template <typename L, typename R, int N, typename T>
+constexpr vec<product<L, R>::matrix::rows, T> apply(const product<L, R>& p, const vec<N, T>& v) {
+    return apply(p.l, apply(p.r, v));
+}
+
+} // namespace linear
@@ -0,0 +1,508 @@
+/* 4x4 matrix product and transform kernels of math4x4.c included once per instruction set with:
+       ISA     name suffix
+       W       lanes, 4, 8 or 16: a vector holds W / 4 columns of the result
+               or one coordinate of W points
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+   Column major r = a * b: r[c * 4 + j] = sum of a[k * 4 + j] * b[c * 4 + k]
+   over k, so every vector of r is the sum of 4 columns of a repeated W / 4
+   times, each scaled by lanes of b broadcast per column. The vectors that
+   depend on a matrix shared by the whole batch are built once.
+   Transforms take W points at a time as x, y, z vectors, interleaved
+   points go 4 at a time as 3 vectors (W == 4 only).
+   Instance kernels put one instance (camera, matrix, quaternion) per lane.
+   They are the only ones instantiated with W == 1, VF float, VI int32_t:
+   that is the scalar reference. */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(load)(const float* p) { VF r; memcpy(&r, p, sizeof(r)); return r; }
+
+static TARGET inline void FN(store)(float* p, VF v) { memcpy(p, &v, sizeof(v)); }
+
+#if W > 1
+
+/* columns of a, repeated W / 4 times */
+static TARGET inline void FN(columns)(VF c[4], const float* a) {
+    for (int k = 0; k < 4; k++) {
+        for (int i = 0; i < W; i++) { c[k][i] = a[k * 4 + i % 4]; }
+    }
+}
+
+/* b[c * 4 + k] broadcast to the lanes of column c in vector v */
+static TARGET inline VF FN(scale)(const float* b, int v, int k) {
+    VF s;
+    for (int c = 0; c < W / 4; c++) {
+        const float x = b[(v * W / 4 + c) * 4 + k];
+        for (int i = 0; i < 4; i++) { s[c * 4 + i] = x; }
+    }
+    return s;
+}
+
+static TARGET inline void FN(scales)(VF s[16 / W][4], const float* b) {
+    for (int v = 0; v < 16 / W; v++) {
+        s[v][0] = FN(scale)(b, v, 0);
+        s[v][1] = FN(scale)(b, v, 1);
+        s[v][2] = FN(scale)(b, v, 2);
+        s[v][3] = FN(scale)(b, v, 3);
+    }
+}
+
+static TARGET inline void FN(product)(float* r, const VF c[4], VF s[16 / W][4]) {
+    VF p[16 / W];
+    for (int v = 0; v < 16 / W; v++) { p[v] = c[0] * s[v][0] + c[1] * s[v][1] + c[2] * s[v][2] + c[3] * s[v][3]; }
+    for (int v = 0; v < 16 / W; v++) { FN(store)(r + v * W, p[v]); }
+}
+
+/* r[i] = a[i * as] * b[i * bs] for i in [0..n), as and bs are 0 or 1 */
+static TARGET void FN(multiply)(mat4x4f_t r[], const mat4x4f_t a[], int as, const mat4x4f_t b[], int bs, int n) {
+    VF c[4], s[16 / W][4];
+    if (as == 0 && bs == 0) {
+        FN(columns)(c, a[0]);
+        FN(scales)(s, b[0]);
+        for (int i = 0; i < n; i++) { FN(product)(r[i], c, s); }
+    } else if (as == 0) {
+        FN(columns)(c, a[0]);
+        for (int i = 0; i < n; i++) {
+            FN(scales)(s, b[i]);
+            FN(product)(r[i], c, s);
+        }
+    } else if (bs == 0) {
+        FN(scales)(s, b[0]);
+        for (int i = 0; i < n; i++) {
+            FN(columns)(c, a[i]);
+            FN(product)(r[i], c, s);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            FN(columns)(c, a[i]);
+            FN(scales)(s, b[i]);
+            FN(product)(r[i], c, s);
+        }
+    }
+}
+
+#endif
+
+#if W == 1
+
+static inline VF FN(splat)(float s) { return s; }
+
+static inline VF FN(select)(VI m, VF a, VF b) { return m ? a : b; }
+
+static inline VF FN(sqrt)(VF a) { return sqrtf(a); }
+
+static inline VF FN(tan)(VF a) { return tanf(a); }
+
+#else
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+static TARGET inline VF FN(select)(VI m, VF a, VF b) { return (VF)(((VI)a & m) | ((VI)b & ~m)); }
+
+static TARGET inline VF FN(sqrt)(VF a) {
+    VF r = a;
+    for (int i = 0; i < W; i++) { r[i] = sqrtf(a[i]); }
+    return r;
+}
+
+static TARGET inline VF FN(tan)(VF a) {
+    VF r = a;
+    for (int i = 0; i < W; i++) { r[i] = tanf(a[i]); }
+    return r;
+}
+
+#endif
+
+#if W > 1
+
+/* stream: p is aligned to sizeof(VF) and the line is not read back soon */
+static TARGET inline void FN(put)(float* p, VF v, int stream) {
+#ifdef SIMD_NONTEMPORAL
+    if (stream) {
+        PASTE(simd_stream, W)(p, v);
+        return;
+    }
+#endif
+    (void)stream;
+    FN(store)(p, v);
+}
+
+/* e broadcast once per batch: outputs may alias e as far as the compiler knows */
+static TARGET inline void FN(splats)(VF m[16], const float e[16]) {
+    for (int i = 0; i < 16; i++) { m[i] = FN(splat)(e[i]); }
+}
+
+/* v = m * (x, y, z, 1) in the order of operations of transform_4x4f_scalar() */
+static TARGET inline void FN(transform)(const VF m[16], int divide, int normalize, VF v[3]) {
+    VF r[3];
+    for (int k = 0; k < 3; k++) { r[k] = m[k] * v[0] + m[4 + k] * v[1] + m[8 + k] * v[2] + m[12 + k]; }
+    if (divide) {
+        const VF w = m[3] * v[0] + m[7] * v[1] + m[11] * v[2] + m[15];
+        for (int k = 0; k < 3; k++) { r[k] = r[k] / w; }
+    }
+    if (normalize) {
+        const VF l2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        const VF s = FN(splat)(1) / FN(sqrt)(l2);
+        const VI nonzero = l2 > FN(splat)(0);
+        for (int k = 0; k < 3; k++) { r[k] = FN(select)(nonzero, r[k] * s, r[k]); }
+    }
+    for (int k = 0; k < 3; k++) { v[k] = r[k]; }
+}
+
+/* n points, a multiple of W */
+static TARGET void FN(transform_soa)(const float e[16], int divide, int normalize,
+                                     const float* const in[3], float* const out[3], int n, int stream) {
+    VF m[16];
+    FN(splats)(m, e);
+    for (int i = 0; i < n; i += W) {
+        VF v[3] = { FN(load)(in[0] + i), FN(load)(in[1] + i), FN(load)(in[2] + i) };
+        FN(transform)(m, divide, normalize, v);
+        for (int k = 0; k < 3; k++) { FN(put)(out[k] + i, v[k], stream); }
+    }
+}
+
+#if W == 4
+
+/* n points, a multiple of 4: 4 interleaved points are 3 vectors, shuffled
+   to x, y, z vectors and back (3x4 transpose) */
+static TARGET void FN(transform_aos)(const float e[16], int divide, int normalize,
+                                     const vec3f_t* in, vec3f_t* out, int n, int stream) {
+    VF m[16];
+    FN(splats)(m, e);
+    for (int i = 0; i < n; i += 4) {
+        const VF a = FN(load)(in[i]), b = FN(load)(in[i] + 4), c = FN(load)(in[i] + 8);
+        VF v[3] = {
+            __builtin_shufflevector(__builtin_shufflevector(a, b, 0, 3, 6, 6), c, 0, 1, 2, 5),
+            __builtin_shufflevector(__builtin_shufflevector(a, b, 1, 4, 7, 7), c, 0, 1, 2, 6),
+            __builtin_shufflevector(__builtin_shufflevector(a, b, 2, 5, 5, 5), c, 0, 1, 4, 7)
+        };
+        FN(transform)(m, divide, normalize, v);
+        const VF xy0 = __builtin_shufflevector(v[0], v[1], 0, 4, 1, 5); // x0 y0 x1 y1
+        const VF xy1 = __builtin_shufflevector(v[0], v[1], 2, 5, 6, 6); // x2 y1 y2 y2
+        const VF xy2 = __builtin_shufflevector(v[0], v[1], 3, 7, 3, 7); // x3 y3 x3 y3
+        FN(put)(out[i], __builtin_shufflevector(xy0, v[2], 0, 1, 4, 2), stream);
+        FN(put)(out[i] + 4, __builtin_shufflevector(xy1, v[2], 1, 5, 0, 2), stream);
+        FN(put)(out[i] + 8, __builtin_shufflevector(xy2, v[2], 6, 0, 1, 7), stream);
+    }
+}
+
+#endif
+
+#endif
+
+static TARGET inline VI FN(all)(void) { const VI z = {0}; return z - 1; }
+
+static TARGET inline int FN(count)(VI m, int lanes) {
+#if W == 1
+    (void)lanes;
+    return m != 0;
+#else
+    int n = 0;
+    for (int l = 0; l < lanes; l++) { n += m[l] != 0; }
+    return n;
+#endif
+}
+
+#if W > 1
+
+/* 4x4 block of floats from rows p, p + stride, ... to columns r[0..3] */
+static TARGET inline void FN(transpose4)(f32x4 r[4], const float* p, int stride) {
+    f32x4 a, b, c, d;
+    memcpy(&a, p, sizeof(a));
+    memcpy(&b, p + stride, sizeof(b));
+    memcpy(&c, p + 2 * stride, sizeof(c));
+    memcpy(&d, p + 3 * stride, sizeof(d));
+    const f32x4 ab0 = __builtin_shufflevector(a, b, 0, 4, 1, 5), ab1 = __builtin_shufflevector(a, b, 2, 6, 3, 7);
+    const f32x4 cd0 = __builtin_shufflevector(c, d, 0, 4, 1, 5), cd1 = __builtin_shufflevector(c, d, 2, 6, 3, 7);
+    r[0] = __builtin_shufflevector(ab0, cd0, 0, 1, 4, 5);
+    r[1] = __builtin_shufflevector(ab0, cd0, 2, 3, 6, 7);
+    r[2] = __builtin_shufflevector(ab1, cd1, 0, 1, 4, 5);
+    r[3] = __builtin_shufflevector(ab1, cd1, 2, 3, 6, 7);
+}
+
+#endif
+
+/* lane l of v[c] = p[l * stride + c] for c in [0..count), lanes past the
+   last instance are 0. Whole vectors of 4 float arguments go through 4x4
+   transposes, the rest float by float */
+static TARGET inline void FN(gather)(VF* v, const float* p, int stride, int count, int lanes) {
+#if W == 1
+    (void)stride;
+    (void)lanes;
+    for (int c = 0; c < count; c++) { v[c] = p[c]; }
+#else
+    float t[16][W];
+    int c = 0;
+    if (lanes == W && stride == count) {
+        for (; c + 4 <= count; c += 4) {
+            for (int l = 0; l < W; l += 4) {
+                f32x4 r[4];
+                FN(transpose4)(r, p + l * stride + c, stride);
+                for (int k = 0; k < 4; k++) { memcpy(&t[c + k][l], &r[k], sizeof(r[k])); }
+            }
+        }
+    } else {
+        memset(t, 0, sizeof(t));
+    }
+    for (int l = 0; l < lanes; l++) {
+        for (int k = c; k < count; k++) { t[k][l] = p[l * stride + k]; }
+    }
+    for (int k = 0; k < count; k++) { v[k] = FN(load)(t[k]); }
+#endif
+}
+
+static TARGET inline void FN(scatter)(float* p, const VF* v, int count, int lanes) {
+#if W == 1
+    (void)lanes;
+    for (int c = 0; c < count; c++) { p[c] = v[c]; }
+#else
+    float t[16][W];
+    for (int c = 0; c < count; c++) { FN(store)(t[c], v[c]); }
+    if (lanes == W && count % 4 == 0) {
+        for (int c = 0; c < count; c += 4) {
+            for (int l = 0; l < W; l += 4) {
+                f32x4 r[4];
+                FN(transpose4)(r, &t[c][l], W);
+                for (int k = 0; k < 4; k++) { memcpy(p + (l + k) * count + c, &r[k], sizeof(r[k])); }
+            }
+        }
+    } else {
+        for (int l = 0; l < lanes; l++) {
+            for (int c = 0; c < count; c++) { p[l * count + c] = t[c][l]; }
+        }
+    }
+#endif
+}
+
+static TARGET inline VF FN(dot)(const VF* a, const VF* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static TARGET inline void FN(cross)(const VF* a, const VF* b, VF* r) {
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static TARGET inline void FN(normalize)(VF* v) { /* 0 stays 0 */
+    const VF l2 = FN(dot)(v, v);
+    const VF s = 1.0f / FN(sqrt)(l2);
+    for (int k = 0; k < 3; k++) { v[k] = FN(select)(l2 > 0.0f, v[k] * s, v[k]); }
+}
+
+/* zero y[0..n) of lanes where 1 / det is not finite */
+static TARGET inline VI FN(invertible)(VF inv, VF* y, int n) {
+    const VI ok = inv - inv == 0.0f;
+    for (int i = 0; i < n; i++) { y[i] = FN(select)(ok, y[i], FN(splat)(0)); }
+    return ok;
+}
+
+/* x: fovy, aspect, near, far */
+static TARGET inline VI FN(perspective)(const VF* x, VF* y) {
+    const VF f = 1.0f / FN(tan)(x[0] * 0.5f), near = x[2], far = x[3], depth = 1.0f / (near - far);
+    for (int i = 0; i < 16; i++) { y[i] = FN(splat)(0); }
+    y[0] = f / x[1];
+    y[5] = f;
+    y[10] = (far + near) * depth;
+    y[11] = FN(splat)(-1);
+    y[14] = 2.0f * far * near * depth;
+    return FN(all)();
+}
+
+/* x: left, right, bottom, top, near, far */
+static TARGET inline VI FN(orthographic)(const VF* x, VF* y) {
+    const VF ix = 1.0f / (x[1] - x[0]), iy = 1.0f / (x[3] - x[2]), iz = 1.0f / (x[5] - x[4]);
+    for (int i = 0; i < 16; i++) { y[i] = FN(splat)(0); }
+    y[0] = 2.0f * ix;
+    y[5] = 2.0f * iy;
+    y[10] = -2.0f * iz;
+    y[12] = -(x[1] + x[0]) * ix;
+    y[13] = -(x[3] + x[2]) * iy;
+    y[14] = -(x[5] + x[4]) * iz;
+    y[15] = FN(splat)(1);
+    return FN(all)();
+}
+
+/* x: eye, center, up. Rows are side, up and back, translation moves eye to 0 */
+static TARGET inline VI FN(look_at)(const VF* x, VF* y) {
+    const VF* eye = x;
+    VF f[3] = { x[3] - eye[0], x[4] - eye[1], x[5] - eye[2] }, s[3], u[3];
+    FN(normalize)(f);
+    FN(cross)(f, x + 6, s);
+    FN(normalize)(s);
+    FN(cross)(s, f, u);
+    for (int k = 0; k < 3; k++) {
+        y[k * 4 + 0] = s[k];
+        y[k * 4 + 1] = u[k];
+        y[k * 4 + 2] = -f[k];
+        y[k * 4 + 3] = FN(splat)(0);
+    }
+    y[12] = -FN(dot)(s, eye);
+    y[13] = -FN(dot)(u, eye);
+    y[14] = FN(dot)(f, eye);
+    y[15] = FN(splat)(1);
+    return FN(all)();
+}
+
+/* 2x2 minors of the first and last two rows (Laplace expansion),
+   the same for the transpose: a is read as a[row * 4 + column] */
+static TARGET inline VI FN(inverse)(const VF* a, VF* y) {
+    const VF s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[6] - a[4] * a[2], s2 = a[0] * a[7] - a[4] * a[3];
+    const VF s3 = a[1] * a[6] - a[5] * a[2], s4 = a[1] * a[7] - a[5] * a[3], s5 = a[2] * a[7] - a[6] * a[3];
+    const VF c5 = a[10] * a[15] - a[14] * a[11], c4 = a[9] * a[15] - a[13] * a[11];
+    const VF c3 = a[9] * a[14] - a[13] * a[10], c2 = a[8] * a[15] - a[12] * a[11];
+    const VF c1 = a[8] * a[14] - a[12] * a[10], c0 = a[8] * a[13] - a[12] * a[9];
+    const VF inv = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+    y[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * inv;
+    y[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * inv;
+    y[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+    y[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * inv;
+    y[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * inv;
+    y[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * inv;
+    y[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+    y[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * inv;
+    y[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * inv;
+    y[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * inv;
+    y[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+    y[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * inv;
+    y[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * inv;
+    y[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * inv;
+    y[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+    y[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * inv;
+    return FN(invertible)(inv, y, 16);
+}
+
+/* cross products of the columns of the upper 3x3 of m: row i of its inverse is r[i] / determinant */
+static TARGET inline VF FN(cofactors)(const VF* m, VF r[3][3]) {
+    FN(cross)(m + 4, m + 8, r[0]);
+    FN(cross)(m + 8, m, r[1]);
+    FN(cross)(m, m + 4, r[2]);
+    return FN(dot)(m, r[0]);
+}
+
+static TARGET inline VI FN(inverse_affine)(const VF* m, VF* y) {
+    VF r[3][3];
+    const VF inv = 1.0f / FN(cofactors)(m, r);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) { y[j * 4 + i] = r[i][j] * inv; }
+        y[i * 4 + 3] = FN(splat)(0);
+    }
+    for (int i = 0; i < 3; i++) { y[12 + i] = -(y[i] * m[12] + y[4 + i] * m[13] + y[8 + i] * m[14]); }
+    y[15] = FN(splat)(1);
+    return FN(invertible)(inv, y, 16);
+}
+
+static TARGET inline VI FN(normal)(const VF* m, VF* y) {
+    VF r[3][3];
+    const VF inv = 1.0f / FN(cofactors)(m, r);
+    for (int j = 0; j < 3; j++) {
+        for (int i = 0; i < 3; i++) { y[j * 4 + i] = r[j][i] * inv; }
+        y[j * 4 + 3] = FN(splat)(0);
+    }
+    for (int i = 12; i < 15; i++) { y[i] = FN(splat)(0); }
+    y[15] = FN(splat)(1);
+    return FN(invertible)(inv, y, 16);
+}
+
+/* x: a, b */
+static TARGET inline VI FN(multiply_quat)(const VF* x, VF* y) {
+    const VF* a = x;
+    const VF* b = x + 4;
+    y[0] = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+    y[1] = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+    y[2] = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+    y[3] = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+    return FN(all)();
+}
+
+/* sin(t * angle) / sin(angle) from c = cos(angle): series in t^2 and c - 1 */
+static TARGET inline VF FN(slerp_weight)(VF t, VF c) {
+    const VF t2 = t * t, c1 = c - 1.0f;
+    VF b = FN(splat)(1);
+    for (int i = SLERP_TERMS - 1; i >= 0; i--) { b = 1.0f + (slerp_u[i] * t2 - slerp_v[i]) * c1 * b; }
+    return t * b;
+}
+
+/* x: a, b, t. The arc is split at the unit midpoint m of a and b, each
+   half is at most 45 degrees where the series converges fast */
+static TARGET inline VI FN(slerp)(const VF* x, VF* y) {
+    const VF* a = x;
+    const VF t = x[8];
+    const VI flip = a[0] * x[4] + a[1] * x[5] + a[2] * x[6] + a[3] * x[7] < 0.0f;
+    VF b[4], m[4];
+    for (int k = 0; k < 4; k++) {
+        b[k] = FN(select)(flip, -x[4 + k], x[4 + k]);
+        m[k] = a[k] + b[k];
+    }
+    const VF l = FN(sqrt)(m[0] * m[0] + m[1] * m[1] + m[2] * m[2] + m[3] * m[3]);
+    for (int k = 0; k < 4; k++) { m[k] = m[k] / l; }
+    const VF c = l * 0.5f; // cosine of the half angle
+    const VI second = t >= 0.5f;
+    const VF s = FN(select)(second, t * 2.0f - 1.0f, t * 2.0f);
+    const VF wp = FN(slerp_weight)(1.0f - s, c), wq = FN(slerp_weight)(s, c);
+    for (int k = 0; k < 4; k++) {
+        y[k] = wp * FN(select)(second, m[k], a[k]) + wq * FN(select)(second, b[k], m[k]);
+    }
+    return FN(all)();
+}
+
+/* x: rotation, translation, scale */
+static TARGET inline VI FN(compose)(const VF* x, VF* y) {
+    const VF* q = x;
+    const VF* s = x + 7;
+    const VF n = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+    const VF k = FN(select)(n > 0.0f, 2.0f / n, FN(splat)(0));
+    const VF xx = q[0] * q[0] * k, yy = q[1] * q[1] * k, zz = q[2] * q[2] * k;
+    const VF xy = q[0] * q[1] * k, xz = q[0] * q[2] * k, yz = q[1] * q[2] * k;
+    const VF wx = q[3] * q[0] * k, wy = q[3] * q[1] * k, wz = q[3] * q[2] * k;
+    y[0] = (1.0f - (yy + zz)) * s[0];
+    y[1] = (xy + wz) * s[0];
+    y[2] = (xz - wy) * s[0];
+    y[4] = (xy - wz) * s[1];
+    y[5] = (1.0f - (xx + zz)) * s[1];
+    y[6] = (yz + wx) * s[1];
+    y[8] = (xz + wy) * s[2];
+    y[9] = (yz - wx) * s[2];
+    y[10] = (1.0f - (xx + yy)) * s[2];
+    y[3] = y[7] = y[11] = FN(splat)(0);
+    for (int i = 0; i < 3; i++) { y[12 + i] = x[4 + i]; }
+    y[15] = FN(splat)(1);
+    return FN(all)();
+}
+
+/* instances [from..to) of b W at a time, returns the number of them that succeeded */
+static TARGET int FN(instances)(const instances_t* b, int from, int to) {
+    int ok = 0;
+    VF x[16], y[16];
+    memset(x, 0, sizeof(x)); // arguments are gathered in a loop the compiler cannot count
+    for (int i = from; i < to; i += W) {
+        const int lanes = minimum(W, to - i);
+        for (int a = 0, c = 0; a < b->arguments; c += b->count[a], a++) {
+            FN(gather)(x + c, b->in[a] + (size_t)i * b->stride[a], b->stride[a], b->count[a], lanes);
+        }
+        VI m;
+        switch (b->op) {
+            case OP_PERSPECTIVE:    m = FN(perspective)(x, y); break;
+            case OP_ORTHOGRAPHIC:   m = FN(orthographic)(x, y); break;
+            case OP_LOOK_AT:        m = FN(look_at)(x, y); break;
+            case OP_INVERSE:        m = FN(inverse)(x, y); break;
+            case OP_INVERSE_AFFINE: m = FN(inverse_affine)(x, y); break;
+            case OP_NORMAL:         m = FN(normal)(x, y); break;
+            case OP_MULTIPLY_QUAT:  m = FN(multiply_quat)(x, y); break;
+            case OP_SLERP:          m = FN(slerp)(x, y); break;
+            default:                m = FN(compose)(x, y); break;
+        }
+        FN(scatter)(b->r + (size_t)i * b->results, y, b->results, lanes);
+        ok += FN(count)(m, lanes);
+    }
+    return ok;
+}
+
+#undef PASTE_
+#undef PASTE
+#undef FN
@@ -0,0 +1,23 @@
+#pragma once
+#include "std.h"
+#include "math4x4.h"
+
+/* indexed triangle mesh, a view of caller owned arrays */
+
+BEGIN_C
+
+typedef struct mesh_s {
+    const vec3f_t* vertices;
+    const int32_t* indices; /* 3 per triangle */
+    int vertex_count;
+    int triangle_count;
+} mesh_t;
+
+static inline void mesh_triangle(const mesh_t* m, int i, const float* v[3]) {
+    const int32_t* ix = m->indices + i * 3;
+    v[0] = m->vertices[ix[0]];
+    v[1] = m->vertices[ix[1]];
+    v[2] = m->vertices[ix[2]];
+}
+
+END_C
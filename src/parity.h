@@ -0,0 +1,41 @@
+#pragma once
+#include "std.h"
+
+/* inside/outside parity of rows along x, shared by voxels.c and sdf.c */
+
+BEGIN_C
+
+/* x where the line along x through (py, pz) crosses triangle v, false if it
+   misses or v is parallel to it. Edge functions in double are exact for
+   practical coordinates, ties go to top-left edges: a line through an edge
+   shared by two triangles crosses exactly one of them */
+static inline int parity_crossing(const float v[3][3], double py, double pz, double* x) {
+    const double area = ((double)v[1][1] - v[0][1]) * ((double)v[2][2] - v[0][2]) -
+                        ((double)v[1][2] - v[0][2]) * ((double)v[2][1] - v[0][1]);
+    if (area == 0) { return false; }
+    const double s = area > 0 ? 1 : -1;
+    double w[3];
+    for (int i = 0; i < 3; i++) {
+        const float* a = v[i];
+        const float* b = v[(i + 1) % 3];
+        const double ey = s * ((double)b[1] - a[1]), ez = s * ((double)b[2] - a[2]);
+        const double e = ey * (pz - a[2]) - ez * (py - a[1]);
+        if (e < 0 || (e == 0 && !(ez < 0 || (ez == 0 && ey > 0)))) { return false; }
+        w[(i + 2) % 3] = e; // weight of the vertex opposite to the edge
+    }
+    *x = (w[0] * v[0][0] + w[1] * v[1][0] + w[2] * v[2][0]) / (w[0] + w[1] + w[2]);
+    return true;
+}
+
+/* bit i = xor of bits [0..i] of t */
+static inline uint64_t parity_prefix(uint64_t t) {
+    t ^= t << 1;
+    t ^= t << 2;
+    t ^= t << 4;
+    t ^= t << 8;
+    t ^= t << 16;
+    t ^= t << 32;
+    return t;
+}
+
+END_C
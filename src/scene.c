@@ -0,0 +1,321 @@
+#include "scene.h"
+#include "threads.h"
+
+BEGIN_C
+
+/* Breadth first slots make the descendants of a dirty node d levels
+   below it one slot range: children of [b..e) are [first[b]..first[e]).
+   scene_update() starts at the depth of the first dirty slot with the
+   ranges of that depth, merges in the dirty slots of the next depth and
+   coalesces adjacent ranges, so a node is computed once however many of
+   its ancestors changed. Depths are computed one after another, slots of
+   a depth are split across threads in GRAIN chunks. Runs of siblings go to
+   multiply_4x4f_batch_one_many() with the world of their parent. */
+
+enum {
+    GRAIN = 1024 /* nodes per parallel_for() body call, well below batch threading */
+};
+
+typedef struct scene_work_s {
+    int32_t* list;      /* dirty slots, each once */
+    int listed;
+    int32_t* ranges[2]; /* [begin, end) pairs of the previous and current depth */
+    int32_t* offset;    /* nodes of current depth before range r */
+    mat4x4f_t* spare;   /* capacity matrices, layout() permutes local and world through it */
+} scene_work_t;
+
+typedef struct update_s {
+    scene_t* s;
+    const int32_t* range;
+    const int32_t* offset;
+    int n;
+} update_t;
+
+static int grow(scene_t* s, int capacity) {
+    scene_work_t* w = s->work;
+    const size_t n = (size_t)capacity;
+    int ok = true;
+    int32_t** ints[] = { &s->parent, &s->first, &s->level, &s->id, &s->slot,
+                         &w->list, &w->ranges[0], &w->ranges[1], &w->offset };
+    const size_t counts[] = { n, n + 1, n + 1, n, n, n, 2 * n, 2 * n, n };
+    for (int i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); i++) {
+        int32_t* a = (int32_t*)realloc(*ints[i], sizeof(int32_t) * counts[i]);
+        if (a != null) { *ints[i] = a; } else { ok = false; }
+    }
+    uint8_t* dirty = (uint8_t*)realloc(s->dirty, n);
+    if (dirty != null) { s->dirty = dirty; } else { ok = false; }
+    mat4x4f_t* local = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+    mat4x4f_t* world = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+    mat4x4f_t* spare = (mat4x4f_t*)aligned_alloc(64, sizeof(mat4x4f_t) * n);
+    if (!ok || local == null || world == null || spare == null) {
+        free(local);
+        free(world);
+        free(spare);
+        return false;
+    }
+    if (s->count > 0) {
+        memcpy(local, s->local, sizeof(mat4x4f_t) * (size_t)s->count);
+        memcpy(world, s->world, sizeof(mat4x4f_t) * (size_t)s->count);
+    }
+    free(s->local);
+    free(s->world);
+    free(w->spare);
+    s->local = local;
+    s->world = world;
+    w->spare = spare;
+    s->capacity = capacity;
+    return true;
+}
+
+scene_t* scene_create(int capacity) {
+    scene_t* s = (scene_t*)calloc(1, sizeof(scene_t));
+    if (s != null) {
+        s->work = (scene_work_t*)calloc(1, sizeof(scene_work_t));
+        if (s->work == null || !grow(s, maximum(16, capacity))) {
+            scene_destroy(s);
+            return null;
+        }
+        s->sorted = true;
+        s->first[0] = 0;
+        s->level[0] = 0;
+    }
+    return s;
+}
+
+void scene_destroy(scene_t* s) {
+    if (s != null) {
+        if (s->work != null) {
+            free(s->work->list);
+            free(s->work->ranges[0]);
+            free(s->work->ranges[1]);
+            free(s->work->offset);
+            free(s->work->spare);
+            free(s->work);
+        }
+        free(s->parent);
+        free(s->first);
+        free(s->level);
+        free(s->id);
+        free(s->slot);
+        free(s->dirty);
+        free(s->local);
+        free(s->world);
+        free(s);
+    }
+}
+
+static void touch(scene_t* s, int k) {
+    if (!s->dirty[k]) {
+        s->dirty[k] = true;
+        s->work->list[s->work->listed++] = k;
+    }
+}
+
+int scene_add(scene_t* s, int parent, const mat4x4f_t local) {
+    assert(-1 <= parent && parent < s->count);
+    if (s->count == s->capacity && !grow(s, s->capacity * 2)) { return -1; }
+    const int k = s->count++;
+    s->id[k] = k; // next id in the next slot
+    s->slot[k] = k;
+    s->parent[k] = parent < 0 ? -1 : s->slot[parent];
+    memcpy(s->local[k], local != null ? local : identity_4x4f, sizeof(mat4x4f_t));
+    s->dirty[k] = false;
+    touch(s, k);
+    s->sorted = false;
+    return k;
+}
+
+void scene_set_local(scene_t* s, int node, const mat4x4f_t local) {
+    assert(0 <= node && node < s->count);
+    const int k = s->slot[node];
+    memcpy(s->local[k], local, sizeof(mat4x4f_t));
+    touch(s, k);
+}
+
+int scene_set_parent(scene_t* s, int node, int parent) {
+    assert(0 <= node && node < s->count && -1 <= parent && parent < s->count);
+    const int k = s->slot[node];
+    for (int a = parent < 0 ? -1 : s->slot[parent]; a >= 0; a = s->parent[a]) {
+        if (a == k) { return false; }
+    }
+    s->parent[k] = parent < 0 ? -1 : s->slot[parent];
+    touch(s, k);
+    s->sorted = false;
+    return true;
+}
+
+/* breadth first slots: order[new] = old, roots and children keep their slot order */
+static int layout(scene_t* s) {
+    const int n = s->count;
+    const size_t bytes = sizeof(int32_t) * (size_t)maximum(1, n);
+    int32_t* children = (int32_t*)calloc((size_t)n + 1, sizeof(int32_t)); // start of children of old slot
+    int32_t* kids = (int32_t*)malloc(bytes);
+    int32_t* order = (int32_t*)malloc(bytes);
+    int32_t* remap = (int32_t*)malloc(bytes); // new slot of old slot
+    uint8_t* dirty = (uint8_t*)malloc((size_t)maximum(1, n));
+    const int ok = children != null && kids != null && order != null && remap != null && dirty != null;
+    if (ok) {
+        int roots = 0;
+        for (int i = 0; i < n; i++) {
+            if (s->parent[i] < 0) { order[roots++] = i; } else { children[s->parent[i] + 1]++; }
+        }
+        for (int i = 0; i < n; i++) { children[i + 1] += children[i]; }
+        for (int i = 0; i < n; i++) {
+            if (s->parent[i] >= 0) { kids[children[s->parent[i]]++] = i; }
+        }
+        for (int i = n; i > 0; i--) { children[i] = children[i - 1]; } // back to starts
+        children[0] = 0;
+        int tail = roots;
+        s->depths = 0;
+        s->level[0] = 0;
+        for (int head = 0; head < n; ) { // one depth per iteration
+            const int end = tail;
+            for (; head < end; head++) {
+                for (int c = children[order[head]]; c < children[order[head] + 1]; c++) { order[tail++] = kids[c]; }
+            }
+            s->level[++s->depths] = end;
+        }
+        assert(tail == n); // every node reachable: parents are never descendants
+        for (int i = 0; i < n; i++) { remap[order[i]] = i; }
+        s->first[0] = roots;
+        for (int i = 0; i < n; i++) {
+            const int o = order[i];
+            s->first[i + 1] = s->first[i] + children[o + 1] - children[o];
+            kids[i] = s->parent[o] < 0 ? -1 : remap[s->parent[o]]; // kids reused for the new parents
+            dirty[i] = s->dirty[o];
+        }
+        scene_work_t* w = s->work;
+        mat4x4f_t** matrices[] = { &s->local, &s->world };
+        for (int m = 0; m < 2; m++) {
+            mat4x4f_t* a = *matrices[m];
+            for (int i = 0; i < n; i++) { memcpy(w->spare[i], a[order[i]], sizeof(mat4x4f_t)); }
+            *matrices[m] = w->spare;
+            w->spare = a;
+        }
+        memcpy(s->parent, kids, sizeof(int32_t) * (size_t)n);
+        memcpy(s->dirty, dirty, (size_t)n);
+        for (int i = 0; i < n; i++) { kids[i] = s->id[order[i]]; }
+        memcpy(s->id, kids, sizeof(int32_t) * (size_t)n);
+        for (int i = 0; i < n; i++) { s->slot[s->id[i]] = i; }
+        w->listed = 0;
+        for (int i = 0; i < n; i++) {
+            if (s->dirty[i]) { w->list[w->listed++] = i; }
+        }
+        s->sorted = true;
+    }
+    free(children);
+    free(kids);
+    free(order);
+    free(remap);
+    free(dirty);
+    return ok;
+}
+
+/* world of slots [b..e), all of one depth */
+static void compute(scene_t* s, int b, int e) {
+    while (b < e) {
+        const int p = s->parent[b];
+        int k = b + 1;
+        while (k < e && s->parent[k] == p) { k++; }
+        if (p < 0) {
+            memcpy(s->world[b], s->local[b], sizeof(mat4x4f_t) * (size_t)(k - b));
+        } else if (k - b == 1) {
+            multiply_4x4f(s->world[b], s->world[p], s->local[b]);
+        } else {
+            multiply_4x4f_batch_one_many(s->world + b, s->world[p], s->local + b, k - b);
+        }
+        b = k;
+    }
+}
+
+static void update_body(void* that, int i, int j) {
+    const update_t* u = (const update_t*)that;
+    int r = 0, hi = u->n - 1; // last range with offset[r] <= i
+    while (r < hi) {
+        const int m = (r + hi + 1) / 2;
+        if (u->offset[m] <= i) { r = m; } else { hi = m - 1; }
+    }
+    for (; i < j; r++) {
+        const int b = u->range[r * 2] + (i - u->offset[r]);
+        const int e = minimum(u->range[r * 2 + 1], b + (j - i));
+        compute(u->s, b, e);
+        i += e - b;
+    }
+}
+
+static int compare_slots(const void* a, const void* b) {
+    const int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* depth of slot k */
+static int depth_of(const scene_t* s, int k) {
+    int lo = 0, hi = s->depths - 1;
+    while (lo < hi) {
+        const int m = (lo + hi + 1) / 2;
+        if (s->level[m] <= k) { lo = m; } else { hi = m - 1; }
+    }
+    return lo;
+}
+
+/* appends [b..e) to ranges, coalesced with the last one when they touch */
+static void push(int32_t* ranges, int* n, int b, int e) {
+    if (*n > 0 && b <= ranges[*n * 2 - 1]) {
+        ranges[*n * 2 - 1] = maximum(ranges[*n * 2 - 1], e);
+    } else {
+        ranges[*n * 2] = b;
+        ranges[*n * 2 + 1] = e;
+        (*n)++;
+    }
+}
+
+int scene_update(scene_t* s) {
+    if (!s->sorted && !layout(s)) { return -1; }
+    scene_work_t* w = s->work;
+    if (w->listed == 0) { return 0; }
+    if (w->listed > s->count / 16) { // scanning the bits is cheaper than sorting
+        w->listed = 0;
+        for (int i = 0; i < s->count; i++) {
+            if (s->dirty[i]) { w->list[w->listed++] = i; }
+        }
+    } else {
+        qsort(w->list, (size_t)w->listed, sizeof(int32_t), compare_slots);
+    }
+    int updated = 0, next = 0, previous = 0; // next dirty in list, ranges of previous depth
+    int depth = depth_of(s, w->list[0]);
+    while (depth < s->depths && (previous > 0 || next < w->listed)) {
+        if (previous == 0) { depth = depth_of(s, w->list[next]); } // skip clean depths
+        int32_t* parents = w->ranges[0];
+        int32_t* ranges = w->ranges[1];
+        const int limit = s->level[depth + 1];
+        int n = 0, p = 0;
+        while (p < previous || (next < w->listed && w->list[next] < limit)) { // merge by begin
+            const int single = next < w->listed && w->list[next] < limit ? w->list[next] : s->count;
+            if (p < previous && s->first[parents[p * 2]] <= single) {
+                const int b = s->first[parents[p * 2]], e = s->first[parents[p * 2 + 1]];
+                if (b < e) { push(ranges, &n, b, e); }
+                p++;
+            } else {
+                s->dirty[single] = false;
+                push(ranges, &n, single, single + 1);
+                next++;
+            }
+        }
+        int nodes = 0;
+        for (int r = 0; r < n; r++) {
+            w->offset[r] = nodes;
+            nodes += ranges[r * 2 + 1] - ranges[r * 2];
+        }
+        update_t u = { s, ranges, w->offset, n };
+        parallel_for(0, nodes, GRAIN, &u, update_body);
+        updated += nodes;
+        w->ranges[0] = ranges;
+        w->ranges[1] = parents;
+        previous = n;
+        depth++;
+    }
+    w->listed = 0;
+    return updated;
+}
+
+END_C
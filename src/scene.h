@@ -0,0 +1,52 @@
+#pragma once
+#include "math4x4.h"
+
+/* scene graph of nodes with local and world matrices.
+   Nodes are stored breadth first in parallel arrays (slots): roots, then
+   the children of slot 0, of slot 1 and so on. Children of any run of
+   consecutive slots are consecutive, so a changed subtree is one slot
+   range per depth. scene_update() walks only those ranges, depth by depth,
+   world = world of parent * local with multiply_4x4f(), nodes of one depth
+   in parallel. Per frame cost is proportional to the changed subtrees,
+   not to the scene size.
+   Node ids are stable, slots move when nodes are added or reparented
+   (the layout is rebuilt in O(count) on the next update). */
+
+BEGIN_C
+
+typedef struct scene_s {
+    int count;           /* nodes */
+    int capacity;
+    int depths;          /* levels of the layout, depth d is slots [level[d]..level[d + 1]) */
+    int sorted;          /* slots are breadth first, cleared by topology changes */
+    int32_t* parent;     /* slot of parent, -1 for roots */
+    int32_t* first;      /* children of slot i are [first[i]..first[i + 1]), count + 1 entries */
+    int32_t* level;
+    int32_t* id;         /* node id of slot */
+    int32_t* slot;       /* slot of node id */
+    uint8_t* dirty;      /* local changed since last update */
+    mat4x4f_t* local;    /* 64 byte aligned */
+    mat4x4f_t* world;    /* 64 byte aligned, valid after scene_update() */
+    struct scene_work_s* work; /* scene_update() state */
+} scene_t;
+
+scene_t* scene_create(int capacity); /* returns null on out of memory */
+void scene_destroy(scene_t* s);
+
+/* new node with world = world of parent * local, parent -1 for a root.
+   Returns the node id (ids are 0, 1, 2, ... in order of addition)
+   or -1 on out of memory. local may be null for identity. */
+int scene_add(scene_t* s, int parent, const mat4x4f_t local);
+
+void scene_set_local(scene_t* s, int node, const mat4x4f_t local); /* marks the node dirty */
+/* returns 0 when parent is the node or one of its descendants */
+int  scene_set_parent(scene_t* s, int node, int parent);
+
+/* world matrices of dirty nodes and their descendants,
+   returns number of world matrices computed or -1 on out of memory */
+int scene_update(scene_t* s);
+
+static inline const float* scene_local(const scene_t* s, int node) { return s->local[s->slot[node]]; }
+static inline const float* scene_world(const scene_t* s, int node) { return s->world[s->slot[node]]; }
+
+END_C
@@ -0,0 +1,347 @@
+#include "sdf.h"
+#include "distance.h"
+#include "parity.h"
+#include "threads.h"
+
+BEGIN_C
+
+/* Brick rows (8 x 8 rows of samples along the whole x extent) are
+   independent tasks. Triangles are binned into the brick rows of the
+   sample rows their y, z bounds cover. Sign: a ray along x through every
+   sample row toggles the first sample past each crossing (exact edge
+   functions of parity.h, an edge shared by two triangles is crossed
+   once), prefix xor of the toggles is the inside.
+   Narrow band: a brick is stored when bvh_closest_point() from its center
+   finds a triangle within band plus half of the brick diagonal, so every
+   sample within band is stored and bricks left out have no surface in
+   them: one sign for all of their samples.
+   Distance of every stored sample is a closest point query, samples are
+   visited in serpentine order so that consecutive ones are neighbors, the
+   distance to the triangle nearest to the previous sample is usually the
+   answer already and bounds the query, which prunes most of the hierarchy.
+   Outputs of parallel_for chunks are concatenated in row order: keys come
+   out sorted. */
+
+typedef float brick_t[SDF_BRICK * SDF_BRICK * SDF_BRICK];
+
+typedef struct output_s {
+    uint32_t* keys;
+    brick_t* bricks;
+    uint8_t* after;
+    int count;
+    int capacity;
+} output_t;
+
+typedef struct baker_s {
+    const bvh_t* bvh;
+    sdf_t* s;
+    float scale;         /* 1 / cell */
+    int bricks[3];       /* along each axis */
+    int words;           /* 64 bit words per row of samples along x */
+    atomic_int* counts;  /* triangles per brick row, then scatter cursors */
+    int* offsets;        /* first reference of every brick row, [rows + 1] */
+    int32_t* refs;       /* triangles binned by brick row */
+    output_t* outputs;   /* one per parallel_for chunk, at index of its first row */
+    atomic_int oom;
+} baker_t;
+
+enum {
+    CHUNK = 16384, /* triangles per parallel_for chunk */
+    ROW_GRAIN = 1  /* brick rows per parallel_for chunk, cost varies a lot */
+};
+
+/* vertices in grid space: sample (x, y, z) is at (x, y, z) */
+static void grid_triangle(const baker_t* b, int32_t triangle, float t[3][3]) {
+    const float* v[3];
+    mesh_triangle(&b->bvh->mesh, triangle, v);
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) { t[i][k] = (v[i][k] - b->s->origin[k]) * b->scale; }
+    }
+}
+
+/* sample rows [lo..hi] along axis k covered by the triangle, empty when lo > hi */
+static void rows_range(const baker_t* b, const float t[3][3], int k, int* lo, int* hi) {
+    const float a = minimum(t[0][k], minimum(t[1][k], t[2][k]));
+    const float c = maximum(t[0][k], maximum(t[1][k], t[2][k]));
+    *lo = maximum(0, (int)ceilf(a));
+    *hi = minimum(b->s->size[k] - 1, (int)floorf(c));
+}
+
+static void bin(baker_t* b, int from, int to, int scatter) {
+    const int nby = b->bricks[1];
+    for (int i = from; i < to; i++) {
+        float t[3][3];
+        int y0, y1, z0, z1;
+        grid_triangle(b, i, t);
+        rows_range(b, t, 1, &y0, &y1);
+        rows_range(b, t, 2, &z0, &z1);
+        if (y0 > y1 || z0 > z1) { continue; }
+        for (int bz = z0 / SDF_BRICK; bz <= z1 / SDF_BRICK; bz++) {
+            for (int by = y0 / SDF_BRICK; by <= y1 / SDF_BRICK; by++) {
+                const int row = bz * nby + by;
+                if (scatter) {
+                    b->refs[atomic_fetch_add(&b->counts[row], 1)] = i;
+                } else {
+                    atomic_fetch_add(&b->counts[row], 1);
+                }
+            }
+        }
+    }
+}
+
+static void bin_count(void* that, int from, int to) { bin((baker_t*)that, from, to, false); }
+
+static void bin_scatter(void* that, int from, int to) { bin((baker_t*)that, from, to, true); }
+
+static int output_push(baker_t* b, output_t* o, uint32_t key, const brick_t values, int after) {
+    if (o->count == o->capacity) {
+        const int capacity = o->capacity == 0 ? 16 : o->capacity * 2;
+        uint32_t* keys = (uint32_t*)realloc(o->keys, sizeof(uint32_t) * (size_t)capacity);
+        if (keys != null) { o->keys = keys; }
+        brick_t* bricks = (brick_t*)realloc(o->bricks, sizeof(brick_t) * (size_t)capacity);
+        if (bricks != null) { o->bricks = bricks; }
+        uint8_t* a = (uint8_t*)realloc(o->after, (size_t)capacity);
+        if (a != null) { o->after = a; }
+        if (keys == null || bricks == null || a == null) { atomic_store(&b->oom, 1); return false; }
+        o->capacity = capacity;
+    }
+    o->keys[o->count] = key;
+    memcpy(o->bricks[o->count], values, sizeof(brick_t));
+    o->after[o->count] = (uint8_t)after;
+    o->count++;
+    return true;
+}
+
+/* inside bits of 64 sample rows (z % 8) * 8 + y % 8 of one brick row, words each */
+static void row_inside(baker_t* b, int row, uint64_t* inside) {
+    const int y0 = row % b->bricks[1] * SDF_BRICK, z0 = row / b->bricks[1] * SDF_BRICK;
+    for (int r = b->offsets[row]; r < b->offsets[row + 1]; r++) {
+        float t[3][3];
+        int ya, yb, za, zb;
+        grid_triangle(b, b->refs[r], t);
+        rows_range(b, t, 1, &ya, &yb);
+        rows_range(b, t, 2, &za, &zb);
+        for (int z = maximum(za, z0); z <= minimum(zb, z0 + SDF_BRICK - 1); z++) {
+            for (int y = maximum(ya, y0); y <= minimum(yb, y0 + SDF_BRICK - 1); y++) {
+                double x;
+                if (parity_crossing((const float (*)[3])t, y, z, &x)) {
+                    const int c = maximum(0, (int)floor(x) + 1); // first sample past the crossing
+                    if (c < b->s->size[0]) {
+                        inside[((z - z0) * SDF_BRICK + y - y0) * b->words + (c >> 6)] ^= 1ULL << (c & 63);
+                    }
+                }
+            }
+        }
+    }
+    for (int c = 0; c < 64; c++) {
+        uint64_t carry = 0;
+        for (int w = 0; w < b->words; w++) {
+            const uint64_t p = parity_prefix(inside[c * b->words + w]) ^ (0 - carry);
+            inside[c * b->words + w] = p;
+            carry = p >> 63;
+        }
+    }
+}
+
+static inline int is_inside(const baker_t* b, const uint64_t* inside, int x, int c) {
+    return (int)((inside[c * b->words + (x >> 6)] >> (x & 63)) & 1);
+}
+
+static void brick_values(const baker_t* b, int bx, int row, const uint64_t* inside, brick_t values) {
+    const sdf_t* s = b->s;
+    const int x0 = bx * SDF_BRICK, y0 = row % b->bricks[1] * SDF_BRICK, z0 = row / b->bricks[1] * SDF_BRICK;
+    int previous = -1; // triangle nearest to the previous sample
+    int n = 0;
+    for (int z = 0; z < SDF_BRICK; z++) {
+        for (int j = 0; j < SDF_BRICK; j++) {
+            const int y = z % 2 == 0 ? j : SDF_BRICK - 1 - j;
+            for (int i = 0; i < SDF_BRICK; i++, n++) {
+                const int x = n / SDF_BRICK % 2 == 0 ? i : SDF_BRICK - 1 - i;
+                const float p[3] = {
+                    s->origin[0] + (float)(x0 + x) * s->cell,
+                    s->origin[1] + (float)(y0 + y) * s->cell,
+                    s->origin[2] + (float)(z0 + z) * s->cell
+                };
+                float d = s->band;
+                if (previous >= 0) {
+                    const float* v[3];
+                    mesh_triangle(&b->bvh->mesh, previous, v);
+                    d = minimum(d, sqrtf(point_triangle_distance2(p, v[0], v[1], v[2], null)));
+                }
+                bvh_closest_t c;
+                if (bvh_closest_point(b->bvh, p, d, &c)) {
+                    d = c.distance;
+                    previous = c.triangle;
+                }
+                values[(z * SDF_BRICK + y) * SDF_BRICK + x] =
+                    is_inside(b, inside, x0 + x, z * SDF_BRICK + y) ? -d : d;
+            }
+        }
+    }
+}
+
+/* some sample of the brick may be within band of the surface */
+static int near_surface(const baker_t* b, int bx, int by, int bz) {
+    const sdf_t* s = b->s;
+    if (s->band == INFINITY) { return true; }
+    const float h = (SDF_BRICK - 1) * 0.5f;
+    const float center[3] = {
+        s->origin[0] + ((float)(bx * SDF_BRICK) + h) * s->cell,
+        s->origin[1] + ((float)(by * SDF_BRICK) + h) * s->cell,
+        s->origin[2] + ((float)(bz * SDF_BRICK) + h) * s->cell
+    };
+    bvh_closest_t c;
+    return bvh_closest_point(b->bvh, center, s->band + h * s->cell * sqrtf(3) * 1.0001f, &c);
+}
+
+static void row_bricks(baker_t* b, int row, uint64_t* inside, output_t* o) {
+    row_inside(b, row, inside);
+    const int by = row % b->bricks[1], bz = row / b->bricks[1];
+    for (int bx = 0; bx < b->bricks[0]; bx++) {
+        if (!near_surface(b, bx, by, bz)) { continue; }
+        brick_t values;
+        brick_values(b, bx, row, inside, values);
+        const int next = (bx + 1) * SDF_BRICK; // bricks left out after this one share the sign of their first sample
+        const int after = next < b->s->size[0] && is_inside(b, inside, next, 0);
+        const uint32_t key = (uint32_t)row * (uint32_t)b->bricks[0] + (uint32_t)bx;
+        if (!output_push(b, o, key, values, after)) { break; }
+    }
+    memset(inside, 0, sizeof(uint64_t) * (size_t)b->words * 64);
+}
+
+static void rows_body(void* that, int from, int to) {
+    baker_t* b = (baker_t*)that;
+    uint64_t* inside = (uint64_t*)calloc((size_t)b->words * 64, sizeof(uint64_t));
+    if (inside == null) { atomic_store(&b->oom, 1); return; }
+    for (int k = from; k < to && !atomic_load(&b->oom); k++) { row_bricks(b, k, inside, &b->outputs[from]); }
+    free(inside);
+}
+
+static int gather(baker_t* b, int slots) {
+    sdf_t* s = b->s;
+    int total = 0;
+    for (int k = 0; k < slots; k++) { total += b->outputs[k].count; }
+    s->keys = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)maximum(1, total));
+    s->bricks = (brick_t*)malloc(sizeof(brick_t) * (size_t)maximum(1, total));
+    s->after = (uint8_t*)malloc((size_t)maximum(1, total));
+    if (s->keys == null || s->bricks == null || s->after == null) { return false; }
+    for (int k = 0; k < slots; k++) {
+        const output_t* o = &b->outputs[k];
+        if (o->count == 0) { continue; }
+        memcpy(s->keys + s->brick_count, o->keys, sizeof(uint32_t) * (size_t)o->count);
+        memcpy(s->bricks + s->brick_count, o->bricks, sizeof(brick_t) * (size_t)o->count);
+        memcpy(s->after + s->brick_count, o->after, (size_t)o->count);
+        s->brick_count += o->count;
+    }
+    return true;
+}
+
+static int bake(baker_t* b) {
+    const int rows = b->bricks[1] * b->bricks[2];
+    const int n = b->bvh->mesh.triangle_count;
+    b->counts = (atomic_int*)malloc(sizeof(atomic_int) * (size_t)rows);
+    b->offsets = (int*)malloc(sizeof(int) * (size_t)(rows + 1));
+    if (b->counts == null || b->offsets == null) { return false; }
+    for (int r = 0; r < rows; r++) { atomic_init(&b->counts[r], 0); }
+    parallel_for(0, n, CHUNK, b, bin_count);
+    int total = 0;
+    for (int r = 0; r < rows; r++) {
+        const int c = atomic_load(&b->counts[r]);
+        b->offsets[r] = total;
+        atomic_store(&b->counts[r], total);
+        total += c;
+    }
+    b->offsets[rows] = total;
+    b->refs = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, total));
+    b->outputs = (output_t*)calloc((size_t)rows, sizeof(output_t));
+    if (b->refs == null || b->outputs == null) { return false; }
+    parallel_for(0, n, CHUNK, b, bin_scatter);
+    parallel_for(0, rows, ROW_GRAIN, b, rows_body);
+    const int ok = !atomic_load(&b->oom) && gather(b, rows);
+    for (int k = 0; k < rows; k++) {
+        free(b->outputs[k].keys);
+        free(b->outputs[k].bricks);
+        free(b->outputs[k].after);
+    }
+    return ok;
+}
+
+sdf_t* sdf_create(const bvh_t* bvh, int resolution, float band) {
+    if (resolution < 2 || resolution > SDF_MAX || !(band > 0)) { return null; }
+    sdf_t* s = (sdf_t*)calloc(1, sizeof(sdf_t));
+    if (s == null) { return null; }
+    const float margin = band < INFINITY ? band : 0;
+    float lo[3] = {0}, hi[3] = {0}, extent = 0;
+    for (int k = 0; k < 3 && bvh->node_count > 0; k++) {
+        lo[k] = bvh->nodes[0].min[k] - margin;
+        hi[k] = bvh->nodes[0].max[k] + margin;
+        extent = maximum(extent, hi[k] - lo[k]);
+    }
+    s->cell = extent > 0 ? extent / (float)(resolution - 1) : 1;
+    s->band = band;
+    for (int k = 0; k < 3; k++) {
+        const int samples = (int)ceilf((hi[k] - lo[k]) / s->cell) + 1;
+        s->origin[k] = lo[k];
+        s->size[k] = minimum(SDF_MAX, (samples + SDF_BRICK - 1) / SDF_BRICK * SDF_BRICK);
+    }
+    baker_t b = { bvh, s, 1 / s->cell };
+    for (int k = 0; k < 3; k++) { b.bricks[k] = s->size[k] / SDF_BRICK; }
+    b.words = (s->size[0] + 63) / 64;
+    atomic_init(&b.oom, 0);
+    const int ok = bake(&b);
+    free(b.counts);
+    free(b.offsets);
+    free(b.refs);
+    free(b.outputs);
+    if (!ok) {
+        sdf_destroy(s);
+        return null;
+    }
+    return s;
+}
+
+void sdf_destroy(sdf_t* s) {
+    if (s != null) {
+        free(s->keys);
+        free(s->bricks);
+        free(s->after);
+        free(s);
+    }
+}
+
+float sdf_get(const sdf_t* s, int x, int y, int z) {
+    x = maximum(0, minimum(s->size[0] - 1, x));
+    y = maximum(0, minimum(s->size[1] - 1, y));
+    z = maximum(0, minimum(s->size[2] - 1, z));
+    const uint32_t nbx = (uint32_t)(s->size[0] / SDF_BRICK);
+    const uint32_t row = (uint32_t)(z / SDF_BRICK * (s->size[1] / SDF_BRICK) + y / SDF_BRICK);
+    const uint32_t key = row * nbx + (uint32_t)(x / SDF_BRICK);
+    int lo = 0, hi = s->brick_count; // first key >= key
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (s->keys[mid] < key) { lo = mid + 1; } else { hi = mid; }
+    }
+    if (lo < s->brick_count && s->keys[lo] == key) {
+        return s->bricks[lo][(z % SDF_BRICK * SDF_BRICK + y % SDF_BRICK) * SDF_BRICK + x % SDF_BRICK];
+    }
+    return lo > 0 && s->keys[lo - 1] / nbx == row && s->after[lo - 1] ? -s->band : s->band;
+}
+
+float sdf_sample(const sdf_t* s, const float p[3]) {
+    int i[3];
+    float f[3];
+    for (int k = 0; k < 3; k++) {
+        const float g = maximum(0.0f, minimum((float)(s->size[k] - 1), (p[k] - s->origin[k]) / s->cell));
+        i[k] = minimum(s->size[k] - 2, (int)g);
+        f[k] = g - (float)i[k];
+    }
+    float r = 0;
+    for (int c = 0; c < 8; c++) {
+        const int dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+        const float w = (dx ? f[0] : 1 - f[0]) * (dy ? f[1] : 1 - f[1]) * (dz ? f[2] : 1 - f[2]);
+        if (w > 0) { r += w * sdf_get(s, i[0] + dx, i[1] + dy, i[2] + dz); } // 0 * INFINITY of empty dense fields
+    }
+    return r;
+}
+
+END_C
@@ -0,0 +1,37 @@
+#pragma once
+#include "bvh.h"
+
+/* signed distance field of a closed triangle mesh sampled on a grid,
+   negative inside. Samples are stored in bricks of 8x8x8, a narrow band
+   field keeps only bricks with samples nearer to the surface than band,
+   samples of other bricks read as +band or -band, so memory grows with
+   surface area not volume. Distances come from bvh_closest_point(), the
+   sign from parity of crossings of a ray along x (mesh must be closed). */
+
+BEGIN_C
+
+enum {
+    SDF_BRICK = 8,   /* samples along brick edge */
+    SDF_MAX   = 4096 /* samples along longest axis */
+};
+
+typedef struct sdf_s {
+    float origin[3];     /* position of sample (0, 0, 0) */
+    float cell;          /* distance between neighboring samples */
+    float band;          /* INFINITY for a dense field */
+    int size[3];         /* samples per axis, multiples of SDF_BRICK */
+    int brick_count;
+    uint32_t* keys;      /* sorted: (bz * bricks along y + by) * bricks along x + bx */
+    float (*bricks)[SDF_BRICK * SDF_BRICK * SDF_BRICK]; /* sample (z * 8 + y) * 8 + x */
+    uint8_t* after;      /* bricks following keys[k] along x up to the next stored one are inside */
+} sdf_t;
+
+/* resolution is number of samples along the longest axis of mesh bounds
+   grown by band on every side (INFINITY: dense field of the mesh bounds),
+   returns null on out of memory, resolution outside of [2..SDF_MAX] or band <= 0 */
+sdf_t* sdf_create(const bvh_t* bvh, int resolution, float band);
+void  sdf_destroy(sdf_t* s);
+float sdf_get(const sdf_t* s, int x, int y, int z); /* clamped to the grid */
+float sdf_sample(const sdf_t* s, const float p[3]); /* trilinear, p clamped to the grid */
+
+END_C
@@ -0,0 +1,39 @@
+#include "simd.h"
+
+BEGIN_C
+
+static int detected = -1;
+static int forced = -1;
+
+int simd_detect(void) {
+    if (detected < 0) { // benign race: every thread computes the same value
+        int level = SIMD_SCALAR;
+#if defined(SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1")) { level = SIMD_SSE; }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { level = SIMD_AVX2; }
+        if (level == SIMD_AVX2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) {
+            level = SIMD_AVX512;
+        }
+#elif defined(SIMD_ARM)
+        level = SIMD_NEON;
+#endif
+        detected = level;
+    }
+    return detected;
+}
+
+int simd_level(void) {
+    return forced >= 0 ? forced : simd_detect();
+}
+
+void simd_force(int level) {
+    forced = level < 0 ? -1 : minimum(level, simd_detect());
+}
+
+const char* simd_name(int level) {
+    static const char* names[] = { "scalar", "neon", "sse4.1", "avx2", "avx512" };
+    return 0 <= level && level <= SIMD_AVX512 ? names[level] : "?";
+}
+
+END_C
@@ -0,0 +1,97 @@
+#pragma once
+#include "std.h"
+
+/* runtime selection of SIMD kernels.
+   Kernels are written once against the width generic vector types below
+   (gcc/clang vector extensions) and instantiated per instruction set with
+   SIMD_TARGET_* function attributes, dispatch picks the widest one the CPU
+   and OS support. simd_force() is for benchmarks and cross checking kernels
+   against each other and against scalar reference code. */
+
+BEGIN_C
+
+enum { /* simd_level() */
+    SIMD_SCALAR = 0,
+    SIMD_NEON   = 1, /* 4 lanes, arm64 baseline */
+    SIMD_SSE    = 2, /* 4 lanes, SSE4.1 */
+    SIMD_AVX2   = 3, /* 8 lanes, AVX2 + FMA */
+    SIMD_AVX512 = 4  /* 16 lanes, AVX-512F */
+};
+
+int  simd_level(void); /* detected once, or whatever simd_force() clamped it to */
+int  simd_detect(void); /* best level supported by hardware and OS */
+void simd_force(int level); /* min(level, simd_detect()), negative restores detected */
+const char* simd_name(int level);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#define SIMD_TARGET_SSE    __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define SIMD_ARM
+#endif
+
+typedef float   f32x4  __attribute__((vector_size(16)));
+typedef int32_t i32x4  __attribute__((vector_size(16)));
+typedef float   f32x8  __attribute__((vector_size(32)));
+typedef int32_t i32x8  __attribute__((vector_size(32)));
+typedef float   f32x16 __attribute__((vector_size(64)));
+typedef int32_t i32x16 __attribute__((vector_size(64)));
+
+#define SIMD_ALIGN __attribute__((aligned(64)))
+
+/* non temporal store of v to p aligned to sizeof(v): clang builtin, movntps
+   builtins of gcc on x86, plain store elsewhere (SIMD_NONTEMPORAL undefined).
+   simd_stream_fence() orders the stores before the data is handed to other
+   threads. */
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_nontemporal_store)
+#define SIMD_NONTEMPORAL_BUILTIN
+#endif
+#endif
+
+#if defined(SIMD_NONTEMPORAL_BUILTIN) || defined(SIMD_X86)
+#define SIMD_NONTEMPORAL
+#endif
+
+static inline void simd_stream_4(float* p, f32x4 v) {
+#if defined(SIMD_NONTEMPORAL_BUILTIN)
+    __builtin_nontemporal_store(v, (f32x4*)p);
+#elif defined(SIMD_X86)
+    __builtin_ia32_movntps(p, v);
+#else
+    *(f32x4*)p = v;
+#endif
+}
+
+#ifdef SIMD_X86
+
+static inline SIMD_TARGET_AVX2 void simd_stream_8(float* p, f32x8 v) {
+#ifdef SIMD_NONTEMPORAL_BUILTIN
+    __builtin_nontemporal_store(v, (f32x8*)p);
+#else
+    __builtin_ia32_movntps256(p, v);
+#endif
+}
+
+static inline SIMD_TARGET_AVX512 void simd_stream_16(float* p, f32x16 v) {
+#ifdef SIMD_NONTEMPORAL_BUILTIN
+    __builtin_nontemporal_store(v, (f32x16*)p);
+#else
+    __builtin_ia32_movntps512(p, v);
+#endif
+}
+
+#endif
+
+static inline void simd_stream_fence(void) {
+#ifdef SIMD_X86
+    __builtin_ia32_sfence();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+END_C
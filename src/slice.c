@@ -0,0 +1,443 @@
+#include "slice.h"
+#include "threads.h"
+
+BEGIN_C
+
+/* Triangles are binned by z extent into the layers they cross (count,
+   prefix sum, scatter), so every layer only visits its active triangles
+   and layers are independent parallel_for tasks.
+   A vertex at or above the layer height is above (simulation of
+   simplicity): a triangle crosses the plane when its vertices are on both
+   sides, then exactly two of its edges cross and the segment between them
+   is computed the same way as tri_tri_intersect_line() does: interpolation
+   along the edge by the signed distances of its ends. The edge is always
+   interpolated from its end above, so both triangles sharing it compute
+   the same point bit for bit.
+   Segment end points are identified by the crossed edge (pair of vertex
+   indices), not by position. Triangles of a layer are radix sorted (binning
+   order depends on thread timing), segments are radix sorted once by the
+   edge they start on and once by the edge they end on, merging the two
+   lists links every segment to its successor without hashing or searching.
+   Chains without a predecessor are emitted first (open), the rest are
+   closed loops. Outputs of parallel_for chunks are concatenated in layer
+   order: the result is independent of the number of threads. */
+
+enum {
+    RADIX_BITS = 11, /* radix sort digit */
+    RADIX      = 1 << RADIX_BITS
+};
+
+typedef struct output_s {
+    float (*points)[2];
+    slice_contour_t* contours; /* offsets relative to points of this output */
+    int* layers;               /* contours of every layer of the chunk */
+    int layer_count;           /* layers of the chunk */
+    int point_count;
+    int point_capacity;
+    int contour_count;
+    int contour_capacity;
+} output_t;
+
+typedef struct scratch_s { /* per parallel_for chunk, arrays of the most segments of its layers */
+    float (*points)[2][2]; /* x, y where segment i starts and ends */
+    uint64_t* from;        /* crossed edge segment i starts on: lower vertex index << bits | higher, relative to base */
+    uint64_t* to;          /* crossed edge it ends on */
+    int32_t* starts;       /* segments sorted by from */
+    int32_t* ends;         /* segments sorted by to */
+    uint64_t* start_edges; /* from of starts */
+    uint64_t* end_edges;   /* to of ends */
+    uint64_t* keys_swap;
+    int32_t* swap;
+    int32_t* next;         /* successor of every segment, -1 none */
+    uint8_t* visited;
+    uint8_t* preceded;
+    int32_t base;          /* lowest vertex index of the layer */
+    int bits;              /* of highest vertex index - base */
+    int histogram[RADIX];
+} scratch_t;
+
+typedef struct slicer_s {
+    const mesh_t* mesh;
+    const float* z;
+    int count;
+    int32_t (*spans)[2]; /* [first..last) layers of every triangle */
+    atomic_int* counts;  /* triangles per layer, then scatter cursors */
+    int* offsets;        /* first reference of every layer, [count + 1] */
+    int32_t* refs;       /* triangles binned by layer */
+    output_t* outputs;   /* one per parallel_for chunk, at index of its first layer */
+    atomic_int oom;
+} slicer_t;
+
+enum {
+    CHUNK = 16384,   /* triangles per parallel_for chunk */
+    LAYER_GRAIN = 4  /* layers per parallel_for chunk */
+};
+
+static int upper_bound(const float* z, int count, float v) { /* first z[i] > v, without branches on data */
+    if (count == 0) { return 0; }
+    int base = 0, n = count;
+    while (n > 1) {
+        const int half = n / 2;
+        base = z[base + half] <= v ? base + half : base;
+        n -= half;
+    }
+    return base + (z[base] <= v);
+}
+
+/* counted per chunk first: one atomic add per layer the chunk touches,
+   scatter reserves a block of every such layer the same way */
+static void bin(slicer_t* s, int from, int to, int scatter) {
+    int* local = (int*)calloc((size_t)maximum(1, s->count), sizeof(int));
+    if (local == null) { atomic_store(&s->oom, 1); return; }
+    int first = s->count, last = 0;
+    for (int i = from; i < to; i++) {
+        int32_t* span = s->spans[i];
+        if (!scatter) {
+            const float* v[3];
+            mesh_triangle(s->mesh, i, v);
+            const float lo = minimum(v[0][2], minimum(v[1][2], v[2][2]));
+            const float hi = maximum(v[0][2], maximum(v[1][2], v[2][2]));
+            span[0] = upper_bound(s->z, s->count, lo);
+            span[1] = span[0];
+            while (span[1] < s->count && s->z[span[1]] <= hi) { span[1]++; } // lo < z <= hi
+        }
+        first = minimum(first, span[0]);
+        last = maximum(last, span[1]);
+        for (int l = span[0]; l < span[1]; l++) { local[l]++; }
+    }
+    for (int l = first; l < last; l++) {
+        if (local[l] > 0) {
+            const int start = atomic_fetch_add(&s->counts[l], local[l]);
+            if (scatter) { local[l] = start; }
+        }
+    }
+    for (int i = from; i < to && scatter; i++) {
+        for (int l = s->spans[i][0]; l < s->spans[i][1]; l++) { s->refs[local[l]++] = i; }
+    }
+    free(local);
+}
+
+static void bin_count(void* that, int from, int to) { bin((slicer_t*)that, from, to, false); }
+
+static void bin_scatter(void* that, int from, int to) { bin((slicer_t*)that, from, to, true); }
+
+/* point where edge (i, j) crosses z = h, one end is below h: interpolated
+   from the end at or above h so a vertex exactly at h is hit exactly */
+static uint64_t crossing(const mesh_t* m, const scratch_t* w, int32_t i, int32_t j, float h, float p[2]) {
+    const float* a = m->vertices[i];
+    const float* b = m->vertices[j];
+    if (a[2] < h) { const float* t = a; a = b; b = t; }
+    const float t = (h - a[2]) / (b[2] - a[2]);
+    p[0] = a[0] + (b[0] - a[0]) * t;
+    p[1] = a[1] + (b[1] - a[1]) * t;
+    const int32_t lo = minimum(i, j), hi = maximum(i, j);
+    return ((uint64_t)(uint32_t)(lo - w->base) << w->bits) | (uint32_t)(hi - w->base);
+}
+
+/* for triangle a, b, c (counterclockwise around its normal) with a alone
+   on its side: a above runs from edge ab to edge ca, direction of z x normal */
+static void segment(const slicer_t* s, scratch_t* w, int i, int32_t triangle, float h) {
+    const mesh_t* m = s->mesh;
+    const int32_t* ix = m->indices + triangle * 3;
+    int above[3];
+    for (int k = 0; k < 3; k++) { above[k] = m->vertices[ix[k]][2] >= h; }
+    const int a = above[0] == above[1] ? 2 : (above[0] == above[2] ? 1 : 0);
+    const int b = (a + 1) % 3, c = (a + 2) % 3;
+    const int f = above[a] ? 0 : 1;
+    const uint64_t ab = crossing(m, w, ix[a], ix[b], h, w->points[i][f]);
+    const uint64_t ca = crossing(m, w, ix[c], ix[a], h, w->points[i][1 - f]);
+    w->from[i] = f == 0 ? ab : ca;
+    w->to[i] = f == 0 ? ca : ab;
+}
+
+/* LSD radix sort of values[0..n) by keys below bits into sorted keys,
+   stable, passes with a single digit value are skipped */
+static void radix_sort(scratch_t* w, const uint64_t* keys, int32_t* values, uint64_t* sorted, int n, int bits) {
+    memcpy(sorted, keys, sizeof(uint64_t) * (size_t)n);
+    uint64_t* k0 = sorted;
+    int32_t* v0 = values;
+    uint64_t* k1 = w->keys_swap;
+    int32_t* v1 = w->swap;
+    for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+        memset(w->histogram, 0, sizeof(w->histogram));
+        for (int i = 0; i < n; i++) { w->histogram[(k0[i] >> shift) & (RADIX - 1)]++; }
+        int sum = 0, skip = false;
+        for (int d = 0; d < RADIX && !skip; d++) {
+            const int count = w->histogram[d];
+            w->histogram[d] = sum;
+            sum += count;
+            skip = count == n;
+        }
+        if (!skip) {
+            for (int i = 0; i < n; i++) {
+                const int j = w->histogram[(k0[i] >> shift) & (RADIX - 1)]++;
+                k1[j] = k0[i];
+                v1[j] = v0[i];
+            }
+            uint64_t* k = k0; k0 = k1; k1 = k;
+            int32_t* v = v0; v0 = v1; v1 = v;
+        }
+    }
+    if (v0 != values) {
+        memcpy(sorted, k0, sizeof(uint64_t) * (size_t)n);
+        memcpy(values, v0, sizeof(int32_t) * (size_t)n);
+    }
+}
+
+static int push_point(slicer_t* s, output_t* o, const float p[2]) {
+    const slice_contour_t* c = &o->contours[o->contour_count];
+    if (c->count > 0) { // zero length segments through a vertex at the layer height
+        const float* q = o->points[o->point_count - 1];
+        if (q[0] == p[0] && q[1] == p[1]) { return true; }
+    }
+    if (o->point_count == o->point_capacity) {
+        const int capacity = o->point_capacity == 0 ? 1024 : o->point_capacity * 2;
+        float (*points)[2] = (float (*)[2])realloc(o->points, sizeof(o->points[0]) * (size_t)capacity);
+        if (points == null) { atomic_store(&s->oom, 1); return false; }
+        o->points = points;
+        o->point_capacity = capacity;
+    }
+    o->points[o->point_count][0] = p[0];
+    o->points[o->point_count][1] = p[1];
+    o->point_count++;
+    o->contours[o->contour_count].count++;
+    return true;
+}
+
+/* open chain from a segment without predecessor or closed loop back to it */
+static int chain(slicer_t* s, output_t* o, scratch_t* w, int first) {
+    if (o->contour_count == o->contour_capacity) {
+        const int capacity = o->contour_capacity == 0 ? 64 : o->contour_capacity * 2;
+        slice_contour_t* contours = (slice_contour_t*)realloc(o->contours, sizeof(slice_contour_t) * (size_t)capacity);
+        if (contours == null) { atomic_store(&s->oom, 1); return false; }
+        o->contours = contours;
+        o->contour_capacity = capacity;
+    }
+    slice_contour_t* c = &o->contours[o->contour_count];
+    c->offset = o->point_count;
+    c->count = 0;
+    int k = first, last = first;
+    while (k >= 0 && !w->visited[k]) {
+        w->visited[k] = 1;
+        if (!push_point(s, o, w->points[k][0])) { return false; }
+        last = k;
+        k = w->next[k];
+    }
+    c->closed = k == first;
+    if (!c->closed && !push_point(s, o, w->points[last][1])) { return false; }
+    const float* p0 = o->points[c->offset];
+    const float* p1 = o->points[o->point_count - 1];
+    if (c->closed && c->count > 1 && p0[0] == p1[0] && p0[1] == p1[1]) {
+        c->count--;
+        o->point_count--;
+    }
+    if (c->count < 2) { // vertex touching the layer from above
+        o->point_count = c->offset;
+        return true;
+    }
+    o->contour_count++;
+    return true;
+}
+
+static int bits(uint32_t range) { /* to represent [0..range] */
+    int b = 1;
+    while (b < 32 && (range >> b) != 0) { b++; }
+    return b;
+}
+
+/* keys are relative to the lowest triangle and vertex index of the layer:
+   slices of meshes with coherent indices sort in fewer passes */
+static int layer_contours(slicer_t* s, int layer, scratch_t* w, output_t* o) {
+    const int n = s->offsets[layer + 1] - s->offsets[layer];
+    const int32_t* refs = s->refs + s->offsets[layer];
+    int32_t* triangles = w->starts;
+    int32_t t0 = INT32_MAX, t1 = 0, v0 = INT32_MAX, v1 = 0;
+    for (int i = 0; i < n; i++) {
+        t0 = minimum(t0, refs[i]);
+        t1 = maximum(t1, refs[i]);
+        for (int k = 0; k < 3; k++) {
+            v0 = minimum(v0, s->mesh->indices[refs[i] * 3 + k]);
+            v1 = maximum(v1, s->mesh->indices[refs[i] * 3 + k]);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        triangles[i] = refs[i];
+        w->from[i] = (uint64_t)(uint32_t)(refs[i] - t0);
+    }
+    radix_sort(w, w->from, triangles, w->start_edges, n, bits((uint32_t)(t1 - t0)));
+    w->base = v0;
+    w->bits = bits((uint32_t)(v1 - v0));
+    for (int i = 0; i < n; i++) { segment(s, w, i, triangles[i], s->z[layer]); }
+    for (int i = 0; i < n; i++) { w->starts[i] = i; w->ends[i] = i; }
+    radix_sort(w, w->from, w->starts, w->start_edges, n, w->bits * 2);
+    radix_sort(w, w->to, w->ends, w->end_edges, n, w->bits * 2);
+    for (int i = 0; i < n; i++) { w->visited[i] = 0; w->preceded[i] = 0; }
+    for (int i = 0, j = 0; i < n; i++) { // ends[i] is followed by the first segment starting on its edge
+        const int e = w->ends[i];
+        w->next[e] = -1;
+        while (j < n && w->start_edges[j] < w->end_edges[i]) { j++; }
+        if (j < n && w->start_edges[j] == w->end_edges[i]) {
+            w->next[e] = w->starts[j];
+            w->preceded[w->starts[j]] = 1;
+        }
+    }
+    const int before = o->contour_count;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < n; i++) {
+            if (!w->visited[i] && (pass == 1 || !w->preceded[i]) && !chain(s, o, w, i)) { return false; }
+        }
+    }
+    o->layers[layer - (int)(o - s->outputs)] = o->contour_count - before;
+    return true;
+}
+
+static void scratch_destroy(scratch_t* w) {
+    if (w != null) {
+        free(w->points);
+        free(w->from);
+        free(w->to);
+        free(w->starts);
+        free(w->ends);
+        free(w->start_edges);
+        free(w->end_edges);
+        free(w->keys_swap);
+        free(w->swap);
+        free(w->next);
+        free(w->visited);
+        free(w);
+    }
+}
+
+static scratch_t* scratch_create(int n) {
+    scratch_t* w = (scratch_t*)calloc(1, sizeof(scratch_t));
+    if (w == null) { return null; }
+    const size_t c = (size_t)maximum(1, n);
+    w->points = (float (*)[2][2])malloc(sizeof(w->points[0]) * c);
+    w->from = (uint64_t*)malloc(sizeof(uint64_t) * c);
+    w->to = (uint64_t*)malloc(sizeof(uint64_t) * c);
+    w->keys_swap = (uint64_t*)malloc(sizeof(uint64_t) * c);
+    w->starts = (int32_t*)malloc(sizeof(int32_t) * c);
+    w->ends = (int32_t*)malloc(sizeof(int32_t) * c);
+    w->start_edges = (uint64_t*)malloc(sizeof(uint64_t) * c);
+    w->end_edges = (uint64_t*)malloc(sizeof(uint64_t) * c);
+    w->swap = (int32_t*)malloc(sizeof(int32_t) * c);
+    w->next = (int32_t*)malloc(sizeof(int32_t) * c);
+    w->visited = (uint8_t*)malloc(c * 2);
+    w->preceded = w->visited == null ? null : w->visited + c;
+    if (w->points == null || w->from == null || w->to == null || w->keys_swap == null || w->starts == null ||
+        w->ends == null || w->start_edges == null || w->end_edges == null || w->swap == null || w->next == null || w->visited == null) {
+        scratch_destroy(w);
+        return null;
+    }
+    return w;
+}
+
+static void layers_body(void* that, int from, int to) {
+    slicer_t* s = (slicer_t*)that;
+    output_t* o = &s->outputs[from];
+    o->layer_count = to - from;
+    int n = 0;
+    for (int l = from; l < to; l++) { n = maximum(n, s->offsets[l + 1] - s->offsets[l]); }
+    scratch_t* w = scratch_create(n);
+    o->layers = (int*)calloc((size_t)(to - from), sizeof(int));
+    if (w == null || o->layers == null) { atomic_store(&s->oom, 1); }
+    for (int l = from; l < to && !atomic_load(&s->oom); l++) {
+        if (!layer_contours(s, l, w, o)) { break; }
+    }
+    scratch_destroy(w);
+}
+
+static int gather(slicer_t* s, slices_t* r) {
+    int contours = 0, points = 0;
+    for (int l = 0; l < s->count; l += s->outputs[l].layer_count) {
+        contours += s->outputs[l].contour_count;
+        points += s->outputs[l].point_count;
+    }
+    r->layers = (int*)malloc(sizeof(int) * (size_t)(s->count + 1));
+    r->contours = (slice_contour_t*)malloc(sizeof(slice_contour_t) * (size_t)maximum(1, contours));
+    r->points = (float (*)[2])malloc(sizeof(r->points[0]) * (size_t)maximum(1, points));
+    if (r->layers == null || r->contours == null || r->points == null) { return false; }
+    for (int l = 0; l < s->count; l += s->outputs[l].layer_count) {
+        const output_t* o = &s->outputs[l];
+        for (int k = 0; k < o->layer_count; k++) {
+            r->layers[l + k] = r->contour_count;
+            r->contour_count += o->layers[k];
+        }
+        for (int k = 0; k < o->contour_count; k++) {
+            slice_contour_t* c = &r->contours[r->contour_count - o->contour_count + k];
+            *c = o->contours[k];
+            c->offset += r->point_count;
+        }
+        if (o->point_count > 0) {
+            memcpy(r->points + r->point_count, o->points, sizeof(r->points[0]) * (size_t)o->point_count);
+            r->point_count += o->point_count;
+        }
+    }
+    r->layers[s->count] = r->contour_count;
+    return true;
+}
+
+static int slice(slicer_t* s, slices_t* r) {
+    const int n = s->mesh->triangle_count;
+    s->counts = (atomic_int*)malloc(sizeof(atomic_int) * (size_t)maximum(1, s->count));
+    s->offsets = (int*)malloc(sizeof(int) * (size_t)(s->count + 1));
+    s->outputs = (output_t*)calloc((size_t)maximum(1, s->count), sizeof(output_t));
+    s->spans = (int32_t (*)[2])malloc(sizeof(s->spans[0]) * (size_t)maximum(1, n));
+    if (s->counts == null || s->offsets == null || s->outputs == null || s->spans == null) { return false; }
+    for (int l = 0; l < s->count; l++) { atomic_init(&s->counts[l], 0); }
+    parallel_for(0, n, CHUNK, s, bin_count);
+    if (atomic_load(&s->oom)) { return false; }
+    int total = 0;
+    for (int l = 0; l < s->count; l++) {
+        const int c = atomic_load(&s->counts[l]);
+        s->offsets[l] = total;
+        atomic_store(&s->counts[l], total);
+        total += c;
+    }
+    s->offsets[s->count] = total;
+    s->refs = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, total));
+    if (s->refs == null) { return false; }
+    parallel_for(0, n, CHUNK, s, bin_scatter);
+    if (atomic_load(&s->oom)) { return false; }
+    parallel_for(0, s->count, LAYER_GRAIN, s, layers_body);
+    const int ok = !atomic_load(&s->oom) && gather(s, r);
+    for (int l = 0; l < s->count; l++) {
+        free(s->outputs[l].points);
+        free(s->outputs[l].contours);
+        free(s->outputs[l].layers);
+    }
+    return ok;
+}
+
+slices_t* slices_create(const mesh_t* mesh, const float* z, int count) {
+    for (int l = 1; l < count; l++) {
+        if (!(z[l - 1] <= z[l])) { return null; }
+    }
+    slices_t* r = (slices_t*)calloc(1, sizeof(slices_t));
+    if (r == null) { return null; }
+    r->layer_count = count;
+    slicer_t s = { mesh, z, count };
+    atomic_init(&s.oom, 0);
+    const int ok = slice(&s, r);
+    free(s.spans);
+    free(s.counts);
+    free(s.offsets);
+    free(s.refs);
+    free(s.outputs);
+    if (!ok) {
+        slices_destroy(r);
+        return null;
+    }
+    return r;
+}
+
+void slices_destroy(slices_t* s) {
+    if (s != null) {
+        free(s->layers);
+        free(s->contours);
+        free(s->points);
+        free(s);
+    }
+}
+
+END_C
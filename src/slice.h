@@ -0,0 +1,34 @@
+#pragma once
+#include "mesh.h"
+
+/* planar sections of a triangle mesh at many heights along z.
+   Every layer is a set of polylines in the xy plane. The mesh is expected
+   to be welded (triangles share vertex indices): segments are chained
+   through the edges they cross, so a closed welded mesh gives closed
+   contours, boundary edges and unwelded seams give open ones. Contours
+   of outward facing meshes run counterclockwise seen from +z around
+   solid and clockwise around holes. */
+
+BEGIN_C
+
+typedef struct slice_contour_s {
+    int offset; /* first point */
+    int count;  /* points, first point is not repeated at the end */
+    int closed; /* 0: ends at a boundary edge */
+} slice_contour_t;
+
+typedef struct slices_s {
+    int layer_count;
+    int contour_count;
+    int point_count;
+    int* layers;               /* contours of layer l are [layers[l]..layers[l + 1]) */
+    slice_contour_t* contours;
+    float (*points)[2];        /* x, y */
+} slices_t;
+
+/* z[0..count) must be ascending, a vertex exactly at a layer height counts
+   as above it. Returns null on out of memory or heights out of order */
+slices_t* slices_create(const mesh_t* mesh, const float* z, int count);
+void slices_destroy(slices_t* s);
+
+END_C
@@ -0,0 +1,244 @@
+#include "threads.h"
+#include <sched.h>
+
+BEGIN_C
+
+typedef struct task_s {
+    void* that;
+    void* message;
+    void (*run)(void* that, void* message);
+    tasks_t* group;
+} task_t;
+
+typedef struct deque_s {
+    pthread_mutex_t lock;
+    task_t* ring;
+    int capacity; /* power of 2 */
+    int top;      /* thieves take from the top */
+    int bottom;   /* owner pushes and pops at the bottom, top <= bottom */
+} deque_t;
+
+enum { WORKER_STACK = 8 * 1024 * 1024 }; /* macOS secondary threads default to 512KB */
+
+static struct {
+    int count;
+    deque_t* deques;
+    pthread_t* threads;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_int queued;
+    atomic_int sleeping;
+    atomic_int quit;
+} pool;
+
+static atomic_int started;
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local int self; /* deque index, threads outside of the pool share deque 0 */
+
+static void push(deque_t* d, const task_t* t) {
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom - d->top == d->capacity) {
+        const int capacity = d->capacity * 2;
+        task_t* ring = (task_t*)malloc(sizeof(task_t) * (size_t)capacity);
+        assert(ring != null); // cannot be reported to spawner sensibly
+        for (int i = d->top; i < d->bottom; i++) { ring[i - d->top] = d->ring[i & (d->capacity - 1)]; }
+        free(d->ring);
+        d->ring = ring;
+        d->bottom -= d->top;
+        d->top = 0;
+        d->capacity = capacity;
+    }
+    d->ring[d->bottom & (d->capacity - 1)] = *t;
+    d->bottom++;
+    pthread_mutex_unlock(&d->lock);
+}
+
+static int take(deque_t* d, task_t* t, int steal) {
+    int taken = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        if (steal) {
+            *t = d->ring[d->top & (d->capacity - 1)];
+            d->top++;
+        } else {
+            d->bottom--;
+            *t = d->ring[d->bottom & (d->capacity - 1)];
+        }
+        if (d->top == d->bottom) { d->top = d->bottom = 0; }
+        taken = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return taken;
+}
+
+static int find(task_t* t) {
+    if (atomic_load(&pool.queued) == 0) { return 0; }
+    int found = take(&pool.deques[self], t, false);
+    for (int i = 1; i < pool.count && !found; i++) {
+        found = take(&pool.deques[(self + i) % pool.count], t, true);
+    }
+    if (found) { atomic_fetch_sub(&pool.queued, 1); }
+    return found;
+}
+
+static void execute(task_t* t) {
+    t->run(t->that, t->message);
+    atomic_fetch_sub(&t->group->pending, 1);
+}
+
+static void* worker(void* p) {
+    self = (int)(intptr_t)p;
+    for (;;) {
+        task_t t;
+        if (find(&t)) {
+            execute(&t);
+        } else if (atomic_load(&pool.quit)) {
+            break;
+        } else {
+            for (int spin = 0; spin < 64 && atomic_load(&pool.queued) == 0; spin++) { sched_yield(); }
+            pthread_mutex_lock(&pool.lock);
+            atomic_fetch_add(&pool.sleeping, 1);
+            while (atomic_load(&pool.queued) == 0 && !atomic_load(&pool.quit)) {
+                pthread_cond_wait(&pool.wake, &pool.lock);
+            }
+            atomic_fetch_sub(&pool.sleeping, 1);
+            pthread_mutex_unlock(&pool.lock);
+        }
+    }
+    return null;
+}
+
+static void start(int count) {
+    if (count <= 0) { count = (int)sysconf(_SC_NPROCESSORS_ONLN); }
+    pool.count = maximum(1, count);
+    pool.deques = (deque_t*)calloc((size_t)pool.count, sizeof(deque_t));
+    pool.threads = (pthread_t*)calloc((size_t)pool.count, sizeof(pthread_t));
+    assert(pool.deques != null && pool.threads != null);
+    pthread_mutex_init(&pool.lock, null);
+    pthread_cond_init(&pool.wake, null);
+    atomic_store(&pool.queued, 0);
+    atomic_store(&pool.sleeping, 0);
+    atomic_store(&pool.quit, 0);
+    for (int i = 0; i < pool.count; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, null);
+        pool.deques[i].capacity = 256;
+        pool.deques[i].ring = (task_t*)malloc(sizeof(task_t) * 256);
+        assert(pool.deques[i].ring != null);
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, WORKER_STACK);
+    for (int i = 1; i < pool.count; i++) { // calling thread is deque 0
+        pthread_create(&pool.threads[i], &attr, worker, (void*)(intptr_t)i);
+    }
+    pthread_attr_destroy(&attr);
+    atomic_store(&started, 1);
+}
+
+static void ensure_started(void) {
+    if (!atomic_load(&started)) {
+        pthread_mutex_lock(&start_lock);
+        if (!atomic_load(&started)) { start(0); }
+        pthread_mutex_unlock(&start_lock);
+    }
+}
+
+void threads_fini(void) {
+    pthread_mutex_lock(&start_lock);
+    if (atomic_load(&started)) {
+        pthread_mutex_lock(&pool.lock);
+        atomic_store(&pool.quit, 1);
+        pthread_cond_broadcast(&pool.wake);
+        pthread_mutex_unlock(&pool.lock);
+        for (int i = 1; i < pool.count; i++) { pthread_join(pool.threads[i], null); }
+        for (int i = 0; i < pool.count; i++) {
+            pthread_mutex_destroy(&pool.deques[i].lock);
+            free(pool.deques[i].ring);
+        }
+        free(pool.deques);
+        free(pool.threads);
+        pthread_cond_destroy(&pool.wake);
+        pthread_mutex_destroy(&pool.lock);
+        pool.count = 0;
+        atomic_store(&started, 0);
+    }
+    pthread_mutex_unlock(&start_lock);
+}
+
+void threads_init(int count) {
+    threads_fini();
+    pthread_mutex_lock(&start_lock);
+    start(count);
+    pthread_mutex_unlock(&start_lock);
+}
+
+int threads_count(void) {
+    ensure_started();
+    return pool.count;
+}
+
+void tasks_spawn(tasks_t* g, void* that, void* message, void (*run)(void* that, void* message)) {
+    ensure_started();
+    task_t t = { that, message, run, g };
+    atomic_fetch_add(&g->pending, 1);
+    push(&pool.deques[self], &t);
+    atomic_fetch_add(&pool.queued, 1);
+    if (atomic_load(&pool.sleeping) > 0) {
+        pthread_mutex_lock(&pool.lock);
+        pthread_cond_signal(&pool.wake);
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+void tasks_wait(tasks_t* g) {
+    while (atomic_load(&g->pending) > 0) {
+        task_t t;
+        if (find(&t)) {
+            execute(&t);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+typedef struct range_s {
+    int from;
+    int to;
+    int grain;
+    void* that;
+    void (*body)(void* that, int i, int j);
+} range_t;
+
+/* binary splitting: halves are spawned where they can be stolen, chunk
+   boundaries depend only on from, to and grain never on number of threads */
+static void range_run(void* unused, void* message) {
+    const range_t* r = (const range_t*)message;
+    range_t halves[32];
+    tasks_t g = {0};
+    int n = 0;
+    int to = r->to;
+    while (to - r->from > r->grain) {
+        const int mid = r->from + (to - r->from) / 2;
+        halves[n] = *r;
+        halves[n].from = mid;
+        halves[n].to = to;
+        tasks_spawn(&g, null, &halves[n], range_run);
+        n++;
+        to = mid;
+    }
+    if (to > r->from) { r->body(r->that, r->from, to); }
+    tasks_wait(&g);
+    (void)unused;
+}
+
+void parallel_for(int from, int to, int grain, void* that, void (*body)(void* that, int i, int j)) {
+    range_t r = { from, to, maximum(1, grain), that, body };
+    if (to - from <= r.grain) {
+        if (to > from) { body(that, from, to); }
+    } else {
+        ensure_started();
+        range_run(null, &r);
+    }
+}
+
+END_C
@@ -0,0 +1,30 @@
+#pragma once
+#include "std.h"
+#include <stdatomic.h>
+
+/* work stealing thread pool.
+   Every worker owns a deque: spawn pushes to the bottom of the deque of
+   the calling thread, owner pops from the bottom (depth first, cache warm),
+   idle workers steal from the top of others (breadth first, big chunks).
+   tasks_wait() executes queued tasks instead of blocking, so tasks may
+   spawn and wait recursively (divide and conquer) without deadlocks.
+   The pool is started lazily with one worker per core, the calling
+   thread is one of them. */
+
+BEGIN_C
+
+typedef struct tasks_s { /* group of spawned tasks, zero initialize */
+    atomic_int pending;
+} tasks_t;
+
+int  threads_count(void); /* number of threads including the caller */
+void threads_init(int count); /* 0 means number of cores, not reentrant: no tasks may be in flight */
+void threads_fini(void);
+
+void tasks_spawn(tasks_t* g, void* that, void* message, void (*run)(void* that, void* message));
+void tasks_wait(tasks_t* g); /* helps executing tasks until all of the group are done */
+
+/* body(that, i, j) is called for disjoint [i..j) covering [from..to), j - i <= grain */
+void parallel_for(int from, int to, int grain, void* that, void (*body)(void* that, int i, int j));
+
+END_C
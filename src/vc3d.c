@@ -1,6 +1,7 @@
 #include "app.h"
 #include "vc3d.h"
 #include "math4x4.h"
+#include "scene.h"
 #include <OpenGL/gl.h>
 #include <OpenGL/gl3.h>
 
@@ -11,7 +12,7 @@ typedef struct vc3d_s {
     GLuint program_id;
     int w;
     int h;
-    mat4x4f_t model;
+    scene_t* scene; /* model matrices, node 0 is the root */
     mat4x4f_t view;
     mat4x4f_t projection;
 } vc3d_t_;
@@ -20,36 +21,18 @@ vc3d_t vc3d_create(app_t* app) {
     vc3d_t_* vc = (vc3d_t_*)calloc(sizeof(vc3d_t_), 1); // zeroed out
     if (vc != null) {
         vc->app = app;
-        memcpy(vc->model, identity_4x4f, sizeof(vc->model));
+        vc->scene = scene_create(0);
+        if (vc->scene == null || scene_add(vc->scene, -1, null) < 0) {
+            scene_destroy(vc->scene);
+            free(vc);
+            return null;
+        }
         memcpy(vc->view, identity_4x4f, sizeof(vc->view));
         memcpy(vc->projection, identity_4x4f, sizeof(vc->projection));
     }
     return vc;
 }
 
-static void orthographic_projection(GLfloat* m, float left, float right, float bottom, float top, float near, float far) {
-    // see: http://en.wikipedia.org/wiki/Orthographic_projection_(geometry)
-    const float inv_z = 1.0f / (far - near);
-    const float inv_y = 1.0f / (top - bottom);
-    const float inv_x = 1.0f / (right - left);
-    m[0] = 2 * inv_x; m[1] = 0; m[2] = 0; m[3] = 0;
-    m[4] = 0; m[5] = 2 * inv_y; m[6] = 0; m[7] = 0;
-    m[8] = 0; m[9] = 0; m[10] = -2 * inv_z; m[11] = 0;
-    m[12] = -(right + left) * inv_x; m[13] = -(top + bottom) * inv_y; m[14] = -(far + near) * inv_z; m[15] = 1;
-}
-
-static void viewport(GLfloat* m, float w, float h, float near, float far) {
-    memcpy(m, identity_4x4f, sizeof(identity_4x4f));
-/*
-    m[0] = w / 2;
-    m[5] = h / 2;
-    m[10] = (far - near) / 2;
-    m[12] = w / 2;
-    m[13] = h / 2;
-    m[14] = (far + near) / 2;
-*/
-}
-
 #define check_gl(call) call; { \
     int _gl_error_ = glGetError(); \
     if (_gl_error_ != 0) { printf("%s(%d): %s %s glError=%d\n", __FILE__, __LINE__, __func__, #call, _gl_error_); } \
@@ -59,10 +42,7 @@ void vc3d_shape(vc3d_t vc, int x, int y, int w, int h) {
     vc3d_t_* v = (vc3d_t_*)vc;
     v->w = w;
     v->h = h;
-    const float far = -1;
-    const float near = 1;
-    orthographic_projection(v->projection, 0, w, h, 0, -1, 1);
-    viewport(v->view, w, h, near, far);
+    orthographic_4x4f(v->projection, 0, w, h, 0, -1, 1);
     check_gl(glViewport(0, 0, w, h));
     printf("glViewport(0, 0, %d, %d)\n", w, h);
 //  disabled because I failed to make it communicate with glClear()
@@ -186,19 +166,12 @@ void vc3d_paint(vc3d_t p, int x, int y, int w, int h) {
     }
     check_gl(glUseProgram(vc->program_id))
     // create transformations
+    scene_update(vc->scene); // world matrices of changed nodes only
     mat4x4f_t mv;  // model * view
-    multiply_4x4f(mv, vc->model, vc->view);
+    multiply_4x4f(mv, scene_world(vc->scene, 0), vc->view);
     mat4x4f_t mvp = IDENTITY_MATRIX_4x4F; // model * view * projection
     multiply_4x4f(mvp, mv, vc->projection);
     memcpy(mvp, identity_4x4f, sizeof(mvp)); // DEBUG
-/*
-    projection = perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    view       = translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
-    model      = translate(model, cubePositions[i]);
-    static count;
-    float angle = 20.0f * count++;
-    rotate(model, radians(angle), vec3(1.0f, 0.3f, 0.5f));
-*/
     check_gl(GLint mvp_matrix_uniform = glGetUniformLocation(vc->program_id, "mvp"))
     check_gl(glUniformMatrix4fv(mvp_matrix_uniform, 1, GL_FALSE, mvp));
     check_gl(glEnableVertexAttribArray(0))
@@ -215,6 +188,7 @@ void vc3d_paint(vc3d_t p, int x, int y, int w, int h) {
 void vc3d_destroy(vc3d_t p) {
     vc3d_t_* vc = (vc3d_t_*)p;
     glDeleteProgram(vc->program_id);
+    scene_destroy(vc->scene);
     free(vc);
 }
 
@@ -0,0 +1,383 @@
+#include "voxels.h"
+#include "parity.h"
+#include "simd.h"
+#include "threads.h"
+#include "../ext/intersections/intersections.h"
+
+BEGIN_C
+
+/* Brick rows (8 x 8 rows of cells along the whole x extent) are independent
+   tasks: triangles are binned into the brick rows their bounds (and
+   triBoxOverlap() with the row box) overlap, each task rasterizes its
+   triangles into a dense bit mask of 64 cell rows, restricted to cells of
+   triangle bounds, 8 cells (4 without AVX2) tested at a time. Rows of cells
+   that fail the separating axis tests independent of x are skipped whole.
+   Solid: a ray along x through the center of every cell row toggles the
+   cell where it crosses a triangle, exclusive prefix xor of the toggles is
+   the inside. Edges shared by two triangles are crossed once (top-left
+   rule), the toggled cell is always a surface cell so bricks without
+   surface have the same parity throughout.
+   Bits only get or-ed and xor-ed, the result does not depend on the order of
+   triangles within a bin or on the number of threads. Outputs of parallel_for
+   chunks are concatenated in row order: keys come out sorted. */
+
+typedef uint64_t brick_t[VOXEL_BRICK];
+
+typedef struct voxel_triangle_s {
+    float v[3][3]; /* vertices in grid space: cell (x, y, z) is [x..x + 1] x [y..y + 1] x [z..z + 1] */
+    float e[3][3]; /* edges v1 - v0, v2 - v1, v0 - v2 */
+    float f[3][3]; /* fabsf(e) */
+    float n[3];    /* e0 x e1 */
+    int min[3];    /* candidate cells */
+    int max[3];
+} voxel_triangle_t;
+
+typedef struct output_s {
+    uint32_t* keys;
+    brick_t* bricks;
+    uint8_t* after;
+    int count;
+    int capacity;
+} output_t;
+
+typedef struct voxelizer_s {
+    const mesh_t* mesh;
+    voxels_t* v;
+    int flags;
+    float scale;         /* 1 / cell */
+    int bricks[3];       /* along each axis */
+    int words;           /* 64 bit words per row of cells along x */
+    int lanes;           /* cells tested together by cells() */
+    int (*cells)(const voxel_triangle_t* t, int x, float cy, float cz);
+    atomic_int* counts;  /* triangles per brick row, then scatter cursors */
+    int* offsets;        /* first reference of every brick row, [rows + 1] */
+    int32_t* refs;       /* triangles binned by brick row */
+    int* rows;           /* brick rows with triangles */
+    output_t* outputs;   /* one per parallel_for chunk, at index of its first row */
+    atomic_int oom;
+} voxelizer_t;
+
+enum {
+    CHUNK = 16384, /* triangles per parallel_for chunk */
+    ROW_GRAIN = 4  /* brick rows per parallel_for chunk */
+};
+
+#define ISA generic
+#define W 4
+#define VF f32x4
+#define VI i32x4
+#define TARGET
+#include "voxels.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+
+#ifdef SIMD_X86
+#define ISA avx2
+#define W 8
+#define VF f32x8
+#define VI i32x8
+#define TARGET SIMD_TARGET_AVX2
+#include "voxels.inl"
+#undef ISA
+#undef W
+#undef VF
+#undef VI
+#undef TARGET
+#endif
+
+static void voxel_triangle(const voxelizer_t* z, int32_t triangle, voxel_triangle_t* t) {
+    const float* v[3];
+    mesh_triangle(z->mesh, triangle, v);
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < 3; i++) { t->v[i][k] = (v[i][k] - z->v->origin[k]) * z->scale; }
+        const float lo = minimum(t->v[0][k], minimum(t->v[1][k], t->v[2][k]));
+        const float hi = maximum(t->v[0][k], maximum(t->v[1][k], t->v[2][k]));
+        t->min[k] = maximum(0, minimum(z->v->size[k] - 1, (int)ceilf(lo - 1))); // closed cells: lo == 3 touches cell 2
+        t->max[k] = maximum(0, minimum(z->v->size[k] - 1, (int)floorf(hi)));
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) {
+            t->e[i][k] = t->v[(i + 1) % 3][k] - t->v[i][k];
+            t->f[i][k] = fabsf(t->e[i][k]);
+        }
+    }
+    t->n[0] = t->e[0][1] * t->e[1][2] - t->e[0][2] * t->e[1][1];
+    t->n[1] = t->e[0][2] * t->e[1][0] - t->e[0][0] * t->e[1][2];
+    t->n[2] = t->e[0][0] * t->e[1][1] - t->e[0][1] * t->e[1][0];
+}
+
+/* separating axis tests on edge x X axes: same for all cells of a row */
+static int row_overlap(const voxel_triangle_t* t, float cy, float cz) {
+    const float h = 0.5f;
+    const float v0y = t->v[0][1] - cy, v1y = t->v[1][1] - cy, v2y = t->v[2][1] - cy;
+    const float v0z = t->v[0][2] - cz, v1z = t->v[1][2] - cz, v2z = t->v[2][2] - cz;
+    const float p[3][2] = {
+        { t->e[0][2] * v0y - t->e[0][1] * v0z, t->e[0][2] * v2y - t->e[0][1] * v2z },
+        { t->e[1][2] * v0y - t->e[1][1] * v0z, t->e[1][2] * v2y - t->e[1][1] * v2z },
+        { t->e[2][2] * v0y - t->e[2][1] * v0z, t->e[2][2] * v1y - t->e[2][1] * v1z }
+    };
+    for (int i = 0; i < 3; i++) {
+        const float rad = (t->f[i][2] + t->f[i][1]) * h;
+        if (minimum(p[i][0], p[i][1]) > rad || maximum(p[i][0], p[i][1]) < -rad) { return false; }
+    }
+    return true;
+}
+
+static void bin(voxelizer_t* z, int from, int to, int scatter) {
+    const int nby = z->bricks[1];
+    for (int i = from; i < to; i++) {
+        voxel_triangle_t t;
+        voxel_triangle(z, i, &t);
+        const int by0 = t.min[1] / VOXEL_BRICK, by1 = t.max[1] / VOXEL_BRICK;
+        const int bz0 = t.min[2] / VOXEL_BRICK, bz1 = t.max[2] / VOXEL_BRICK;
+        for (int bz = bz0; bz <= bz1; bz++) {
+            for (int by = by0; by <= by1; by++) {
+                if (by0 != by1 && bz0 != bz1) {
+                    float center[3] = { z->v->size[0] * 0.5f, by * VOXEL_BRICK + 4.0f, bz * VOXEL_BRICK + 4.0f };
+                    float half[3] = { z->v->size[0] * 0.5f, 4.0f, 4.0f };
+                    if (!triBoxOverlap(center, half, t.v)) { continue; }
+                }
+                const int row = bz * nby + by;
+                if (scatter) {
+                    z->refs[atomic_fetch_add(&z->counts[row], 1)] = i;
+                } else {
+                    atomic_fetch_add(&z->counts[row], 1);
+                }
+            }
+        }
+    }
+}
+
+static void bin_count(void* that, int from, int to) { bin((voxelizer_t*)that, from, to, false); }
+
+static void bin_scatter(void* that, int from, int to) { bin((voxelizer_t*)that, from, to, true); }
+
+static int output_push(voxelizer_t* z, output_t* o, uint32_t key, const brick_t bits, int after) {
+    if (o->count == o->capacity) {
+        const int capacity = o->capacity == 0 ? 256 : o->capacity * 2;
+        uint32_t* keys = (uint32_t*)realloc(o->keys, sizeof(uint32_t) * (size_t)capacity);
+        if (keys != null) { o->keys = keys; }
+        brick_t* bricks = (brick_t*)realloc(o->bricks, sizeof(brick_t) * (size_t)capacity);
+        if (bricks != null) { o->bricks = bricks; }
+        uint8_t* a = (uint8_t*)realloc(o->after, (size_t)capacity);
+        if (a != null) { o->after = a; }
+        if (keys == null || bricks == null || a == null) { atomic_store(&z->oom, 1); return false; }
+        o->capacity = capacity;
+    }
+    o->keys[o->count] = key;
+    memcpy(o->bricks[o->count], bits, sizeof(brick_t));
+    o->after[o->count] = (uint8_t)after;
+    o->count++;
+    return true;
+}
+
+/* bit masks of 64 cell rows (z % 8) * 8 + y % 8 of one brick row, words
+   each, returns bit per word written to (at most VOXEL_MAX / 64 words) */
+static uint64_t row_triangles(voxelizer_t* z, int row, uint64_t* surface, uint64_t* toggles) {
+    uint64_t touched = 0;
+    const int y0 = row % z->bricks[1] * VOXEL_BRICK, z0 = row / z->bricks[1] * VOXEL_BRICK;
+    const int solid = z->flags & VOXEL_SOLID;
+    for (int r = z->offsets[row]; r < z->offsets[row + 1]; r++) {
+        voxel_triangle_t t;
+        voxel_triangle(z, z->refs[r], &t);
+        const int ya = maximum(t.min[1], y0), yb = minimum(t.max[1], y0 + VOXEL_BRICK - 1);
+        const int za = maximum(t.min[2], z0), zb = minimum(t.max[2], z0 + VOXEL_BRICK - 1);
+        for (int cz = za; cz <= zb; cz++) {
+            for (int cy = ya; cy <= yb; cy++) {
+                const float fy = (float)cy + 0.5f, fz = (float)cz + 0.5f;
+                uint64_t* bits = surface + ((cz - z0) * VOXEL_BRICK + cy - y0) * z->words;
+                if (row_overlap(&t, fy, fz)) {
+                    for (int x = t.min[0]; x <= t.max[0]; x += z->lanes) {
+                        uint64_t m = (uint64_t)z->cells(&t, x, fy, fz);
+                        if (t.max[0] - x + 1 < z->lanes) { m &= (1ULL << (t.max[0] - x + 1)) - 1; }
+                        const int w = x >> 6, s = x & 63;
+                        bits[w] |= m << s;
+                        if (s + z->lanes > 64 && w + 1 < z->words) { bits[w + 1] |= m >> (64 - s); }
+                    }
+                }
+                double x;
+                if (solid && parity_crossing((const float (*)[3])t.v, fy, fz, &x)) {
+                    const int c = maximum(t.min[0], minimum(t.max[0], (int)floor(x)));
+                    toggles[bits - surface + (c >> 6)] ^= 1ULL << (c & 63);
+                    bits[c >> 6] |= 1ULL << (c & 63);
+                }
+            }
+        }
+        touched |= (~0ULL >> (63 - (t.max[0] >> 6))) & (~0ULL << (t.min[0] >> 6));
+    }
+    return touched;
+}
+
+static void row_bricks(voxelizer_t* z, int row, uint64_t* surface, uint64_t* toggles, output_t* o) {
+    const uint64_t touched = row_triangles(z, row, surface, toggles);
+    const int solid = z->flags & VOXEL_SOLID;
+    uint64_t carry = 0; // bit per cell row: parity of toggles on the left, untouched words keep it
+    for (int w = 0; w < z->words; w++) {
+        if (((touched >> w) & 1) == 0) { continue; }
+        uint64_t set[64], inside[64], any = 0; // inside[c] bit i: cells up to i have odd parity
+        for (int c = 0; c < 64; c++) {
+            const uint64_t in = (carry >> c) & 1;
+            const uint64_t p = parity_prefix(toggles[c * z->words + w]) ^ (0 - in);
+            set[c] = surface[c * z->words + w] | (solid ? (p << 1) | in : 0);
+            inside[c] = p;
+            carry = (carry & ~(1ULL << c)) | ((p >> 63) << c);
+            any |= surface[c * z->words + w];
+        }
+        for (int j = 0; j < 8 && any != 0; j++) {
+            const int bx = w * 8 + j;
+            if (bx >= z->bricks[0] || ((any >> (j * 8)) & 0xFF) == 0) { continue; }
+            brick_t bits = {0};
+            int after = 0;
+            for (int c = 0; c < 64; c++) {
+                bits[c / VOXEL_BRICK] |= ((set[c] >> (j * 8)) & 0xFF) << (c % VOXEL_BRICK * 8);
+                after += (inside[c] >> (j * 8 + 7)) & 1;
+            }
+            const uint32_t key = (uint32_t)row * (uint32_t)z->bricks[0] + (uint32_t)bx;
+            if (!output_push(z, o, key, bits, solid && after >= 32)) { break; }
+        }
+    }
+    for (int w = 0; w < z->words; w++) {
+        for (int c = 0; c < 64 && ((touched >> w) & 1) != 0; c++) {
+            surface[c * z->words + w] = 0;
+            toggles[c * z->words + w] = 0;
+        }
+    }
+}
+
+static void rows_body(void* that, int from, int to) {
+    voxelizer_t* z = (voxelizer_t*)that;
+    uint64_t* surface = (uint64_t*)calloc((size_t)z->words * 64 * 2, sizeof(uint64_t));
+    if (surface == null) { atomic_store(&z->oom, 1); return; }
+    for (int k = from; k < to && !atomic_load(&z->oom); k++) {
+        row_bricks(z, z->rows[k], surface, surface + z->words * 64, &z->outputs[from]);
+    }
+    free(surface);
+}
+
+static int gather(voxelizer_t* z, int slots) {
+    voxels_t* v = z->v;
+    int total = 0;
+    for (int k = 0; k < slots; k++) { total += z->outputs[k].count; }
+    v->keys = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)maximum(1, total));
+    v->bricks = (brick_t*)malloc(sizeof(brick_t) * (size_t)maximum(1, total));
+    v->after = (uint8_t*)malloc((size_t)maximum(1, total));
+    if (v->keys == null || v->bricks == null || v->after == null) { return false; }
+    for (int k = 0; k < slots; k++) {
+        const output_t* o = &z->outputs[k];
+        memcpy(v->keys + v->brick_count, o->keys, sizeof(uint32_t) * (size_t)o->count);
+        memcpy(v->bricks + v->brick_count, o->bricks, sizeof(brick_t) * (size_t)o->count);
+        memcpy(v->after + v->brick_count, o->after, (size_t)o->count);
+        v->brick_count += o->count;
+    }
+    return true;
+}
+
+static int voxelize(voxelizer_t* z) {
+    const int rows = z->bricks[1] * z->bricks[2];
+    const int n = z->mesh->triangle_count;
+    z->counts = (atomic_int*)malloc(sizeof(atomic_int) * (size_t)rows);
+    z->offsets = (int*)malloc(sizeof(int) * (size_t)(rows + 1));
+    if (z->counts == null || z->offsets == null) { return false; }
+    for (int r = 0; r < rows; r++) { atomic_init(&z->counts[r], 0); }
+    parallel_for(0, n, CHUNK, z, bin_count);
+    int total = 0, nonempty = 0;
+    for (int r = 0; r < rows; r++) {
+        const int c = atomic_load(&z->counts[r]);
+        z->offsets[r] = total;
+        atomic_store(&z->counts[r], total);
+        nonempty += c > 0;
+        total += c;
+    }
+    z->offsets[rows] = total;
+    z->refs = (int32_t*)malloc(sizeof(int32_t) * (size_t)maximum(1, total));
+    z->rows = (int*)malloc(sizeof(int) * (size_t)maximum(1, nonempty));
+    z->outputs = (output_t*)calloc((size_t)maximum(1, nonempty), sizeof(output_t));
+    if (z->refs == null || z->rows == null || z->outputs == null) { return false; }
+    parallel_for(0, n, CHUNK, z, bin_scatter);
+    nonempty = 0;
+    for (int r = 0; r < rows; r++) {
+        if (z->offsets[r + 1] > z->offsets[r]) { z->rows[nonempty++] = r; }
+    }
+    parallel_for(0, nonempty, ROW_GRAIN, z, rows_body);
+    const int ok = !atomic_load(&z->oom) && gather(z, nonempty);
+    for (int k = 0; k < nonempty; k++) {
+        free(z->outputs[k].keys);
+        free(z->outputs[k].bricks);
+        free(z->outputs[k].after);
+    }
+    return ok;
+}
+
+voxels_t* voxels_create(const mesh_t* mesh, int resolution, int flags) {
+    if (resolution < 1 || resolution > VOXEL_MAX) { return null; }
+    voxels_t* v = (voxels_t*)calloc(1, sizeof(voxels_t));
+    if (v == null) { return null; }
+    float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int i = 0; i < mesh->vertex_count; i++) {
+        for (int k = 0; k < 3; k++) {
+            lo[k] = minimum(lo[k], mesh->vertices[i][k]);
+            hi[k] = maximum(hi[k], mesh->vertices[i][k]);
+        }
+    }
+    float extent = 0;
+    for (int k = 0; k < 3; k++) {
+        if (mesh->vertex_count == 0) { lo[k] = hi[k] = 0; }
+        extent = maximum(extent, hi[k] - lo[k]);
+    }
+    v->cell = extent > 0 ? extent / (float)resolution : 1;
+    for (int k = 0; k < 3; k++) {
+        const int cells = (int)ceilf((hi[k] - lo[k]) / v->cell);
+        v->origin[k] = lo[k];
+        v->size[k] = minimum(VOXEL_MAX, maximum(1, (cells + VOXEL_BRICK - 1) / VOXEL_BRICK) * VOXEL_BRICK);
+    }
+    voxelizer_t z = { mesh, v, flags, 1 / v->cell };
+    for (int k = 0; k < 3; k++) { z.bricks[k] = v->size[k] / VOXEL_BRICK; }
+    z.words = (v->size[0] + 63) / 64;
+    z.lanes = 4;
+    z.cells = cells_generic;
+#ifdef SIMD_X86
+    if (simd_level() >= SIMD_AVX2) { z.lanes = 8; z.cells = cells_avx2; }
+#endif
+    atomic_init(&z.oom, 0);
+    const int ok = voxelize(&z);
+    free(z.counts);
+    free(z.offsets);
+    free(z.refs);
+    free(z.rows);
+    free(z.outputs);
+    if (!ok) {
+        voxels_destroy(v);
+        return null;
+    }
+    return v;
+}
+
+void voxels_destroy(voxels_t* v) {
+    if (v != null) {
+        free(v->keys);
+        free(v->bricks);
+        free(v->after);
+        free(v);
+    }
+}
+
+int voxels_get(const voxels_t* v, int x, int y, int z) {
+    if (x < 0 || y < 0 || z < 0 || x >= v->size[0] || y >= v->size[1] || z >= v->size[2]) { return 0; }
+    const uint32_t nbx = (uint32_t)(v->size[0] / VOXEL_BRICK);
+    const uint32_t row = (uint32_t)(z / VOXEL_BRICK * (v->size[1] / VOXEL_BRICK) + y / VOXEL_BRICK);
+    const uint32_t key = row * nbx + (uint32_t)(x / VOXEL_BRICK);
+    int lo = 0, hi = v->brick_count; // first key >= key
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (v->keys[mid] < key) { lo = mid + 1; } else { hi = mid; }
+    }
+    if (lo < v->brick_count && v->keys[lo] == key) {
+        return (int)((v->bricks[lo][z % VOXEL_BRICK] >> (y % VOXEL_BRICK * 8 + x % VOXEL_BRICK)) & 1);
+    }
+    return lo > 0 && v->keys[lo - 1] / nbx == row && v->after[lo - 1];
+}
+
+END_C
@@ -0,0 +1,39 @@
+#pragma once
+#include "mesh.h"
+
+/* sparse voxelization of a triangle mesh on a grid of up to 4096^3 cells.
+   Surface voxelization is conservative: every cell touched by a triangle
+   is set (Akenine-Moller triangle/box overlap test). VOXEL_SOLID also sets
+   cells inside of a closed mesh using scanline parity along x.
+   Only bricks of 8x8x8 cells containing surface are stored, bricks without
+   surface are entirely inside or outside, which is recorded in the nearest
+   stored brick on their left, so memory grows with surface area not volume. */
+
+BEGIN_C
+
+enum {
+    VOXEL_BRICK = 8,   /* cells along brick edge */
+    VOXEL_MAX   = 4096 /* cells along longest axis */
+};
+
+enum { /* voxels_create() flags */
+    VOXEL_SOLID = 1
+};
+
+typedef struct voxels_s {
+    float origin[3];     /* minimum corner of cell (0, 0, 0) */
+    float cell;          /* cell edge length */
+    int size[3];         /* cells per axis, multiples of VOXEL_BRICK */
+    int brick_count;
+    uint32_t* keys;      /* sorted: (bz * bricks along y + by) * bricks along x + bx */
+    uint64_t (*bricks)[VOXEL_BRICK]; /* bit y * 8 + x of bricks[k][z] */
+    uint8_t* after;      /* bricks following keys[k] along x up to the next stored one are inside */
+} voxels_t;
+
+/* resolution is number of cells along the longest axis of mesh bounds,
+   returns null on out of memory or resolution outside of [1..VOXEL_MAX] */
+voxels_t* voxels_create(const mesh_t* mesh, int resolution, int flags);
+void voxels_destroy(voxels_t* v);
+int  voxels_get(const voxels_t* v, int x, int y, int z); /* 0 outside of the grid */
+
+END_C
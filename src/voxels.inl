@@ -0,0 +1,56 @@
+/* triangle against a run of cells of voxels.c included once per instruction set with:
+       ISA     name suffix
+       W       lanes: cells tested together
+       VF, VI  float and int32 vector types of W lanes
+       TARGET  function attribute (may be empty)
+   Separating axis tests of triBoxOverlap() (ext/intersections/tribox3.c)
+   except the ones on edge x X axes which do not depend on the x of the
+   cell and are done once per row of cells by row_overlap(). */
+
+#define PASTE_(a, b) a ## _ ## b
+#define PASTE(a, b) PASTE_(a, b)
+#define FN(name) PASTE(name, ISA)
+
+static TARGET inline VF FN(splat)(float s) {
+    VF r;
+    for (int i = 0; i < W; i++) { r[i] = s; }
+    return r;
+}
+
+/* projections of two vertices are both on one side of [-rad..rad] */
+static TARGET inline VI FN(separated)(VF p0, VF p1, float rad) {
+    const VF r = FN(splat)(rad);
+    return ((p0 > r) & (p1 > r)) | ((p0 < -r) & (p1 < -r));
+}
+
+/* bit i is set when cell (x + i, y, z) with center (x + i + 0.5, cy, cz) overlaps */
+static TARGET int FN(cells)(const voxel_triangle_t* t, int x, float cy, float cz) {
+    const float h = 0.5f;
+    VF cx;
+    for (int i = 0; i < W; i++) { cx[i] = (float)(x + i) + h; }
+    const VF v0x = FN(splat)(t->v[0][0]) - cx, v1x = FN(splat)(t->v[1][0]) - cx, v2x = FN(splat)(t->v[2][0]) - cx;
+    const float v0y = t->v[0][1] - cy, v1y = t->v[1][1] - cy, v2y = t->v[2][1] - cy;
+    const float v0z = t->v[0][2] - cz, v1z = t->v[1][2] - cz, v2z = t->v[2][2] - cz;
+    const float (*e)[3] = t->e;
+    const float (*f)[3] = t->f;
+    VI out = FN(separated)(-e[0][2] * v0x + e[0][0] * v0z, -e[0][2] * v2x + e[0][0] * v2z, (f[0][2] + f[0][0]) * h);
+    out |= FN(separated)(e[0][1] * v1x - e[0][0] * v1y, e[0][1] * v2x - e[0][0] * v2y, (f[0][1] + f[0][0]) * h);
+    out |= FN(separated)(-e[1][2] * v0x + e[1][0] * v0z, -e[1][2] * v2x + e[1][0] * v2z, (f[1][2] + f[1][0]) * h);
+    out |= FN(separated)(e[1][1] * v0x - e[1][0] * v0y, e[1][1] * v1x - e[1][0] * v1y, (f[1][1] + f[1][0]) * h);
+    out |= FN(separated)(-e[2][2] * v0x + e[2][0] * v0z, -e[2][2] * v1x + e[2][0] * v1z, (f[2][2] + f[2][0]) * h);
+    out |= FN(separated)(e[2][1] * v1x - e[2][0] * v1y, e[2][1] * v2x - e[2][0] * v2y, (f[2][1] + f[2][0]) * h);
+    // planeBoxOverlap(): box corners nearest and farthest along the normal
+    const float* n = t->n;
+    const VF hx = FN(splat)(n[0] > 0 ? h : -h);
+    const float ny = n[1] > 0 ? h : -h, nz = n[2] > 0 ? h : -h;
+    const VF near = n[0] * (-hx - v0x) + FN(splat)(n[1] * (-ny - v0y) + n[2] * (-nz - v0z));
+    const VF far  = n[0] * (hx - v0x) + FN(splat)(n[1] * (ny - v0y) + n[2] * (nz - v0z));
+    out |= (near > FN(splat)(0)) | (far < FN(splat)(0));
+    int mask = 0;
+    for (int i = 0; i < W; i++) { mask |= (out[i] == 0) << i; }
+    return mask;
+}
+
+#undef FN
+#undef PASTE
+#undef PASTE_